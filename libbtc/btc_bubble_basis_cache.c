@@ -0,0 +1,89 @@
+/* See {btc_bubble_basis_cache.h} */
+/* Last edited on 2026-10-19 11:31:07 by stolfilocal */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <bool.h>
+#include <affirm.h>
+
+#include <btc_bubble_t.h>
+#include <btc_bubble_compute_column.h>
+
+#include <btc_bubble_basis_cache.h>
+
+bool_t btc_bubble_basis_cache_same_shape(btc_bubble_t *a, btc_bubble_t *b);
+  /* TRUE iff the bubbles {*a} and {*b} have the same shape parameters
+    (all those used by {btc_bubble_compute_column}). */
+
+btc_bubble_basis_cache_t *btc_bubble_basis_cache_new(int nd, int nb, int hrad, int ns)
+  { 
+    demand((nd >= 0) && (nb >= 0) && (hrad >= 0), "invalid model size");
+    demand(ns > 0, "invalid number of columns per bubble");
+    btc_bubble_basis_cache_t *bc = notnull(malloc(sizeof(btc_bubble_basis_cache_t)), "no mem");
+    bc->nd = nd;
+    bc->nb = nb;
+    bc->hrad = hrad;
+    bc->ns = ns;
+    int nc = ns*nb; /* Total number of columns. */
+    bc->key = notnull(malloc((nc + 1)*sizeof(btc_bubble_t)), "no mem");
+    bc->full = notnull(malloc((nc + 1)*sizeof(bool_t)), "no mem");
+    bc->col = notnull(malloc(((size_t)nc*nd + 1)*sizeof(double)), "no mem");
+    bc->next = notnull(malloc((nb + 1)*sizeof(int)), "no mem");
+    int k, jb;
+    for (k = 0; k < nc; k++) { bc->full[k] = FALSE; }
+    for (jb = 0; jb < nb; jb++) { bc->next[jb] = 0; }
+    bc->n_hits = 0;
+    bc->n_misses = 0;
+    return bc;
+  }
+
+void btc_bubble_basis_cache_free(btc_bubble_basis_cache_t *bc)
+  {
+    free(bc->key);
+    free(bc->full);
+    free(bc->col);
+    free(bc->next);
+    free(bc);
+  }
+
+void btc_bubble_basis_cache_compute_basis(btc_bubble_basis_cache_t *bc, btc_bubble_t bp[], double bval[])
+  {
+    int nd = bc->nd;
+    int nb = bc->nb;
+    int ns = bc->ns;
+    double *bvali = NULL; /* Raw values of a bubble, allocated if needed. */
+    int id, jb;
+    for (jb = 0; jb < nb; jb++)
+      { btc_bubble_t *bpj = &(bp[jb]);
+        /* Look for the column in the cache: */
+        int is = 0;
+        while ((is < ns) && ! (bc->full[ns*jb + is] && btc_bubble_basis_cache_same_shape(&(bc->key[ns*jb + is]), bpj))) { is++; }
+        if (is < ns)
+          { bc->n_hits++; }
+        else
+          { /* Not found, compute it into the next slot: */
+            is = bc->next[jb];
+            bc->next[jb] = (is + 1) % ns;
+            if (bvali == NULL) { bvali = notnull(malloc((nd + 1)*sizeof(double)), "no mem"); }
+            btc_bubble_compute_column(nd, bpj, bc->hrad, bvali, &(bc->col[nd*(ns*jb + is)]));
+            bc->key[ns*jb + is] = (*bpj);
+            bc->full[ns*jb + is] = TRUE;
+            bc->n_misses++;
+          }
+        /* Store in big array: */
+        double *cj = &(bc->col[nd*(ns*jb + is)]);
+        for (id = 0; id < nd; id++) { bval[nb*id + jb] = cj[id]; }
+      }
+    if (bvali != NULL) { free(bvali); }
+  }
+
+bool_t btc_bubble_basis_cache_same_shape(btc_bubble_t *a, btc_bubble_t *b)
+  {
+    return 
+      (a->rt_up == b->rt_up) &&
+      (a->id_fin_up == b->id_fin_up) &&
+      (a->wd_plat == b->wd_plat) &&
+      (a->rt_dn == b->rt_dn);
+  }
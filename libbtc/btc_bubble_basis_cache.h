@@ -0,0 +1,47 @@
+#ifndef btc_bubble_basis_cache_H
+#define btc_bubble_basis_cache_H
+
+/* A cache of bubble basis columns, for repeated basis computations. */
+/* Last edited on 2026-10-19 11:31:07 by stolfilocal */
+
+#include <bool.h>
+
+#include <btc_bubble_t.h>
+
+typedef struct btc_bubble_basis_cache_t 
+  { int nd;             /* Number of days in each column. */
+    int nb;             /* Number of bubbles in the model. */
+    int hrad;           /* Radius of the smoothing window. */
+    int ns;             /* Number of columns kept per bubble. */
+    btc_bubble_t *key;  /* {key[ns*jb + is]} has the parameters of column {is} of bubble {jb}. */
+    bool_t *full;       /* {full[ns*jb + is]} is TRUE iff that column has been computed. */
+    double *col;        /* Column {is} of bubble {jb} is {col[nd*(ns*jb + is) + id]} for {id} in {0..nd-1}. */
+    int *next;          /* {next[jb]} is the column of bubble {jb} to be replaced next. */
+    int n_hits;         /* Number of columns found in the cache. */
+    int n_misses;       /* Number of columns that had to be computed. */
+  } btc_bubble_basis_cache_t;
+  /* A cache of the smoothed values of bubble functions, as computed by 
+    {btc_bubble_compute_column}.  For each bubble {jb} in {0..nb-1},
+    the cache keeps the last {ns} distinct columns computed for it,
+    identified by the parameters that affect the bubble's shape
+    ({.rt_up}, {.id_fin_up}, {.wd_plat}, and {.rt_dn}). 
+    
+    During non-linear optimization, most trial parameter sets differ
+    from the previous ones in only a few bubbles, so most columns 
+    can be copied from the cache instead of being recomputed.
+    
+    A cache must not be used by two threads at the same time. */
+
+btc_bubble_basis_cache_t *btc_bubble_basis_cache_new(int nd, int nb, int hrad, int ns);
+  /* Creates an empty cache for a model with {nb} bubbles over {nd} days, 
+    smoothed with radius {hrad}, keeping {ns} columns per bubble. */
+
+void btc_bubble_basis_cache_free(btc_bubble_basis_cache_t *bc);
+  /* Reclaims all storage used by {bc}, including the record {*bc}. */
+
+void btc_bubble_basis_cache_compute_basis(btc_bubble_basis_cache_t *bc, btc_bubble_t bp[], double bval[]);
+  /* Same as {btc_bubble_compute_basis(bc->nd,bc->nb,bp,bc->hrad,bval)},
+    except that each column is taken from the cache {bc} if possible, 
+    and otherwise computed and stored into the cache. */
+
+#endif
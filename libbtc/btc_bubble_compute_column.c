@@ -0,0 +1,33 @@
+/* See {btc_bubble_compute_column.h} */
+/* Last edited on 2026-10-19 11:31:07 by stolfilocal */
+
+#define _GNU_SOURCE
+#include <math.h>
+
+#include <btc_bubble_t.h>
+#include <btc_price_series_smooth.h>
+
+#include <btc_bubble_compute_column.h>
+
+void btc_bubble_compute_column(int nd, btc_bubble_t *bpj, int hrad, double bvali[], double bvalo[])
+  {
+    double log_rtup = log(bpj->rt_up);
+    double log_rtdn = log(bpj->rt_dn);
+    int id_fin_up = bpj->id_fin_up;
+    int id_ini_dn = id_fin_up + bpj->wd_plat;
+    /* Split {0..nd-1} into rally, plateau, and decay ranges, so that
+      each loop below is branch-free (and vectorizable): */
+    int id_lim_up = id_fin_up;   /* End of rally range. */
+    if (id_lim_up < 0) { id_lim_up = 0; }
+    if (id_lim_up > nd) { id_lim_up = nd; }
+    int id_lim_pl = id_ini_dn + 1; /* End of plateau range. */
+    if (id_lim_pl < id_lim_up) { id_lim_pl = id_lim_up; }
+    if (id_lim_pl > nd) { id_lim_pl = nd; }
+    int id;
+    for (id = 0; id < id_lim_up; id++) { bvali[id] = exp(log_rtup*(id - id_fin_up)); }
+    for (id = id_lim_up; id < id_lim_pl; id++) { bvali[id] = 1.0; }
+    for (id = id_lim_pl; id < nd; id++) { bvali[id] = exp(log_rtdn*(id - id_ini_dn)); }
+
+    /* Smooth the values with Hann window: */
+    btc_price_series_smooth(nd, bvali, hrad, bvalo);
+  }
@@ -0,0 +1,17 @@
+#ifndef btc_bubble_compute_column_H
+#define btc_bubble_compute_column_H
+
+/* Computing the values of a single bubble of a BTC price model. */
+/* Last edited on 2026-10-19 11:31:07 by stolfilocal */
+
+#include <btc_bubble_t.h>
+
+void btc_bubble_compute_column(int nd, btc_bubble_t *bpj, int hrad, double bvali[], double bvalo[]);
+  /* Computes the values of the bubble function with parameters {*bpj}
+    on days {0..nd-1}.  The raw values are stored in {bvali[0..nd-1]},
+    and the values smoothed with Hann window of radius {hrad} are
+    stored in {bvalo[0..nd-1]}.  The raw function has maximum value 1.0.
+    Only the fields {.rt_up}, {.id_fin_up}, {.wd_plat}, and {.rt_dn} 
+    of {*bpj} are used. */
+
+#endif
@@ -1,5 +1,5 @@
 /* See {btc_bubble_nl_opt_adjust_continuous_parameters.h} */
-/* Last edited on 2017-03-13 21:06:32 by stolfilocal */
+/* Last edited on 2026-10-19 12:41:58 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <stdio.h>
@@ -24,6 +24,7 @@
 #include <btc_bubble_fit_lsq.h>
 #include <btc_bubble_parms_copy.h>
 #include <btc_bubble_eval_rms_log_error.h>
+#include <btc_bubble_basis_cache.h>
 
 #include <btc_bubble_nl_opt_adjust_continuous_parameters.h>
 
@@ -42,11 +43,24 @@ void btc_bubble_nl_opt_adjust_continuous_parameters
     int id_ini,
     int id_fin,
     char* outPrefix, 
-    double bval[]
+    double bval[],
+    btc_bubble_basis_cache_t *bc
   )
   {
     bool_t verbose = TRUE;
     
+    auto void fit_model(void);
+      /* Computes the bubble basis {bval} for the current {bp} and 
+        fits the coefficients {bp[].coef}. */
+    
+    void fit_model(void)
+      { if (bc != NULL)
+          { btc_bubble_basis_cache_compute_basis(bc, bp, bval); }
+        else
+          { btc_bubble_compute_basis(nd, nb, bp, hrad, bval); }
+        btc_bubble_fit_lsq(nd, dt, ap, wt, nb, bp, bval, maxLSQIters, outPrefix);
+      }
+    
     if (maxNLIters > 0) 
       { 
         /* Identify the continuous parameters to optimize: */
@@ -92,8 +106,7 @@ void btc_bubble_nl_opt_adjust_continuous_parameters
                 btc_bubble_nl_opt_check_bubble_parms_in_range(nb, bp_lo, bp, bp_hi);
 
                 /* Compute the bubble basis and fit the coefficients {bp[].coef}: */
-                btc_bubble_compute_basis(nd, nb, bp, hrad, bval); 
-                btc_bubble_fit_lsq(nd, dt, ap, wt, nb, bp, bval, maxLSQIters, outPrefix); 
+                fit_model();
 
                 /* Compute the RMS log error and add bias and penalty terms: */
                 double Q = btc_bubble_eval_rms_log_error(nd, ap, id_ini, id_fin, nb, bp, bval);
@@ -193,6 +206,5 @@ void btc_bubble_nl_opt_adjust_continuous_parameters
       }
             
     /* Compute the basis for {bp} and adjust the linear coefficients {.coef}: */
-    btc_bubble_compute_basis(nd, nb, bp, hrad, bval); 
-    btc_bubble_fit_lsq(nd, dt, ap, wt, nb, bp, bval, maxLSQIters, outPrefix);
+    fit_model();
   }
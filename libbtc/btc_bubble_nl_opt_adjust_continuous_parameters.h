@@ -2,9 +2,10 @@
 #define btc_bubble_nl_opt_adjust_continuous_parameters_H
 
 /* Non-linear optimization of the continuous parameters of a BTC price bubble. */
-/* Last edited on 2015-04-22 20:48:28 by stolfilocal */
+/* Last edited on 2026-10-19 12:41:58 by stolfilocal */
 
 #include <btc_bubble_t.h>
+#include <btc_bubble_basis_cache.h>
 
 void btc_bubble_nl_opt_adjust_continuous_parameters
   ( int nd, 
@@ -21,7 +22,8 @@ void btc_bubble_nl_opt_adjust_continuous_parameters
     int id_ini,
     int id_fin,
     char* outPrefix, 
-    double bval[]         /* (OUT) Bubble basis computed with parameters {bp}. */
+    double bval[],        /* (OUT) Bubble basis computed with parameters {bp}. */
+    btc_bubble_basis_cache_t *bc   /* Cache of basis columns, or NULL. */
   );
   /* Adjusts any adjustable continuous bubble parameters in {pb[0..nb-1]}
     so as to best fit the price series {ap[0..nd-1]}. 
@@ -66,7 +68,11 @@ void btc_bubble_nl_opt_adjust_continuous_parameters
     
     The goal function for non-linear optimization is the RMS error
     bewteen the modeled series and the given series, in log scale,
-    between the samples {id_ini} and {id_fin} inclusive. */
+    between the samples {id_ini} and {id_fin} inclusive. 
+    
+    If {bc} is not NULL, the basis is computed with
+    {btc_bubble_basis_cache_compute_basis}, so that the columns of 
+    bubbles whose shape did not change are not recomputed. */
     
 
 #endif
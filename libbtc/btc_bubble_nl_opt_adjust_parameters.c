@@ -1,15 +1,19 @@
 /* See {btc_bubble_nl_opt_adjust_parameters.h} */
-/* Last edited on 2015-04-22 20:49:43 by stolfilocal */
+/* Last edited on 2026-10-19 12:41:58 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
 #include <math.h>
 
 #include <bool.h>
 #include <affirm.h>
 #include <jsmath.h>
+#include <jsrandom.h>
+#include <jsthread.h>
+#include <jsprof.h>
 
 #include <btc_bubble_t.h>
 #include <btc_bubble_nl_opt_gather_integer_variable_parameters.h>
@@ -22,9 +26,61 @@
 #include <btc_bubble_compute_basis.h>
 #include <btc_bubble_fit_lsq.h>
 #include <btc_bubble_eval_rms_log_error.h>
+#include <btc_bubble_basis_cache.h>
 
 #include <btc_bubble_nl_opt_adjust_parameters.h>
 
+typedef struct btc_bubble_nl_opt_thread_t
+  { btc_bubble_t *bp_try;         /* Tentative bubble parameter set. */
+    btc_bubble_t *bp_best;        /* Best bubble parameter set found by this thread. */
+    int *pi_try;                  /* The trial integer parameter vector. */
+    double *bval;                 /* Bubble basis for {bp_try}. */
+    btc_bubble_basis_cache_t *bc; /* Cache of basis columns. */
+    double Q_best;                /* Goal function value of {bp_best}, or {+INF}. */
+    int it_best;                  /* Index of the trial that gave {bp_best}, or -1. */
+  } btc_bubble_nl_opt_thread_t;
+  /* Work areas and partial results of one thread of {btc_bubble_nl_opt_adjust_parameters}. */
+
+typedef struct btc_bubble_nl_opt_job_t
+  { int nd;
+    char** dt;
+    double* ap;
+    double* wt;
+    int nb;
+    btc_bubble_t* bp_lo;
+    btc_bubble_t* bp;
+    btc_bubble_t* bp_hi;
+    int hrad;
+    int maxLSQIters;
+    int maxNLIters;
+    int id_ini;
+    int id_fin;
+    char* outPrefix;
+    int npi;       /* Number of integer parameters to optimize. */
+    int* pi_lo;    /* Min values of the integer parameters. */
+    int* pi;       /* Guessed values of the integer parameters. */
+    int* pi_hi;    /* Max values of the integer parameters. */
+    bool_t verbose;
+    uint32_t seed; /* Base seed for the random generator of each trial. */
+    btc_bubble_nl_opt_thread_t *th; /* Per-thread work areas. */
+  } btc_bubble_nl_opt_job_t;
+  /* The arguments of {btc_bubble_nl_opt_adjust_parameters}
+    as seen by each thread. */
+
+void btc_bubble_nl_opt_try_range(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Tries the integer parameter combinations with indices {ini..fin},
+    updating {job->th[ith]}, where {job} is {(btc_bubble_nl_opt_job_t *)arg}.
+    Each trial {it} uses a private random generator seeded with 
+    {btc_bubble_nl_opt_trial_seed(job->seed,it)}. */
+
+uint32_t btc_bubble_nl_opt_trial_seed(uint32_t seed, int it);
+  /* The seed of the random generator used by trial {it}. */
+
+void btc_bubble_nl_opt_decode_trial(int npi, int it, int pi_lo[], int pi_hi[], int pi_try[]);
+  /* Stores into {pi_try[0..npi-1]} the integer parameter combination 
+    with index {it} in the enumeration order.  In that order 
+    {pi_try[npi-1]} varies fastest, from {pi_lo[npi-1]} to {pi_hi[npi-1]}. */
+
 void btc_bubble_nl_opt_adjust_parameters
   ( int nd, 
     char* dt[], 
@@ -39,12 +95,15 @@ void btc_bubble_nl_opt_adjust_parameters
     int maxNLIters, 
     int id_ini,
     int id_fin,
+    int nth,
     char* outPrefix, 
     double bval[]
   )
   { 
     bool_t verbose = TRUE;
     
+    jsprof_ENTER("btc_bubble_nl_opt_adjust_parameters");
+    
     if (maxNLIters > 0) 
       { 
         /* Perform non-linear optimization on the variable parameters in {bp}: */
@@ -61,67 +120,61 @@ void btc_bubble_nl_opt_adjust_parameters
         /* We must call {btc_bubble_nl_opt_adjust_continuous_parameters} even 
           if {npi} is zero, because there may be continuous parameters to adjust. */
         
-        /* Keep track of the best parameter set seen: */
-        btc_bubble_t bp_best[nb];  /* The best bubble parameter set found so far. */
-        int pi_best[npi];          /* Best set of integer parameters found so far. */
-        double Q_best = +INF;      /* Best goal function value found so far, or {+INF}. */
+        /* Count the integer parameter combinations: */
+        double nt_dbl = 1.0;
+        int k;
+        for (k = 0; k < npi; k++) 
+          { demand(pi_lo[k] <= pi_hi[k], "invalid integer parameter range");
+            nt_dbl *= (double)(pi_hi[k] - pi_lo[k] + 1);
+          }
+        demand(nt_dbl < 1.0e9, "too many integer parameter combinations");
+        int n_trials = (int)nt_dbl;
         
+        /* Allocate the work areas of each thread: */
+        nth = jsthread_choose_count(nth, n_trials);
+        btc_bubble_nl_opt_thread_t *th = notnull(malloc(nth*sizeof(btc_bubble_nl_opt_thread_t)), "no mem");
+        int ith;
+        for (ith = 0; ith < nth; ith++)
+          { btc_bubble_nl_opt_thread_t *thi = &(th[ith]);
+            thi->bp_try = notnull(malloc((nb + 1)*sizeof(btc_bubble_t)), "no mem");
+            thi->bp_best = notnull(malloc((nb + 1)*sizeof(btc_bubble_t)), "no mem");
+            thi->pi_try = notnull(malloc((npi + 1)*sizeof(int)), "no mem");
+            thi->bval = notnull(malloc(((size_t)nd*nb + 1)*sizeof(double)), "no mem");
+            thi->bc = btc_bubble_basis_cache_new(nd, nb, hrad, 4);
+            thi->Q_best = +INF;
+            thi->it_best = -1;
+          }
+
         /* Step through the integer parameters, remembering the optimum: */
-        btc_bubble_t bp_try[nb]; /* Tentative bubble parameter set during NL optimization. */
-        int pi_try[npi];      /* The trial parameter vector. */
-        int k;
-        for (k = 0; k < npi; k++) { pi_try[k] = pi_lo[k]; }
-        int n_trials = 0;
-        while (TRUE) 
-          { 
-            /* Try the integer parameter values {pi[0..npi-1]}, resetting the given cont ones: */
-            if (verbose)
-              { fprintf(stderr, "=== trial %3d ================================================\n", n_trials);
-                for (k = 0; k < npi; k++) 
-                  { fprintf(stderr, "  pi[%02d] = %5d = %s", k, pi_try[k], dt[pi_try[k]]);
-                    fprintf(stderr, "  in %5d = %s", pi_lo[k], dt[pi_lo[k]]);
-                    fprintf(stderr, " .. %5d = %s\n", pi_hi[k], dt[pi_hi[k]]);
-                  }
-              }
-            btc_bubble_parms_copy(nb, bp, bp_try);
-            btc_bubble_nl_opt_set_integer_variable_parameters(npi, pi_try, nb, bp_lo, bp_try, bp_hi);
-            btc_bubble_nl_opt_adjust_continuous_parameters
-              ( nd, dt, ap, wt, 
-                nb, bp_lo, bp_try, bp_hi,
-                hrad, 
-                maxNLIters, maxLSQIters, id_ini, id_fin,
-                outPrefix, 
-                bval 
-              );
-            n_trials++;
-            /* Assumes that {bp_try} is set to the optimum and {bval} is derived from it. */
-
-            /* Compute the goal function for the adjusted continuous params: */
-            double Q_try = btc_bubble_eval_rms_log_error(nd, ap, id_ini, id_fin, nb, bp_try, bval);
-            if (verbose) { fprintf(stderr, "  Q_try = %25.16e\n", Q_try); }
-
-            /* Add a slight bias to favor the given guess in case of ties or near-ties: */
-            double alpha = 1.0e-6; /* Relative bias factor. */
-            Q_try = btc_bubble_nl_opt_add_integer_parameter_bias(Q_try, npi, pi_try, pi, alpha);
-
-            if ((Q_try < +INF) && (Q_try < Q_best))
-              { /* Save this trial: */
-                Q_best = Q_try;
-                for (k = 0; k < npi; k++) { pi_best[k] = pi_try[k]; }
-                btc_bubble_parms_copy(nb, bp_try, bp_best);
-                if (verbose) { fprintf(stderr, "    updated!\n"); }
-              }
-              
-            if (verbose)
-              { fprintf(stderr, "==============================================================\n"); }
-
-            /* Increment the integer parameter vector: */
-            k = npi - 1;
-            while ((k >= 0) && (pi_try[k] == pi_hi[k])) { pi_try[k] = pi_lo[k]; k--; }
-            if (k < 0) { break; }
-            assert(pi_try[k] < pi_hi[k]);
-            pi_try[k]++;
+        btc_bubble_nl_opt_job_t job = (btc_bubble_nl_opt_job_t)
+          { .nd = nd, .dt = dt, .ap = ap, .wt = wt, 
+            .nb = nb, .bp_lo = bp_lo, .bp = bp, .bp_hi = bp_hi, 
+            .hrad = hrad, .maxLSQIters = maxLSQIters, .maxNLIters = maxNLIters,
+            .id_ini = id_ini, .id_fin = id_fin, .outPrefix = outPrefix,
+            .npi = npi, .pi_lo = pi_lo, .pi = pi, .pi_hi = pi_hi,
+            .verbose = verbose, .seed = uint32_random(), .th = th
+          };
+        jsprof_ENTER("trials");
+        jsprof_COUNT("trials", n_trials);
+        jsthread_run_ranges(n_trials, 1, nth, &btc_bubble_nl_opt_try_range, &job);
+        jsprof_LEAVE("trials");
+        
+        /* Pick the best trial, favoring the earliest one in case of ties: */
+        int ith_best = -1; 
+        for (ith = 0; ith < nth; ith++)
+          { btc_bubble_nl_opt_thread_t *thi = &(th[ith]);
+            if (thi->it_best < 0) { continue; }
+            if 
+              ( (ith_best < 0) || 
+                (thi->Q_best < th[ith_best].Q_best) ||
+                ((thi->Q_best == th[ith_best].Q_best) && (thi->it_best < th[ith_best].it_best))
+              )
+              { ith_best = ith; }
           }
+        demand(ith_best >= 0, "no valid parameter combination");
+        double Q_best = th[ith_best].Q_best;
+        int pi_best[npi]; /* Best set of integer parameters. */
+        btc_bubble_nl_opt_decode_trial(npi, th[ith_best].it_best, pi_lo, pi_hi, pi_best);
         
         if (verbose)
           { fprintf(stderr, "tried %d integer parameter combinations\n", n_trials);
@@ -137,13 +190,94 @@ void btc_bubble_nl_opt_adjust_parameters
             
         /* Copy the best parameters to {bp}, check range to be sure: */
         assert(Q_best < +INF);
-        btc_bubble_parms_copy(nb, bp_best, bp);
+        btc_bubble_parms_copy(nb, th[ith_best].bp_best, bp);
         btc_bubble_nl_opt_check_bubble_parms_in_range(nb, bp_lo, bp, bp_hi);
 
+        for (ith = 0; ith < nth; ith++)
+          { btc_bubble_nl_opt_thread_t *thi = &(th[ith]);
+            free(thi->bp_try); free(thi->bp_best); free(thi->pi_try); free(thi->bval);
+            btc_bubble_basis_cache_free(thi->bc);
+          }
+        free(th);
         free(pi_lo); free(pi); free(pi_hi);
       }
       
     /* recompute the basis and fit the linear combination for {bp}: */
+    jsprof_ENTER("final_fit");
     btc_bubble_compute_basis(nd, nb, bp, hrad, bval); 
     btc_bubble_fit_lsq(nd, dt, ap, wt, nb, bp, bval, maxLSQIters, outPrefix);
+    jsprof_LEAVE("final_fit");
+    jsprof_LEAVE("btc_bubble_nl_opt_adjust_parameters");
+  }
+
+void btc_bubble_nl_opt_try_range(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    btc_bubble_nl_opt_job_t *job = (btc_bubble_nl_opt_job_t *)arg;
+    btc_bubble_nl_opt_thread_t *thi = &(job->th[ith]);
+    int nb = job->nb;
+    int npi = job->npi;
+    int *pi_try = thi->pi_try;
+    int it, k;
+    for (it = ini; it <= fin; it++)
+      { 
+        /* Try the integer parameter values {pi_try[0..npi-1]}, resetting the given cont ones: */
+        btc_bubble_nl_opt_decode_trial(npi, it, job->pi_lo, job->pi_hi, pi_try);
+        if (job->verbose)
+          { fprintf(stderr, "=== trial %3d ================================================\n", it);
+            for (k = 0; k < npi; k++) 
+              { fprintf(stderr, "  pi[%02d] = %5d = %s", k, pi_try[k], job->dt[pi_try[k]]);
+                fprintf(stderr, "  in %5d = %s", job->pi_lo[k], job->dt[job->pi_lo[k]]);
+                fprintf(stderr, " .. %5d = %s\n", job->pi_hi[k], job->dt[job->pi_hi[k]]);
+              }
+          }
+        btc_bubble_parms_copy(nb, job->bp, thi->bp_try);
+        btc_bubble_nl_opt_set_integer_variable_parameters(npi, pi_try, nb, job->bp_lo, thi->bp_try, job->bp_hi);
+        jsprof_ENTER("btc_bubble_nl_opt_trial");
+        jsprof_ENTER("adjust_continuous");
+        jsrandom_thread_seed(btc_bubble_nl_opt_trial_seed(job->seed, it));
+        btc_bubble_nl_opt_adjust_continuous_parameters
+          ( job->nd, job->dt, job->ap, job->wt, 
+            nb, job->bp_lo, thi->bp_try, job->bp_hi,
+            job->hrad, 
+            job->maxLSQIters, job->maxNLIters, job->id_ini, job->id_fin,
+            job->outPrefix, 
+            thi->bval,
+            thi->bc
+          );
+        jsrandom_thread_release();
+        jsprof_LEAVE("adjust_continuous");
+        /* Assumes that {bp_try} is set to the optimum and {bval} is derived from it. */
+
+        /* Compute the goal function for the adjusted continuous params: */
+        double Q_try = btc_bubble_eval_rms_log_error(job->nd, job->ap, job->id_ini, job->id_fin, nb, thi->bp_try, thi->bval);
+        jsprof_LEAVE("btc_bubble_nl_opt_trial");
+        if (job->verbose) { fprintf(stderr, "  trial %3d Q_try = %25.16e\n", it, Q_try); }
+
+        /* Add a slight bias to favor the given guess in case of ties or near-ties: */
+        double alpha = 1.0e-6; /* Relative bias factor. */
+        Q_try = btc_bubble_nl_opt_add_integer_parameter_bias(Q_try, npi, pi_try, job->pi, alpha);
+
+        /* Each thread sees its trials in increasing order, so ties go to the earliest one: */
+        if ((Q_try < +INF) && (Q_try < thi->Q_best))
+          { /* Save this trial: */
+            thi->Q_best = Q_try;
+            thi->it_best = it;
+            btc_bubble_parms_copy(nb, thi->bp_try, thi->bp_best);
+            if (job->verbose) { fprintf(stderr, "  trial %3d updated!\n", it); }
+          }
+      }
+  }
+
+uint32_t btc_bubble_nl_opt_trial_seed(uint32_t seed, int it)
+  { return seed ^ (uint32_t)(2654435761u*(uint32_t)(it + 1)); }
+
+void btc_bubble_nl_opt_decode_trial(int npi, int it, int pi_lo[], int pi_hi[], int pi_try[])
+  {
+    int k;
+    for (k = npi - 1; k >= 0; k--)
+      { int nv = pi_hi[k] - pi_lo[k] + 1;
+        pi_try[k] = pi_lo[k] + it % nv;
+        it = it / nv;
+      }
+    assert(it == 0);
   }
@@ -2,7 +2,7 @@
 #define btc_bubble_nl_opt_adjust_parameters_H
 
 /* Non-linear optimization of BTC price bubbe parameters. */
-/* Last edited on 2015-04-22 20:48:43 by stolfilocal */
+/* Last edited on 2026-10-19 12:41:58 by stolfilocal */
 
 #include <btc_bubble_t.h>
 
@@ -20,6 +20,7 @@ void btc_bubble_nl_opt_adjust_parameters
     int maxNLIters, 
     int id_ini,
     int id_fin,
+    int nth,
     char* outPrefix, 
     double bval[]         /* (OUT) Bubble basis for {bp}. */
   );
@@ -71,6 +72,21 @@ void btc_bubble_nl_opt_adjust_parameters
     
     The goal function for non-linear optimization is the RMS error
     bewteen the modeled series and the given series, in log scale,
-    between the samples {id_ini} and {id_fin} inclusive. */
+    between the samples {id_ini} and {id_fin} inclusive. 
+    
+    The combinations of integer parameters are tried by {nth} threads
+    in parallel (one per available processor if {nth} is zero).  Each 
+    thread has its own copy of the parameters and basis, and its own
+    cache of basis columns (see {btc_bubble_basis_cache_t}).  Among trials 
+    with the same goal function value, the first one in the enumeration 
+    order is chosen.
+    
+    The simplex method used for the continuous parameters makes random
+    choices.  Each trial draws them from its own generator (see
+    {jsrandom_thread_seed}), whose seed depends only on the index of the
+    trial and on one value drawn with {uint32_random} at the start
+    (if {maxNLIters} is positive).
+    Therefore the result, and the state of {random} left for the caller,
+    do not depend on {nth} or on the scheduling of the threads. */
 
 #endif
@@ -1,5 +1,5 @@
 /* See {btc_price_series_local_fit_and_eval.h} */
-/* Last edited on 2015-04-20 01:23:04 by stolfilocal */
+/* Last edited on 2026-10-19 11:28:22 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <stdio.h>
@@ -40,18 +40,9 @@ double btc_price_series_local_fit_and_eval(int deg, int hrad, double val[], doub
           }
       }
     
-    if (A00 < 0.000001) { return 0.0; }
-
     /* Solve the system {A*c = b}: */
-    double det = A00*A11 - A01*A01;
-    if (fabs(det) < 1.0e-6) { return 0.0; }
-    /* Compute adjont of {A}: */
-    double M00 = A11; 
-    double M01 = -A01; 
-    double M11 = A00;
-    /* Compute the solution {c0,c1}: */
-    double c0 = (M00*b0 + M01*b1)/det;
-    double c1 = (M01*b0 + M11*b1)/det;
+    double c0, c1;
+    if (! btc_price_series_local_fit_solve(A00, A01, A11, b0, b1, &c0, &c1)) { return 0.0; }
     /* The fitted polynomial is {P(j) = c0 + c1*j}. */
 
     if (debug)
@@ -70,3 +61,26 @@ double btc_price_series_local_fit_and_eval(int deg, int hrad, double val[], doub
     return exp(c0);
   }
 
+bool_t btc_price_series_local_fit_solve
+  ( double A00, 
+    double A01, 
+    double A11, 
+    double b0, 
+    double b1, 
+    double *c0P, 
+    double *c1P
+  )
+  {
+    if (A00 < 0.000001) { return FALSE; }
+    double det = A00*A11 - A01*A01;
+    if (fabs(det) < 1.0e-6) { return FALSE; }
+    /* Compute adjont of {A}: */
+    double M00 = A11; 
+    double M01 = -A01; 
+    double M11 = A00;
+    /* Compute the solution {c0,c1}: */
+    (*c0P) = (M00*b0 + M01*b1)/det;
+    (*c1P) = (M01*b0 + M11*b1)/det;
+    return TRUE;
+  }
+
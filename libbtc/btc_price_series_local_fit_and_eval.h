@@ -2,7 +2,9 @@
 #define btc_price_series_local_fit_and_eval_H
 
 /* Local polynomial smoothing/interpolation of a BTC price series. */
-/* Last edited on 2015-04-20 00:39:27 by stolfilocal */
+/* Last edited on 2026-10-19 11:28:22 by stolfilocal */
+
+#include <bool.h>
     
 double btc_price_series_local_fit_and_eval(int deg, int hrad, double val[], double wht[]);
   /* Assumes that {val[0..nw-1]} and {wht[0..nw-1]} are 
@@ -11,5 +13,21 @@ double btc_price_series_local_fit_and_eval(int deg, int hrad, double val[], doub
     weight {wht[hrad+j]}, for {j} in {-hrad..+hrad}.  Then evaluates {exp(P(0))}.
     Returns 0.0 if there is not enough data to fit the polynomial. */
 
+bool_t btc_price_series_local_fit_solve
+  ( double A00, 
+    double A01, 
+    double A11, 
+    double b0, 
+    double b1, 
+    double *c0P, 
+    double *c1P
+  );
+  /* Solves the least squares system of a degree 1 fit {P(j) = c0 + c1*j},
+    given the weighted moments {A00 = SUM{w_j}}, {A01 = SUM{w_j*j}},
+    {A11 = SUM{w_j*j^2}}, {b0 = SUM{w_j*y_j}}, and {b1 = SUM{w_j*y_j*j}}
+    of the data points {(j,y_j)}.  If successful, stores the coefficients in 
+    {*c0P,*c1P} and returns TRUE.  Returns FALSE (leaving {*c0P,*c1P} 
+    unchanged) if there is not enough data to fit the line. */
+
 
 #endif
@@ -1,15 +1,125 @@
 /* See {btc_price_series_smooth.h} */
-/* Last edited on 2015-04-20 00:44:51 by stolfilocal */
+/* Last edited on 2026-10-19 11:28:22 by stolfilocal */
 
 #define _GNU_SOURCE
+#include <stdlib.h>
+#include <math.h>
 
-#include <btc_price_series_smooth.h>
-#include <btc_price_series_local_avg.h>
+#include <bool.h>
+#include <affirm.h>
+
+#include <btc_price_series_local_fit_and_eval.h>
 
+#include <btc_price_series_smooth.h>
 
 void btc_price_series_smooth(int nd, double vi[], int hrad, double vo[])
   {
+    demand(hrad >= 0, "invalid window radius");
     int id;
-    for (id = 0; id <= nd-1; id++)
-      { vo[id] = btc_price_series_local_avg(nd,vi,id,hrad); }
+    if (hrad == 0)
+      { for (id = 0; id < nd; id++) { vo[id] = vi[id]; }
+        return;
+      }
+
+    /* The result is the same as that of {btc_price_series_local_avg}
+      at each day {id}, namely the value at {j=0} of a line fitted to the
+      points {(j,log(vi[id+j]))} with Hann weights {w(j) = 0.5*(1 + cos(a*j))},
+      where {a = PI/(hrad+0.5)}.  The moments needed for the fit are
+      maintained incrementally as the window slides along the series.
+
+      The Hann weight is split as {w(j) = 0.5*(1 + Re(e^{I*a*j}))}.
+      For each quantity {f_r(j)} among {1, j, j^2, L, L*j}, where
+      {L = log(vi[id+j])}, we keep the sums {P[r] = SUM{f_r(j)}},
+      {C[r] = SUM{f_r(j)*cos(a*j)}}, and {S[r] = SUM{f_r(j)*sin(a*j)}},
+      over the non-missing samples in the window.  When the window
+      center advances by one day, the offset {j} of each sample decreases by
+      one; the new sums are linear combinations of the old ones, so the
+      update costs {O(1)} instead of {O(hrad)}. To limit the accumulation
+      of rounding errors, the sums are recomputed from scratch every
+      {2*hrad+1} days, so the total cost is {O(nd)}. */
+
+    int nf = 5; /* Number of quantities {f_r}. */
+    double P[nf], C[nf], S[nf];
+
+    /* Logs of the data values (0 where missing): */
+    double *lv = notnull(malloc((nd + 1)*sizeof(double)), "no mem");
+    for (id = 0; id < nd; id++) { lv[id] = (vi[id] > 0 ? log(vi[id]) : 0.0); }
+
+    /* Tables of {cos(a*j)} and {sin(a*j)} for {j} in {-hrad-1..+hrad}: */
+    int nt = 2*hrad + 2;
+    double a = M_PI/(hrad + 0.5);
+    double *cw = notnull(malloc(nt*sizeof(double)), "no mem");
+    double *sw = notnull(malloc(nt*sizeof(double)), "no mem");
+    int j;
+    for (j = -hrad-1; j <= hrad; j++)
+      { cw[hrad + 1 + j] = cos(a*j);
+        sw[hrad + 1 + j] = sin(a*j);
+      }
+    double ca = cos(a), sa = sin(a);
+
+    auto void add_sample(int kd, int jk, double sgn);
+      /* Adds to the sums {sgn} times the terms of day {kd}, assumed to
+        be at offset {jk} in the window. Ignores the day if it is outside
+        {0..nd-1} or its value is missing. */
+
+    void add_sample(int kd, int jk, double sgn)
+      { if ((kd < 0) || (kd >= nd) || (vi[kd] <= 0)) { return; }
+        double L = lv[kd];
+        double f[nf];
+        f[0] = 1; f[1] = jk; f[2] = ((double)jk)*jk; f[3] = L; f[4] = L*jk;
+        double cj = sgn*cw[hrad + 1 + jk];
+        double sj = sgn*sw[hrad + 1 + jk];
+        int r;
+        for (r = 0; r < nf; r++)
+          { P[r] += sgn*f[r]; C[r] += cj*f[r]; S[r] += sj*f[r]; }
+      }
+
+    auto void shift_sums(double X[]);
+      /* Replaces each sum {X[r] = SUM{f_r(j)*g(j)}} by {SUM{f_r(j-1)*g(j)}}. */
+
+    void shift_sums(double X[])
+      { X[2] = X[2] - 2*X[1] + X[0];
+        X[1] = X[1] - X[0];
+        X[4] = X[4] - X[3];
+      }
+
+    for (id = 0; id < nd; id++)
+      { if ((id % (2*hrad + 1)) == 0)
+          { /* Recompute the sums from scratch: */
+            int r;
+            for (r = 0; r < nf; r++) { P[r] = C[r] = S[r] = 0.0; }
+            for (j = -hrad; j <= hrad; j++) { add_sample(id + j, j, +1.0); }
+          }
+        else
+          { /* Move the window center from {id-1} to {id}: */
+            shift_sums(P);
+            shift_sums(C);
+            shift_sums(S);
+            int r;
+            for (r = 0; r < nf; r++)
+              { /* Multiply {C[r] + I*S[r]} by {e^{-I*a}}: */
+                double Cr = C[r], Sr = S[r];
+                C[r] = Cr*ca + Sr*sa;
+                S[r] = Sr*ca - Cr*sa;
+              }
+            add_sample(id - hrad - 1, -hrad - 1, -1.0);
+            add_sample(id + hrad, +hrad, +1.0);
+          }
+
+        /* Fit the line and evaluate it at the center: */
+        double A00 = 0.5*(P[0] + C[0]);
+        double A01 = 0.5*(P[1] + C[1]);
+        double A11 = 0.5*(P[2] + C[2]);
+        double b0 = 0.5*(P[3] + C[3]);
+        double b1 = 0.5*(P[4] + C[4]);
+        double c0, c1;
+        if (btc_price_series_local_fit_solve(A00, A01, A11, b0, b1, &c0, &c1))
+          { vo[id] = exp(c0); }
+        else
+          { vo[id] = 0.0; }
+      }
+
+    free(lv);
+    free(cw);
+    free(sw);
   }
@@ -1,12 +1,14 @@
 /* See rn_classif.h. */
-/* Last edited on 2017-01-04 19:07:50 by stolfilocal */
+/* Last edited on 2026-10-19 12:57:38 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <assert.h>
 
 #include <rn_classif.h>
+#include <rn_classif_nn_index.h>
 #include <filefmt.h>
 #include <bool.h>
 #include <affirm.h>
@@ -193,6 +195,22 @@ void rn_classif_find_nearest_neighbor_index(int NS, int NA, double p[], rn_class
 
 int rn_classif_find_nearest_in_dataset(rn_classif_dataset_t *M, double HM[], int NA, double p[], rn_classif_pq_dist_t *dist)
   {
+    if (dist == NULL)
+      { /* Euclidean distance, without callbacks: */
+        int imin = -1; double dmin = +INF;
+        int i;
+        for (i = 0; i < M->NS; i++)
+          { double *q = M->smp[i];
+            double sum = 0.0;
+            int t;
+            for (t = 0; t < NA; t++) { double dt = p[t] - q[t]; sum += dt*dt; }
+            double dpi = sqrt(sum);
+            if (HM != NULL) { dpi = fmax(dpi, HM[i]); }
+            if (dpi < dmin) { imin = i; dmin = dpi; }
+          }
+        return imin;
+      }
+
     auto double pi_dist(int NA, double p[], int i);
       /* Distance from {p} to {M->smp[i]} with handicap {HM[i]} if given. */
       
@@ -216,10 +234,22 @@ void rn_classif_nn_label_dataset
     int classM[],               /* {classM[i]} is the class of sample {M.smp[i]}. */
     rn_classif_dataset_t *C,    /* Sanples to be classified. */
     rn_classif_pq_dist_t *dist, /* Distance metric. */
+    int nth,                    /* Number of threads to use if {dist} is NULL. */
     int classC[]                /* (OUT) {classC{j]} is the class assigned to {C.smp[j]}. */
   )
   {
     demand(C->NA <= M->NA, "incompatible domain dimensions");
+    if (dist == NULL)
+      { /* Euclidean distance, use a search index and {nth} threads: */
+        rn_classif_nn_index_t *X = rn_classif_nn_index_new(M, C->NA, NULL, HM);
+        int *imin = notnull(malloc((C->NS + 1)*sizeof(int)), "no mem");
+        rn_classif_nn_index_find_nearest_many(X, C, nth, imin);
+        int j;
+        for (j = 0; j < C->NS; j++) { classC[j] = classM[imin[j]]; }
+        free(imin);
+        rn_classif_nn_index_free(X);
+        return;
+      }
     int j;
     for (j = 0; j < C->NS; j++)
       { double *p = C->smp[j];
@@ -295,7 +325,7 @@ void rn_classif_nn_improve
           { int i; for (i = 0; i < M->NS; i++) { HM[i] = 0; } } 
         else if (HM != NULL) 
           { hproc(M, classM, HM); }
-        rn_classif_nn_label_dataset(M, HM, classM, R, dist, classX);
+        rn_classif_nn_label_dataset(M, HM, classM, R, dist, 1, classX);
         int ns, nf;
         rn_classif_compare(R->NS, classR, classX, &ns, &nf);
         if (verbose) { fprintf(stderr, " nf = %6d (%5.1f)\n", nf, (100.0*nf)/R->NS ); }
@@ -1,5 +1,5 @@
 /* rn_classif.h --- tools for vector classifiers. */
-/* Last edited on 2010-05-25 04:18:09 by stolfi */
+/* Last edited on 2026-10-19 12:57:38 by stolfi */
 
 #ifndef rn_classif_H
 #define rn_classif_H
@@ -162,20 +162,33 @@ int rn_classif_find_nearest_in_dataset(rn_classif_dataset_t *M, double HM[], int
     {M.smp[i]} are closest to {p[0..NA-1]}, in the metric {dist}.
     Requires {NA<=M.NA}. If {HM} is not null it must be a vector of
     {M.NS} handicaps; the distance {dist} is then replced by
-    {DIST(p,M.smp[i]) = max(dist(p,M.smp[i]),HM[i])} */
+    {DIST(p,M.smp[i]) = max(dist(p,M.smp[i]),HM[i])}.
+    
+    If {dist} is NULL, the Euclidean metric is used, computed in line
+    rather than through a callback; the result is the same as with 
+    {dist = rn_dist}.  For many queries with the same {M} and {HM},
+    see {rn_classif_nn_index_t}. */
 
 void rn_classif_nn_label_dataset
   ( rn_classif_dataset_t *M,    /* Model samples. */
     double HM[],                /* {HM[i]} is the handicap of sample {M.smp[i]}. */
     int classM[],               /* {classM[i]} is the class of sample {M.smp[i]}. */
     rn_classif_dataset_t *C,    /* Samples to be classified. */
-    rn_classif_pq_dist_t *dist, /* Sample distance function. */
+    rn_classif_pq_dist_t *dist, /* Sample distance function, or NULL for Euclidean. */
+    int nth,                    /* Number of threads to use if {dist} is NULL. */
     int classC[]                /* (OUT) {classC{j]} is the class assigned to {C.smp[j]}. */
   );
   /* Calls {i = rn_classif_find_nearest_in_dataset(M,HM,M.NA,C.smp[j],dist)}
     for each sample {C.smp[j]} and sets {classC[j]} to {classM[i]}.
     The vectors {HM} and {classM} must have {M.NS} elements.
-    The vector {classC} must have {C.NS} elements. */
+    The vector {classC} must have {C.NS} elements. 
+    
+    If {dist} is NULL, the Euclidean metric is used, and the queries are 
+    answered with a {rn_classif_nn_index_t} built for {M,HM}, distributed
+    among {nth} threads (one per available processor if {nth} is zero).  
+    The result is the same as with {dist = rn_dist}, for any {nth}.  
+    If {dist} is not NULL, {nth} is ignored and the queries are
+    answered by the calling thread. */
 
 typedef void rn_classif_handicap_proc_t(rn_classif_dataset_t *M, int classM[], double HM[]);
   /* Type of a procedure that computes handicaps {HM[0..M.NS-1]} for a 1NN
@@ -188,7 +201,7 @@ void rn_classif_nn_improve
     rn_classif_dataset_t *R,    /* (IN/OUT) Training samples. */
     int classR[],               /* (IN/OUT) {classR[i]} is the given class of sample {R.smp[i]}. */
     int classX[],               /* (OUT) {classX[i]} is the class of {R.smp[i]} assigned by {M}. */
-    rn_classif_pq_dist_t *dist, /* Sample distance function. */
+    rn_classif_pq_dist_t *dist, /* Sample distance function, or NULL for Euclidean. */
     rn_classif_handicap_proc_t *hproc, /* Procedure that computes handicaps for {M}. */
     int maxIters,               /* Maximum iterations. */
     bool_t sameClass,           /* TRUE only swaps samples of the same class. */
@@ -0,0 +1,278 @@
+/* See rn_classif_nn_index.h. */
+/* Last edited on 2026-10-19 11:33:27 by stolfi */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsthread.h>
+
+#include <rn_classif.h>
+#include <rn_classif_nn_index.h>
+
+/* INTERNAL PROTOTYPES */
+
+int rn_classif_nn_index_build_node(rn_classif_nn_index_t *X, int ini, int fin, bool_t split);
+  /* Creates a node of the k-d tree of {X} for rows {ini..fin-1},
+    computes its box and handicap bound, and returns its index.
+    If {split} is true, and the node has more than
+    {rn_classif_nn_index_LEAF_SIZE} rows, also builds its subtrees,
+    rearranging the rows as needed. */
+
+void rn_classif_nn_index_select(rn_classif_nn_index_t *X, int ini, int fin, int mid, int t);
+  /* Rearranges the rows {ini..fin-1} of {X} so that row {mid} has the
+    value of attribute {t} that would be there if the rows were sorted by that
+    attribute; rows {ini..mid-1} have that attribute less than or equal
+    to it, and rows {mid+1..fin-1} greater than or equal to it. */
+
+void rn_classif_nn_index_swap_rows(rn_classif_nn_index_t *X, int a, int b);
+  /* Swaps rows {a} and {b} of {X}, with their indices and handicaps. */
+
+double rn_classif_nn_index_box_dist(rn_classif_nn_index_t *X, int n, double p[]);
+  /* Returns a lower bound for the distance {d(p,q)} from {p} to any row {q}
+    of node {n} of {X}, namely the distance from {p} to the node's box.
+    Does not consider the handicaps. */
+
+void rn_classif_nn_index_search(rn_classif_nn_index_t *X, int n, double p[], int *ibestP, double *dbestP);
+  /* Searches the subtree of {X} with root node {n} for a sample that
+    is closer to {p} than the current best {*ibestP,*dbestP}, and
+    updates these variables if found. */
+
+typedef struct rn_classif_nn_index_job_t
+  { rn_classif_nn_index_t *X;  /* The search index. */
+    rn_classif_dataset_t *C;   /* The query samples. */
+    int *imin;                 /* The results. */
+  } rn_classif_nn_index_job_t;
+  /* Arguments of {rn_classif_nn_index_find_nearest_range}. */
+
+void rn_classif_nn_index_find_nearest_range(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Answers the queries {C.smp[ini..fin]} of the job {(rn_classif_nn_index_job_t *)arg}. */
+
+/* IMPLEMENTATIONS */
+
+rn_classif_nn_index_t *rn_classif_nn_index_new(rn_classif_dataset_t *M, int NA, double wt[], double HM[])
+  {
+    demand((NA >= 0) && (NA <= M->NA), "invalid attribute count");
+    int NS = M->NS;
+    rn_classif_nn_index_t *X = notnull(malloc(sizeof(rn_classif_nn_index_t)), "no mem");
+    X->NS = NS;
+    X->NA = NA;
+    int t, k;
+    if (wt == NULL)
+      { X->wt = NULL; }
+    else
+      { X->wt = notnull(malloc((NA + 1)*sizeof(double)), "no mem");
+        for (t = 0; t < NA; t++)
+          { demand(wt[t] >= 0, "invalid attribute weight");
+            X->wt[t] = wt[t];
+          }
+      }
+    /* Copy the samples into the contiguous matrix: */
+    X->X = notnull(malloc(((size_t)NS*NA + 1)*sizeof(double)), "no mem");
+    X->ix = notnull(malloc((NS + 1)*sizeof(int)), "no mem");
+    for (k = 0; k < NS; k++)
+      { double *q = M->smp[k];
+        double *xk = &(X->X[(size_t)k*NA]);
+        for (t = 0; t < NA; t++) { xk[t] = q[t]; }
+        X->ix[k] = k;
+      }
+    if (HM == NULL)
+      { X->H = NULL; }
+    else
+      { X->H = notnull(malloc((NS + 1)*sizeof(double)), "no mem");
+        for (k = 0; k < NS; k++) { X->H[k] = HM[k]; }
+      }
+    /* Build the tree: */
+    int maxNN = 2*NS + 1;
+    X->node = notnull(malloc(maxNN*sizeof(rn_classif_nn_node_t)), "no mem");
+    X->box = notnull(malloc(((size_t)2*maxNN*NA + 1)*sizeof(double)), "no mem");
+    X->NN = 0;
+    bool_t split = (NA <= rn_classif_nn_index_MAX_TREE_DIM);
+    int root = rn_classif_nn_index_build_node(X, 0, NS, split);
+    assert(root == 0);
+    assert(X->NN <= maxNN);
+    return X;
+  }
+
+void rn_classif_nn_index_free(rn_classif_nn_index_t *X)
+  { if (X != NULL)
+      { if (X->wt != NULL) { free(X->wt); }
+        free(X->X);
+        free(X->ix);
+        if (X->H != NULL) { free(X->H); }
+        free(X->node);
+        free(X->box);
+        free(X);
+      }
+  }
+
+int rn_classif_nn_index_build_node(rn_classif_nn_index_t *X, int ini, int fin, bool_t split)
+  {
+    int NA = X->NA;
+    int n = X->NN; X->NN++;
+    rn_classif_nn_node_t *nd = &(X->node[n]);
+    nd->ini = ini;
+    nd->fin = fin;
+    nd->sub[0] = nd->sub[1] = -1;
+
+    /* Compute the box and the min handicap: */
+    double *bx = &(X->box[(size_t)2*NA*n]);
+    int t, k;
+    for (t = 0; t < NA; t++) { bx[2*t] = +INF; bx[2*t+1] = -INF; }
+    double Hmin = (X->H == NULL ? 0.0 : +INF);
+    for (k = ini; k < fin; k++)
+      { double *xk = &(X->X[(size_t)k*NA]);
+        for (t = 0; t < NA; t++)
+          { if (xk[t] < bx[2*t]) { bx[2*t] = xk[t]; }
+            if (xk[t] > bx[2*t+1]) { bx[2*t+1] = xk[t]; }
+          }
+        if ((X->H != NULL) && (X->H[k] < Hmin)) { Hmin = X->H[k]; }
+      }
+    nd->Hmin = Hmin;
+
+    if (split && (fin - ini > rn_classif_nn_index_LEAF_SIZE))
+      { /* Choose the axis {tmax} with largest weighted extent: */
+        int tmax = -1;
+        double emax = 0;
+        for (t = 0; t < NA; t++)
+          { double et = bx[2*t+1] - bx[2*t];
+            if (X->wt != NULL) { et = et*sqrt(X->wt[t]); }
+            if (et > emax) { tmax = t; emax = et; }
+          }
+        if (tmax >= 0)
+          { /* Split at the median along that axis: */
+            int mid = (ini + fin)/2;
+            rn_classif_nn_index_select(X, ini, fin, mid, tmax);
+            int sub0 = rn_classif_nn_index_build_node(X, ini, mid, split);
+            int sub1 = rn_classif_nn_index_build_node(X, mid, fin, split);
+            /* Note: {nd} is still valid since {X->node} is not reallocated. */
+            nd->sub[0] = sub0;
+            nd->sub[1] = sub1;
+          }
+      }
+    return n;
+  }
+
+void rn_classif_nn_index_select(rn_classif_nn_index_t *X, int ini, int fin, int mid, int t)
+  {
+    int NA = X->NA;
+    int lo = ini, hi = fin - 1;
+    while (hi > lo)
+      { /* Partition {lo..hi} around the value of the middle row: */
+        double v = X->X[(size_t)((lo + hi)/2)*NA + t];
+        int a = lo, b = hi;
+        while (a <= b)
+          { while (X->X[(size_t)a*NA + t] < v) { a++; }
+            while (X->X[(size_t)b*NA + t] > v) { b--; }
+            if (a <= b) { rn_classif_nn_index_swap_rows(X, a, b); a++; b--; }
+          }
+        /* Now rows {lo..b} are {<= v}, rows {a..hi} are {>= v}, rows {b+1..a-1} are {== v}: */
+        if (mid <= b)
+          { hi = b; }
+        else if (mid >= a)
+          { lo = a; }
+        else
+          { break; }
+      }
+  }
+
+void rn_classif_nn_index_swap_rows(rn_classif_nn_index_t *X, int a, int b)
+  {
+    if (a == b) { return; }
+    int NA = X->NA;
+    double *xa = &(X->X[(size_t)a*NA]);
+    double *xb = &(X->X[(size_t)b*NA]);
+    int t;
+    for (t = 0; t < NA; t++) { double tmp = xa[t]; xa[t] = xb[t]; xb[t] = tmp; }
+    { int tmp = X->ix[a]; X->ix[a] = X->ix[b]; X->ix[b] = tmp; }
+    if (X->H != NULL) { double tmp = X->H[a]; X->H[a] = X->H[b]; X->H[b] = tmp; }
+  }
+
+double rn_classif_nn_index_box_dist(rn_classif_nn_index_t *X, int n, double p[])
+  {
+    int NA = X->NA;
+    double *bx = &(X->box[(size_t)2*NA*n]);
+    double sum = 0.0;
+    int t;
+    for (t = 0; t < NA; t++)
+      { double gt = 0.0;
+        if (p[t] < bx[2*t])
+          { gt = bx[2*t] - p[t]; }
+        else if (p[t] > bx[2*t+1])
+          { gt = p[t] - bx[2*t+1]; }
+        double st = gt*gt;
+        if (X->wt != NULL) { st = X->wt[t]*st; }
+        sum += st;
+      }
+    return sqrt(sum);
+  }
+
+int rn_classif_nn_index_find_nearest(rn_classif_nn_index_t *X, double p[], double *dminP)
+  {
+    int ibest = -1;
+    double dbest = +INF;
+    if (X->NS > 0) { rn_classif_nn_index_search(X, 0, p, &ibest, &dbest); }
+    if (dminP != NULL) { (*dminP) = dbest; }
+    return ibest;
+  }
+
+void rn_classif_nn_index_search(rn_classif_nn_index_t *X, int n, double p[], int *ibestP, double *dbestP)
+  {
+    rn_classif_nn_node_t *nd = &(X->node[n]);
+    double lb = fmax(rn_classif_nn_index_box_dist(X, n, p), nd->Hmin);
+    if (lb > (*dbestP)) { return; }
+    if (nd->sub[0] < 0)
+      { /* Leaf node, scan its rows: */
+        int NA = X->NA;
+        double *wt = X->wt;
+        int k;
+        for (k = nd->ini; k < nd->fin; k++)
+          { double *xk = &(X->X[(size_t)k*NA]);
+            double sum = 0.0;
+            int t;
+            if (wt == NULL)
+              { for (t = 0; t < NA; t++) { double dt = p[t] - xk[t]; sum += dt*dt; } }
+            else
+              { for (t = 0; t < NA; t++) { double dt = p[t] - xk[t]; sum += wt[t]*dt*dt; } }
+            double d = sqrt(sum);
+            if (X->H != NULL) { d = fmax(d, X->H[k]); }
+            int i = X->ix[k];
+            if ((d < (*dbestP)) || ((d == (*dbestP)) && (i < (*ibestP))))
+              { (*ibestP) = i; (*dbestP) = d; }
+          }
+      }
+    else
+      { /* Visit the nearest child first: */
+        int s0 = nd->sub[0], s1 = nd->sub[1];
+        double d0 = rn_classif_nn_index_box_dist(X, s0, p);
+        double d1 = rn_classif_nn_index_box_dist(X, s1, p);
+        if (d1 < d0) { int tmp = s0; s0 = s1; s1 = tmp; }
+        rn_classif_nn_index_search(X, s0, p, ibestP, dbestP);
+        rn_classif_nn_index_search(X, s1, p, ibestP, dbestP);
+      }
+  }
+
+void rn_classif_nn_index_find_nearest_many
+  ( rn_classif_nn_index_t *X,
+    rn_classif_dataset_t *C,
+    int nth,
+    int imin[]
+  )
+  {
+    demand(C->NA >= X->NA, "incompatible domain dimensions");
+    rn_classif_nn_index_job_t job = (rn_classif_nn_index_job_t){ .X = X, .C = C, .imin = imin };
+    jsthread_run_ranges(C->NS, 64, nth, &rn_classif_nn_index_find_nearest_range, &job);
+  }
+
+void rn_classif_nn_index_find_nearest_range(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    rn_classif_nn_index_job_t *job = (rn_classif_nn_index_job_t *)arg;
+    int j;
+    for (j = ini; j <= fin; j++)
+      { job->imin[j] = rn_classif_nn_index_find_nearest(job->X, job->C->smp[j], NULL); }
+  }
@@ -0,0 +1,101 @@
+/* rn_classif_nn_index.h --- fast nearest-neighbor search for 1NN classifiers. */
+/* Last edited on 2026-10-19 11:33:27 by stolfi */
+
+#ifndef rn_classif_nn_index_H
+#define rn_classif_nn_index_H
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <math.h>
+
+#include <bool.h>
+
+#include <rn_classif.h>
+
+/*
+  These tools speed up the nearest-neighbor queries of
+  {rn_classif_find_nearest_in_dataset} when the distance is the
+  Euclidean metric, possibly with a weight on each attribute.
+
+  The model samples are copied into a contiguous {NS x NA} matrix,
+  whose rows are rearranged so that nearby samples are stored
+  together.  For small {NA}, the rows are also organized as a k-d
+  tree, so that a query only needs to examine a few of them.
+  The distances are computed by a tight loop over the matrix
+  instead of through a callback. */
+
+#define rn_classif_nn_index_MAX_TREE_DIM 16
+  /* The k-d tree is built only if {NA} is at most this much;
+    otherwise all rows are scanned, sequentially. */
+
+#define rn_classif_nn_index_LEAF_SIZE 8
+  /* Max number of rows in a leaf node of the k-d tree. */
+
+typedef struct rn_classif_nn_node_t
+  { int ini;       /* First row of the node. */
+    int fin;       /* Last row of the node plus one. */
+    int sub[2];    /* Indices of the children nodes, or -1 if leaf. */
+    double Hmin;   /* Minimum handicap of the rows {ini..fin-1}, or 0 if no handicaps. */
+  } rn_classif_nn_node_t;
+  /* A node of the k-d tree of a {rn_classif_nn_index_t}. */
+
+typedef struct rn_classif_nn_index_t
+  { int NS;          /* Number of model samples. */
+    int NA;          /* Number of attributes used in the distance. */
+    double *wt;      /* Attribute weights {wt[0..NA-1]}, or NULL. */
+    double *X;       /* Row {k} of the matrix is {X[k*NA + t]} for {t} in {0..NA-1}. */
+    int *ix;         /* {ix[k]} is the index in the dataset of the sample in row {k}. */
+    double *H;       /* {H[k]} is the handicap of row {k}, or NULL if none. */
+    int NN;          /* Number of nodes in the k-d tree. */
+    rn_classif_nn_node_t *node; /* The nodes of the tree; node 0 is the root. */
+    double *box;     /* The box of node {n} on axis {t} is {[box[2*(NA*n+t)] _ box[2*(NA*n+t)+1]]}. */
+  } rn_classif_nn_index_t;
+  /* A search structure for the first {NA} attributes of the samples
+    of some dataset {M}.
+
+    The distance from a vector {p[0..NA-1]} to sample {M.smp[i]} is
+    {DIST(p,i) = max(d(p,M.smp[i]),HM[i])}, where {HM[i]} is the handicap of
+    sample {i} (zero if not given) and {d(p,q)} is
+    {sqrt(SUM{wt[t]*(p[t] - q[t])^2 : t \in 0..NA-1})}.  If {wt} is NULL,
+    all weights are assumed to be 1, and {d} is the same as {rn_dist}.
+
+    Each node of the tree holds a contiguous range of rows of {X}.  An internal node
+    has two children that split its rows in two halves, by the median
+    value along the axis of maximum (weighted) extent.  The root
+    holds all rows. */
+
+rn_classif_nn_index_t *rn_classif_nn_index_new(rn_classif_dataset_t *M, int NA, double wt[], double HM[]);
+  /* Builds a search index for the first {NA} attributes of the samples
+    in {M}, with attribute weights {wt[0..NA-1]} (or unit weights if NULL) and
+    sample handicaps {HM[0..M.NS-1]} (or zero handicaps if NULL).
+    Requires {NA <= M.NA}.
+
+    The index has its own copy of the sample attributes, weights, and
+    handicaps, so it remains valid if {M}, {wt} or {HM} are changed later.
+    The cost is {O(NS*NA*log(NS))} time and {O(NS*NA)} space. */
+
+void rn_classif_nn_index_free(rn_classif_nn_index_t *X);
+  /* Deallocates all storage of {X} including the header {*X} itself. */
+
+int rn_classif_nn_index_find_nearest(rn_classif_nn_index_t *X, double p[], double *dminP);
+  /* Returns the index {i} of the sample that minimizes {DIST(p,i)}, and
+    stores that distance in {*dminP} (if not NULL).  If there are two
+    or more samples at the same minimum distance, returns the one with
+    smallest index {i}.  Returns -1 (and {+INF}) if the dataset is empty.
+
+    If {wt} was NULL when {X} was built, the result is the same as that of
+    {rn_classif_find_nearest_in_dataset(M,HM,NA,p,rn_dist)}. */
+
+void rn_classif_nn_index_find_nearest_many
+  ( rn_classif_nn_index_t *X,
+    rn_classif_dataset_t *C,
+    int nth,
+    int imin[]
+  );
+  /* Sets {imin[j] = rn_classif_nn_index_find_nearest(X,C.smp[j],NULL)} for
+    each {j} in {0..C.NS-1}.  Requires {C.NA >= X.NA}; only the first
+    {X.NA} attributes of each sample are used. The queries are
+    distributed among {nth} threads (one per available processor if
+    {nth} is zero). */
+
+#endif
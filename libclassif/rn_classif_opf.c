@@ -1,8 +1,9 @@
 /* See rn_classif_opf.h. */
-/* Last edited on 2010-05-24 02:58:38 by stolfi */
+/* Last edited on 2026-10-19 11:33:27 by stolfi */
 
 #define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <assert.h>
 
@@ -30,6 +31,17 @@ void rn_classif_opf_compute_handicaps
     auto double ijdist_homo(int i, int j);
       /* If {i} and {j} have the same class, returns {ijdist_full(i,j)}, else {+INF}. */
     
+    /* If {dist} is NULL, copy the samples into a contiguous matrix for speed: */
+    double *X = NULL; /* Attribute {t} of sample {i} is {X[i*NA + t]}. */
+    if (dist == NULL)
+      { X = notnull(malloc(((size_t)NS*NA + 1)*sizeof(double)), "no mem");
+        int i, t;
+        for (i = 0; i < NS; i++) 
+          { double *q = M->smp[i];
+            for (t = 0; t < NA; t++) { X[(size_t)i*NA + t] = q[t]; }
+          }
+      }
+    
     /* Output vectors for {opf_build_complete}: */
     int *P = notnull(malloc(NS*sizeof(int)), "no mem"); /* Predecessor map. */
     int *R = notnull(malloc(NS*sizeof(int)), "no mem"); /* Root map. */
@@ -53,11 +65,22 @@ void rn_classif_opf_compute_handicaps
     if (verbose) { rn_classif_nn_print_handicaps(stderr, "opf", NS, H); }
     free(P);
     free(R);
+    if (X != NULL) { free(X); }
 
     /* Local procedure implementations */
     
     double ijdist_full(int i, int j)
-      { double d = dist(NA, M->smp[i], M->smp[j]);
+      { double d;
+        if (X == NULL)
+          { d = dist(NA, M->smp[i], M->smp[j]); }
+        else
+          { /* Euclidean distance, same as {rn_dist}: */
+            double *xi = &(X[(size_t)i*NA]), *xj = &(X[(size_t)j*NA]);
+            double sum = 0.0;
+            int t;
+            for (t = 0; t < NA; t++) { double dt = xi[t] - xj[t]; sum += dt*dt; }
+            d = sqrt(sum);
+          }
         assert((! isnan(d)) && (d >= 0));
         if ((i != j) && (d == 0)) { d = 1.0e-200; }
         return d;
@@ -1,5 +1,5 @@
 /* rn_classif_opf.h --- tools for the optimum path forest classifier. */
-/* Last edited on 2010-05-25 03:07:34 by stolfi */
+/* Last edited on 2026-10-19 11:33:27 by stolfi */
 
 #ifndef rn_classif_opf_H
 #define rn_classif_opf_H
@@ -14,12 +14,15 @@
 void rn_classif_opf_compute_handicaps
   ( rn_classif_dataset_t *M,    /* Model samples. */
     int classM[],               /* {classM[i]} is the given class of {M.smp[i]}. */
-    rn_classif_pq_dist_t *dist, /* Sample distance function. */
+    rn_classif_pq_dist_t *dist, /* Sample distance function, or NULL for Euclidean. */
     double H[],                 /* (OUT) {H[i]} is the OPF handicap of sample {M.smp[i]}. */
     bool_t verbose              /* TRUE for diagnostic messages. */
   );
   /* Computes the OPF handicaps {H[0..M.NS-1]} for the 1NN 
     classifier {(M,H,classM)} as described in J. P. Papa, A. X. Falcao, 
-    C. T. N. Suzuki "Supervised Classification ..." (IJIST, 2009). */
+    C. T. N. Suzuki "Supervised Classification ..." (IJIST, 2009). 
+    
+    If {dist} is NULL, uses the Euclidean distance (same as {rn_dist}),
+    computed in line over a contiguous copy of the samples. */
 
 #endif
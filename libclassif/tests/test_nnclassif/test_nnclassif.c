@@ -5,7 +5,7 @@
 #define make_test_classif_data_C_COPYRIGHT \
   "Copyright  2010 by the State University of Campinas (UNICAMP)"
 
-/* Last edited on 2020-10-11 03:22:30 by jstolfi */
+/* Last edited on 2026-10-19 12:57:38 by jstolfi */
 
 #define PROG_HELP \
   "  " PROG_NAME " \\\n" \
@@ -237,6 +237,7 @@
 #include <math.h>
 
 #include <bool.h>
+#include <affirm.h>
 #include <argparser.h>
 #include <jsrandom.h>
 #include <jsfile.h>
@@ -538,7 +539,18 @@ void verify_dataset(problem_t *P, dataset_t *D, int classD[], char *nameD)
 int evaluate_nn_classifier(int NC, dataset_t *M, int classM[], double HM[], char *nameM, dataset_t *E, int classE[], char *nameE)
   {
     int *classEX = notnull(malloc(E->NS*sizeof(int)), "no mem");
-    rn_classif_nn_label_dataset(M, HM, classM, E, rn_dist, classEX);
+    rn_classif_nn_label_dataset(M, HM, classM, E, rn_dist, 1, classEX);
+    
+    /* Check the indexed Euclidean search against the brute-force one: */
+    int *classEY = notnull(malloc(E->NS*sizeof(int)), "no mem");
+    int nth[3] = { 1, 3, 0 };
+    int k, j;
+    for (k = 0; k < 3; k++)
+      { rn_classif_nn_label_dataset(M, HM, classM, E, NULL, nth[k], classEY);
+        for (j = 0; j < E->NS; j++)
+          { demand(classEY[j] == classEX[j], "indexed search gives a different class"); }
+      }
+    free(classEY);
     
     fprintf(stderr, "=== cross-classification of 1-NN(%s) on evaluation set %s ===\n", nameM, nameE);
     int *ncc;
@@ -1,5 +1,5 @@
 /* Procedures of {raut.h} that do not require access to the internal rep. */
-/* Last edited on 2009-10-29 21:21:58 by stolfi */
+/* Last edited on 2026-10-19 11:46:03 by stolfi */
 
 #include <stdio.h>
 #include <stdint.h>
@@ -107,6 +107,79 @@ raut_state_t raut_string_remove(raut_t *A, raut_state_t u, uint32_t nstr, rdag_s
     return do_remove(u, 0);
   }
 
+struct raut_builder_t
+  { raut_t *A;             /* The automaton. */
+    uint32_t np;           /* Length of the last string added. */
+    rdag_symbol_vec_t str; /* The last string added is {str.e[0..np-1]}. */
+    raut_state_vec_t st;   /* The states under construction are {st.e[0..np]}. */
+    bool_t empty;          /* TRUE if no string was added yet. */
+  };
+  /* The state {st.e[d]} has the arcs of the pending state at depth {d}
+    along the path spelled by {str.e[0..np-1]}, except the arc with 
+    input symbol {str.e[d]}, which will lead to {st.e[d+1]} once that
+    state is complete. */
+
+raut_builder_t *raut_builder_new(raut_t *A)
+  {
+    raut_builder_t *B = (raut_builder_t *)notnull(malloc(sizeof(raut_builder_t)), "no mem");
+    B->A = A;
+    B->np = 0;
+    B->str = rdag_symbol_vec_new(50);
+    B->st = raut_state_vec_new(51);
+    B->st.e[0] = raut_state_VOID;
+    B->empty = TRUE;
+    return B;
+  }
+
+void raut_builder_add_string(raut_builder_t *B, uint32_t nstr, rdag_symbol_t str[])
+  {
+    raut_t *A = B->A;
+    uint32_t np = B->np;
+    rdag_symbol_t *prev = B->str.e;
+    
+    /* Find the length {m} of the common prefix with the previous string: */
+    uint32_t m = 0;
+    while ((m < nstr) && (m < np) && (str[m] == prev[m])) { m++; }
+    if (! B->empty)
+      { if ((m == nstr) && (m == np)) { /* Repeated string: */ return; }
+        demand((m == np) || ((m < nstr) && (str[m] > prev[m])), "strings out of order");
+      }
+    
+    /* Complete the states beyond the common prefix, from the deepest one up: */
+    uint32_t d = np;
+    while (d > m)
+      { d--;
+        B->st.e[d] = raut_arc_set(A, B->st.e[d], prev[d], B->st.e[d+1]);
+      }
+    
+    /* Append the new states for the rest of {str}: */
+    rdag_symbol_vec_expand(&(B->str), nstr);
+    raut_state_vec_expand(&(B->st), nstr+1);
+    for (d = m; d < nstr; d++) 
+      { B->str.e[d] = str[d];
+        B->st.e[d+1] = raut_state_VOID;
+      }
+    B->st.e[nstr].ac = 1;
+    B->np = nstr;
+    B->empty = FALSE;
+  }
+
+raut_state_t raut_builder_finish(raut_builder_t *B)
+  {
+    uint32_t d = B->np;
+    while (d > 0)
+      { d--;
+        B->st.e[d] = raut_arc_set(B->A, B->st.e[d], B->str.e[d], B->st.e[d+1]);
+      }
+    raut_state_t u = B->st.e[0];
+    free(B->str.e);
+    free(B->st.e);
+    free(B);
+    return u;
+  }
+
+vec_typeimpl(raut_state_vec_t,raut_state_vec,raut_state_t);
+
 //CONST
 //    NullLetter = FIRST(rdag_basics.h.rdag_symbol_t);
 //    (*
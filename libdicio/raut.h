@@ -3,12 +3,13 @@
 
 #define raut_DESC "Reduced deterministic acyclic automata"
 
-/* Last edited on 2009-10-31 00:00:12 by stolfi */
+/* Last edited on 2026-10-19 11:46:03 by stolfi */
 /**/
 
 #include <stdint.h>
 
 #include <bool.h>
+#include <vec.h>
 #include <rdag.h>
 
 /*
@@ -40,6 +41,9 @@ typedef struct raut_state_t { rdag_symbol_t ac; rdag_node_t nd; } raut_state_t;
   /* A state of an automaton with node {nd}.  The field {ac} is either
     0 or 1. !!! Should use the encoding {(o,s) --> 2*s+o} !!!. */
 
+vec_typedef(raut_state_vec_t,raut_state_vec,raut_state_t);
+  /* A vector of states. */
+
 rdag_node_t raut_node_max(raut_t *A);
   /* The maximum node number currently valid in the automaton {A}.
     Cost: {O(1)} time, 0 space. */
@@ -196,6 +200,36 @@ raut_state_t raut_string_remove(raut_t *A, raut_state_t u, uint32_t nstr, rdag_s
 void raut_root_set(raut_t *A, raut_state_t u);
   /* Makes {u} the current root state of {A}.  Cost: {O(1)} time, 0 space. */
 
+/*
+  BUILDING FROM SORTED STRINGS: When the strings of a large language
+  are available in lexicographic order, the state that accepts them
+  can be built much faster with the following procedures than
+  by repeated calls to {raut_string_add}.  The builder keeps the 
+  states along the path spelled by the last string added, which
+  are still subject to change; every other state that it creates is
+  final, and is looked up in or added to {A} only once. The nodes created
+  are exactly those of the final state and its substates and successors,
+  so there is no need for {raut_crunch} afterwards. */
+
+typedef struct raut_builder_t raut_builder_t;
+  /* A builder of a state of an automaton from a sorted list of strings. */
+
+raut_builder_t *raut_builder_new(raut_t *A);
+  /* Creates a builder for a new state of {A}, whose suffix set 
+    is initially empty. */
+
+void raut_builder_add_string(raut_builder_t *B, uint32_t nstr, rdag_symbol_t str[]);
+  /* Adds the string {str[0..nstr-1]} to the suffix set of the state
+    being built by {B}.  The string must be lexicographically greater
+    than or equal to the previous string given to {B} (if equal, the
+    call has no effect).  Cost: {O(nstr)} time and space, apart from
+    expansion and rehashing of {A}. */
+
+raut_state_t raut_builder_finish(raut_builder_t *B);
+  /* Returns the state of {A} whose suffix set is the set of all 
+    strings given to {B}, and frees {B}.  The state is not made
+    the root of {A}. */
+
 /*
   VIRTUAL LINKS: When a state {u} of {A} lacks an output arc with a given input mark
   {i}, it is convenient to assume that it has a /virtual arc/ {(i,(0,NULL))},
@@ -3,7 +3,7 @@
 
 #define raut_def_DESC "Internal representation of {raut_t}"
 
-/* Last edited on 2009-10-28 23:42:37 by stolfi */
+/* Last edited on 2026-10-19 11:46:03 by stolfi */
 /**/
 
 #include <stdint.h>
@@ -18,6 +18,10 @@ struct raut_t
     raut_state_t root; /* The current root state. */
     rdag_t *D;              /* The underlying dag. */
     
+    /* Mapped file, if the automaton was obtained with {raut_map}: */
+    void *map_addr;         /* Start of the mapped region, or NULL if none. */
+    uint64_t map_size;      /* Size in bytes of the mapped region. */
+    
     /* Auxiliary data for finding prefixes: */
   };
   
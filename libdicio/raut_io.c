@@ -1,10 +1,15 @@
 /* See {raut_io.h}. */
-/* Last edited on 2019-04-09 13:02:20 by jstolfi */
+/* Last edited on 2026-10-19 11:46:03 by jstolfi */
 
 #include <stdio.h>
 #include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <affirm.h>
 #include <filefmt.h>
@@ -22,6 +27,21 @@
 
 #define raut_FILE_TYPE "raut_t"
 #define raut_FILE_VERSION "2009-10-28"
+
+#define raut_BINARY_MAGIC "raut_bin"
+  /* Magic string at the start of a binary file (exactly 8 bytes, without the NUL). */
+
+#define raut_BINARY_BOM ((uint32_t)0x01020304)
+  /* Byte-order mark of a binary file. */
+
+typedef struct raut_binary_header_t
+  { char magic[8];    /* The string {raut_BINARY_MAGIC}. */
+    uint32_t bom;     /* The value {raut_BINARY_BOM}. */
+    uint32_t root_ac; /* Accept bit of the root state. */
+    uint32_t root_nd; /* Node of the root state. */
+    uint32_t ndoc;    /* Length of the doc string, without the final NUL. */
+  } raut_binary_header_t;
+  /* The header of a binary automaton file. */
     
 void raut_write(FILE *wr, raut_t *A)
   { 
@@ -68,6 +88,8 @@ raut_t *raut_read(FILE *rd)
     A->root = (raut_state_t){ .ac = root_ac, .nd = root_nd };
     A->doc = doc;
     A->D = D;
+    A->map_addr = NULL;
+    A->map_size = 0;
     
     /* Read and check the file footer: */
     filefmt_read_footer(rd, raut_FILE_TYPE);
@@ -75,6 +97,79 @@ raut_t *raut_read(FILE *rd)
     return A;
   }
 
+void raut_write_binary(FILE *wr, raut_t *A)
+  {
+    assert(sizeof(raut_binary_header_t) == 24);
+    raut_state_t root = raut_root_get(A);
+    char *doc = raut_doc_get(A);
+    uint64_t ndoc = (doc == NULL ? 0 : strlen(doc));
+    demand(ndoc <= UINT32_MAX, "doc string is too long");
+    
+    /* Write the header: */
+    raut_binary_header_t hd;
+    memcpy(hd.magic, raut_BINARY_MAGIC, 8);
+    hd.bom = raut_BINARY_BOM;
+    hd.root_ac = root.ac;
+    hd.root_nd = root.nd;
+    hd.ndoc = (uint32_t)ndoc;
+    demand(fwrite(&hd, sizeof(hd), 1, wr) == 1, "write failed");
+    
+    /* Write the doc string, padded to a multiple of 8 bytes: */
+    if (ndoc > 0) { demand(fwrite(doc, 1, ndoc, wr) == ndoc, "write failed"); }
+    while ((ndoc % 8) != 0) { fputc('\000', wr); ndoc++; }
+    
+    /* Write the underlying dag: */
+    rdag_write_binary(wr, raut_dag_get(A));
+  }
+
+raut_t *raut_map(char *fname)
+  {
+    /* Map the whole file: */
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) { fprintf(stderr, "%s: cannot open file \"%s\"\n", __FUNCTION__, fname); }
+    demand(fd >= 0, "cannot open binary automaton file");
+    struct stat st;
+    demand(fstat(fd, &st) == 0, "cannot get the file size");
+    uint64_t nimg = (uint64_t)st.st_size;
+    demand(nimg >= sizeof(raut_binary_header_t), "file is too short");
+    void *addr = mmap(NULL, nimg, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    demand(addr != MAP_FAILED, "mmap failed");
+    (void)close(fd);
+    char *img = (char *)addr;
+    
+    /* Check the header: */
+    raut_binary_header_t *hd = (raut_binary_header_t *)img;
+    demand(memcmp(hd->magic, raut_BINARY_MAGIC, 8) == 0, "not a binary automaton file");
+    demand(hd->bom == raut_BINARY_BOM, "file has the wrong byte order");
+    demand(hd->root_ac <= 1, "invalid root class");
+    
+    /* Copy the doc string: */
+    uint64_t pos = sizeof(raut_binary_header_t);
+    uint64_t ndoc = hd->ndoc;
+    demand(pos + ndoc <= nimg, "file is truncated");
+    char *doc = NULL;
+    if (ndoc > 0)
+      { doc = (char *)notnull(malloc(ndoc + 1), "no mem");
+        memcpy(doc, img + pos, ndoc);
+        doc[ndoc] = '\000';
+      }
+    pos += (ndoc + 7)/8*8;
+    
+    /* Attach the dag: */
+    demand(pos <= nimg, "file is truncated");
+    rdag_t *D = rdag_binary_attach(img + pos, nimg - pos, NULL);
+    demand(hd->root_nd <= rdag_node_max(D), "invalid root node");
+    
+    /* Put it together: */
+    raut_t *A = (raut_t *)notnull(malloc(sizeof(raut_t)), "no mem");
+    A->root = (raut_state_t){ .ac = hd->root_ac, .nd = hd->root_nd };
+    A->doc = doc;
+    A->D = D;
+    A->map_addr = addr;
+    A->map_size = nimg;
+    return A;
+  }
+
 void raut_state_debug(FILE *wr, char* pref, raut_t *A, raut_state_t v, char *suff)
   {
     fprintf(wr, "%s%u", pref, v.ac);
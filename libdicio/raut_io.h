@@ -1,7 +1,7 @@
 #ifndef raut_io_H
 #define raut_io_H
 
-/* Last edited on 2009-10-29 20:57:57 by stolfi */
+/* Last edited on 2026-10-19 11:46:03 by stolfi */
 
 #include <stdio.h>
 #include <raut.h>
@@ -16,6 +16,29 @@ raut_t *raut_read(FILE *rd);
   /* Creates an autoamton from its description in {rd}. Assumes
     the same format used by {raut_write}. */
 
+/* BINARY AUTOMATON FILES
+
+  A /binary automaton file/ contains a 24-byte header with the magic
+  string "raut_bin", a byte-order mark, the root state, and the length
+  of the doc string; then the doc string, padded with zeros to a
+  multiple of 8 bytes; then the binary image of the underlying dag, as
+  written by {rdag_write_binary}. */
+ 
+void raut_write_binary(FILE *wr, raut_t *A);
+  /* Writes to {wr} a binary automaton file with the contents of {A}.
+    The file can be read back with {raut_map}. */
+    
+raut_t *raut_map(char *fname);
+  /* Maps the binary automaton file called {fname} into memory, with
+    {mmap}, and returns an automaton that uses the mapped node table
+    directly (see {rdag_binary_attach}).  The doc string is copied.
+
+    The cost is {O(1)} time apart from the mapping itself;
+    pages of the file are brought into memory only as they are
+    needed by {raut_arc_follow}, {raut_state_accepts}, etc.. The
+    mapping is private, so any changes to the automaton are not
+    written back to the file. The file is unmapped by {raut_free}. */
+
 /* MISCELLANEOUS */
 
 void raut_state_debug(FILE *wr, char* pref, raut_t *A, raut_state_t v, char *suff);
@@ -1,10 +1,11 @@
 /* Procedures of {raut.h} that require access to the internal rep. */
-/* Last edited on 2009-10-31 00:05:37 by stolfi */
+/* Last edited on 2026-10-19 11:46:03 by stolfi */
 
 #include <stdio.h>
 #include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 
 #include <affirm.h>
 #include <bool.h>
@@ -19,6 +20,8 @@ raut_t *raut_new(uint32_t nn, uint32_t ni, rdag_node_t max_alloc_node)
     A->D = rdag_new(nn, ni, 1, max_alloc_node);
     A->root = raut_state_VOID;
     A->doc = NULL;
+    A->map_addr = NULL;
+    A->map_size = 0;
     return A;
   }
 
@@ -225,5 +228,6 @@ void raut_expand(raut_t *A, rdag_node_t max_alloc_node)
 void raut_free(raut_t *A)
   { 
     rdag_free(A->D);
+    if (A->map_addr != NULL) { (void)munmap(A->map_addr, A->map_size); }
     free(A);
   }
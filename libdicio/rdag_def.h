@@ -3,7 +3,7 @@
 
 #define rdag_def_DESC "Private definitions of {rdag_t}"
 
-/* Last edited on 2009-10-29 13:07:45 by stolfi */
+/* Last edited on 2026-10-19 11:46:03 by stolfi */
 /**/
 
 #include <stdint.h>
@@ -26,6 +26,7 @@ struct rdag_t
     rdag_node_t max_node;       /* Max node currently in dag. */
     rdag_node_t max_alloc_node; /* Max node that can be stored without expansion. */
     rdag_node_packed_t *pk;     /* {pk[s-1]} is the packed data of proper node {s}. */
+    bool_t pk_shared;           /* TRUE iff {pk} points into storage not owned by the dag. */
     
     /* Node hash table to find nodes with given data (only for proper nodes): */
     uint32_t hash_size;  /* Size of hash table. */
@@ -54,7 +55,12 @@ struct rdag_t
     The {.hinit} vector has {.hash_size} entries.
     
     The valid nodes are {0 .. .max_node}. The attributes of proper
-    node {s} are stored in {pk[s-1]}, packed into a 64-bit word. */
+    node {s} are stored in {pk[s-1]}, packed into a 64-bit word. 
+    
+    If {.pk_shared} is TRUE, the {.pk} vector is part of a memory image
+    (e.g. a mapped file, see {rdag_binary_attach}); it is then never
+    {realloc}ed or {free}d by the dag procedures, and is replaced by
+    a private copy when the dag needs to be expanded. */
 
 /* LOW-LEVEL PROCEDURES */
 
@@ -1,10 +1,11 @@
 /* See {rdag_io.h}. */
-/* Last edited on 2017-01-04 18:01:18 by stolfilocal */
+/* Last edited on 2026-10-19 11:46:03 by stolfilocal */
 
 #include <stdio.h>
 #include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <affirm.h>
 #include <filefmt.h>
@@ -19,6 +20,23 @@
 #define rdag_FILE_TYPE "rdag_t"
 #define rdag_FILE_VERSION "2009-10-24"
 
+#define rdag_BINARY_MAGIC "rdag_bin"
+  /* Magic string at the start of a binary image (exactly 8 bytes, without the NUL). */
+
+#define rdag_BINARY_BOM ((uint32_t)0x01020304)
+  /* Byte-order mark of a binary image. */
+
+typedef struct rdag_binary_header_t
+  { char magic[8];    /* The string {rdag_BINARY_MAGIC}. */
+    uint32_t bom;     /* The value {rdag_BINARY_BOM}. */
+    uint32_t nn;      /* Bits per node number. */
+    uint32_t ni;      /* Bits per input mark. */
+    uint32_t no;      /* Bits per output mark. */
+    uint32_t max_node; /* Number of proper nodes. */
+    uint32_t pad;     /* Zero. */
+  } rdag_binary_header_t;
+  /* The header of a binary dag image. */
+
 void rdag_write(FILE *wr, rdag_t *D)
   {
     filefmt_write_header(wr, rdag_FILE_TYPE, rdag_FILE_VERSION);
@@ -77,6 +95,53 @@ rdag_t *rdag_read(FILE *rd)
     return D;
   }
 
+uint64_t rdag_binary_size(rdag_t *D)
+  {
+    return sizeof(rdag_binary_header_t) + ((uint64_t)D->max_node)*sizeof(rdag_node_packed_t);
+  }
+
+void rdag_write_binary(FILE *wr, rdag_t *D)
+  {
+    assert(sizeof(rdag_binary_header_t) == rdag_BINARY_HEADER_BYTES);
+    rdag_binary_header_t hd;
+    memcpy(hd.magic, rdag_BINARY_MAGIC, 8);
+    hd.bom = rdag_BINARY_BOM;
+    hd.nn = D->nn;
+    hd.ni = D->ni;
+    hd.no = D->no;
+    hd.max_node = D->max_node;
+    hd.pad = 0;
+    demand(fwrite(&hd, sizeof(hd), 1, wr) == 1, "write failed");
+    size_t nw = fwrite(D->pk, sizeof(rdag_node_packed_t), D->max_node, wr);
+    demand(nw == D->max_node, "write failed");
+    fflush(wr);
+  }
+
+rdag_t *rdag_binary_attach(char *img, uint64_t nimg, uint64_t *nusedP)
+  {
+    demand((((uintptr_t)img) % 8) == 0, "image is not aligned");
+    demand(nimg >= sizeof(rdag_binary_header_t), "image is too short");
+    rdag_binary_header_t *hd = (rdag_binary_header_t *)img;
+    demand(memcmp(hd->magic, rdag_BINARY_MAGIC, 8) == 0, "not a binary dag image");
+    demand(hd->bom == rdag_BINARY_BOM, "image has the wrong byte order");
+    
+    /* Create an empty dag with the proper bit widths: */
+    rdag_t *D = rdag_new(hd->nn, hd->ni, hd->no, 0);
+    demand(hd->max_node <= D->mask_node, "invalid max_node");
+    uint64_t nused = sizeof(rdag_binary_header_t) + ((uint64_t)hd->max_node)*sizeof(rdag_node_packed_t);
+    demand(nused <= nimg, "image is truncated");
+    
+    /* Point the node table to the image: */
+    D->pk = (rdag_node_packed_t *)(img + sizeof(rdag_binary_header_t));
+    D->pk_shared = TRUE;
+    D->max_node = hd->max_node;
+    D->max_alloc_node = hd->max_node;
+    D->hash_valid = FALSE;
+    
+    if (nusedP != NULL) { (*nusedP) = nused; }
+    return D;
+  }
+
 int rdag_line_read (FILE *rd, uint32_t *nbuf, char buf[], uint32_t nmax)
   {
     int c;
@@ -1,7 +1,7 @@
 #ifndef rdag_io_H
 #define rdag_io_H
 
-/* Last edited on 2009-10-28 17:53:42 by stolfi */
+/* Last edited on 2026-10-19 11:46:03 by stolfi */
 
 #include <stdio.h>
 #include <stdint.h>
@@ -18,6 +18,43 @@ void rdag_write(FILE *wr, rdag_t *D);
 rdag_t *rdag_read(FILE *rd);
   /* Reads from {rd} a dag, in the format used by {rdag_write}. */
 
+/* BINARY DAG IMAGES
+
+  A /binary image/ of a dag is a 32-byte header followed by the packed
+  node data {pk[0..max_node-1]} of {rdag_def.h}, as 64-bit words in the
+  native byte order.  The header contains the magic string "rdag_bin", a
+  byte-order mark, the bit widths {nn,ni,no}, and {max_node}; its size
+  and that of every node word are multiples of 8 bytes.  Therefore an image
+  that starts at an 8-byte aligned address (e.g. a file mapped with {mmap})
+  can be used in place, without copying the nodes or rebuilding the hash
+  tables. */
+
+#define rdag_BINARY_HEADER_BYTES 32
+  /* Size in bytes of the header of a binary dag image. */
+
+uint64_t rdag_binary_size(rdag_t *D);
+  /* Total size in bytes of the binary image of {D}. */
+
+void rdag_write_binary(FILE *wr, rdag_t *D);
+  /* Writes to {wr} the binary image of the dag {D}, namely
+    {rdag_binary_size(D)} bytes. Only the nodes {1..rdag_node_max(D)} are
+    written; the hash tables are not. */
+
+rdag_t *rdag_binary_attach(char *img, uint64_t nimg, uint64_t *nusedP);
+  /* Returns a dag whose nodes are those of the binary image in
+    {img[0..nimg-1]}, which must start at an 8-byte aligned address.
+    Stores in {*nusedP} (if not NULL) the number of bytes of the image,
+    so that any further data follows at {img[*nusedP]}.
+    
+    The node table of the new dag lives in the image itself, so the
+    cost is {O(1)} time and space, apart from the hash tables, which are
+    built only when a node is first looked up by its fields. The image
+    must remain valid until the dag is freed with {rdag_free}, which
+    does not reclaim it. The image is copied to private storage if
+    the dag needs to be expanded; nodes modified in place (e.g. by
+    {rdag_crunch}) are modified in the image. Only the sizes in the
+    header are checked, not the invariants of the dag. */
+
 /* STRING IO AND CLEANUP */
 
 int rdag_line_read (FILE *rd, uint32_t *nbuf, char buf[], uint32_t nmax);
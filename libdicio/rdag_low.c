@@ -1,5 +1,5 @@
 /* Procedures of {rdag.h} that require access to the internal rep. */
-/* Last edited on 2017-01-03 02:04:15 by jstolfi */
+/* Last edited on 2026-10-19 11:46:03 by jstolfi */
 
 #include <stdint.h>
 #include <stdio.h>
@@ -260,6 +260,7 @@ rdag_t *rdag_new(uint32_t nn, uint32_t ni, uint32_t no, rdag_node_t max_alloc_no
     /* Null data vector, to be allocated by {rdag-expand}: */
     D->max_alloc_node = 0; 
     D->pk = NULL;
+    D->pk_shared = FALSE;
     
     /* Null hash table, to be created by {rdag_rehash}: */
     D->hash_size = 0;
@@ -353,7 +354,16 @@ void rdag_expand(rdag_t *D, rdag_node_t max_alloc_node)
     
     /* Expand the old node data vector: */
     if (D->debug) { fprintf(stderr, "%s: old size = %u  new size = %u\n", __FUNCTION__, old_size, new_size); }
-    D->pk = (rdag_node_packed_t *)notnull(realloc(D->pk, new_size * sizeof(rdag_node_packed_t)), "no mem");
+    if (D->pk_shared)
+      { /* The node data is not ours, make a private copy: */
+        rdag_node_packed_t *pk = (rdag_node_packed_t *)notnull(malloc(new_size * sizeof(rdag_node_packed_t)), "no mem");
+        uint32_t k;
+        for (k = 0; k < D->max_node; k++) { pk[k] = D->pk[k]; }
+        D->pk = pk;
+        D->pk_shared = FALSE;
+      }
+    else
+      { D->pk = (rdag_node_packed_t *)notnull(realloc(D->pk, new_size * sizeof(rdag_node_packed_t)), "no mem"); }
     D->max_alloc_node = max_alloc_node;
     
     /* The hash tables are no longer valid: */
@@ -557,7 +567,7 @@ rdag_node_t rdag_node_from_data(rdag_t *D, rdag_node_data_t *dt)
 
 void rdag_free(rdag_t *D)
   {
-    free(D->pk);
+    if (! D->pk_shared) { free(D->pk); }
     free(D->hinit);
     free(D->hnext);
     free(D);
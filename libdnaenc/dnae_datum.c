@@ -1,5 +1,5 @@
 /* See {dnae_datum.h}. */
-/* Last edited on 2014-08-27 21:05:06 by stolfilocal */
+/* Last edited on 2026-10-19 13:26:15 by stolfilocal */
 
 #define dnae_datum_C_COPYRIGHT \
   "Copyright  2006  by the State University of Campinas (UNICAMP)"
@@ -18,6 +18,13 @@
 #include <dnae_datum.h>
 #include <dnae_seq.h>
 
+/* INTERNAL PROTOTYPES */
+
+void dnae_datum_window_decode(int n, dnae_datum_t f[], dnae_datum_scale_t *scale, double *tb, double v[]);
+  /* Decodes the datums {f[0..n-1]} with the scales {scale} and the
+    decoding table {tb} (as returned by {dnae_sample_decode_table}).
+    Stores sample {c} of datum {k} into {v[dnae_CHANNELS*k + c]}. */
+
 /* IMPLEMENTATIONS: */
 
 /* INTERPOLATION */
@@ -290,6 +297,158 @@ double dnae_datum_half_step_diffsq
     return iwT2/8;
   }
 
+/* COMPARING WINDOWS OF DATUMS */
+
+void dnae_datum_window_decode(int n, dnae_datum_t f[], dnae_datum_scale_t *scale, double *tb, double v[])
+  { double s0 = scale->f[0], s1 = scale->f[1], s2 = scale->f[2];
+    int k;
+    for (k = 0; k < n; k++)
+      { dnae_sample_enc_t *fk = f[k].c;
+        double *vk = &(v[dnae_CHANNELS*k]);
+        vk[0] = s0*tb[fk[0]];
+        vk[1] = s1*tb[fk[1]];
+        vk[2] = s2*tb[fk[2]];
+      }
+  }
+
+double dnae_datum_window_euc_distsq
+  ( int n,
+    dnae_datum_t fx[], 
+    dnae_datum_scale_t *xscale, 
+    dnae_datum_t fy[], 
+    dnae_datum_scale_t *yscale,
+    double w[]
+  )
+  { assert(dnae_CHANNELS == 3);
+    double *tb = dnae_sample_decode_table();
+    double xs0 = xscale->f[0], xs1 = xscale->f[1], xs2 = xscale->f[2];
+    double ys0 = yscale->f[0], ys1 = yscale->f[1], ys2 = yscale->f[2];
+    double sum = 0;
+    int k;
+    for (k = 0; k < n; k++)
+      { dnae_sample_enc_t *xk = fx[k].c, *yk = fy[k].c;
+        double d0 = xs0*tb[xk[0]] - ys0*tb[yk[0]];
+        double d1 = xs1*tb[xk[1]] - ys1*tb[yk[1]];
+        double d2 = xs2*tb[xk[2]] - ys2*tb[yk[2]];
+        double e = d0*d0 + d1*d1 + d2*d2;
+        sum += (w == NULL ? e : w[k]*e);
+      }
+    /* The invalid code decodes to {NAN}, which propagates to {sum}: */
+    demand(! isnan(sum), "invalid encoded value or weight");
+    return sum;
+  }
+
+double dnae_datum_window_diffsq
+  ( int n,
+    dnae_datum_t fx[], 
+    dnae_datum_scale_t *xscale, 
+    dnae_datum_t fy[], 
+    dnae_datum_scale_t *yscale,
+    double w[]
+  )
+  { assert(dnae_CHANNELS == 3);
+    double *tb = dnae_sample_decode_table();
+    double s0 = xscale->f[0]*yscale->f[0];
+    double s1 = xscale->f[1]*yscale->f[1];
+    double s2 = xscale->f[2]*yscale->f[2];
+    double sum = 0;
+    int k;
+    for (k = 0; k < n; k++)
+      { dnae_sample_enc_t *xk = fx[k].c, *yk = fy[k].c;
+        double p = s0*tb[xk[0]]*tb[yk[0]] + s1*tb[xk[1]]*tb[yk[1]] + s2*tb[xk[2]]*tb[yk[2]];
+        /* Same formula and clipping as in {dnae_datum_diffsq}: */
+        double T2 = 6 - 2*p;
+        if (T2 < 0) { T2 = 0; }
+        sum += (w == NULL ? T2 : w[k]*T2);
+      }
+    /* The invalid code decodes to {NAN}, which propagates to {sum}: */
+    demand(! isnan(sum), "invalid encoded value or weight");
+    return sum/8;
+  }
+
+void dnae_datum_window_slide_euc_distsq
+  ( int n,
+    dnae_datum_t fx[], 
+    dnae_datum_scale_t *xscale, 
+    int ny,
+    dnae_datum_t fy[], 
+    dnae_datum_scale_t *yscale,
+    double w[],
+    int smin,
+    int smax,
+    double d2[]
+  )
+  { if (smin > smax) { return; }
+    demand((smin >= 0) && (smax + n <= ny), "shift range exceeds the sequence {fy}");
+    assert(dnae_CHANNELS == 3);
+    double *tb = dnae_sample_decode_table();
+    /* Decode the window {fx} and the part of {fy} that will be used: */
+    int NC = dnae_CHANNELS;
+    int nv = smax - smin + n;
+    double *xv = notnull(malloc((NC*n + 1)*sizeof(double)), "no mem");
+    double *yv = notnull(malloc((NC*nv + 1)*sizeof(double)), "no mem");
+    dnae_datum_window_decode(n, fx, xscale, tb, xv);
+    dnae_datum_window_decode(nv, &(fy[smin]), yscale, tb, yv);
+    /* Replicate the weights for all channels: */
+    double *wv = notnull(malloc((NC*n + 1)*sizeof(double)), "no mem");
+    int k, j;
+    for (k = 0; k < n; k++)
+      { double wk = (w == NULL ? 1.0 : w[k]);
+        for (j = 0; j < NC; j++) { wv[NC*k + j] = wk; }
+      }
+    int s;
+    for (s = smin; s <= smax; s++)
+      { double *ys = &(yv[NC*(s - smin)]);
+        double sum = 0;
+        for (j = 0; j < NC*n; j++)
+          { double dj = xv[j] - ys[j]; sum += wv[j]*dj*dj; }
+        demand(! isnan(sum), "invalid encoded value or weight");
+        d2[s - smin] = sum;
+      }
+    free(xv);
+    free(yv);
+    free(wv);
+  }
+
+void dnae_datum_window_slide_diffsq
+  ( int n,
+    dnae_datum_t fx[], 
+    dnae_datum_scale_t *xscale, 
+    int ny,
+    dnae_datum_t fy[], 
+    dnae_datum_scale_t *yscale,
+    double w[],
+    int smin,
+    int smax,
+    double d2[]
+  )
+  { if (smin > smax) { return; }
+    demand((smin >= 0) && (smax + n <= ny), "shift range exceeds the sequence {fy}");
+    assert(dnae_CHANNELS == 3);
+    double *tb = dnae_sample_decode_table();
+    int NC = dnae_CHANNELS;
+    int nv = smax - smin + n;
+    double *xv = notnull(malloc((NC*n + 1)*sizeof(double)), "no mem");
+    double *yv = notnull(malloc((NC*nv + 1)*sizeof(double)), "no mem");
+    dnae_datum_window_decode(n, fx, xscale, tb, xv);
+    dnae_datum_window_decode(nv, &(fy[smin]), yscale, tb, yv);
+    int s, k;
+    for (s = smin; s <= smax; s++)
+      { double *ys = &(yv[NC*(s - smin)]);
+        double sum = 0;
+        for (k = 0; k < n; k++)
+          { double *xk = &(xv[NC*k]), *yk = &(ys[NC*k]);
+            double T2 = 6 - 2*(xk[0]*yk[0] + xk[1]*yk[1] + xk[2]*yk[2]);
+            if (T2 < 0) { T2 = 0; }
+            sum += (w == NULL ? T2 : w[k]*T2);
+          }
+        demand(! isnan(sum), "invalid encoded value or weight");
+        d2[s - smin] = sum/8;
+      }
+    free(xv);
+    free(yv);
+  }
+
 void dnae_datum_to_nucleic_densities(dnae_datum_t *d, dnae_datum_scale_t *dscale, double *A, double *T, double *C, double *G)
   { double d0 = dnae_sample_decode(d->c[0], dscale->f[0]);
     double d1 = dnae_sample_decode(d->c[1], dscale->f[1]);
@@ -2,7 +2,7 @@
 #define dnae_datum_H
 
 /* Numerical encoding of DNA/RNA bases */
-/* Last edited on 2014-08-27 20:56:14 by stolfilocal */
+/* Last edited on 2026-10-19 13:26:15 by stolfilocal */
 
 #define dnae_datum_H_COPYRIGHT \
   "Copyright  2006  by the State University of Campinas (UNICAMP)"
@@ -105,6 +105,76 @@ double dnae_datum_half_step_diffsq
     {dnae_datum_half_step_diffsq(fx0,fy0,fx1,fy1)} and
     {dnae_datum_half_step_diffsq(fx1,fy1,fx0,fy0)}. */
 
+/* COMPARING WINDOWS OF DATUMS
+
+  The functions in this section compare whole windows of {n}
+  consecutive datums, reading the encoded samples directly through
+  {dnae_sample_decode_table} instead of calling {dnae_sample_decode}
+  for each sample.  The optional weight {w[k]} applies to the datum
+  pair with index {k} in the window; if {w} is NULL, all weights are 1.
+  
+  Like {dnae_sample_decode}, these functions fail if any sample that
+  they read is not a valid code (i.e. is {dnae_sample_enc_VALID_MIN-1}).
+  The check is made on the sums, since that code decodes to {NAN}; so
+  they also fail if any weight is {NAN}. */
+
+double dnae_datum_window_euc_distsq
+  ( int n,
+    dnae_datum_t fx[], 
+    dnae_datum_scale_t *xscale, 
+    dnae_datum_t fy[], 
+    dnae_datum_scale_t *yscale,
+    double w[]
+  );
+  /* Returns {SUM{ w[k]*dnae_datum_euc_distsq(&(fx[k]),xscale,&(fy[k]),yscale) : k \in 0..n-1 }}. */
+
+double dnae_datum_window_diffsq
+  ( int n,
+    dnae_datum_t fx[], 
+    dnae_datum_scale_t *xscale, 
+    dnae_datum_t fy[], 
+    dnae_datum_scale_t *yscale,
+    double w[]
+  );
+  /* Returns {SUM{ w[k]*dnae_datum_diffsq(&(fx[k]),xscale,&(fy[k]),yscale) : k \in 0..n-1 }}. */
+
+void dnae_datum_window_slide_euc_distsq
+  ( int n,
+    dnae_datum_t fx[], 
+    dnae_datum_scale_t *xscale, 
+    int ny,
+    dnae_datum_t fy[], 
+    dnae_datum_scale_t *yscale,
+    double w[],
+    int smin,
+    int smax,
+    double d2[]
+  );
+  /* Compares the window {fx[0..n-1]} with the windows
+    {fy[s..s+n-1]} of the sequence {fy[0..ny-1]}, for every shift
+    {s} in {smin..smax}.  Namely, sets {d2[s-smin]} to
+    {dnae_datum_window_euc_distsq(n,fx,xscale,&(fy[s]),yscale,w)}.
+    Requires {0 <= smin} and {smax + n <= ny}; does nothing if {smin > smax}.
+    
+    Each datum of {fx} and {fy} is decoded only once, so the cost is
+    dominated by {(smax-smin+1)*n} multiply-adds over contiguous
+    arrays of {double}s. */
+
+void dnae_datum_window_slide_diffsq
+  ( int n,
+    dnae_datum_t fx[], 
+    dnae_datum_scale_t *xscale, 
+    int ny,
+    dnae_datum_t fy[], 
+    dnae_datum_scale_t *yscale,
+    double w[],
+    int smin,
+    int smax,
+    double d2[]
+  );
+  /* Same as {dnae_datum_window_slide_euc_distsq}, but sets {d2[s-smin]} to
+    {dnae_datum_window_diffsq(n,fx,xscale,&(fy[s]),yscale,w)}. */
+
 /* DATUM VECTORS */
 
 vec_typedef(dnae_datum_vec_t,dnae_datum_vec,dnae_datum_t);
@@ -1,5 +1,5 @@
 /* See {dnae_sample.h}. */
-/* Last edited on 2017-01-04 19:08:29 by stolfilocal */
+/* Last edited on 2026-10-19 11:44:00 by stolfilocal */
 
 #define dnae_sample_C_COPYRIGHT \
   "Copyright  2006  by the State University of Campinas (UNICAMP)"
@@ -112,6 +112,11 @@ dnae_sample_enc_t dnae_sample_encode(double dv, double scale)
     return (dnae_sample_enc_t)v;
   }
 
+double *dnae_sample_decode_table(void)
+  { if (dnae_decode_table == NULL) { dnae_decode_table_setup(); }
+    return dnae_decode_table + dnae_sample_BIAS;
+  }
+
 double dnae_sample_diffsq(dnae_sample_enc_t xs, double xscale, dnae_sample_enc_t ys, double yscale)
   { double D = dnae_sample_decode(xs, xscale) - dnae_sample_decode(ys, yscale);
     return D*D;
@@ -2,7 +2,7 @@
 #define dnae_sample_H
 
 /* Encoded of numerical signal samples */
-/* Last edited on 2014-06-14 01:42:04 by stolfilocal */
+/* Last edited on 2026-10-19 11:44:00 by stolfilocal */
 
 #define dnae_sample_H_COPYRIGHT \
   "Copyright  2006  by the State University of Campinas (UNICAMP)"
@@ -36,6 +36,13 @@ double dnae_sample_diffsq(dnae_sample_enc_t xs, double xscale, dnae_sample_enc_t
   /* Returns the abs difference squared between the samples,
     defined as {(dnae_sample_decode(xs, xscale) - dnae_sample_decode(ys, yscale))^2}. */
 
+double *dnae_sample_decode_table(void);
+  /* Returns a pointer {tb} to the internal decoding table, such that
+    {dnae_sample_decode(ev,scale) = scale*tb[ev]} for every valid
+    {ev}.  The entry {tb[ev]} is defined (and {NaN}) also for the
+    invalid code {ev = -2^15}.  Meant for inner loops that decode
+    many samples and cannot afford a function call per sample. */
+
 vec_typedef(dnae_sample_enc_vec_t,dnae_sample_enc_vec,dnae_sample_enc_t);
 /* Vector of {dnae_sample_enc_t}. */
 
@@ -0,0 +1,122 @@
+#define PROG_NAME "test_dnae_window"
+#define PROG_DESC "test of the window comparison routines of {dnae_datum.h}"
+#define PROG_VERS "1.0"
+
+/* Last edited on 2026-10-19 13:40:00 by stolfi */
+
+#define test_dnae_window_C_COPYRIGHT \
+  "Copyright \xa9 2026  by the State University of Campinas (UNICAMP)"
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <jsrandom.h>
+#include <affirm.h>
+
+#include <dnae_sample.h>
+#include <dnae_datum.h>
+
+int main(int argc, char**argv);
+
+void dm_test_windows(int n, int ny, int smin, int smax, bool_t weighted, bool_t raw);
+  /* Creates a random window {fx[0..n-1]} and a random sequence
+    {fy[0..ny-1]}, and compares {dnae_datum_window_euc_distsq},
+    {dnae_datum_window_diffsq}, {dnae_datum_window_slide_euc_distsq},
+    and {dnae_datum_window_slide_diffsq} at every shift {s} in
+    {smin..smax} with sums of {dnae_datum_euc_distsq} and
+    {dnae_datum_diffsq} over the window.  The {dnae_datum_euc_distsq}
+    values are in turn checked against sums of {dnae_sample_diffsq}.
+    If {weighted} is false, passes {w=NULL}.  If {raw} is true, the
+    datums are raw nucleotide vectors, otherwise they have random samples. */
+
+dnae_datum_t dm_random_datum(bool_t raw);
+  /* A random datum; either a raw nucleotide vector (if {raw} is true)
+    or a datum with random valid samples. */
+
+void dm_check_same(double a, double b, char *what, int s);
+  /* Fails with a message if {a} and {b} differ by more than rounding errors. */
+
+int main(int argc, char**argv)
+  { 
+    srandom(4615);
+    dm_test_windows(1, 1, 0, 0, FALSE, TRUE);
+    dm_test_windows(5, 20, 0, 15, FALSE, TRUE);
+    dm_test_windows(5, 20, 3, 9, TRUE, TRUE);
+    dm_test_windows(13, 100, 0, 87, TRUE, FALSE);
+    dm_test_windows(40, 60, 10, 20, FALSE, FALSE);
+    dm_test_windows(7, 30, 5, 4, TRUE, FALSE);
+    fprintf(stderr, "done.\n");
+    return 0;
+  }
+
+void dm_test_windows(int n, int ny, int smin, int smax, bool_t weighted, bool_t raw)
+  {
+    fprintf(stderr, "n = %d ny = %d shifts = %d..%d weighted = %c raw = %c\n", n, ny, smin, smax, "FT"[weighted], "FT"[raw]);
+    dnae_datum_t fx[n], fy[ny];
+    double w[n];
+    dnae_datum_scale_t xscale, yscale;
+    int k, c, s;
+    for (c = 0; c < dnae_CHANNELS; c++)
+      { xscale.f[c] = (raw ? 1.0 : 0.5 + drandom());
+        yscale.f[c] = (raw ? 1.0 : 0.5 + drandom());
+      }
+    for (k = 0; k < n; k++) { fx[k] = dm_random_datum(raw); w[k] = drandom(); }
+    for (k = 0; k < ny; k++) { fy[k] = dm_random_datum(raw); }
+    double *wp = (weighted ? w : NULL);
+    
+    int ns = smax - smin + 1;
+    double d2e[ns > 0 ? ns : 1], d2d[ns > 0 ? ns : 1];
+    dnae_datum_window_slide_euc_distsq(n, fx, &xscale, ny, fy, &yscale, wp, smin, smax, d2e);
+    dnae_datum_window_slide_diffsq(n, fx, &xscale, ny, fy, &yscale, wp, smin, smax, d2d);
+    for (s = smin; s <= smax; s++)
+      { /* Reference sums: */
+        double se = 0, sd = 0;
+        for (k = 0; k < n; k++)
+          { double wk = (weighted ? w[k] : 1.0);
+            double ek = dnae_datum_euc_distsq(&(fx[k]), &xscale, &(fy[s+k]), &yscale);
+            double ck = 0;
+            for (c = 0; c < dnae_CHANNELS; c++)
+              { ck += dnae_sample_diffsq(fx[k].c[c], xscale.f[c], fy[s+k].c[c], yscale.f[c]); }
+            dm_check_same(ek, ck, "dnae_datum_euc_distsq", s);
+            se += wk*ek;
+            sd += wk*dnae_datum_diffsq(&(fx[k]), &xscale, &(fy[s+k]), &yscale);
+          }
+        double we = dnae_datum_window_euc_distsq(n, fx, &xscale, &(fy[s]), &yscale, wp);
+        double wd = dnae_datum_window_diffsq(n, fx, &xscale, &(fy[s]), &yscale, wp);
+        dm_check_same(we, se, "dnae_datum_window_euc_distsq", s);
+        dm_check_same(wd, sd, "dnae_datum_window_diffsq", s);
+        dm_check_same(d2e[s-smin], se, "dnae_datum_window_slide_euc_distsq", s);
+        dm_check_same(d2d[s-smin], sd, "dnae_datum_window_slide_diffsq", s);
+      }
+  }
+
+dnae_datum_t dm_random_datum(bool_t raw)
+  {
+    dnae_datum_t d;
+    int c;
+    if (raw)
+      { /* One of the four nucleotide vectors: */
+        static double nv[4][3] = 
+          { { +1.0, +1.0, +1.0 }, { +1.0, -1.0, -1.0 }, { -1.0, +1.0, -1.0 }, { -1.0, -1.0, +1.0 } };
+        double *v = nv[int32_abrandom(0, 3)];
+        for (c = 0; c < dnae_CHANNELS; c++) { d.c[c] = dnae_sample_encode(v[c], 1.0); }
+      }
+    else
+      { for (c = 0; c < dnae_CHANNELS; c++) 
+          { d.c[c] = (dnae_sample_enc_t)int32_abrandom(dnae_sample_enc_VALID_MIN, dnae_sample_enc_VALID_MAX); }
+      }
+    return d;
+  }
+
+void dm_check_same(double a, double b, char *what, int s)
+  {
+    double tol = 1.0e-12*(fabs(a) + fabs(b)) + 1.0e-14;
+    if (fabs(a - b) > tol)
+      { fprintf(stderr, "  %s: s = %d  %24.16e  %24.16e\n", what, s, a, b);
+        demand(FALSE, "window routine does not match reference");
+      }
+  }
@@ -1,5 +1,5 @@
 /* See float_image.h */
-/* Last edited on 2020-11-06 03:00:39 by jstolfi */ 
+/* Last edited on 2026-10-19 12:16:30 by jstolfi */ 
 
 #define _GNU_SOURCE
 #include <limits.h>
@@ -23,6 +23,7 @@
 #include <bool.h>
 
 #include <float_image.h>
+#include <float_image_sat.h>
 
 /* IMPLEMENTATIONS */
 
@@ -587,6 +588,13 @@ void float_image_local_avg_var
     /* Get {A} size and check chennels: */
     int32_t NCA = (int32_t)A->sz[0];
     demand((cA >= 0) && (cA < NCA), "invalid {A} channel");
+    
+    /* If the weights are uniform, use summed-area tables: */
+    bool_t unif = (wt[0] > 0);
+    int32_t k;
+    for (k = 1; (k <= 2*hw) && unif; k++) { unif = (wt[k] == wt[0]); }
+    if (unif) { float_image_sat_local_avg_var(A, cA, hw, M, cM, V, cV, 1); return; }
+    
     int32_t NXA = (int32_t)A->sz[1]; 
     int32_t NYA = (int32_t)A->sz[2];
     /* Get {M} size and check chennels: */
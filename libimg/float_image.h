@@ -2,7 +2,7 @@
 #define float_image_H
 
 /* Multichannel images with floating-point samples. */
-/* Last edited on 2020-11-06 02:58:20 by jstolfi */ 
+/* Last edited on 2026-10-19 12:16:30 by jstolfi */ 
 
 #define _GNU_SOURCE_
 #include <stdio.h>
@@ -186,7 +186,11 @@ void float_image_local_avg_var
     This procedure may be used for smoothing. Although it is more
     expensive than FFT-based filtering, it does not assume that
     the image is periodic, and therefore does not suffer from
-    wrap-around spillover. */
+    wrap-around spillover.
+    
+    If the weights {wt[0..2*hw]} are all equal and positive, the
+    computation is delegated to {float_image_sat_local_avg_var},
+    whose cost does not depend on {hw}. */
 
 /* IMAGE GRADIENT */
 
@@ -1,13 +1,15 @@
 /* See {float_image_geostereo_multiscale.h}. */
-/* Last edited on 2017-06-25 04:55:23 by stolfilocal */
+/* Last edited on 2026-10-19 13:24:33 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <assert.h>
 #include <limits.h>
+#include <stdint.h>
 #include <string.h>
 #include <math.h>
  
 #include <bool.h>
+#include <jsprof.h>
 #include <float_image.h>
 #include <float_image_mscale.h>
 #include <float_image_geostereo_uniscale.h>
@@ -17,73 +19,176 @@
 #define ALPHA (0.5)
   /* Relative weight of higher-scale scores in total score. */
 
-float float_image_geostereo_interpolate(float sa, float sb, float sc, float sd, double fd);
+float float_image_geostereo_interpolate(float sa, float sb, float sc, float sd, int rd);
   /* Given four consecutive samples {sa,sb,sc,sd}, returns the interpolated 
-    image value at a point {fd} of the way between samples {sb} and {sc}.
-    Must be called with {fd} in {[0_1]} only. */
+    image value at a point {rd/3} of the way between samples {sb} and {sc}.
+    Must be called with {rd} in {1..2} only. */
+
+void float_image_geostereo_uniscale_displacement_map
+  ( float_image_t *f1,  /* Image 1. */
+    float_image_t *f2,  /* Image 2. */
+    int ncands,         /* Number of candidates to keep. */
+    int rx,             /* Window half-width. */
+    int ry,             /* Window half-height. */
+    int dmin,           /* Minimum signed displacement (pixels). */
+    int dmax,           /* Maximum signed displacement (pixels). */
+    float_image_t **fd, /* (OUT) Dispmap image. */
+    float_image_t **fs  /* (OUT) Scoremap image. */
+  );
+  /* Computes the dispmap and scoremap of {f1,f2} by trying every
+    displacement in {dmin..dmax}, adjusted by {-1/3..+1/3} pixels.
+    The displacements are stored in units of 1/3 pixel. */
+
+void float_image_geostereo_local_match
+  ( float_image_t *f1, /* Image 1. */
+    float_image_t *f2, /* Image 2. */
+    int x,             /* Central column (origin for displacement). */
+    int y,             /* Current row index in image. */
+    int dmin,          /* Min displacement, in 1/3 pixels. */
+    int dmax,          /* Max displacement, in 1/3 pixels. */
+    int rx,            /* Window half-width. */
+    int ry,            /* Window half-height. */
+    int *dbest,        /* Adjusted displacement, in 1/3 pixels. */
+    double *sbest,     /* Score (squared mismatch) for {dbest}. */
+    float *w1,         /* Buffer for image 1 window samples. */
+    float *w2          /* Buffer for image 2 window samples. */
+  );
+  /* Finds the displacement {*dbest} in {dmin..dmax} with least
+    normalized mismatch {*sbest} between the windows of {f1,f2}
+    around pixel {x,y}. */
+
+void float_image_geostereo_multiscale_get_samples
+  ( float_image_t *f,  /* Pixel row buffer for image 1. */
+    int x,             /* Central column (origin for displacement). */
+    int y,             /* Current row index in image. */
+    int d,             /* The displacement, in 1/3 pixels. */
+    int rx,            /* Window half-width. */
+    int ry,            /* Window half-height. */
+    float *w           /* (OUT) Window sample buffer. */
+  );
+  /* Extracts into {w} the samples of {f} in the window with half-sizes
+    {rx,ry} centered at column {x+d/3} of row {y}, interpolating if
+    {d} is not a multiple of 3.  Samples outside the image are {NAN}. */
+
+void float_image_geostereo_insert_disp(int d, float s, float *disp, float *scor, int nd);
+  /* Inserts displacement {d} with score {s} into the list 
+    {disp[0..nd-1],scor[0..nd-1]}, sorted by increasing score,
+    if it is better than the last one. */
+
+void float_image_geostereo_multiscale_debug_window(float *w, int rx, int ry, int NC);
+  /* Prints the window samples {w} to {stderr}. */
+
+void float_image_geostereo_multiscale_level
+  ( float_image_mscale_pyramid_t *P1,
+    float_image_mscale_pyramid_t *P2,
+    int k,
+    int ncands,
+    int rx,
+    int ry,
+    int dmin,
+    int dmax,
+    float_image_t **fd,
+    float_image_t **fs
+  );
+  /* Same as {float_image_geostereo_multiscale}, for
+    level {k} of the pyramids {P1,P2} of the two images, using the
+    remaining {P1.NL-k-1} levels for the multiscale search. 
+    Here {dmin,dmax} are integers. */
 
 void float_image_geostereo_normalize_samples(float w[], int npix, int NC);
   /* Independently normalizes each channel of the given samples {w[0..NC*npix-1]} to have
     mean 0 and unit variance. Ignores {NAN} samples. If all samples
     are equal, sets them all to 0. */
 
-void float_image_geostereo_multiscale_displacement_map
+void float_image_geostereo_multiscale
   ( float_image_t *f1,  /* Image 1. */
     float_image_t *f2,  /* Image 2. */
     int nscales,        /* Number of scales to consider (0 = uniscale). */
     int ncands,         /* Number of candidates to keep. */
     int rx,             /* Window half-width. */
     int ry,             /* Window half-height. */
-    int dmin,           /* Minimum signed displacement (pixels). */
-    int dmax,           /* Maximum signed displacement (pixels). */
+    double dmin,        /* Minimum signed displacement (pixels). */
+    double dmax,        /* Maximum signed displacement (pixels). */
+    int nth,            /* Number of threads for the pyramids (0 = one per processor). */
     float_image_t **fd, /* (OUT) Dispmap image. */
     float_image_t **fs  /* (OUT) Scoremap image. */
   )
   {
+    /* Build the pyramids of both images, with half-size reductions: */
+    jsprof_ENTER("pyramids");
+    int NL = (nscales <= 0 ? 1 : nscales + 1);
+    float_image_mscale_pyramid_t *P1 = float_image_mscale_pyramid_new(f1, NULL, NL, 1, 1, 3, FALSE, nth);
+    float_image_mscale_pyramid_t *P2 = float_image_mscale_pyramid_new(f2, NULL, NL, 1, 1, 3, FALSE, nth);
+    jsprof_LEAVE("pyramids");
+    
+    int idmin = (int)floor(dmin), idmax = (int)ceil(dmax);
+    float_image_geostereo_multiscale_level(P1, P2, 0, ncands, rx, ry, idmin, idmax, fd, fs);
+    
+    float_image_mscale_pyramid_free(P1);
+    float_image_mscale_pyramid_free(P2);
+  }
+
+void float_image_geostereo_multiscale_level
+  ( float_image_mscale_pyramid_t *P1,
+    float_image_mscale_pyramid_t *P2,
+    int k,
+    int ncands,
+    int rx,
+    int ry,
+    int dmin,
+    int dmax,
+    float_image_t **fd,
+    float_image_t **fs
+  )
+  {
+    float_image_t *f1 = P1->img[k];
+    float_image_t *f2 = P2->img[k];
+    int nscales = P1->NL - k - 1;
     int fNX = (int)f1->sz[1];
     int fNY = (int)f1->sz[2];
+    jsprof_ENTER("float_image_geostereo_multiscale");
+    jsprof_COUNT("pixels", ((int64_t)fNX)*fNY);
     if (nscales <= 0)
-      { float_image_geostereo_uniscale_displacement_map
+      { jsprof_ENTER("uniscale");
+        float_image_geostereo_uniscale_displacement_map
           ( f1, f2, 
             /* ncands: */ ncands, 
             /* rx,ry: */ rx,ry,  
             /* dmin,dmax: */ dmin, dmax,
             fd, fs
           );
+        jsprof_LEAVE("uniscale");
       }
     else
-      { /* Scale images to half-size: */
-        int gNX = (fNX+1)/2;
-        int gNY = (fNY+1)/2;
-        float_image_t *g1 = float_image_mscale_shrink(f1, NULL, gNX, gNY, 1, 1, 3);
-        float_image_t *g2 = float_image_mscale_shrink(f2, NULL, gNX, gNY, 1, 1, 3);
+      { /* The half-size images {g1,g2} are the next level of the pyramids: */
         float_image_t *gd;  /* Displacement map. */
         float_image_t *gs;  /* Score map. */
         
         /* Compute dispmaps for {g1,g2}, with twice as many cands: */
-        float_image_geostereo_multiscale_displacement_map
-          ( g1, g2,
-            /* nscales: */ nscales-1, 
+        float_image_geostereo_multiscale_level
+          ( P1, P2, k+1,
             /* ncands: */ 2*ncands,
             /* rx,ry: */ (rx-1)/2, (ry-1)/2,
             /* dmin,dmax: */ dmin/2, (dmax+1)/2,
             &gd, &gs
           );
-        float_image_free(g1); float_image_free(g2);
         
         /* Translate displacements, refine, keep {ncands} best ones: */
         /* !!! Check for 0.5 offset !!! */
+        jsprof_ENTER("refine");
         (*fd) = float_image_new(ncands, fNX, fNY);
         (*fs) = float_image_new(ncands, fNX, fNY);
         float_image_geostereo_refine_and_prune_displacement_map
           ( gd, gs, 
             f1, f2,
-            /* rx,ry: */ (rx-1)/2, (ry-1)/2,
+            /* rx,ry: */ rx, ry,
             /* dmin,dmax: */ dmin, dmax,
             (*fd), (*fs)
           );
         float_image_free(gd); float_image_free(gs);
+        jsprof_LEAVE("refine");
       }
+    jsprof_LEAVE("float_image_geostereo_multiscale");
   }
 
 #define HDEBUG 146
@@ -155,8 +260,8 @@ void float_image_geostereo_refine_and_prune_displacement_map
     float_image_t *f2,  /* Full-size image 2. */
     int rx,             /* Window half-width. */
     int ry,             /* Window half-height. */
-    int dmin,           /* Minimum signed displacement (pixels). */
-    int dmax,           /* Maximum signed displacement (pixels). */
+    double dmin,        /* Minimum signed displacement (pixels). */
+    double dmax,        /* Maximum signed displacement (pixels). */
     float_image_t *fd,  /* (OUT) Dispmap for full-size images. */
     float_image_t *fs   /* (OUT) Scoremap for full-size images. */
   )
@@ -237,7 +342,6 @@ void float_image_geostereo_local_match
   )
   { 
     int NC = (int)f1->sz[0];
-    int NX = (int)f1->sz[1];
     int npix = (2*rx+1)*(2*ry+1);
     int nsamp = npix*NC;
     int d;
@@ -247,18 +351,18 @@ void float_image_geostereo_local_match
       { double s = 0.0; 
         int nok = 0, i;
         if (debug) { fprintf(stderr, "    d = %d\n", d); }
-        float_image_geostereo_get_samples(f1, x, y, +d, rx, ry, w1);
-        float_image_geostereo_get_samples(f2, x, y, -d, rx, ry, w2);
+        float_image_geostereo_multiscale_get_samples(f1, x, y, +d, rx, ry, w1);
+        float_image_geostereo_multiscale_get_samples(f2, x, y, -d, rx, ry, w2);
         if (debug) 
-          { float_image_geostereo_debug_window(w1, rx, ry, NX); 
-            float_image_geostereo_debug_window(w2, rx, ry, NX);
+          { float_image_geostereo_multiscale_debug_window(w1, rx, ry, NC); 
+            float_image_geostereo_multiscale_debug_window(w2, rx, ry, NC);
           }
         /* Normalize samples for zero mean and unit variance: */
-        float_image_geostereo_normalize_samples(w1, npix, NX);
-        float_image_geostereo_normalize_samples(w2, npix, NX);
+        float_image_geostereo_normalize_samples(w1, npix, NC);
+        float_image_geostereo_normalize_samples(w2, npix, NC);
         if (debug) 
-          { float_image_geostereo_debug_window(w1, rx, ry, NX); 
-            float_image_geostereo_debug_window(w2, rx, ry, NX);
+          { float_image_geostereo_multiscale_debug_window(w1, rx, ry, NC); 
+            float_image_geostereo_multiscale_debug_window(w2, rx, ry, NC);
           }
         /* Compute discrepancy, ignoring missing samples: */
         for (i = 0; i < nsamp; i++) 
@@ -277,7 +381,7 @@ void float_image_geostereo_local_match
       }
   }
 
-void float_image_geostereo_get_samples
+void float_image_geostereo_multiscale_get_samples
   ( float_image_t *f,  /* Pixel row buffer for image 1. */
     int x,             /* Central column (origin for displacement). */
     int y,             /* Current row index in image. */
@@ -298,9 +402,9 @@ void float_image_geostereo_get_samples
     int ixlo = -1;
     int ixhi = (rd == 0 ? +1 : +2);
     for (iy = y-ry; iy <= y+ry; iy++)
-      { bool_t iyok = ((iy >= 0) || (iy < NY));
+      { bool_t iyok = ((iy >= 0) && (iy < NY));
         for (ix = x+id-rx; ix <= x+id+rx; ix++)
-          { bool_t ixok = ((ix+ixlo >= 0) || (ix+ixhi < NX));
+          { bool_t ixok = ((ix+ixlo >= 0) && (ix+ixhi < NX));
             for (ic = 0; ic < NC; ic++)
               { if (! (iyok && ixok)) 
                   { /* Out of bounds (partially or totally): */
@@ -330,19 +434,19 @@ void float_image_geostereo_normalize_samples(float *w, int npix, int NC)
       { double s; int nok;
         /* Shift so that mean of valid pixels is 0: */
         s = 0.0; nok = 0;
-        for (i = c; i < npix; i += NC) 
+        for (i = c; i < npix*NC; i += NC) 
           { double wi = w[i]; if (! isnan(wi)) { s += wi; nok++; } }
-        if (nok == 0) { return; }
+        if (nok == 0) { continue; }
         s /= (double)nok;
-        for (i = c; i < npix; i += NC)
+        for (i = c; i < npix*NC; i += NC)
           { if (! isnan(w[i])) { w[i] = (float)(w[i] - s); } }
         /* Scale so that variance of valid pixels is 1: */
         s = 0.0;
-        for (i = c; i < npix; i += NC)
+        for (i = c; i < npix*NC; i += NC)
           { double wi = w[i]; if (! isnan(wi)) { s += wi*wi; } }
         s = sqrt(s/(double)nok);
-        if (s == 0.0) { return; }
-        for (i = c; i < npix; i += NC) 
+        if (s == 0.0) { continue; }
+        for (i = c; i < npix*NC; i += NC) 
           { if (! isnan(w[i])) { w[i] = (float)(w[i]/s); } }
       }
   }
@@ -360,14 +464,14 @@ void float_image_geostereo_insert_disp(int d, float s, float *disp, float *scor,
   { int j;
     /* Should not be called twice for the same {d} in the same pixel. */
     if (s < scor[nd-1])
-      { j = nd;
+      { j = nd-1;
         while((j > 0) && (scor[j-1] > s))
           { disp[j] = disp[j-1]; scor[j] = scor[j-1]; j--; }
         disp[j] = (float)d; scor[j] = s;
       }
   }
 
-void float_image_geostereo_debug_window(float *w, int rx, int ry, int NC)
+void float_image_geostereo_multiscale_debug_window(float *w, int rx, int ry, int NC)
   {
     int c, x, y, k;
     k = 0;
@@ -2,7 +2,7 @@
 #define float_image_geostereo_multiscale_H
 
 /* Tools for multiscale geometric stereo reconstruction from image pairs. */
-/* Last edited on 2017-06-25 03:11:17 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:59:38 by stolfilocal */ 
 
 #define _GNU_SOURCE
 #include <stdio.h>
@@ -19,16 +19,21 @@ void float_image_geostereo_multiscale
     int ry,             /* Window half-height. */
     double dmin,        /* Minimum signed displacement (pixels). */
     double dmax,        /* Maximum signed displacement (pixels). */
+    int nth,            /* Number of threads for the pyramids (0 = one per processor). */
     float_image_t **fd, /* (OUT) Dispmap image. */
     float_image_t **fs  /* (OUT) Scoremap image. */
   );
-  /* Same as {float_image_geostereo_uniscale_displacement_map}, but uses a
+  /* Similar to {float_image_geostereo_uniscale}, but uses a
     multiscale search algorithm with {nscales} levels deep. (If
-    {nscales = 0}, uses uniscale search.)
+    {nscales = 0}, uses uniscale search.)  The displacements 
+    in {fd} are in units of 1/3 pixel.
     
     At each scale {k}, the procedure uses versions of {img1}
     and {img2} shrunk by a factor of {1/2^k} in both
-    directions.  !!! FINISH EXPLANATION !!! */
+    directions.  The shrunk images are the levels of pyramids
+    built with {float_image_mscale_pyramid_new}, using {nth} threads;
+    the rest of the search is done by the calling thread, so
+    the result does not depend on {nth}.  !!! FINISH EXPLANATION !!! */
   
 void float_image_geostereo_refine_and_prune_displacement_map
   ( float_image_t *gd,  /* Displacement map for halfsize images. */
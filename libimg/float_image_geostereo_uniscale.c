@@ -1,5 +1,5 @@
 /* See {float_image_geostereo.h}. */
-/* Last edited on 2017-06-26 19:37:15 by stolfilocal */
+/* Last edited on 2026-10-19 12:00:17 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <stdint.h>
@@ -12,7 +12,9 @@
 #include <bool.h>
 #include <affirm.h>
 #include <wt_table.h>
+#include <jsthread.h>
 #include <float_image.h>
+#include <float_image_interpolate.h>
 #include <float_image_geostereo.h>
 
 #include <float_image_geostereo_uniscale.h>
@@ -21,6 +23,32 @@
 #define VDEBUG 300
   /* Print debugging information for this pixel. */
 
+#define BAND_ROWS 16
+  /* Number of rows in each band of {float_image_geostereo_uniscale_volume}. */
+
+/* INTERNAL PROTOTYPES */
+
+typedef struct figv_job_t
+  { float_image_t *f1;  /* Image 1. */
+    float_image_t *f2;  /* Image 2. */
+    int32_t nwx;        /* Window width. */
+    int32_t nwy;        /* Window height. */
+    double *wtx;        /* Horizontal factors of window weights. */
+    double *wty;        /* Vertical factors of window weights. */
+    double dmin;        /* Minimum signed displacement (pixels). */
+    double dmax;        /* Maximum signed displacement (pixels). */
+    int32_t ncands;     /* Number of candidates to keep. */
+    float_image_t *fd;  /* (OUT) Dispmap image. */
+    float_image_t *fs;  /* (OUT) Scoremap image. */
+  } figv_job_t;
+  /* Arguments of {float_image_geostereo_uniscale_volume} for the threads. */
+
+void float_image_geostereo_uniscale_volume_band(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Computes the dispmap and scoremap of {float_image_geostereo_uniscale_volume} 
+    for the rows {ini..fin}. The argument {arg} must be the {figv_job_t} of the call. */
+
+/* IMPLEMENTATIONS */
+
 void float_image_geostereo_uniscale
   ( float_image_t *f1,  /* Image 1. */
     float_image_t *f2,  /* Image 2. */
@@ -90,3 +118,192 @@ void float_image_geostereo_uniscale
     free(smp1);
     free(smp2);
   }
+
+void float_image_geostereo_uniscale_volume
+  ( float_image_t *f1,  /* Image 1. */
+    float_image_t *f2,  /* Image 2. */
+    int32_t nwx,         /* Window width. */
+    int32_t nwy,         /* Window height. */
+    double dmin,         /* Minimum signed displacement (pixels). */
+    double dmax,         /* Maximum signed displacement (pixels). */
+    int32_t ncands,      /* Number of candidates to keep. */
+    int32_t nth,         /* Number of threads, or 0 for one per processor. */
+    float_image_t **fd,  /* (OUT) Dispmap image. */
+    float_image_t **fs   /* (OUT) Scoremap image. */
+  )
+  {
+    /* Get and check image and window sizes: */
+    int32_t NC, NX, NY;
+    float_image_get_size(f1 ,&NC, &NX, &NY);
+    float_image_check_size(f2, NC, NX, NY);
+    demand((nwx % 2) == 1, "window width must be odd");
+    demand((nwy % 2) == 1, "window height must be odd");
+    
+    /* Window pixel weight factors, as in {float_image_geostereo_uniscale}: */
+    double wtx[nwx]; wt_table_fill_binomial(nwx, wtx);
+    double wty[nwy]; wt_table_fill_binomial(nwy, wty);
+
+    /* Allocate dispmap and scoremap: */
+    (*fd) = float_image_new(ncands, NX, NY);
+    (*fs) = float_image_new(ncands, NX, NY);
+
+    /* Compute dispmap/scoremap by bands of rows: */
+    figv_job_t job = (figv_job_t)
+      { .f1 = f1, .f2 = f2, .nwx = nwx, .nwy = nwy, .wtx = wtx, .wty = wty, 
+        .dmin = dmin, .dmax = dmax, .ncands = ncands, .fd = (*fd), .fs = (*fs)
+      };
+    jsthread_run_ranges(NY, BAND_ROWS, nth, &float_image_geostereo_uniscale_volume_band, &job);
+  }
+
+void float_image_geostereo_uniscale_volume_band(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    figv_job_t *job = (figv_job_t *)arg;
+    float_image_t *f[2] = { job->f1, job->f2 };
+    int32_t NC, NX, NY;
+    float_image_get_size(job->f1 ,&NC, &NX, &NY);
+    int32_t hx = job->nwx/2, hy = job->nwy/2;
+    int32_t ncands = job->ncands;
+    double dmin = job->dmin, dmax = job->dmax;
+    
+    /* Displacements to consider, as in {float_image_geostereo_single_pixel_best}: */
+    int32_t idmin = (int32_t)ceil(3.0*dmin*0.99999999);
+    int32_t idmax = (int32_t)floor(3.0*dmax*1.00000001);
+    
+    /* Image {i} at displacement {sgn[i]*id/3} is image {i} at phase {r}, shifted by {k} pixels: */
+    int32_t sgn[2] = { +1, -1 };
+    auto void get_shift(int32_t i, int32_t id, int32_t *kP, int32_t *rP);
+      /* Sets {*kP,*rP} so that {sgn[i]*id = 3*(*kP) + (*rP)} with {*rP} in {0..2}. */
+    
+    void get_shift(int32_t i, int32_t id, int32_t *kP, int32_t *rP)
+      { int32_t t = sgn[i]*id;
+        int32_t r = ((t % 3) + 3) % 3;
+        (*kP) = (t - r)/3; (*rP) = r;
+      }
+
+    /* Rows {v0..v0+nv-1} are needed; columns {jlo..jlo+nj-1} at each phase: */
+    int32_t nb = fin - ini + 1;  /* Rows in band. */
+    int32_t v0 = ini - hy;
+    int32_t nv = nb + 2*hy;
+    int32_t nu = NX + 2*hx;      /* Window columns needed for each output row. */
+    int32_t kmin = INT32_MAX, kmax = INT32_MIN;
+    for (int32_t i = 0; i < 2; i++)
+      { for (int32_t e = 0; e < 2; e++)
+          { int32_t k, r;
+            get_shift(i, (e == 0 ? idmin : idmax), &k, &r);
+            if (k < kmin) { kmin = k; }
+            if (k > kmax) { kmax = k; }
+          }
+      }
+    int32_t jlo = kmin - hx;
+    int32_t nj = (NX + hx + kmax) - jlo;
+    
+    /* Interpolated images: {P[i][r][(v*nj + j)*NC + c]} is channel {c} of image {i} at
+      point {(jlo + j + r/3, v0 + v)}: */
+    double *P[2][3];
+    for (int32_t i = 0; i < 2; i++)
+      { for (int32_t r = 0; r < 3; r++)
+          { double *Pir = notnull(malloc(nv*nj*NC*sizeof(double)), "no mem");
+            for (int32_t v = 0; v < nv; v++)
+              { for (int32_t j = 0; j < nj; j++)
+                  { double x = (double)(jlo + j) + ((double)r)/3.0;
+                    double y = (double)(v0 + v);
+                    float_image_interpolate_pixel(f[i], x, y, 1, ix_reduction_SINGLE, &(Pir[(v*nj + j)*NC]));
+                  }
+              }
+            P[i][r] = Pir;
+          }
+      }
+    
+    /* Pixel costs {E[v*nu+u]} and valid sample counts {M[v*nu+u]} of column {u-hx}: */
+    double *E = notnull(malloc(nv*nu*sizeof(double)), "no mem");
+    double *M = notnull(malloc(nv*nu*sizeof(double)), "no mem");
+    /* Their horizontal window sums {HE[v*NX+x]}, {HM[v*NX+x]}: */
+    double *HE = notnull(malloc(nv*NX*sizeof(double)), "no mem");
+    double *HM = notnull(malloc(nv*NX*sizeof(double)), "no mem");
+    
+    /* Candidate search state for pixel {p = b*NX + x} of the band: */
+    int32_t np = nb*NX;
+    double *dprev = notnull(malloc(np*sizeof(double)), "no mem");
+    double *sprev = notnull(malloc(np*sizeof(double)), "no mem");
+    bool_t *mprev = notnull(malloc(np*sizeof(bool_t)), "no mem");
+    double *dbest = notnull(malloc(np*ncands*sizeof(double)), "no mem");
+    double *sbest = notnull(malloc(np*ncands*sizeof(double)), "no mem");
+    for (int32_t p = 0; p < np; p++)
+      { dprev[p] = NAN; sprev[p] = +INF; mprev[p] = FALSE;
+        for (int32_t k = 0; k < ncands; k++) { dbest[p*ncands + k] = -INF; sbest[p*ncands + k] = +INF; }
+      }
+    
+    for (int32_t id = idmin; id <= idmax; id++)
+      { double d = ((double)id)/3.0; /* Candidate displacement. */
+        if ((d < dmin) || (d > dmax)) { continue; }
+        int32_t k1, r1, k2, r2;
+        get_shift(0, id, &k1, &r1);
+        get_shift(1, id, &k2, &r2);
+        
+        /* Compute the pixel costs and their horizontal window sums: */
+        for (int32_t v = 0; v < nv; v++)
+          { double *p1 = &(P[0][r1][(v*nj + k1 - hx - jlo)*NC]);
+            double *p2 = &(P[1][r2][(v*nj + k2 - hx - jlo)*NC]);
+            double *Ev = &(E[v*nu]), *Mv = &(M[v*nu]);
+            for (int32_t u = 0; u < nu; u++)
+              { double sum_e2 = 0.0, sum_m = 0.0;
+                for (int32_t c = 0; c < NC; c++)
+                  { double s1 = p1[u*NC + c];
+                    bool_t ok1 = (!isnan(s1)) && (fabs(s1) != INF);
+                    double s2 = p2[u*NC + c];
+                    bool_t ok2 = (!isnan(s2)) && (fabs(s2) != INF);
+                    if (ok1 && ok2) { double e = s2 - s1; sum_e2 += e*e; sum_m += 1.0; }
+                  }
+                Ev[u] = sum_e2; Mv[u] = sum_m;
+              }
+            double *HEv = &(HE[v*NX]), *HMv = &(HM[v*NX]);
+            for (int32_t x = 0; x < NX; x++) { HEv[x] = 0.0; HMv[x] = 0.0; }
+            for (int32_t ix = 0; ix < job->nwx; ix++)
+              { double w = job->wtx[ix];
+                double *Eix = &(Ev[ix]), *Mix = &(Mv[ix]);
+                for (int32_t x = 0; x < NX; x++) { HEv[x] += w*Eix[x]; HMv[x] += w*Mix[x]; }
+              }
+          }
+        
+        /* Compute the scores of the band pixels and update their candidate lists: */
+        for (int32_t b = 0; b < nb; b++)
+          { for (int32_t x = 0; x < NX; x++)
+              { double sum_we2 = 0.0;
+                double sum_w = 0.0;
+                for (int32_t iy = 0; iy < job->nwy; iy++)
+                  { double w = job->wty[iy];
+                    sum_we2 += w*HE[(b + iy)*NX + x];
+                    sum_w += w*HM[(b + iy)*NX + x];
+                  }
+                double s = sum_we2/(sum_w + 1.0e-200);
+                int32_t p = b*NX + x;
+                /* If there are two or more successive cands with equal score, take the first one */ 
+                if (mprev[p] && (sprev[p] <= s))
+                  { /* Displacement {dprev} is a local minimum of score: */
+                    float_image_geostereo_queue_insert(dprev[p], sprev[p], ncands, &(dbest[p*ncands]), &(sbest[p*ncands]));
+                  }
+                mprev[p] = (s < sprev[p]);
+                dprev[p] = d;
+                sprev[p] = s;
+              }
+          }
+      }
+    
+    /* Check the last displacement for candidacy, store the candidates: */
+    for (int32_t b = 0; b < nb; b++)
+      { for (int32_t x = 0; x < NX; x++)
+          { int32_t p = b*NX + x;
+            double *dq = &(dbest[p*ncands]), *sq = &(sbest[p*ncands]);
+            if (mprev[p]) { float_image_geostereo_queue_insert(dprev[p], sprev[p], ncands, dq, sq); }
+            for (int32_t rk = 0; rk < ncands; rk++)
+              { float_image_set_sample(job->fd, rk, x, ini + b, (float)dq[rk]);
+                float_image_set_sample(job->fs, rk, x, ini + b, (float)sq[rk]);
+              }
+          }
+      }
+     
+    /* Free auxiliary storage: */
+    for (int32_t i = 0; i < 2; i++) { for (int32_t r = 0; r < 3; r++) { free(P[i][r]); } }
+    free(E); free(M); free(HE); free(HM);
+    free(dprev); free(sprev); free(mprev); free(dbest); free(sbest);
+  }
@@ -2,7 +2,7 @@
 #define float_image_geostereo_uniscale_H
 
 /* Tools for geometric stereo reconstruction from image pairs. */
-/* Last edited on 2017-06-26 01:53:48 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:55:42 by stolfilocal */ 
 
 #define _GNU_SOURCE
 #include <stdio.h>
@@ -61,4 +61,37 @@ void float_image_geostereo_uniscale
     The images {fd,fs} are allocated by the procedure, and retuned in
     {*fdP} and {*fsP}, if these are not {NULL}. */
 
+void float_image_geostereo_uniscale_volume
+  ( float_image_t *f1,   /* Image 1. */
+    float_image_t *f2,   /* Image 2. */
+    int32_t nwx,         /* Window width. */
+    int32_t nwy,         /* Window height. */
+    double dmin,         /* Minimum signed displacement (pixels). */
+    double dmax,         /* Maximum signed displacement (pixels). */
+    int32_t ncands,      /* Number of candidates to keep. */
+    int32_t nth,         /* Number of threads, or 0 for one per processor. */
+    float_image_t **fdP, /* (OUT) Dispmap image. */
+    float_image_t **fsP  /* (OUT) Scoremap image. */
+  );
+  /* Same as {float_image_geostereo_uniscale}, but much faster for
+    large images and displacement ranges.  The result is the same, 
+    apart from rounding errors.  Note that where the score is nearly 
+    constant over a range of displacements, those errors may create or
+    remove local minima, and so change the lesser candidates.
+    
+    Instead of extracting the two sampling windows of every pixel for
+    every displacement {d}, the procedure computes, for each {d}, the
+    squared mismatch of each pair of corresponding pixels (the /cost
+    volume/), and then the weighted window sums of those costs, by
+    convolution with the horizontal and vertical factors of the window
+    weights. Since the displacements {d} are multiples of {1/3}, the
+    images are interpolated only at three horizontal phases; every
+    displacement is then just a shift of one of those interpolated
+    images.  The cost is {O(NX*NY*ND*(NC+nwx+nwy))} instead of
+    {O(NX*NY*ND*NC*nwx*nwy)}, where {ND} is the number of displacements.
+
+    The image is processed in bands of consecutive rows, which are
+    distributed among {nth} threads.  The memory used by each band
+    is proportional to its area, not to {ND}. */
+
 #endif
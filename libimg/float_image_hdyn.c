@@ -1,14 +1,17 @@
 /* See {float_image_hdyn.h}. */
-/* Last edited on 2013-10-20 23:06:11 by stolfilocal */
+/* Last edited on 2026-10-19 12:45:41 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <assert.h>
 #include <limits.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
  
 #include <bool.h>
 #include <jsmath.h>
+#include <jsthread.h>
 #include <gauss_elim.h>
 #include <affirm.h>
 #include <sample_conv.h>
@@ -38,31 +41,102 @@ bool_t float_image_hdyn_check_convergence
     compares their logarithms instead. If {verbose} is TRUE, prints
     out the {name} and the largest change seen. */
 
-void float_image_hdyn_compute_avg_corr_and_weight
-  ( int c,               /* Channel. */
-    float_image_t *imgA, /* First image. */
-    double vminA,        /* Underexposed value of {imgA} */
-    double vmaxA,        /* Overexposed value of {imgA} */
-    double sigmaA,       /* Assumed deviation of noise in {imgA}. */
-    float_image_t *imgB, /* Second image. */
-    double vminB,        /* Underexposed value of {imgB} */
-    double vmaxB,        /* Overexposed value of {imgB} */
-    double sigmaB,       /* Assumed deviation of noise in {imgB}. */
-    bool_t verbose,      /* TRUE to print out detailed diagnostics. */
-    double *MAP,         /* (OUT) Mean value of {imgA} image on common pixels. */
-    double *MBP,         /* (OUT) Mean value of {imgB} image on common pixels. */
-    double *CP,          /* (OUT) Regression coef of {imgA} rel to {imgB} on common pixels. */
-    double *WP           /* (OUT) Fuzzy count of common pixels. */
+#define float_image_hdyn_BAND_ROWS 16
+  /* Number of image rows in each band of the parallel passes. */
+
+typedef struct fihd_job_t
+  { int NI;                /* Number of input images. */
+    float_image_t **img;   /* Input images. */
+    int c0;                /* First channel to process. */
+    int nc;                /* Number of channels to process. */
+    double *vmin;          /* {vmin[k*NI+i]} is the underexposed value of channel {c0+k} of image {i}. */
+    double *vmax;          /* Same, for the overexposed value. */
+    double *gain;          /* Same, for the gain. */
+    double *offset;        /* Same, for the value offset. */
+    double *sigma;         /* Same, for the noise deviation. */
+    double *PM;            /* Pair means, as in {float_image_hdyn_compute_pair_stats}. */
+    float_image_t *omg;    /* Estimated true values. */
+    int NS;                /* Number of partial sums per band. */
+    double *S;             /* The partial sums of band {b} are {S[b*NS..b*NS+NS-1]}. */
+  } fihd_job_t;
+  /* Data for the parallel passes over channels {c0..c0+nc-1} of the images. */
+
+void float_image_hdyn_run_bands(fihd_job_t *job, int NS, int nth, jsthread_range_proc_t *proc, double tot[]);
+  /* Splits the image rows into bands of {float_image_hdyn_BAND_ROWS} rows,
+    and calls {proc(job,ith,ini,fin)} for all band index ranges,
+    with {nth} threads. If {NS} is positive, {proc} must accumulate
+    {NS} partial sums for each band {b} into {job->S[b*NS..b*NS+NS-1]},
+    which are initially zero; on return, {tot[s]} is the sum of partial 
+    sum {s} over all bands, added in band order. */
+
+void float_image_hdyn_check_images(int c0, int nc, int NI, float_image_t *img[], float_image_t *omg);
+  /* Checks that {NI} is positive, that all images {img[0..NI-1]} and {omg}
+    (if not NULL) have the same number of columns and rows as {img[0]},
+    and that each of them has channels {c0..c0+nc-1}. */
+
+void float_image_hdyn_get_rows(fihd_job_t *job, int k, int y, float *rp[], ix_step_t sx[]);
+  /* Sets {rp[i]} to the address of sample {[c0+k,0,y]} of each image {img[i]},
+    and {sx[i]} to the position step between consecutive columns. */
+
+void float_image_hdyn_compute_pair_stats
+  ( fihd_job_t *job,
+    int nth,
+    double PM[],
+    double PC[],
+    double PW[]
   );
-  /* This procedure assigns to each pixel {x,y} a weight that is 1 iff
-    the values of {imgA,imgB} are well away from 0 and 1, assuming
-    noise with deviations {sigmaA,sigmaB}, respectively.
-    
-    Computes the weighted averages {*MAP} and {*MBP} of the values
-    {imgA} and {imgB}, respectively. It also returns in {*WP} the sum
-    of those weights, and in {*CP} the weighted linear regression
-    coefficient {C} for the model {(imgA-MA) = C*(imgB-MB)}, which 
-    may be 0, {INF}, or {NAN}. */
+  /* For each channel {c0+k} and each pair of images {i,j} with {j <= i},
+    consider the pixels that are well-exposed in both images.  Computes the mean values 
+    {Mij=PM[2*q]} and {Mji=PM[2*q+1]} of images {i} and {j} over those pixels,
+    the regression coefficient {Cij=PC[q]} for the model {(V[i]-Mij) = Cij*(V[j]-Mji)}
+    (which may be 0, {INF}, or {NAN}), and the fuzzy count {Wij=PW[q]} of those
+    pixels; where {q = k*NP + p}, {NP = NI*(NI+1)/2} and {p = i*(i+1)/2 + j}. */
+
+void float_image_hdyn_pair_sums_bands(void *arg, int32_t ith, int32_t ini, int32_t fin);
+void float_image_hdyn_pair_corr_bands(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Band procedures for the first pass (counts and means) and 
+    second pass (regression) of {float_image_hdyn_compute_pair_stats}. */
+
+void float_image_hdyn_gains_offsets_from_stats
+  ( int NI,
+    double PM[],
+    double PC[],
+    double PW[],
+    double vmin[],
+    double vmax[],
+    bool_t verbose,
+    double gain[],
+    double offset[]
+  );
+  /* Estimates {gain[0..NI-1]} and {offset[0..NI-1]} of one channel
+    from the pair statistics {PM,PC,PW} of that channel (as computed
+    by {float_image_hdyn_compute_pair_stats}, with {k=0}). */
+
+void float_image_hdyn_values_bands(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Band procedure for {float_image_hdyn_estimate_values}. */
+
+void float_image_hdyn_sigmas_bands(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Band procedure for {float_image_hdyn_estimate_sigmas}. */
+
+void float_image_hdyn_estimate_gains_offsets_chans
+  ( int c0, int nc, int NI, float_image_t *img[], double vmin[], double vmax[], 
+    double sigma[], int nth, bool_t verbose, double gain[], double offset[]
+  );
+void float_image_hdyn_estimate_values_chans
+  ( int c0, int nc, int NI, float_image_t *img[], double vmin[], double vmax[],
+    double gain[], double offset[], double sigma[], int nth, bool_t verbose, float_image_t *omg
+  );
+void float_image_hdyn_estimate_sigmas_chans
+  ( int c0, int nc, int NI, float_image_t *img[], double vmin[], double vmax[],
+    double gain[], double offset[], float_image_t *omg, int nth, bool_t verbose, double sigma[]
+  );
+void float_image_hdyn_estimate_gains_offsets_sigmas_values_chans
+  ( int c0, int nc, int NI, float_image_t *img[], double vmin[], double vmax[], 
+    int nth, bool_t verbose, double gain[], double offset[], double sigma[], float_image_t *omg
+  );
+  /* Same as the public procedures without the "_chans" suffix, but
+    process channels {c0..c0+nc-1}.  The parameters of channel {c0+k}
+    of image {i} are {vmin[k*NI+i]}, {gain[k*NI+i]}, etc. */
 
 void float_image_hdyn_print_system(FILE *wr, int m, int n, double A[], int p, double B[]);
   /* Prints to {wr} the matrix {A} with {m} rows and {n} columns, side 
@@ -106,6 +180,7 @@ void float_image_hdyn_estimate_gains_offsets_sigmas_values
     float_image_t *img[], /* Input images. */
     double vmin[],        /* Value of underexposed pixels. */
     double vmax[],        /* Value of overexposed pixels. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
     bool_t verbose,       /* TRUE for diagnostics. */
     double gain[],        /* (OUT) Estimated gain of each image. */
     double offset[],      /* (OUT) Estimated value offset of each image. */
@@ -113,17 +188,46 @@ void float_image_hdyn_estimate_gains_offsets_sigmas_values
     float_image_t *omg    /* (OUT) Estimated true values. */
   )
   {
+    float_image_hdyn_estimate_gains_offsets_sigmas_values_chans
+      ( c, 1, NI, img, vmin, vmax, nth, verbose, gain, offset, sigma, omg );
+  }
+
+void float_image_hdyn_estimate_all_channels
+  ( int NI,               /* Number of input images. */
+    float_image_t *img[], /* Input images. */
+    double vmin[],        /* Value of underexposed pixels, per channel and image. */
+    double vmax[],        /* Value of overexposed pixels, per channel and image. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
+    bool_t verbose,       /* TRUE for diagnostics. */
+    double gain[],        /* (OUT) Estimated gain, per channel and image. */
+    double offset[],      /* (OUT) Estimated value offset, per channel and image. */
+    double sigma[],       /* (OUT) Estimated noise deviation, per channel and image. */
+    float_image_t *omg    /* (OUT) Estimated true values. */
+  )
+  {
+    int NC = (int)img[0]->sz[0];
+    float_image_hdyn_estimate_gains_offsets_sigmas_values_chans
+      ( 0, NC, NI, img, vmin, vmax, nth, verbose, gain, offset, sigma, omg );
+  }
+
+void float_image_hdyn_estimate_gains_offsets_sigmas_values_chans
+  ( int c0, int nc, int NI, float_image_t *img[], double vmin[], double vmax[], 
+    int nth, bool_t verbose, double gain[], double offset[], double sigma[], float_image_t *omg
+  )
+  {
+    float_image_hdyn_check_images(c0, nc, NI, img, omg);
+    int NK = nc*NI; /* Number of parameters of each kind. */
     /* Initial guess for {sigmas}: */
     int i;
-    for (i = 0; i < NI; i++) { sigma[i] = 0.003; /* About right for 8-bit quantization */ }
+    for (i = 0; i < NK; i++) { sigma[i] = 0.003; /* About right for 8-bit quantization */ }
     int max_iterations = 1;
     double tol_gain = 0.0001;
     double tol_offset = 0.0001;
     double tol_sigma = 0.0001;
     bool_t converged = FALSE;
-    double gain_old[NI];
-    double offset_old[NI];
-    double sigma_old[NI];
+    double gain_old[NK];
+    double offset_old[NK];
+    double sigma_old[NK];
     int iter = 0;
     while (TRUE)
       { if (verbose)
@@ -131,28 +235,28 @@ void float_image_hdyn_estimate_gains_offsets_sigmas_values
             fprintf(stderr, "iteration %d\n", iter);
             if (iter > 0)
               { fprintf(stderr, "  gain =   ");
-                for (i = 0; i < NI; i++) { fprintf(stderr, " %10.6f", gain[i]); }
+                for (i = 0; i < NK; i++) { fprintf(stderr, " %10.6f", gain[i]); }
                 fprintf(stderr, "\n");
                 fprintf(stderr, "  offset = ");
-                for (i = 0; i < NI; i++) { fprintf(stderr, " %10.6f", offset[i]); }
+                for (i = 0; i < NK; i++) { fprintf(stderr, " %10.6f", offset[i]); }
                 fprintf(stderr, "\n");
               }
             fprintf(stderr, "  sigma =  ");
-            for (i = 0; i < NI; i++) { fprintf(stderr, " %10.6f", sigma[i]); }
+            for (i = 0; i < NK; i++) { fprintf(stderr, " %10.6f", sigma[i]); }
             fprintf(stderr, "\n");
           }
         /* Check for convergence: */
         if ((iter >= max_iterations) || converged) { break; }
         /* Save current {gain,sigma}: */
-        for (i = 0; i < NI; i++) { gain_old[i] = gain[i]; offset_old[i] = offset[i]; sigma_old[i] = sigma[i]; }
+        for (i = 0; i < NK; i++) { gain_old[i] = gain[i]; offset_old[i] = offset[i]; sigma_old[i] = sigma[i]; }
         /* Re-estimate {gain} assuming current {sigma}: */
-        float_image_hdyn_estimate_gains_offsets(c, NI, img, vmin, vmax, sigma, verbose, /*OUT*/ gain, offset);
+        float_image_hdyn_estimate_gains_offsets_chans(c0, nc, NI, img, vmin, vmax, sigma, nth, verbose, /*OUT*/ gain, offset);
         /* Estimate {Y} values assuming {gain,offset,sigma}: */
-        float_image_hdyn_estimate_values(c, NI, img, vmin, vmax, gain, offset, sigma, verbose, /*OUT*/ omg);
+        float_image_hdyn_estimate_values_chans(c0, nc, NI, img, vmin, vmax, gain, offset, sigma, nth, verbose, /*OUT*/ omg);
         /* Re-estimate {sigma} assuming current {gain,offset} and values: */
-        float_image_hdyn_estimate_sigmas(c, NI, img, vmin, vmax, gain, offset, omg, verbose, /*OUT*/ sigma);
+        float_image_hdyn_estimate_sigmas_chans(c0, nc, NI, img, vmin, vmax, gain, offset, omg, nth, verbose, /*OUT*/ sigma);
         /* Make sure that {Vmax - Vmin >= 2*sigma}: */
-        for (i = 0; i < NI; i++)
+        for (i = 0; i < NK; i++)
           { double sigma_max = (vmax[i] - vmin[i])/2.0001;  /* Max valid sigma. */
             if (sigma[i] > sigma_max) { sigma[i] = sigma_max; }
           }
@@ -161,9 +265,9 @@ void float_image_hdyn_estimate_gains_offsets_sigmas_values
         /* Find max change in {gain,offset,sigma}: */
         if (verbose){ fprintf(stderr, "  max changes:"); }
         converged = TRUE;
-        converged &= float_image_hdyn_check_convergence(NI, gain,   gain_old,   tol_gain,   TRUE,  verbose, "gain");
-        converged &= float_image_hdyn_check_convergence(NI, offset, offset_old, tol_offset, FALSE, verbose, "offset");
-        converged &= float_image_hdyn_check_convergence(NI, sigma,  sigma_old,  tol_sigma,  FALSE, verbose, "sigma");
+        converged &= float_image_hdyn_check_convergence(NK, gain,   gain_old,   tol_gain,   TRUE,  verbose, "gain");
+        converged &= float_image_hdyn_check_convergence(NK, offset, offset_old, tol_offset, FALSE, verbose, "offset");
+        converged &= float_image_hdyn_check_convergence(NK, sigma,  sigma_old,  tol_sigma,  FALSE, verbose, "sigma");
       }
     if (! converged) { fprintf(stderr, "  failed to converge in %d iterations\n", iter); }
   }
@@ -215,13 +319,21 @@ void float_image_hdyn_estimate_gains_offsets
     double vmin[],        /* Value of underexposed pixels. */
     double vmax[],        /* Value of overexposed pixels. */
     double sigma[],       /* Assumed noise deviation of each image. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
     bool_t verbose,       /* TRUE for diagnostics. */
     double gain[],        /* (OUT) Estimated gain of each image. */
     double offset[]       /* (OUT) Estimated value offset of each image. */
   )
   {
-    bool_t debug = FALSE;
-    
+    float_image_hdyn_estimate_gains_offsets_chans(c, 1, NI, img, vmin, vmax, sigma, nth, verbose, gain, offset);
+  }
+
+void float_image_hdyn_estimate_gains_offsets_chans
+  ( int c0, int nc, int NI, float_image_t *img[], double vmin[], double vmax[], 
+    double sigma[], int nth, bool_t verbose, double gain[], double offset[]
+  )
+  {
+    float_image_hdyn_check_images(c0, nc, NI, img, NULL);
     /* For each pair of distinct images
       {i,j}, compute the weighted average {M[i,j]} of the values of image {i},
       the linear regression coefficient {C[i,j]} of image {i} versus image {j},
@@ -229,24 +341,52 @@ void float_image_hdyn_estimate_gains_offsets
       both images.  The coefficient {C[i,j]} assumes the equation
       {(V[i] - M[i,j]) = C[i,j]*(V[j] - M[j,i]).
     */
+    if (verbose) { fprintf(stderr, "collecting image statistics...\n"); }
+    int NP = NI*(NI+1)/2; /* Number of image pairs {i,j} with {j <= i}. */
+    double *PM = notnull(malloc(2*nc*NP*sizeof(double)), "no mem");
+    double *PC = notnull(malloc(nc*NP*sizeof(double)), "no mem");
+    double *PW = notnull(malloc(nc*NP*sizeof(double)), "no mem");
+    fihd_job_t job = (fihd_job_t)
+      { .NI = NI, .img = img, .c0 = c0, .nc = nc, .vmin = vmin, .vmax = vmax,
+        .gain = NULL, .offset = NULL, .sigma = sigma, .PM = NULL, .omg = NULL, .NS = 0, .S = NULL
+      };
+    float_image_hdyn_compute_pair_stats(&job, nth, PM, PC, PW);
     
+    int k;
+    for (k = 0; k < nc; k++)
+      { if (verbose && (nc > 1)) { fprintf(stderr, "channel %d\n", c0 + k); }
+        int q = k*NP, r = k*NI;
+        float_image_hdyn_gains_offsets_from_stats
+          ( NI, &(PM[2*q]), &(PC[q]), &(PW[q]), &(vmin[r]), &(vmax[r]), verbose, &(gain[r]), &(offset[r]) );
+      }
+    free(PM); free(PC); free(PW);
+  }
+
+void float_image_hdyn_gains_offsets_from_stats
+  ( int NI,
+    double PM[],
+    double PC[],
+    double PW[],
+    double vmin[],
+    double vmax[],
+    bool_t verbose,
+    double gain[],
+    double offset[]
+  )
+  {
     /* Matrices for image pair statistics: */
-    if (verbose) { fprintf(stderr, "collecting image statistics...\n"); }
     int NI2 = NI*NI;
     double *M = notnull(malloc(NI2*sizeof(double)), "no mem"); /* Average values. */
     double *C = notnull(malloc(NI2*sizeof(double)), "no mem"); /* Correlation coefficients. */
     double *W = notnull(malloc(NI2*sizeof(double)), "no mem"); /* Weights. */
     int i, j;
+    int p = 0; /* Index of pair {i,j} in {PM,PC,PW}. */
     for (i = 0; i < NI; i++) 
       { for (j = 0; j <= i; j++) 
-          { double Wij, Cij, Cji, Mij, Mji;
-            float_image_hdyn_compute_avg_corr_and_weight
-              ( c, 
-                img[i], vmin[i], vmax[i], sigma[i], 
-                img[j], vmin[j], vmax[j], sigma[j], 
-                debug & (i == 2) && (j == 0),
-                &Mij, &Mji, &Cij, &Wij
-              );
+          { double Mij = PM[2*p], Mji = PM[2*p+1];
+            double Cij = PC[p], Cji;
+            double Wij = PW[p];
+            p++;
             if (! isnan(Cij))
               { /* Ensure {C[i,j]} is non-negative: */
                 if (Cij < -0.00001)
@@ -551,71 +691,112 @@ void float_image_hdyn_estimate_values
     double gain[],        /* Assumed gain of each image. */
     double offset[],      /* Assumed value offset of each image. */
     double sigma[],       /* Assumed noise deviation of each image. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
     bool_t verbose,       /* TRUE for diagnostics. */
     float_image_t *omg    /* (OUT) Estimated luminances. */
   )
   {
+    float_image_hdyn_estimate_values_chans(c, 1, NI, img, vmin, vmax, gain, offset, sigma, nth, verbose, omg);
+  }
+
+void float_image_hdyn_estimate_values_chans
+  ( int c0, int nc, int NI, float_image_t *img[], double vmin[], double vmax[],
+    double gain[], double offset[], double sigma[], int nth, bool_t verbose, float_image_t *omg
+  )
+  {
+    float_image_hdyn_check_images(c0, nc, NI, img, omg);
     if (verbose) { fprintf(stderr, "estimating the true image values...\n"); }
-    /* Get image dimensions: */
-    int NX = (int)img[0]->sz[1];
-    int NY = (int)img[0]->sz[2];
+    fihd_job_t job = (fihd_job_t)
+      { .NI = NI, .img = img, .c0 = c0, .nc = nc, .vmin = vmin, .vmax = vmax,
+        .gain = gain, .offset = offset, .sigma = sigma, .PM = NULL, .omg = omg, .NS = 0, .S = NULL
+      };
+    float_image_hdyn_run_bands(&job, 0, nth, &float_image_hdyn_values_bands, NULL);
+  }
+
+void float_image_hdyn_values_bands(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fihd_job_t *job = (fihd_job_t *)arg;
+    int NI = job->NI;
+    int NX = (int)job->img[0]->sz[1];
+    int NY = (int)job->img[0]->sz[2];
     
-    /* Scan pixels: */
-    int x, y;
-    for (y = 0; y < NY; y++)
-      { for (x = 0; x < NX; x++)
-          { int nlo = 0; /* Number of images where this pixel is underexposed. */
-            int nhi = 0; /* Number of images where this pixel is overexposed. */
-            int nin = 0; /* Number of images where this pixel is well-exposed. */
-            int nun = 0; /* Number of bad images. */
-            double sum_W = 0.0;
-            double sum_WY = 0.0;
-            int i;
-            for (i = 0; i < NI; i++) 
-              { if (isfinite(gain[i]) && (gain[i] != 0))
-                  { double Vi = float_image_get_sample(img[i], c, x, y);
-                    double Yi = (Vi - offset[i])/gain[i];
-                    double sigYi = sigma[i]/gain[i];
-                    int class = float_image_hdyn_sample_class(Vi, vmin[i], vmax[i]);
-                    if (class < 0) 
-                      { nlo++; }
-                    else if (class > 0)
-                      { nhi++; }
-                    else
-                      { nin++;
-                        double Vrel = (Vi - vmin[i])/(vmax[i] - vmin[i]);
-                        double W_val = 0.5*(1 - cos(2*M_PI*Vrel));
+    /* Per-pixel accumulators for one row: */
+    double *sum_W = notnull(malloc(NX*sizeof(double)), "no mem");
+    double *sum_WY = notnull(malloc(NX*sizeof(double)), "no mem");
+    int *nlo = notnull(malloc(NX*sizeof(int)), "no mem"); /* Number of images where the pixel is underexposed. */
+    int *nhi = notnull(malloc(NX*sizeof(int)), "no mem"); /* Number of images where the pixel is overexposed. */
+    int *nin = notnull(malloc(NX*sizeof(int)), "no mem"); /* Number of images where the pixel is well-exposed. */
+    
+    float *rp[NI];
+    ix_step_t sx[NI];
+    int b, x, y, k, i;
+    for (b = ini; b <= fin; b++)
+      { int ylo = b*float_image_hdyn_BAND_ROWS;
+        int yhi = (int)imin(NY, ylo + float_image_hdyn_BAND_ROWS) - 1;
+        for (y = ylo; y <= yhi; y++)
+          { for (k = 0; k < job->nc; k++)
+              { float_image_hdyn_get_rows(job, k, y, rp, sx);
+                double *gain = &(job->gain[k*NI]);
+                double *offset = &(job->offset[k*NI]);
+                double *sigma = &(job->sigma[k*NI]);
+                double *vmin = &(job->vmin[k*NI]);
+                double *vmax = &(job->vmax[k*NI]);
+                for (x = 0; x < NX; x++) { sum_W[x] = 0.0; sum_WY[x] = 0.0; nlo[x] = 0; nhi[x] = 0; nin[x] = 0; }
+                int nun = 0; /* Number of bad images. */
+                for (i = 0; i < NI; i++) 
+                  { if (isfinite(gain[i]) && (gain[i] != 0))
+                      { /* Accumulate image {i} over the whole row: */
+                        float *ri = rp[i];
+                        ix_step_t si = sx[i];
+                        double sigYi = sigma[i]/gain[i];
                         double W_sig = 1/(sigYi*sigYi);
-                        double Wi = W_val*W_sig;
-                        sum_WY += Wi*Yi;
-                        sum_W += Wi;
+                        for (x = 0; x < NX; x++)
+                          { double Vi = ri[x*si];
+                            int class = float_image_hdyn_sample_class(Vi, vmin[i], vmax[i]);
+                            if (class < 0) 
+                              { nlo[x]++; }
+                            else if (class > 0)
+                              { nhi[x]++; }
+                            else
+                              { nin[x]++;
+                                double Yi = (Vi - offset[i])/gain[i];
+                                double Vrel = (Vi - vmin[i])/(vmax[i] - vmin[i]);
+                                double W_val = 0.5*(1 - cos(2*M_PI*Vrel));
+                                double Wi = W_val*W_sig;
+                                sum_WY[x] += Wi*Yi;
+                                sum_W[x] += Wi;
+                              }
+                          }
                       }
+                    else
+                      { nun++; }
+                  }
+                for (x = 0; x < NX; x++)
+                  { double Y;
+                    if (nhi[x] >= NI)
+                      { /* Seems overexposed in all good images: */
+                        Y = +INF;
+                      }
+                    else if (nlo[x] >= NI)
+                      { /* Seems underexposed in all good images: */
+                        Y = -INF; 
+                      }
+                    else if (nin[x] == 0)
+                      { /* Seems either under- or over-exposed in all good images: */
+                        Y = NAN; 
+                      }
+                    else if ((nun == NI) || (sum_W[x] == 0))
+                      { /* There is no good image: */
+                        Y = NAN;
+                      }
+                    else
+                      { Y = sum_WY[x]/sum_W[x]; }
+                    float_image_set_sample(job->omg, job->c0 + k, x, y, (float)Y);
                   }
-                else
-                  { nun++; }
-              }
-            double Y;
-            if (nhi >= NI)
-              { /* Seems overexposed in all good images: */
-                Y = +INF;
-              }
-            else if (nlo >= NI)
-              { /* Seems underexposed in all good images: */
-                Y = -INF; 
-              }
-            else if (nin == 0)
-              { /* Seems either under- or over-exposed in all good images: */
-                Y = NAN; 
-              }
-            else if ((nun == NI) || (sum_W == 0))
-              { /* There is no good image: */
-                Y = NAN;
               }
-            else
-              { Y = sum_WY/sum_W; }
-            float_image_set_sample(omg, c, x, y, (float)Y);
           }
       }
+    free(sum_W); free(sum_WY); free(nlo); free(nhi); free(nin);
   }
   
 void float_image_hdyn_estimate_sigmas
@@ -627,117 +808,264 @@ void float_image_hdyn_estimate_sigmas
     double gain[],        /* Assumed gain of each image. */
     double offset[],      /* Assumed value offset of each image. */
     float_image_t *omg,   /* Assumed luminances. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
     bool_t verbose,       /* TRUE for diagnostics. */
     double sigma[]        /* (OUT) Estimated noise deviation. */
   )
   {
+    float_image_hdyn_estimate_sigmas_chans(c, 1, NI, img, vmin, vmax, gain, offset, omg, nth, verbose, sigma);
+  }
+
+void float_image_hdyn_estimate_sigmas_chans
+  ( int c0, int nc, int NI, float_image_t *img[], double vmin[], double vmax[],
+    double gain[], double offset[], float_image_t *omg, int nth, bool_t verbose, double sigma[]
+  )
+  {
+    float_image_hdyn_check_images(c0, nc, NI, img, omg);
     /* Get image dimensions: */
     int NX = (int)img[0]->sz[1];
     int NY = (int)img[0]->sz[2];
-    int i;
     if (verbose) { fprintf(stderr, "estimating the noise deviations...\n"); }
-    for (i = 0; i < NI; i++) 
-      { if (verbose) { fprintf(stderr, "  sigma[%2d] =", i); }
-        double Nvalid = NAN;
-        double sum_W = 1.0e-200;
-        double sum_WD2 = 0;
-        int x, y;
-        for (y = 0; y < NY; y++)
-          { for (x = 0; x < NX; x++)
-              { double V_obs = float_image_get_sample(img[i], c, x, y);
-                int class = float_image_hdyn_sample_class(V_obs, vmin[i], vmax[i]);
-                if (class == 0)
-                  { double W = 1.0;
-                    double Y = float_image_get_sample(omg, c, x, y);
-                    double V_exp = gain[i]*Y + offset[i];
-                    double D = V_obs - V_exp;
-                    sum_WD2 += W*D*D;
-                    sum_W += W;
+    
+    /* Compute the sums {sum_W,sum_WD2} for each channel and image: */
+    int NK = nc*NI;
+    fihd_job_t job = (fihd_job_t)
+      { .NI = NI, .img = img, .c0 = c0, .nc = nc, .vmin = vmin, .vmax = vmax,
+        .gain = gain, .offset = offset, .sigma = NULL, .PM = NULL, .omg = omg, .NS = 0, .S = NULL
+      };
+    double tot[2*NK];
+    float_image_hdyn_run_bands(&job, 2*NK, nth, &float_image_hdyn_sigmas_bands, tot);
+    
+    int k, i;
+    for (k = 0; k < nc; k++)
+      { for (i = 0; i < NI; i++) 
+          { int r = k*NI + i;
+            if (verbose) 
+              { if (nc > 1) { fprintf(stderr, "  channel %d", c0 + k); }
+                fprintf(stderr, "  sigma[%2d] =", i);
+              }
+            double sum_W = 1.0e-200 + tot[2*r];
+            double sum_WD2 = tot[2*r+1];
+            sigma[r] = sqrt(sum_WD2/sum_W);
+            fprintf(stderr, " %10.6f", sigma[r]);
+            double Nvalid = sum_W;
+            if (verbose) { fprintf(stderr, " ~%.2f%% valid pixels", 100*Nvalid/(NX*NY)); }
+            fprintf(stderr, "\n");
+          }
+      }
+  }
+
+void float_image_hdyn_sigmas_bands(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fihd_job_t *job = (fihd_job_t *)arg;
+    int NI = job->NI;
+    int NX = (int)job->img[0]->sz[1];
+    int NY = (int)job->img[0]->sz[2];
+    float *rp[NI];
+    ix_step_t sx[NI];
+    int b, x, y, k, i;
+    for (b = ini; b <= fin; b++)
+      { double *S = &(job->S[b*job->NS]);
+        int ylo = b*float_image_hdyn_BAND_ROWS;
+        int yhi = (int)imin(NY, ylo + float_image_hdyn_BAND_ROWS) - 1;
+        for (y = ylo; y <= yhi; y++)
+          { for (k = 0; k < job->nc; k++)
+              { float_image_hdyn_get_rows(job, k, y, rp, sx);
+                float *ro = float_image_get_sample_address(job->omg, job->c0 + k, 0, y);
+                ix_step_t so = job->omg->st[1];
+                for (i = 0; i < NI; i++) 
+                  { int r = k*NI + i;
+                    double vmin = job->vmin[r], vmax = job->vmax[r];
+                    double gain = job->gain[r], offset = job->offset[r];
+                    float *ri = rp[i];
+                    ix_step_t si = sx[i];
+                    double sum_W = 0, sum_WD2 = 0;
+                    for (x = 0; x < NX; x++)
+                      { double V_obs = ri[x*si];
+                        int class = float_image_hdyn_sample_class(V_obs, vmin, vmax);
+                        if (class == 0)
+                          { double W = 1.0;
+                            double Y = ro[x*so];
+                            double V_exp = gain*Y + offset;
+                            double D = V_obs - V_exp;
+                            sum_WD2 += W*D*D;
+                            sum_W += W;
+                          }
+                      }
+                    S[2*r] += sum_W;
+                    S[2*r+1] += sum_WD2;
                   }
               }
           }
-        sigma[i] = sqrt(sum_WD2/sum_W);
-        fprintf(stderr, " %10.6f", sigma[i]);
-        Nvalid = sum_W;
-        if (verbose) { fprintf(stderr, " ~%.2f%% valid pixels", 100*Nvalid/(NX*NY)); }
-        fprintf(stderr, "\n");
       }
   }
 
-void float_image_hdyn_compute_avg_corr_and_weight
-  ( int c,               /* Channel. */
-    float_image_t *imgA, /* First image. */
-    double vminA,        /* Underexposed value of {imgA} */
-    double vmaxA,        /* Overexposed value of {imgA} */
-    double sigmaA,       /* Assumed deviation of noise in {imgA}. */
-    float_image_t *imgB, /* Second image. */
-    double vminB,        /* Underexposed value of {imgB} */
-    double vmaxB,        /* Overexposed value of {imgB} */
-    double sigmaB,       /* Assumed deviation of noise in {imgB}. */
-    bool_t verbose,      /* TRUE to print out detailed diagnostics. */
-    double *MAP,         /* (OUT) Mean value of {imgA} image on common pixels. */
-    double *MBP,         /* (OUT) Mean value of {imgB} image on common pixels. */
-    double *CP,          /* (OUT) Regression coef of {imgA} rel to {imgB} on common pixels. */
-    double *WP           /* (OUT) Fuzzy count of common pixels. */
+void float_image_hdyn_compute_pair_stats
+  ( fihd_job_t *job,
+    int nth,
+    double PM[],
+    double PC[],
+    double PW[]
   )
   {
-    /* Get image dimensions: */
-    int NX = (int)imgA->sz[1]; demand(((int)imgB->sz[1]) == NX, "incompat cols");
-    int NY = (int)imgA->sz[2]; demand(((int)imgB->sz[2]) == NY, "incompat rows");
-
-    /* Compute weight and means: */
-    double sum_W = 1.0e-200;
-    double sum_WVA = 0;
-    double sum_WVB = 0;
-    int x, y;
-    for (y = 0; y < NY; y++)
-      { for (x = 0; x < NX; x++)
-          { double VA = float_image_get_sample(imgA, c, x, y);
-            assert(VA >= 0);
-            int classA = float_image_hdyn_sample_class(VA, vminA, vmaxA);
-
-            double VB = float_image_get_sample(imgB, c, x, y);
-            assert(VB >= 0);
-            int classB = float_image_hdyn_sample_class(VB, vminB, vmaxB);
-            
-            if ((classA == 0) && (classB == 0))
-              { double WAB = 1.0;
-                sum_WVA += WAB*VA;
-                sum_WVB += WAB*VB;
-                sum_W += WAB;
+    int NI = job->NI;
+    int NP = NI*(NI+1)/2;
+    int NQ = job->nc*NP;
+    
+    /* Compute weights and means: */
+    double tot1[3*NQ];
+    float_image_hdyn_run_bands(job, 3*NQ, nth, &float_image_hdyn_pair_sums_bands, tot1);
+    int q;
+    for (q = 0; q < NQ; q++)
+      { double sum_W = 1.0e-200 + tot1[3*q];
+        PM[2*q] = tot1[3*q+1]/sum_W;
+        PM[2*q+1] = tot1[3*q+2]/sum_W;
+        PW[q] = sum_W;
+      }
+    
+    /* Compute regression coefficients: */
+    double tot2[2*NQ];
+    job->PM = PM;
+    float_image_hdyn_run_bands(job, 2*NQ, nth, &float_image_hdyn_pair_corr_bands, tot2);
+    job->PM = NULL;
+    for (q = 0; q < NQ; q++)
+      { PC[q] = tot2[2*q]/tot2[2*q+1]; /* May be 0, {INF} or {NAN}. */ }
+  }
+
+void float_image_hdyn_pair_sums_bands(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fihd_job_t *job = (fihd_job_t *)arg;
+    int NI = job->NI;
+    int NP = NI*(NI+1)/2;
+    int NX = (int)job->img[0]->sz[1];
+    int NY = (int)job->img[0]->sz[2];
+    float *rp[NI];
+    ix_step_t sx[NI];
+    double V[NI];
+    bool_t ok[NI];
+    int b, x, y, k, i, j;
+    for (b = ini; b <= fin; b++)
+      { double *S = &(job->S[b*job->NS]);
+        int ylo = b*float_image_hdyn_BAND_ROWS;
+        int yhi = (int)imin(NY, ylo + float_image_hdyn_BAND_ROWS) - 1;
+        for (y = ylo; y <= yhi; y++)
+          { for (k = 0; k < job->nc; k++)
+              { float_image_hdyn_get_rows(job, k, y, rp, sx);
+                double *vmin = &(job->vmin[k*NI]);
+                double *vmax = &(job->vmax[k*NI]);
+                double *Sk = &(S[3*k*NP]);
+                for (x = 0; x < NX; x++)
+                  { for (i = 0; i < NI; i++)
+                      { V[i] = rp[i][x*sx[i]];
+                        ok[i] = (float_image_hdyn_sample_class(V[i], vmin[i], vmax[i]) == 0);
+                      }
+                    int p = 0;
+                    for (i = 0; i < NI; i++)
+                      { for (j = 0; j <= i; j++)
+                          { if (ok[i] && ok[j])
+                              { double WAB = 1.0;
+                                Sk[3*p] += WAB;
+                                Sk[3*p+1] += WAB*V[i];
+                                Sk[3*p+2] += WAB*V[j];
+                              }
+                            p++;
+                          }
+                      }
+                  }
               }
           }
       }
-    double MA = sum_WVA/sum_W;
-    double MB = sum_WVB/sum_W;
-    double W = sum_W;
-
-    /* Compute correlation: */
-    double sum_WdVAdVB = 0;
-    double sum_WdVB2 = 0;
-    for (y = 0; y < NY; y++)
-      { for (x = 0; x < NX; x++)
-          { double VA = float_image_get_sample(imgA, c, x, y);
-            int classA = float_image_hdyn_sample_class(VA, vminA, vmaxA);
-
-            double VB = float_image_get_sample(imgB, c, x, y);
-            int classB = float_image_hdyn_sample_class(VB, vminB, vmaxB);
-            
-            if ((classA == 0) && (classB == 0))
-              { double WAB = 1.0;
-                double dVA = VA - MA;
-                double dVB = VB - MB;
-                if (verbose) { fprintf(stderr, "  %5d %5d %+12.8f %+12.8f\n", x, y, dVA, dVB); }
-                sum_WdVAdVB += WAB*dVA*dVB;
-                sum_WdVB2 += WAB*dVB*dVB;
+  }
+
+void float_image_hdyn_pair_corr_bands(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fihd_job_t *job = (fihd_job_t *)arg;
+    int NI = job->NI;
+    int NP = NI*(NI+1)/2;
+    int NX = (int)job->img[0]->sz[1];
+    int NY = (int)job->img[0]->sz[2];
+    float *rp[NI];
+    ix_step_t sx[NI];
+    double V[NI];
+    bool_t ok[NI];
+    int b, x, y, k, i, j;
+    for (b = ini; b <= fin; b++)
+      { double *S = &(job->S[b*job->NS]);
+        int ylo = b*float_image_hdyn_BAND_ROWS;
+        int yhi = (int)imin(NY, ylo + float_image_hdyn_BAND_ROWS) - 1;
+        for (y = ylo; y <= yhi; y++)
+          { for (k = 0; k < job->nc; k++)
+              { float_image_hdyn_get_rows(job, k, y, rp, sx);
+                double *vmin = &(job->vmin[k*NI]);
+                double *vmax = &(job->vmax[k*NI]);
+                double *PMk = &(job->PM[2*k*NP]);
+                double *Sk = &(S[2*k*NP]);
+                for (x = 0; x < NX; x++)
+                  { for (i = 0; i < NI; i++)
+                      { V[i] = rp[i][x*sx[i]];
+                        ok[i] = (float_image_hdyn_sample_class(V[i], vmin[i], vmax[i]) == 0);
+                      }
+                    int p = 0;
+                    for (i = 0; i < NI; i++)
+                      { for (j = 0; j <= i; j++)
+                          { if (ok[i] && ok[j])
+                              { double WAB = 1.0;
+                                double dVA = V[i] - PMk[2*p];
+                                double dVB = V[j] - PMk[2*p+1];
+                                Sk[2*p] += WAB*dVA*dVB;
+                                Sk[2*p+1] += WAB*dVB*dVB;
+                              }
+                            p++;
+                          }
+                      }
+                  }
               }
           }
       }
-    if (verbose) { fprintf(stderr, "  sums AB = %+12.8f BB = %+12.8f\n", sum_WdVAdVB, sum_WdVB2); }
-    double C = sum_WdVAdVB/sum_WdVB2; /* May be 0, {INF} or {NAN}. */
-    
-    (*MAP) = MA;
-    (*MBP) = MB;
-    (*CP) = C;
-    (*WP) = W;
+  }
+
+void float_image_hdyn_run_bands(fihd_job_t *job, int NS, int nth, jsthread_range_proc_t *proc, double tot[])
+  {
+    int NY = (int)job->img[0]->sz[2];
+    int nb = (NY + float_image_hdyn_BAND_ROWS - 1)/float_image_hdyn_BAND_ROWS;
+    job->NS = NS;
+    job->S = (NS > 0 ? notnull(calloc(nb*NS, sizeof(double)), "no mem") : NULL);
+    jsthread_run_ranges(nb, 1, nth, proc, job);
+    if (NS > 0)
+      { int b, s;
+        for (s = 0; s < NS; s++) { tot[s] = 0; }
+        for (b = 0; b < nb; b++)
+          { double *Sb = &(job->S[b*NS]);
+            for (s = 0; s < NS; s++) { tot[s] += Sb[s]; }
+          }
+        free(job->S);
+      }
+    job->NS = 0;
+    job->S = NULL;
+  }
+
+void float_image_hdyn_check_images(int c0, int nc, int NI, float_image_t *img[], float_image_t *omg)
+  {
+    demand(NI > 0, "no input images");
+    demand((c0 >= 0) && (nc >= 0), "invalid channel range");
+    int NX = (int)img[0]->sz[1];
+    int NY = (int)img[0]->sz[2];
+    int i;
+    for (i = 0; i <= NI; i++)
+      { float_image_t *A = (i < NI ? img[i] : omg);
+        if (A == NULL) { continue; }
+        demand(((int)A->sz[1]) == NX, "incompat cols");
+        demand(((int)A->sz[2]) == NY, "incompat rows");
+        demand(c0 + nc <= (int)A->sz[0], "invalid channel range");
+      }
+  }
+
+void float_image_hdyn_get_rows(fihd_job_t *job, int k, int y, float *rp[], ix_step_t sx[])
+  {
+    int i;
+    for (i = 0; i < job->NI; i++)
+      { float_image_t *A = job->img[i];
+        rp[i] = float_image_get_sample_address(A, job->c0 + k, 0, y);
+        sx[i] = A->st[1];
+      }
   }
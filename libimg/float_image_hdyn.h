@@ -2,7 +2,7 @@
 #define float_image_hdyn_H
 
 /* Tools for high-dynamic-range mixing of PGM/PBM images. */
-/* Last edited on 2017-06-20 20:47:08 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:13:06 by stolfilocal */ 
 
 #include <r2.h>
 #include <r2x2.h>
@@ -36,6 +36,12 @@
   
   If the {verbose} parameter is TRUE, the procedures print out
   various diagnostic messages. 
+  
+  The passes over the pixels are split into bands of consecutive rows,
+  which are processed by {nth} threads (one per processor if {nth} is
+  zero).  The sums over all pixels are accumulated separately for
+  each band, and then added in band order, so the results do not
+  depend on the number of threads.
 */
 
   
@@ -45,6 +51,7 @@ void float_image_hdyn_estimate_gains_offsets_sigmas_values
     float_image_t *img[], /* Input images. */
     double vmin[],        /* Value of underexposed pixels. */
     double vmax[],        /* Value of overexposed pixels. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
     bool_t verbose,       /* TRUE for diagnostics. */
     double gain[],        /* (OUT) Estimated gain of each image. */
     double offset[],      /* (OUT) Estimated value offset of each image. */
@@ -59,6 +66,25 @@ void float_image_hdyn_estimate_gains_offsets_sigmas_values
      (overexposed) or {NAN} (indeterminate) if there is no valid
      information about the pixel. */
   
+void float_image_hdyn_estimate_all_channels
+  ( int NI,               /* Number of input images. */
+    float_image_t *img[], /* Input images. */
+    double vmin[],        /* Value of underexposed pixels, per channel and image. */
+    double vmax[],        /* Value of overexposed pixels, per channel and image. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
+    bool_t verbose,       /* TRUE for diagnostics. */
+    double gain[],        /* (OUT) Estimated gain, per channel and image. */
+    double offset[],      /* (OUT) Estimated value offset, per channel and image. */
+    double sigma[],       /* (OUT) Estimated noise deviation, per channel and image. */
+    float_image_t *omg    /* (OUT) Estimated true values. */
+  );
+  /* Same as {float_image_hdyn_estimate_gains_offsets_sigmas_values}
+    applied to every channel {c} in {0..NC-1}, where {NC} is the number 
+    of channels of the images; except that each pass reads all channels
+    of each pixel at once. The parameters of channel {c} of image
+    {i} are {vmin[k]}, {vmax[k]}, {gain[k]}, {offset[k]}, and {sigma[k]}
+    where {k = c*NI + i}. */
+  
 void float_image_hdyn_estimate_gains_offsets
   ( int c,                /* Channel. */
     int NI,               /* Number of input images. */
@@ -66,6 +92,7 @@ void float_image_hdyn_estimate_gains_offsets
     double vmin[],        /* Value of underexposed pixels. */
     double vmax[],        /* Value of overexposed pixels. */
     double sigma[],       /* Assumed noise deviation of each image. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
     bool_t verbose,       /* TRUE for diagnostics. */
     double gain[],        /* (OUT) Estimated gain of each image. */
     double offset[]       /* (OUT) Estimated value offset of each image. */
@@ -84,6 +111,7 @@ void float_image_hdyn_estimate_values
     double gain[],        /* Assumed gain of each image. */
     double offset[],      /* Assumed value offset of each image. */
     double sigma[],       /* Assumed noise deviation of each image. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
     bool_t verbose,       /* TRUE for diagnostics. */
     float_image_t *omg    /* (OUT) Estimated luminances. */
   );
@@ -105,6 +133,7 @@ void float_image_hdyn_estimate_sigmas
     double gain[],        /* Assumed gain of each image. */
     double offset[],      /* Assumed value offset of each image. */
     float_image_t *omg,   /* Assumed luminances. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
     bool_t verbose,       /* TRUE for diagnostics. */
     double sigma[]        /* (OUT) Estimated noise deviation. */
   );
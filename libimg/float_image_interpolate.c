@@ -1,15 +1,18 @@
 /* See float_image_interpolate.h */
-/* Last edited on 2017-06-26 18:16:29 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:05:31 by stolfilocal */ 
 
 #define _GNU_SOURCE
 #include <limits.h>
 #include <float.h>
 #include <assert.h>
 #include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
 
 #include <affirm.h>
 #include <bool.h>
 #include <ix.h>
+#include <jsthread.h>
 #include <float_image.h>
 
 #include <float_image_interpolate.h>
@@ -53,6 +56,67 @@ void float_image_interpolate_get_samples_and_weights
     reduced according to {ix_reduce(i, N, red)}; If a reduced index is
     {-1}, the corresponding pointers are set to NULL. */
 
+void float_image_interpolate_grid_tables
+  ( double r,
+    int j0,
+    int n,
+    double dt,
+    int N,
+    int m,
+    ix_reduction_t red,
+    int i[],
+    double w[]
+  );
+  /* Applies {float_image_interpolate_get_indices_and_weights} to the 
+    coordinates {r + (j0+j)*dt} for {j} in {0..n-1}, storing the indices and
+    weights into {i[j*m..j*m+m-1]} and {w[j*m..j*m+m-1]}. */
+
+void float_image_interpolate_grid_apply
+  ( float_image_t *A,
+    int c,
+    int m,
+    int nx, 
+    int ix[],
+    double wx[],
+    int jy0,
+    int jy1,
+    int iy[],
+    double wy[],
+    bool_t norm,
+    double z[],
+    int zsx, 
+    int zsy
+  );
+  /* Interpolates channel {c} of {A} at the grid points in columns {0..nx-1}
+    and rows {jy0..jy1}, whose indices and weights along each axis
+    are given by the tables {ix,wx} and {iy,wy} computed by
+    {float_image_interpolate_grid_tables}, each with {m} entries per
+    point.  The value at column {jx} and row {jy} is stored into
+    {z[(jy-jy0)*zsy + jx*zsx]}.
+    
+    The interpolation is done in two passes: first each source
+    row is interpolated horizontally at all columns {jx}, then those
+    rows are combined with the vertical weights.  Recently used rows
+    are kept, so that each source row is usually interpolated only
+    once.  If {norm} is false, the result is the same as that of
+    {float_image_interpolate_sample}; if {norm} is true, it is that of
+    {float_image_interpolate_pixel}. */
+
+typedef struct fii_job_t
+  { float_image_t *A;  /* The image to interpolate. */
+    int m;             /* Number of samples per axis. */
+    int *ix;           /* Column index table. */
+    double *wx;        /* Column weight table. */
+    int *iy;           /* Row index table. */
+    double *wy;        /* Row weight table. */
+    float_image_t *B;  /* The result image. */
+  } fii_job_t;
+  /* Arguments of {float_image_interpolate_grid_image} for the threads. */
+
+void float_image_interpolate_grid_image_rows(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Computes rows {ini..fin} of the image {B} of {float_image_interpolate_grid_image}.  
+    The argument {arg} must be the {fii_job_t} of the call. */
+
 /* EXPORTED FUNCTIONS */
 
 double float_image_interpolate_sample
@@ -132,8 +196,6 @@ void float_image_interpolate_pixel
       }
   }
 
-/* !!! TO DO: Improve efficiency of grid evaluation by reusing samples and weights !!! */
-
 void float_image_interpolate_grid_samples
   ( float_image_t *A, 
     int c, 
@@ -144,19 +206,15 @@ void float_image_interpolate_grid_samples
     double z[]
   )
   {
-    /* Slow but safe interpolation: */
     demand(hx >= 0, "invalid X grid size");
     demand(hy >= 0, "invalid Y grid size");
-    int jx, jy;
-    int jxy = 0;
-    for (jy = -hy; jy <= +hy; jy++)
-      { double y = ry + jy * dy;
-        for (jx = -hx; jx <= +hx; jx++)
-          { double x = rx + jx * dx;
-            z[jxy] = float_image_interpolate_sample(A, c, x, y, order, red);
-            jxy++;
-          }
-      }
+    int m = float_image_interpolate_compute_num_samples(order);
+    int nx = 2*hx + 1, ny = 2*hy + 1;
+    int ix[nx*m], iy[ny*m];
+    double wx[nx*m], wy[ny*m];
+    float_image_interpolate_grid_tables(rx, -hx, nx, dx, (int)A->sz[1], m, red, ix, wx);
+    float_image_interpolate_grid_tables(ry, -hy, ny, dy, (int)A->sz[2], m, red, iy, wy);
+    float_image_interpolate_grid_apply(A, c, m, nx, ix, wx, 0, ny-1, iy, wy, FALSE, z, 1, nx);
   }
   
 void float_image_interpolate_grid_pixels
@@ -168,20 +226,64 @@ void float_image_interpolate_grid_pixels
     double z[]
   )  
   {
-    /* Slow but safe interpolation: */
     demand(hx >= 0, "invalid X grid size");
     demand(hy >= 0, "invalid Y grid size");
     int NC = (int)A->sz[0];         /* Number of channels. */
-    int jx, jy;
-    int jxy = 0;
-    for (jy = -hy; jy <= +hy; jy++)
-      { double y = ry + jy * dy;
-        for (jx = -hx; jx <= +hx; jx++)
-          { double x = rx + jx * dx;
-            float_image_interpolate_pixel(A, x, y, order, red, &(z[jxy]));
-            jxy += NC;
+    int m = float_image_interpolate_compute_num_samples(order);
+    int nx = 2*hx + 1, ny = 2*hy + 1;
+    int ix[nx*m], iy[ny*m];
+    double wx[nx*m], wy[ny*m];
+    float_image_interpolate_grid_tables(rx, -hx, nx, dx, (int)A->sz[1], m, red, ix, wx);
+    float_image_interpolate_grid_tables(ry, -hy, ny, dy, (int)A->sz[2], m, red, iy, wy);
+    int c;
+    for (c = 0; c < NC; c++)
+      { float_image_interpolate_grid_apply(A, c, m, nx, ix, wx, 0, ny-1, iy, wy, TRUE, &(z[c]), NC, NC*nx); }
+  }
+
+void float_image_interpolate_grid_image
+  ( float_image_t *A, 
+    double x0, double dx,
+    double y0, double dy,
+    int order, 
+    ix_reduction_t red, 
+    float_image_t *B,
+    int nth
+  )  
+  {
+    int NC = (int)A->sz[0];
+    demand(B->sz[0] == NC, "incompatible channel counts");
+    int m = float_image_interpolate_compute_num_samples(order);
+    int nx = (int)B->sz[1], ny = (int)B->sz[2];
+    if ((nx == 0) || (ny == 0)) { return; }
+    int *ix = notnull(malloc(nx*m*sizeof(int)), "no mem");
+    int *iy = notnull(malloc(ny*m*sizeof(int)), "no mem");
+    double *wx = notnull(malloc(nx*m*sizeof(double)), "no mem");
+    double *wy = notnull(malloc(ny*m*sizeof(double)), "no mem");
+    float_image_interpolate_grid_tables(x0, 0, nx, dx, (int)A->sz[1], m, red, ix, wx);
+    float_image_interpolate_grid_tables(y0, 0, ny, dy, (int)A->sz[2], m, red, iy, wy);
+    fii_job_t job = (fii_job_t){ .A = A, .m = m, .ix = ix, .wx = wx, .iy = iy, .wy = wy, .B = B };
+    jsthread_run_ranges(ny, 16, nth, &float_image_interpolate_grid_image_rows, &job);
+    free(ix); free(iy); free(wx); free(wy);
+  }
+
+void float_image_interpolate_grid_image_rows(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fii_job_t *job = (fii_job_t *)arg;
+    float_image_t *B = job->B;
+    int NC = (int)B->sz[0];
+    int nx = (int)B->sz[1];
+    int nb = fin - ini + 1;
+    double *z = notnull(malloc(nb*nx*sizeof(double)), "no mem");
+    int c, jx, jy;
+    for (c = 0; c < NC; c++)
+      { float_image_interpolate_grid_apply
+          ( job->A, c, job->m, nx, job->ix, job->wx, ini, fin, job->iy, job->wy, TRUE, z, 1, nx );
+        for (jy = ini; jy <= fin; jy++)
+          { double *zy = &(z[(jy - ini)*nx]);
+            for (jx = 0; jx < nx; jx++) { float_image_set_sample(B, c, jx, jy, (float)zy[jx]); }
           }
       }
+    free(z);
   }
 
 /* INTERNAL FUNCTIONS */
@@ -291,3 +393,105 @@ void float_image_interpolate_get_samples_and_weights
           }
       }
   }
+
+void float_image_interpolate_grid_tables
+  ( double r,
+    int j0,
+    int n,
+    double dt,
+    int N,
+    int m,
+    ix_reduction_t red,
+    int i[],
+    double w[]
+  )
+  {
+    int j;
+    for (j = 0; j < n; j++)
+      { double t = r + (j0 + j) * dt;
+        float_image_interpolate_get_indices_and_weights(t, N, m, red, &(i[j*m]), &(w[j*m]));
+      }
+  }
+
+void float_image_interpolate_grid_apply
+  ( float_image_t *A,
+    int c,
+    int m,
+    int nx, 
+    int ix[],
+    double wx[],
+    int jy0,
+    int jy1,
+    int iy[],
+    double wy[],
+    bool_t norm,
+    double z[],
+    int zsx, 
+    int zsy
+  )
+  {
+    if ((nx <= 0) || (jy1 < jy0)) { return; }
+    
+    /* Cache of horizontally interpolated source rows: */
+    int R = 2*m;                /* Number of rows in the cache. */
+    int riy[R];                 /* {riy[r]} is the source row in slot {r}, or {-2} if none. */
+    int rnext = 0;              /* Next slot to be replaced. */
+    int r;
+    for (r = 0; r < R; r++) { riy[r] = -2; }
+    double *H = notnull(malloc((R+3)*nx*sizeof(double)), "no mem");
+    double *Wx = &(H[R*nx]);      /* {Wx[jx]} is the sum of valid weights of column {jx}. */
+    double *sumwp = &(Wx[nx]);    /* Weighted sums of the current grid row. */
+    double *sumw = &(sumwp[nx]);  /* Sums of weights of the current grid row. */
+    
+    int jx, jy, k;
+    if (norm)
+      { for (jx = 0; jx < nx; jx++)
+          { int *ixj = &(ix[jx*m]);
+            double *wxj = &(wx[jx*m]);
+            double s = 0;
+            for (k = 0; k < m; k++) { if (ixj[k] >= 0) { s += wxj[k]; } }
+            Wx[jx] = s;
+          }
+      }
+
+    ix_step_t sx = A->st[1];
+    for (jy = jy0; jy <= jy1; jy++)
+      { int *iyj = &(iy[jy*m]);
+        double *wyj = &(wy[jy*m]);
+        for (jx = 0; jx < nx; jx++) { sumwp[jx] = 0; sumw[jx] = 1.0e-200; }
+        for (k = 0; k < m; k++)
+          { int iyk = iyj[k];
+            if (iyk < 0) { continue; }
+            /* Find the source row {iyk} in the cache, or compute it: */
+            for (r = 0; (r < R) && (riy[r] != iyk); r++) { }
+            if (r >= R)
+              { r = rnext; rnext = (rnext + 1) % R;
+                riy[r] = iyk;
+                float *row = float_image_get_sample_address(A, c, 0, iyk);
+                double *Hr = &(H[r*nx]);
+                for (jx = 0; jx < nx; jx++)
+                  { int *ixj = &(ix[jx*m]);
+                    double *wxj = &(wx[jx*m]);
+                    double s = 0;
+                    int kx;
+                    for (kx = 0; kx < m; kx++) 
+                      { int ixk = ixj[kx];
+                        if (ixk >= 0) { s += wxj[kx]*row[ixk*sx]; }
+                      }
+                    Hr[jx] = s;
+                  }
+              }
+            /* Accumulate it with weight {wyj[k]}: */
+            double wyk = wyj[k];
+            double *Hr = &(H[r*nx]);
+            for (jx = 0; jx < nx; jx++) { sumwp[jx] += wyk*Hr[jx]; }
+            if (norm) { for (jx = 0; jx < nx; jx++) { sumw[jx] += wyk*Wx[jx]; } }
+          }
+        double *zy = &(z[(jy - jy0)*zsy]);
+        if (norm)
+          { for (jx = 0; jx < nx; jx++) { zy[jx*zsx] = sumwp[jx]/sumw[jx]; } }
+        else
+          { for (jx = 0; jx < nx; jx++) { zy[jx*zsx] = sumwp[jx]; } }
+      }
+    free(H);
+  }
@@ -2,7 +2,7 @@
 #define float_image_interpolate_H
 
 /* Bilinear (C0) and Bicubic (C1) interpolation of floating-point images. */
-/* Last edited on 2017-06-26 17:06:54 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:05:30 by stolfilocal */ 
 
 #include <bool.h>
 #include <ix.h>
@@ -115,4 +115,29 @@ void float_image_interpolate_grid_pixels
     The interpolated channel {c} value at point {p[x,y]}
     is stored in {z[NC*jxy + c]} where {jxy = (jx+hx)+(jy+hy)*nx}. */
 
+/* 
+  The two procedures above compute the interpolation indices and weights
+  once for each grid column and once for each grid row, and apply them
+  in two passes (first along each row, then along each column).  The
+  results are the same as those of the single-point procedures. */
+
+void float_image_interpolate_grid_image
+  ( float_image_t *A, 
+    double x0, double dx,
+    double y0, double dy,
+    int order, 
+    ix_reduction_t red, 
+    float_image_t *B,
+    int nth
+  );
+  /* Fills the image {B}, which must have the same number of
+    channels as {A}, by interpolating {A} on a regular grid.  Namely,
+    sets every channel {c} of pixel {[jx,jy]} of {B} to the value at
+    the point {(x0+jx*dx, y0+jy*dy)} computed by
+    {float_image_interpolate_pixel}, with the given {order} and {red}.
+    Useful for resampling an image to a different scale.
+    
+    The rows of {B} are distributed among {nth} threads (one per
+    processor if {nth} is zero). */
+
 #endif
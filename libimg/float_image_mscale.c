@@ -1,14 +1,18 @@
 /* See {float_image_mscale.h}. */
-/* Last edited on 2013-10-21 00:50:04 by stolfilocal */
+/* Last edited on 2026-10-19 12:19:32 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <assert.h>
 #include <limits.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
  
 #include <bool.h>
 #include <affirm.h>
+#include <ix.h>
+#include <jsthread.h>
 #include <r2.h>
 #include <jsfile.h>
 #include <wt_table.h>
@@ -18,9 +22,59 @@
 
 /* INTERNAL PROTOTYPES */
 
+#define float_image_mscale_BAND_ROWS 8
+  /* Number of rows of the reduced image in each band of the parallel passes. */
+
+typedef struct fims_job_t
+  { float_image_t *A;   /* Image to reduce. */
+    float_image_t *M;   /* Weight mask for {A}, or {NULL}. */
+    float_image_t *R;   /* Reduced image. */
+    int dx, dy;         /* Window shifts. */
+    int nw;             /* Window width. */
+    double *wt;         /* 1D window weights {wt[0..nw-1]}. */
+    bool_t mask;        /* TRUE if {A} is a weight mask. */
+    bool_t harm;        /* TRUE to reduce a mask with the harmonic mean. */
+  } fims_job_t;
+  /* Arguments for the parallel reduction passes. */
+
+void float_image_mscale_shrink_rows(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Computes rows {ini..fin} of the reduced image {job->R}, where
+    {job} is {arg}. */
+
+void float_image_mscale_shrink_row(fims_job_t *job, int yA, double H[]);
+  /* Filters and decimates row {yA} of {job->A} horizontally.  Stores
+    the sum of weights for column {xR} of {job->R} into {H[xR]}, and
+    the weighted sum of channel {c} into {H[(c+1)*NXR + xR]}, where
+    {NXR} is the width of {R}.  The weights include the mask weights if
+    {job->M} is not {NULL}.  If {job->mask} is true, the weighted sums are
+    of the sample values or of their reciprocals, depending on {job->harm},
+    and the sum of weights excludes the samples. */
+
+float_image_t *float_image_mscale_pyramid_header(int NC, int NX, int NY, float **smpP);
+  /* Allocates a header for an image with {NC} channels, {NX} columns
+    and {NY} rows, with the same layout as {float_image_new},
+    whose samples are stored starting at {*smpP}. Increments {*smpP}
+    by the number of samples. */
+
 /* IMPLEMENTATIONS */
 
 float_image_t *float_image_mscale_shrink(float_image_t *A, float_image_t *M, int NXR, int NYR, int dx, int dy, int nw)
+  { 
+    int NC = (int)A->sz[0];
+    float_image_t *R = float_image_new(NC, NXR, NYR);
+    float_image_mscale_shrink_into(A, M, R, dx, dy, nw, 1);
+    return R;
+  }
+  
+float_image_t *float_image_mscale_mask_shrink(float_image_t *M, int NXR, int NYR, int dx, int dy, int nw, bool_t harm)
+  { 
+    int NC = (int)M->sz[0];
+    float_image_t *R = float_image_new(NC, NXR, NYR);
+    float_image_mscale_mask_shrink_into(M, R, dx, dy, nw, harm, 1);
+    return R;
+  }
+
+void float_image_mscale_shrink_into(float_image_t *A, float_image_t *M, float_image_t *R, int dx, int dy, int nw, int nth)
   { 
     /* Generate the 1D weight mask: */
     demand(nw > 0, "invalid filter width");
@@ -28,9 +82,9 @@ float_image_t *float_image_mscale_shrink(float_image_t *A, float_image_t *M, int
     wt_table_fill_binomial(nw, wt);
     
     /* Get the image dimensions: */
-    int NC = (int)A->sz[0];
     int NXA = (int)A->sz[1];
     int NYA = (int)A->sz[2];
+    demand(R->sz[0] == A->sz[0], "channel count mismatch");
 
     /* Check the mask dimensions: */
     if (M != NULL)
@@ -39,92 +93,198 @@ float_image_t *float_image_mscale_shrink(float_image_t *A, float_image_t *M, int
         demand((int)M->sz[2] == NYA, "mask height mismatch");
       }
     
-    /* Create the output image {R}: */
-    float_image_t *R = float_image_new(NC, NXR, NYR);
-    
-    /* Fill the pixels of {R}: */
-    int xR, yR, c;
-    for(yR = 0; yR < NYR; yR++)
-      { for(xR = 0; xR < NXR; xR++)
-          { /* Accumulate the weighted pixel sum over the window: */
-            double sum_w = 0;    /* Sum of weights. */
-            double sum_w_v[NC];  /* Sum of weighted pixels. */
-            for (c = 0; c < NC; c++) { sum_w_v[c] = 0; }
-            int xD, yD;
-            for(yD = 0; yD < nw; yD++)
-              { int yA = 2*yR+yD-dy;
-                double wty = ((yA < 0) || (yA >= NYA) ? 0.0 : wt[yD]);
-                for(xD = 0; xD < nw; xD++)
-                  { int xA = 2*xR+xD-dx;
-                    double wtx = ((xA < 0) || (xA >= NXA) ? 0.0 : wt[xD]);
-                    double w = wtx*wty;
-                    if (w > 0)
-                      { /* Multiply by the mask weight, if any: */
-                        if (M != NULL) { w *= float_image_get_sample(M, 0, xA, yA); }
-                        sum_w += w; 
-                        for (c = 0; c < NC; c++)
-                          { double v = float_image_get_sample(A, c, xA, yA);
-                            sum_w_v[c] += w*v;
-                          }
-                      }
-                  }
-              }
-            /* Store the weighted average (maybe NAN) in the {R} pixel: */
-            if (sum_w == 0) { sum_w = 1; }
-            for (c = 0; c < NC; c++)
-              { double v = sum_w_v[c]/sum_w; 
-                float_image_set_sample(R, c, xR, yR, (float)v);
-              }
-          }
-      }
-    return R;
+    fims_job_t job = (fims_job_t){ .A = A, .M = M, .R = R, .dx = dx, .dy = dy, .nw = nw, .wt = wt, .mask = FALSE, .harm = FALSE };
+    jsthread_run_ranges((int32_t)R->sz[2], float_image_mscale_BAND_ROWS, nth, &float_image_mscale_shrink_rows, &job);
   }
   
-float_image_t *float_image_mscale_mask_shrink(float_image_t *M, int NXR, int NYR, int dx, int dy, int nw, bool_t harm)
+void float_image_mscale_mask_shrink_into(float_image_t *M, float_image_t *R, int dx, int dy, int nw, bool_t harm, int nth)
   { /* Generate the 1D weight mask: */
     demand(nw > 0, "invalid filter width");
     double wt[nw];
     wt_table_fill_binomial(nw, wt);
+    demand(R->sz[0] == M->sz[0], "channel count mismatch");
     
-    /* Get the image dimensions: */
-    int NC = (int)M->sz[0];
-    int NXM = (int)M->sz[1];
-    int NYM = (int)M->sz[2];
-        
-    /* Create the output image {R}: */
-    float_image_t *R = float_image_new(NC, NXR, NYR);
+    fims_job_t job = (fims_job_t){ .A = M, .M = NULL, .R = R, .dx = dx, .dy = dy, .nw = nw, .wt = wt, .mask = TRUE, .harm = harm };
+    jsthread_run_ranges((int32_t)R->sz[2], float_image_mscale_BAND_ROWS, nth, &float_image_mscale_shrink_rows, &job);
+  }
+
+void float_image_mscale_shrink_rows(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fims_job_t *job = (fims_job_t *)arg;
+    float_image_t *A = job->A;
+    float_image_t *R = job->R;
+    int NC = (int)A->sz[0];
+    int NYA = (int)A->sz[2];
+    int NXR = (int)R->sz[1];
+    int nw = job->nw;
+    double *wt = job->wt;
+    
+    /* Row sums cache, with {nw} slots of {NH} elements each: */
+    int NH = (NC + 1)*NXR;
+    double *H = notnull(malloc(nw*NH*sizeof(double)), "no mem");
+    int row[nw]; /* {row[s]} is the row of {A} whose sums are in slot {s}, or {-1}. */
+    double *S = notnull(malloc(NH*sizeof(double)), "no mem"); /* Accumulated sums for one row of {R}. */
+    int s, k, xR, yR, yD, c;
+    for (s = 0; s < nw; s++) { row[s] = -1; }
     
-    /* Fill the pixels of {R}: */
-    int xR, yR, c;
-    for(yR = 0; yR < NYR; yR++)
-      { for(xR = 0; xR < NXR; xR++)
-          { for (c = 0; c < NC; c++)
-              { /* Accumulate the sample sums over the window: */
-                double sum_w = 0;    /* Sum of weights. */
-                double sum_w_m = 0;  /* Sum of weighted pixels. */
-                int xD, yD;
-                for(yD = 0; yD < nw; yD++)
-                  { int yM = 2*yR+yD-dy;
-                    double wty = ((yM < 0) || (yM >= NYM) ? 0.0 : wt[yD]);
-                    for(xD = 0; xD < nw; xD++)
-                      { int xM = 2*xR+xD-dx;
-                        double wtx = ((xM < 0) || (xM >= NXM) ? 0.0 : wt[xD]);
-                        double w = wtx*wty;
-                        if (w > 0)
-                          { sum_w += w;
-                            double m = float_image_get_sample(M, c, xM, yM);
-                            /* !!! Must find a probabilistic justification for this: */
-                            sum_w_m += (harm ? w/m : w*m);
-                          }
-                      }
+    for (yR = ini; yR <= fin; yR++)
+      { for (k = 0; k < NH; k++) { S[k] = 0; }
+        for (yD = 0; yD < nw; yD++)
+          { int yA = 2*yR+yD-job->dy;
+            if ((yA < 0) || (yA >= NYA)) { continue; }
+            s = yA % nw;
+            if (row[s] != yA)
+              { float_image_mscale_shrink_row(job, yA, &(H[s*NH])); row[s] = yA; }
+            double wty = wt[yD];
+            double *Hs = &(H[s*NH]);
+            for (k = 0; k < NH; k++) { S[k] += wty*Hs[k]; }
+          }
+        /* Store the weighted averages in row {yR} of {R}: */
+        for (xR = 0; xR < NXR; xR++)
+          { double sum_w = S[xR];
+            for (c = 0; c < NC; c++)
+              { double sum_v = S[(c+1)*NXR + xR];
+                double v;
+                if (job->mask)
+                  { v = (job->harm ? sum_w/sum_v : sum_v/sum_w);
+                    assert(! isnan(v));
+                  }
+                else
+                  { /* Weighted average (maybe NAN): */
+                    v = sum_v/(sum_w == 0 ? 1 : sum_w);
                   }
-                double m = (harm ? sum_w/sum_w_m : sum_w_m/sum_w);
-                assert(! isnan(m));
-                float_image_set_sample(R, c, xR, yR, (float)m);
+                float_image_set_sample(R, c, xR, yR, (float)v);
               }
           }
       }
-    return R;
+    free(S);
+    free(H);
+  }
+
+void float_image_mscale_shrink_row(fims_job_t *job, int yA, double H[])
+  {
+    float_image_t *A = job->A;
+    float_image_t *M = job->M;
+    int NC = (int)A->sz[0];
+    int NXA = (int)A->sz[1];
+    int NXR = (int)job->R->sz[1];
+    int nw = job->nw;
+    double *wt = job->wt;
+    float *pA = float_image_get_sample_address(A, 0, 0, yA);
+    float *pM = (M == NULL ? NULL : float_image_get_sample_address(M, 0, 0, yA));
+    int xR, xD, c;
+    for (xR = 0; xR < NXR; xR++)
+      { double sum_w = 0;    /* Sum of weights. */
+        double sum_w_v[NC];  /* Sum of weighted samples. */
+        for (c = 0; c < NC; c++) { sum_w_v[c] = 0; }
+        for (xD = 0; xD < nw; xD++)
+          { int xA = 2*xR+xD-job->dx;
+            if ((xA < 0) || (xA >= NXA)) { continue; }
+            double w = wt[xD];
+            float *pAx = pA + xA*A->st[1];
+            if (job->mask)
+              { /* Sample values are weights, to be averaged: */
+                sum_w += w;
+                for (c = 0; c < NC; c++)
+                  { double m = pAx[c*A->st[0]];
+                    /* !!! Must find a probabilistic justification for this: */
+                    sum_w_v[c] += (job->harm ? w/m : w*m);
+                  }
+              }
+            else
+              { /* Multiply by the mask weight, if any: */
+                if (pM != NULL) { w *= pM[xA*M->st[1]]; }
+                sum_w += w;
+                for (c = 0; c < NC; c++) { sum_w_v[c] += w*pAx[c*A->st[0]]; }
+              }
+          }
+        H[xR] = sum_w;
+        for (c = 0; c < NC; c++) { H[(c+1)*NXR + xR] = sum_w_v[c]; }
+      }
+  }
+
+float_image_mscale_pyramid_t *float_image_mscale_pyramid_new
+  ( float_image_t *A, 
+    float_image_t *M, 
+    int NL, 
+    int dx, 
+    int dy, 
+    int nw, 
+    bool_t harm, 
+    int nth
+  )
+  {
+    demand(NL >= 1, "invalid number of levels");
+    int NC = (int)A->sz[0];
+    int NX = (int)A->sz[1];
+    int NY = (int)A->sz[2];
+    int NCM = 0;
+    if (M != NULL)
+      { NCM = (int)M->sz[0];
+        demand((int)M->sz[1] == NX, "mask width mismatch");
+        demand((int)M->sz[2] == NY, "mask height mismatch");
+      }
+    
+    /* Compute the total number of samples of all levels: */
+    size_t NS = 0;
+    int k, NXk = NX, NYk = NY;
+    for (k = 0; k < NL; k++)
+      { NS += ((size_t)(NC + NCM))*NXk*NYk;
+        NXk = (NXk + 1)/2; NYk = (NYk + 1)/2;
+      }
+    
+    float_image_mscale_pyramid_t *P = notnull(malloc(sizeof(float_image_mscale_pyramid_t)), "no mem");
+    P->NL = NL; P->dx = dx; P->dy = dy; P->nw = nw; P->harm = harm;
+    P->img = notnull(malloc(NL*sizeof(float_image_t *)), "no mem");
+    P->msk = (M == NULL ? NULL : notnull(malloc(NL*sizeof(float_image_t *)), "no mem"));
+    P->arena = (NS == 0 ? NULL : notnull(malloc(NS*sizeof(float)), "no mem"));
+    
+    /* Carve the images out of the arena and fill them: */
+    float *smp = P->arena;
+    NXk = NX; NYk = NY;
+    for (k = 0; k < NL; k++)
+      { P->img[k] = float_image_mscale_pyramid_header(NC, NXk, NYk, &smp);
+        if (M != NULL) { P->msk[k] = float_image_mscale_pyramid_header(NCM, NXk, NYk, &smp); }
+        if (k == 0)
+          { float_image_assign(P->img[0], A);
+            if (M != NULL) { float_image_assign(P->msk[0], M); }
+          }
+        else
+          { float_image_t *Mk = (M == NULL ? NULL : P->msk[k-1]);
+            float_image_mscale_shrink_into(P->img[k-1], Mk, P->img[k], dx, dy, nw, nth);
+            if (M != NULL) { float_image_mscale_mask_shrink_into(Mk, P->msk[k], dx, dy, nw, harm, nth); }
+          }
+        NXk = (NXk + 1)/2; NYk = (NYk + 1)/2;
+      }
+    assert(smp == P->arena + NS);
+    return P;
+  }
+
+float_image_t *float_image_mscale_pyramid_header(int NC, int NX, int NY, float **smpP)
+  {
+    float_image_t *A = (float_image_t *)notnull(malloc(sizeof(float_image_t)), "no mem");
+    A->sz[0] = NC; A->st[0] = (NC < 2 ? 0 : 1);
+    A->sz[1] = NX; A->st[1] = (NX < 2 ? 0 : NC);
+    A->sz[2] = NY; A->st[2] = (NY < 2 ? 0 : NC*NX);
+    A->bp = 0;
+    size_t NS = ((size_t)NC)*NX*NY;
+    A->sample = (NS == 0 ? NULL : (*smpP));
+    (*smpP) += NS;
+    (void)ix_parms_are_valid(3, A->sz, A->bp, A->st, /*die:*/ TRUE);
+    return A;
+  }
+
+void float_image_mscale_pyramid_free(float_image_mscale_pyramid_t *P)
+  {
+    int k;
+    for (k = 0; k < P->NL; k++)
+      { free(P->img[k]);
+        if (P->msk != NULL) { free(P->msk[k]); }
+      }
+    free(P->img);
+    if (P->msk != NULL) { free(P->msk); }
+    if (P->arena != NULL) { free(P->arena); }
+    free(P);
   }
 
 r2_t float_image_mscale_point_shrink(r2_t *pA, int dx, int dy, int nw)
@@ -2,7 +2,7 @@
 #define float_image_mscale_H
 
 /* Tools for multiscale image processing. */
-/* Last edited on 2010-05-04 00:23:33 by stolfi */
+/* Last edited on 2026-10-19 12:19:32 by stolfi */
 
 #include <bool.h>
 #include <r2.h>
@@ -73,6 +73,21 @@ r2_t float_image_mscale_point_expand(r2_t *pR, int dx, int dy, int nw);
 
 /* !!! Add {float_image_mscale_expand} generalizing {pst_height_map_expand} !!! */
 
+void float_image_mscale_shrink_into(float_image_t *A, float_image_t *M, float_image_t *R, int dx, int dy, int nw, int nth);
+  /* Same as {float_image_mscale_shrink}, but stores the result into
+    the given image {R}, which must have the same number of channels
+    as {A}; its size defines {NXR} and {NYR}.
+    
+    The filter is applied separably: each row of {A} is filtered
+    and decimated horizontally only once, and the vertical filter is
+    applied to those partial sums.  The rows of {R} are computed in
+    bands by {nth} threads (or the default number of threads, if {nth}
+    is zero).  The result does not depend on {nth}. */
+
+void float_image_mscale_mask_shrink_into(float_image_t *M, float_image_t *R, int dx, int dy, int nw, bool_t harm, int nth);
+  /* Same as {float_image_mscale_mask_shrink}, but stores the
+    result into the given image {R}, like {float_image_mscale_shrink_into}. */
+
 int float_image_mscale_rounding_bias(int n);
   /* A bias bit that may be useful to keep the image centered during reduction.
       For n =  0  1  2  3  4  5  6  7  8  9 10 11 12 13 14 15 16 17 
@@ -80,6 +95,53 @@ int float_image_mscale_rounding_bias(int n);
      !!! Find a use for this procedure !!! 
   */
 
+/* MULTISCALE PYRAMIDS */
+
+typedef struct float_image_mscale_pyramid_t
+  { int NL;               /* Number of levels. */
+    int dx;               /* Column shift of the reduction window. */
+    int dy;               /* Row shift of the reduction window. */
+    int nw;               /* Width of the reduction window. */
+    bool_t harm;          /* TRUE if masks are reduced with the harmonic mean. */
+    float_image_t **img;  /* The images of levels {0..NL-1}. */
+    float_image_t **msk;  /* The weight masks of levels {0..NL-1}, or {NULL}. */
+    float *arena;         /* Storage for the samples of all levels. */
+  } float_image_mscale_pyramid_t;
+  /* A multiscale pyramid of an image {A}.  Level 0 is a copy of {A},
+    and each level {k+1} is obtained from level {k} by
+    {float_image_mscale_shrink}, with parameters {dx,dy,nw} and the
+    mask of level {k}, if any.  A level with {NX} columns and {NY}
+    rows is reduced to {(NX+1)/2} columns and {(NY+1)/2} rows.
+    
+    If the pyramid has masks, {msk[0]} is a copy of the original
+    mask, and each {msk[k+1]} is obtained from {msk[k]} by
+    {float_image_mscale_mask_shrink} with the same {dx,dy,nw} and
+    {harm}.
+    
+    The samples of all images and masks are stored in the single
+    vector {arena}.  Therefore the images {img[k]} and {msk[k]}
+    must not be freed with {float_image_free}, and are valid
+    only until the pyramid is freed. */
+
+float_image_mscale_pyramid_t *float_image_mscale_pyramid_new
+  ( float_image_t *A, 
+    float_image_t *M, 
+    int NL, 
+    int dx, 
+    int dy, 
+    int nw, 
+    bool_t harm, 
+    int nth
+  );
+  /* Builds a pyramid with {NL} levels for the image {A}, with
+    weight mask {M} (which may be {NULL}).  Requires {NL >= 1}.
+    Each level is computed with {nth} threads, as in
+    {float_image_mscale_shrink_into}. */
+
+void float_image_mscale_pyramid_free(float_image_mscale_pyramid_t *P);
+  /* Frees all storage used by {P}, including the images
+    and masks of all levels and the record {*P} itself. */
+
 /* DEBUGGING I/O */
 
 char *float_image_mscale_file_name(char *filePrefix, int level, int iter, char *tag, char *ext);
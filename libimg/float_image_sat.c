@@ -0,0 +1,356 @@
+/* See {float_image_sat.h}. */
+/* Last edited on 2026-10-19 12:44:29 by stolfi */
+
+#define _GNU_SOURCE
+#include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <bool.h>
+#include <jsthread.h>
+#include <affirm.h>
+#include <jsmath.h>
+#include <float_image.h>
+#include <float_image_sat.h>
+
+/* INTERNAL PROTOTYPES */
+
+#define float_image_sat_BAND_ROWS 16
+  /* Number of image rows in each band of the parallel passes. */
+
+#define float_image_sat_BAND_COLS 256
+  /* Number of table columns in each band of the column pass. */
+
+typedef struct fisat_job_t
+  { float_image_t *A;       /* The image. */
+    int32_t c;              /* Channel of {A}. */
+    float_image_sat_t *T;   /* The tables being built or used. */
+    int32_t hw;             /* Window half-width. */
+    float_image_t *M;       /* Output image for the local means, or {NULL}. */
+    int32_t cM;             /* Channel of {M}. */
+    float_image_t *V;       /* Output image for the local variances, or {NULL}. */
+    int32_t cV;             /* Channel of {V}. */
+    int32_t NX, NY;         /* Size of computation domain. */
+    int32_t dXA, dYA;       /* Offsets of {A} in computation domain. */
+    int32_t dXM, dYM;       /* Offsets of {M} in computation domain. */
+    int32_t dXV, dYV;       /* Offsets of {V} in computation domain. */
+  } fisat_job_t;
+  /* Arguments for the parallel passes. */
+
+double float_image_sat_ref_value(float_image_t *A, int32_t c, bool_t *infP);
+  /* The mean of the finite samples of channel {c} of {A}, or 0 if
+    there are no such samples.  Also sets {*infP} to TRUE iff that
+    channel has any infinite samples. */
+
+double float_image_sat_box_diff(double *T, size_t NXT, int32_t x0, int32_t x1, int32_t y0, int32_t y1);
+  /* The sum of the entries in columns {x0..x1} and rows {y0..y1} of the 
+    image, computed from the table {T} with {NXT} columns.  Assumes that
+    the rectangle is non-empty and inside the image. */
+
+bool_t float_image_sat_clip_box(float_image_sat_t *T, int32_t *x0P, int32_t *x1P, int32_t *y0P, int32_t *y1P);
+  /* Clips the rectangle {*x0P..*x1P} by {*y0P..*y1P} to the image domain.
+    Returns FALSE if the result is empty. */
+
+void float_image_sat_row_pass(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Stores into row {y+1} of the tables of {job->T} the prefix sums
+    of row {y} of {job->A}, for {y} in {ini..fin}, where {job} is {arg}. */
+
+void float_image_sat_col_pass(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Accumulates the rows of the tables of {job->T} down the columns
+    {ini..fin}, where {job} is {arg}. */
+
+void float_image_sat_local_avg_var_rows(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Stores into {job->M} and {job->V} the local means and variances
+    for rows {ini..fin} of the computation domain, where {job} is {arg}. */
+
+/* IMPLEMENTATIONS */
+
+float_image_sat_t *float_image_sat_new(float_image_t *A, int32_t c, bool_t sqr, int32_t nth)
+  {
+    int32_t NC = (int32_t)A->sz[0];
+    demand((c >= 0) && (c < NC), "invalid channel");
+    int32_t NX = (int32_t)A->sz[1];
+    int32_t NY = (int32_t)A->sz[2];
+    float_image_sat_t *T = notnull(malloc(sizeof(float_image_sat_t)), "no mem");
+    T->NX = NX;
+    T->NY = NY;
+    bool_t inf;
+    T->ref = float_image_sat_ref_value(A, c, &inf);
+    size_t NT = ((size_t)NX + 1)*((size_t)NY + 1);
+    T->N = notnull(malloc(NT*sizeof(double)), "no mem");
+    T->S = notnull(malloc(NT*sizeof(double)), "no mem");
+    T->Q = (sqr ? notnull(malloc(NT*sizeof(double)), "no mem") : NULL);
+    T->NP = (inf ? notnull(malloc(NT*sizeof(double)), "no mem") : NULL);
+    T->NM = (inf ? notnull(malloc(NT*sizeof(double)), "no mem") : NULL);
+
+    /* Row 0 of the tables is all zeros: */
+    int32_t x;
+    for (x = 0; x <= NX; x++)
+      { T->N[x] = 0; T->S[x] = 0; if (sqr) { T->Q[x] = 0; } 
+        if (inf) { T->NP[x] = 0; T->NM[x] = 0; }
+      }
+
+    fisat_job_t job = (fisat_job_t){ .A = A, .c = c, .T = T };
+    jsthread_run_ranges(NY, float_image_sat_BAND_ROWS, nth, &float_image_sat_row_pass, &job);
+    jsthread_run_ranges(NX + 1, float_image_sat_BAND_COLS, nth, &float_image_sat_col_pass, &job);
+    return T;
+  }
+
+void float_image_sat_free(float_image_sat_t *T)
+  {
+    free(T->N);
+    free(T->S);
+    if (T->Q != NULL) { free(T->Q); }
+    if (T->NP != NULL) { free(T->NP); }
+    if (T->NM != NULL) { free(T->NM); }
+    free(T);
+  }
+
+double float_image_sat_ref_value(float_image_t *A, int32_t c, bool_t *infP)
+  {
+    int32_t NX = (int32_t)A->sz[1];
+    int32_t NY = (int32_t)A->sz[2];
+    double sum = 0;
+    double n = 0;
+    bool_t inf = FALSE;
+    int32_t x, y;
+    for (y = 0; y < NY; y++)
+      { float *pA = float_image_get_sample_address(A, c, 0, y);
+        for (x = 0; x < NX; x++)
+          { double v = (*pA);
+            if (isfinite(v)) 
+              { sum += v; n++; }
+            else if (isinf(v))
+              { inf = TRUE; }
+            pA += A->st[1];
+          }
+      }
+    (*infP) = inf;
+    return (n == 0 ? 0.0 : sum/n);
+  }
+
+void float_image_sat_row_pass(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fisat_job_t *job = (fisat_job_t *)arg;
+    float_image_t *A = job->A;
+    float_image_sat_t *T = job->T;
+    int32_t NX = T->NX;
+    double ref = T->ref;
+    bool_t sqr = (T->Q != NULL);
+    bool_t inf = (T->NP != NULL);
+    int32_t x, y;
+    for (y = ini; y <= fin; y++)
+      { size_t k = ((size_t)NX + 1)*((size_t)y + 1);
+        float *pA = float_image_get_sample_address(A, job->c, 0, y);
+        double n = 0, s = 0, q = 0, np = 0, nm = 0;
+        T->N[k] = 0; T->S[k] = 0; if (sqr) { T->Q[k] = 0; }
+        if (inf) { T->NP[k] = 0; T->NM[k] = 0; }
+        for (x = 0; x < NX; x++)
+          { double v = (*pA);
+            if (isfinite(v))
+              { double d = v - ref;
+                n += 1; s += d; q += d*d;
+              }
+            else if (isinf(v))
+              { if (v > 0) { np += 1; } else { nm += 1; } }
+            k++;
+            T->N[k] = n; T->S[k] = s; if (sqr) { T->Q[k] = q; }
+            if (inf) { T->NP[k] = np; T->NM[k] = nm; }
+            pA += A->st[1];
+          }
+      }
+  }
+
+void float_image_sat_col_pass(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fisat_job_t *job = (fisat_job_t *)arg;
+    float_image_sat_t *T = job->T;
+    size_t NXT = (size_t)T->NX + 1;
+    int32_t x, y;
+    for (y = 2; y <= T->NY; y++)
+      { double *N1 = &(T->N[NXT*(size_t)y]), *N0 = N1 - NXT;
+        double *S1 = &(T->S[NXT*(size_t)y]), *S0 = S1 - NXT;
+        for (x = ini; x <= fin; x++) { N1[x] += N0[x]; S1[x] += S0[x]; }
+        if (T->Q != NULL)
+          { double *Q1 = &(T->Q[NXT*(size_t)y]), *Q0 = Q1 - NXT;
+            for (x = ini; x <= fin; x++) { Q1[x] += Q0[x]; }
+          }
+        if (T->NP != NULL)
+          { double *P1 = &(T->NP[NXT*(size_t)y]), *P0 = P1 - NXT;
+            double *M1 = &(T->NM[NXT*(size_t)y]), *M0 = M1 - NXT;
+            for (x = ini; x <= fin; x++) { P1[x] += P0[x]; M1[x] += M0[x]; }
+          }
+      }
+  }
+
+void float_image_sat_box_sums
+  ( float_image_sat_t *T,
+    int32_t x0,
+    int32_t x1,
+    int32_t y0,
+    int32_t y1,
+    double *nP,
+    double *sP,
+    double *qP
+  )
+  {
+    demand((qP == NULL) || (T->Q != NULL), "squares table was not built");
+    if (! float_image_sat_clip_box(T, &x0, &x1, &y0, &y1))
+      { if (nP != NULL) { (*nP) = 0; }
+        if (sP != NULL) { (*sP) = 0; }
+        if (qP != NULL) { (*qP) = 0; }
+        return;
+      }
+    size_t NXT = (size_t)T->NX + 1;
+    if (nP != NULL) { (*nP) = float_image_sat_box_diff(T->N, NXT, x0, x1, y0, y1); }
+    if (sP != NULL) { (*sP) = float_image_sat_box_diff(T->S, NXT, x0, x1, y0, y1); }
+    if (qP != NULL) { (*qP) = float_image_sat_box_diff(T->Q, NXT, x0, x1, y0, y1); }
+  }
+
+void float_image_sat_box_inf_counts
+  ( float_image_sat_t *T,
+    int32_t x0,
+    int32_t x1,
+    int32_t y0,
+    int32_t y1,
+    double *npP,
+    double *nmP
+  )
+  {
+    if ((T->NP == NULL) || (! float_image_sat_clip_box(T, &x0, &x1, &y0, &y1)))
+      { (*npP) = 0; (*nmP) = 0; return; }
+    size_t NXT = (size_t)T->NX + 1;
+    (*npP) = float_image_sat_box_diff(T->NP, NXT, x0, x1, y0, y1);
+    (*nmP) = float_image_sat_box_diff(T->NM, NXT, x0, x1, y0, y1);
+  }
+
+bool_t float_image_sat_clip_box(float_image_sat_t *T, int32_t *x0P, int32_t *x1P, int32_t *y0P, int32_t *y1P)
+  {
+    if ((*x0P) < 0) { (*x0P) = 0; }
+    if ((*y0P) < 0) { (*y0P) = 0; }
+    if ((*x1P) >= T->NX) { (*x1P) = T->NX - 1; }
+    if ((*y1P) >= T->NY) { (*y1P) = T->NY - 1; }
+    return ((*x0P) <= (*x1P)) && ((*y0P) <= (*y1P));
+  }
+
+double float_image_sat_box_diff(double *T, size_t NXT, int32_t x0, int32_t x1, int32_t y0, int32_t y1)
+  {
+    /* Indices of the four corners in the table: */
+    size_t k00 = NXT*(size_t)y0 + (size_t)x0;
+    size_t k01 = NXT*(size_t)y0 + (size_t)x1 + 1;
+    size_t k10 = NXT*((size_t)y1 + 1) + (size_t)x0;
+    size_t k11 = NXT*((size_t)y1 + 1) + (size_t)x1 + 1;
+    return (T[k11] - T[k10]) - (T[k01] - T[k00]);
+  }
+
+void float_image_sat_box_avg_var
+  ( float_image_sat_t *T,
+    int32_t x0,
+    int32_t x1,
+    int32_t y0,
+    int32_t y1,
+    double *avgP,
+    double *varP
+  )
+  {
+    double np, nm;
+    float_image_sat_box_inf_counts(T, x0, x1, y0, y1, &np, &nm);
+    if ((np > 0) || (nm > 0))
+      { if (avgP != NULL) { (*avgP) = (nm <= 0 ? +INF : (np <= 0 ? -INF : NAN)); }
+        if (varP != NULL) { (*varP) = NAN; }
+        return;
+      }
+    double n, s, q;
+    float_image_sat_box_sums(T, x0, x1, y0, y1, &n, &s, (varP == NULL ? NULL : &q));
+    if (n <= 0)
+      { if (avgP != NULL) { (*avgP) = NAN; }
+        if (varP != NULL) { (*varP) = NAN; }
+        return;
+      }
+    double dav = s/n;
+    if (avgP != NULL) { (*avgP) = T->ref + dav; }
+    if (varP != NULL) { double var = q/n - dav*dav; (*varP) = (var < 0 ? 0 : var); }
+  }
+
+void float_image_sat_local_avg_var
+  ( float_image_t *A,
+    int32_t cA,
+    int32_t hw,
+    float_image_t *M,
+    int32_t cM,
+    float_image_t *V,
+    int32_t cV,
+    int32_t nth
+  )
+  {
+    demand(hw >= 0, "invalid window half-width");
+    int32_t NXA = (int32_t)A->sz[1];
+    int32_t NYA = (int32_t)A->sz[2];
+    /* Get {M} size and check channels: */
+    int32_t NXM, NYM;
+    if (M != NULL)
+      { int32_t NCM = (int32_t)M->sz[0];
+        demand((cM >= 0) && (cM < NCM), "invalid {M} channel");
+        NXM = (int32_t)M->sz[1];
+        NYM = (int32_t)M->sz[2];
+      }
+    else
+      { NXM = NYM = 0; }
+    /* Get {V} size and check channels: */
+    int32_t NXV, NYV;
+    if (V != NULL)
+      { int32_t NCV = (int32_t)V->sz[0];
+        demand((cV >= 0) && (cV < NCV), "invalid {V} channel");
+        NXV = (int32_t)V->sz[1];
+        NYV = (int32_t)V->sz[2];
+      }
+    else
+      { NXV = NYV = 0; }
+
+    /* Build the tables ({float_image_sat_new} checks {cA}): */
+    float_image_sat_t *T = float_image_sat_new(A, cA, (V != NULL), nth);
+
+    /* Determine computation domain and ofsets from it: */
+    fisat_job_t job = (fisat_job_t){ .A = A, .c = cA, .T = T, .hw = hw, .M = M, .cM = cM, .V = V, .cV = cV };
+    job.NX = (NXM > NXV ? NXM : NXV);
+    job.NY = (NYM > NYV ? NYM : NYV);
+    job.dXA = (job.NX - NXA)/2; job.dYA = (job.NY - NYA)/2;
+    job.dXM = (job.NX - NXM)/2; job.dYM = (job.NY - NYM)/2;
+    job.dXV = (job.NX - NXV)/2; job.dYV = (job.NY - NYV)/2;
+    jsthread_run_ranges(job.NY, float_image_sat_BAND_ROWS, nth, &float_image_sat_local_avg_var_rows, &job);
+
+    float_image_sat_free(T);
+  }
+
+void float_image_sat_local_avg_var_rows(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fisat_job_t *job = (fisat_job_t *)arg;
+    int32_t hw = job->hw;
+    float_image_t *M = job->M;
+    float_image_t *V = job->V;
+    int32_t x, y;
+    for (y = ini; y <= fin; y++)
+      { int32_t yA = y - job->dYA;
+        int32_t yM = y - job->dYM;
+        int32_t yV = y - job->dYV;
+        bool_t okM = ((M != NULL) && (yM >= 0) && (yM < M->sz[2]));
+        bool_t okV = ((V != NULL) && (yV >= 0) && (yV < V->sz[2]));
+        if ((! okM) && (! okV)) { continue; }
+        for (x = 0; x < job->NX; x++)
+          { int32_t xA = x - job->dXA;
+            double avg, var;
+            float_image_sat_box_avg_var(job->T, xA - hw, xA + hw, yA - hw, yA + hw, &avg, (V != NULL ? &var : NULL));
+            if (okM)
+              { int32_t xM = x - job->dXM;
+                if ((xM >= 0) && (xM < M->sz[1]))
+                  { float_image_set_sample(M, job->cM, xM, yM, (float)avg); }
+              }
+            if (okV)
+              { int32_t xV = x - job->dXV;
+                if ((xV >= 0) && (xV < V->sz[1]))
+                  { float_image_set_sample(V, job->cV, xV, yV, (float)var); }
+              }
+          }
+      }
+  }
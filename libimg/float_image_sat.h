@@ -0,0 +1,128 @@
+#ifndef float_image_sat_H
+#define float_image_sat_H
+
+/* float_image_sat.h - summed-area tables for fast box statistics of float images. */
+/* Last edited on 2026-10-19 12:44:29 by stolfi */
+
+#include <stdint.h>
+
+#include <bool.h>
+#include <float_image.h>
+
+/*
+  A /summed-area table/ (or /integral image/) of a channel of an image
+  {A} with {NX} columns and {NY} rows is a table {T} with {NX+1}
+  columns and {NY+1} rows, such that {T[x,y]} is the sum of all
+  samples of {A} in columns {0..x-1} and rows {0..y-1}.  With it,
+  the sum of the samples in any rectangle can be obtained from
+  four table entries, in time independent of the rectangle's size.
+
+  The tables are kept in {double}, so that they are exact for
+  moderately large images with {float} samples, apart from the
+  subtraction of the reference value below.
+  
+  Infinite samples cannot be added into the tables without spoiling
+  every later entry, so they are counted in two separate tables, by
+  sign.  A box that contains any of them has infinite or {NAN} mean
+  and {NAN} variance, as it would if the samples were added directly. */
+
+typedef struct float_image_sat_t
+  { int32_t NX;   /* Number of columns of the image. */
+    int32_t NY;   /* Number of rows of the image. */
+    double ref;   /* Reference value subtracted from the samples. */
+    double *N;    /* Table of counts of non-{NAN} samples. */
+    double *S;    /* Table of sums of {v - ref} over non-{NAN} samples {v}. */
+    double *Q;    /* Table of sums of {(v - ref)^2}, or {NULL}. */
+    double *NP;   /* Table of counts of {+INF} samples, or {NULL}. */
+    double *NM;   /* Table of counts of {-INF} samples, or {NULL}. */
+  } float_image_sat_t;
+  /* Summed-area tables for one channel of an image with {NX} columns
+    and {NY} rows.  The entry {T[x,y]} of each table is stored in
+    element {(NX+1)*y + x}, for {x} in {0..NX} and {y} in {0..NY}.
+
+    Samples that are {NAN} are ignored, that is, they are not counted
+    in {N} and do not contribute to {S} or {Q}.  Samples that are {+INF}
+    or {-INF} are counted only in {NP} or {NM}, respectively; those two
+    tables are {NULL} if the channel has no infinite samples.  The
+    reference value {ref} is the mean of the finite samples, and is
+    subtracted from every sample in order to reduce the cancellation
+    errors in the computation of variances. */
+
+float_image_sat_t *float_image_sat_new(float_image_t *A, int32_t c, bool_t sqr, int32_t nth);
+  /* Builds the summed-area tables for channel {c} of image {A}.  The
+    table {Q} of squared values is computed only if {sqr} is true.
+
+    The tables are built with {nth} threads (or the default number of
+    threads, if {nth} is zero). Each thread computes first the prefix
+    sums of a band of rows, and then the prefix sums down a band of
+    columns.  The result does not depend on {nth}. */
+
+void float_image_sat_free(float_image_sat_t *T);
+  /* Frees the tables of {T}, including the record {*T} itself. */
+
+void float_image_sat_box_sums
+  ( float_image_sat_t *T,
+    int32_t x0,
+    int32_t x1,
+    int32_t y0,
+    int32_t y1,
+    double *nP,
+    double *sP,
+    double *qP
+  );
+  /* Stores into {*nP} the number of finite samples in columns
+    {x0..x1} and rows {y0..y1} of the image, into {*sP} the sum of
+    {v - T.ref} for those samples {v}, and into {*qP} the sum of
+    {(v - T.ref)^2}. The rectangle is implicitly clipped to the image's
+    domain, and may be empty.  Any of {nP,sP,qP} may be {NULL};
+    {qP} must be {NULL} if the table {T.Q} was not built. */
+
+void float_image_sat_box_inf_counts
+  ( float_image_sat_t *T,
+    int32_t x0,
+    int32_t x1,
+    int32_t y0,
+    int32_t y1,
+    double *npP,
+    double *nmP
+  );
+  /* Stores into {*npP} and {*nmP} the number of samples that are {+INF}
+    and {-INF}, respectively, in columns {x0..x1} and rows {y0..y1} of
+    the image, clipped as in {float_image_sat_box_sums}. */
+
+void float_image_sat_box_avg_var
+  ( float_image_sat_t *T,
+    int32_t x0,
+    int32_t x1,
+    int32_t y0,
+    int32_t y1,
+    double *avgP,
+    double *varP
+  );
+  /* Stores into {*avgP} and {*varP} the mean and variance of the
+    non-{NAN} samples in columns {x0..x1} and rows {y0..y1} of the
+    image, clipped as in {float_image_sat_box_sums}.  Both are {NAN} if
+    there are no such samples.  If there are infinite samples, the mean
+    is {+INF} or {-INF} if they all have the same sign, and {NAN}
+    otherwise; and the variance is {NAN}.  Otherwise the variance is
+    never negative.  Either
+    of {avgP,varP} may be {NULL}; {varP} must be {NULL} if the table
+    {T.Q} was not built. */
+
+void float_image_sat_local_avg_var
+  ( float_image_t *A,
+    int32_t cA,
+    int32_t hw,
+    float_image_t *M,
+    int32_t cM,
+    float_image_t *V,
+    int32_t cV,
+    int32_t nth
+  );
+  /* Same as {float_image_local_avg_var}, but with a uniform
+    weight profile, that is, a square window with {2*hw+1} columns
+    and rows where all samples have the same weight.  The cost per
+    pixel does not depend on {hw}.  Uses {nth} threads to build the
+    tables and to fill {M} and {V} (see {float_image_sat_new}). */
+
+#endif
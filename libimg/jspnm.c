@@ -1,5 +1,5 @@
 /* See jspnm.h */
-/* Last edited on 2016-04-10 03:51:40 by stolfilocal */
+/* Last edited on 2026-10-19 11:39:58 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <limits.h>
@@ -238,6 +238,72 @@ void pnm_write_raw_short(FILE *wr, uint16_t ival, uint16_t maxval)
     putc((char)(ival&255), wr);
   }
 
+void pnm_read_raw_bytes(FILE *rd, int n, uint16_t smp[], uint16_t maxval)
+  { uint8_t buf[PNM_RAW_BLOCK_BYTES];
+    int k = 0;
+    while (k < n)
+      { int nb = (n - k < PNM_RAW_BLOCK_BYTES ? n - k : PNM_RAW_BLOCK_BYTES);
+        if (fread(buf, 1, nb, rd) != nb) { pnm_error("unexpected EOF in sample"); }
+        uint16_t *sP = &(smp[k]);
+        for (int i = 0; i < nb; i++) { sP[i] = buf[i]; }
+        if (maxval < 255)
+          { for (int i = 0; i < nb; i++) 
+              { if (sP[i] > maxval) { pnm_check_sample_range(&(sP[i]), maxval); } }
+          }
+        k += nb;
+      }
+  }
+
+void pnm_read_raw_shorts(FILE *rd, int n, uint16_t smp[], uint16_t maxval)
+  { uint8_t buf[PNM_RAW_BLOCK_BYTES];
+    int k = 0;
+    while (k < n)
+      { int ns = (n - k < PNM_RAW_BLOCK_BYTES/2 ? n - k : PNM_RAW_BLOCK_BYTES/2);
+        if (fread(buf, 2, ns, rd) != ns) { pnm_error("unexpected EOF in sample"); }
+        uint16_t *sP = &(smp[k]);
+        for (int i = 0; i < ns; i++) 
+          { sP[i] = (uint16_t)((((uint16_t)buf[2*i]) << 8) | buf[2*i+1]); }
+        if (maxval < 65535)
+          { for (int i = 0; i < ns; i++) 
+              { if (sP[i] > maxval) { pnm_check_sample_range(&(sP[i]), maxval); } }
+          }
+        k += ns;
+      }
+  }
+
+void pnm_write_raw_bytes(FILE *wr, int n, uint16_t smp[], uint16_t maxval)
+  { uint8_t buf[PNM_RAW_BLOCK_BYTES];
+    int k = 0;
+    while (k < n)
+      { int nb = (n - k < PNM_RAW_BLOCK_BYTES ? n - k : PNM_RAW_BLOCK_BYTES);
+        uint16_t *sP = &(smp[k]);
+        for (int i = 0; i < nb; i++) 
+          { uint16_t ival = sP[i];
+            if (ival > maxval) { pnm_check_sample_range(&ival, maxval); }
+            buf[i] = (uint8_t)(ival & 255);
+          }
+        if (fwrite(buf, 1, nb, wr) != nb) { pnm_error("error writing samples"); }
+        k += nb;
+      }
+  }
+
+void pnm_write_raw_shorts(FILE *wr, int n, uint16_t smp[], uint16_t maxval)
+  { uint8_t buf[PNM_RAW_BLOCK_BYTES];
+    int k = 0;
+    while (k < n)
+      { int ns = (n - k < PNM_RAW_BLOCK_BYTES/2 ? n - k : PNM_RAW_BLOCK_BYTES/2);
+        uint16_t *sP = &(smp[k]);
+        for (int i = 0; i < ns; i++) 
+          { uint16_t ival = sP[i];
+            if (ival > maxval) { pnm_check_sample_range(&ival, maxval); }
+            buf[2*i] = (uint8_t)((ival >> 8) & 255);
+            buf[2*i+1] = (uint8_t)(ival & 255);
+          }
+        if (fwrite(buf, 2, ns, wr) != ns) { pnm_error("error writing samples"); }
+        k += ns;
+      }
+  }
+
 uint16_t pnm_quantize(double fval, uint16_t maxval, bool_t isMask, uint32_t badval)
   { /* Maxval with more bits: */
     int N = (uint32_t)maxval;
@@ -364,11 +430,17 @@ void pnm_read_pixels
         assert(maxval == 1);
         if (raw)
           { /* Bits packed 8 per byte, big-endianly, complemented, row padded to 8 bits: */
-            uint16_t ival;
+            int nbytes = (samples_per_row + 7)/8;
+            uint8_t buf[PNM_RAW_BLOCK_BYTES];
             for (k = 0, sP = smp; k < samples_per_row; k++)
-              { if (k % 8 == 0) { ival = pnm_read_raw_byte(rd, 255); }
-                (*sP) = ((ival & 128) == 0); ++sP; 
-                ival = (uint16_t)(((int32_t)ival) << 1);
+              { int kb = (k/8) % PNM_RAW_BLOCK_BYTES; /* Index of byte in {buf}. */
+                if ((k % (8*PNM_RAW_BLOCK_BYTES)) == 0)
+                  { /* Read the next block of bytes: */
+                    int nb = nbytes - k/8;
+                    if (nb > PNM_RAW_BLOCK_BYTES) { nb = PNM_RAW_BLOCK_BYTES; }
+                    if (fread(buf, 1, nb, rd) != nb) { pnm_error("unexpected EOF in sample"); }
+                  }
+                (*sP) = ((buf[kb] & (128 >> (k % 8))) == 0); ++sP; 
               }
           }
         else
@@ -385,17 +457,11 @@ void pnm_read_pixels
           { /* Raw PGM/PPM format (binary samples). */
             if (maxval <= max_byte)
               { /* One byte per sample: */
-                for (k = 0, sP = smp; k < samples_per_row; k++)
-                  { uint16_t ival = pnm_read_raw_byte(rd, maxval);
-                    *sP = ival; ++sP;
-                  }
+                pnm_read_raw_bytes(rd, samples_per_row, smp, maxval);
               }
             else if (maxval <= max_short)
               { /* Two bytes per sample: */
-                for (k = 0, sP = smp; k < samples_per_row; k++)
-                  { uint16_t ival = pnm_read_raw_short(rd, maxval);
-                    *sP = ival; ++sP;
-                  }
+                pnm_read_raw_shorts(rd, samples_per_row, smp, maxval);
               }
             else
               { pnm_error("maxval (%u) is too large for raw PGM format", maxval); }
@@ -464,17 +530,11 @@ void pnm_write_pixels
           { /* Raw PGM/PPM format  (binary pixels). */
             if (maxval <= max_byte)
               { /* Raw single-byte format: */
-                for (k = 0, sP = smp; k < samples_per_row; k++)
-                  { uint16_t ival = *sP; ++sP;
-                    pnm_write_raw_byte(wr, ival, maxval);
-                  }
+                pnm_write_raw_bytes(wr, samples_per_row, smp, maxval);
               }
             else if (maxval <= max_short)
               { /* Raw two-byte format: */
-                for (k = 0, sP = smp; k < samples_per_row; k++)
-                  { uint16_t ival = *sP; ++sP;
-                    pnm_write_raw_short(wr, ival, maxval);
-                  }
+                pnm_write_raw_shorts(wr, samples_per_row, smp, maxval);
               }
             else
               { pnm_error("maxval (%u) is too large for raw PGM format", maxval); }
@@ -1,5 +1,5 @@
 /* jspnm.h - basic definitions for reading/writing PBM/PGM/PBM files. */
-/* Last edited on 2017-06-20 22:46:13 by stolfilocal */ 
+/* Last edited on 2026-10-19 11:39:58 by stolfilocal */ 
 
 #ifndef jspnm_H
 #define jspnm_H
@@ -163,6 +163,24 @@ void pnm_write_raw_short(FILE *wr, uint16_t ival, uint16_t maxval);
   /* Writes the 16-bit unsigned int {ival} to {wr}, as two bytes,
     big-endian way. */
 
+void pnm_read_raw_bytes(FILE *rd, int n, uint16_t smp[], uint16_t maxval);
+void pnm_read_raw_shorts(FILE *rd, int n, uint16_t smp[], uint16_t maxval);
+  /* These procedures read {n} consecutive samples from {rd} and store them 
+    into {smp[0..n-1]}.  They are equivalent to {n} calls to 
+    {pnm_read_raw_byte} or {pnm_read_raw_short}, respectively,
+    but read the data with {fread} in blocks of up to {PNM_RAW_BLOCK_BYTES}
+    bytes and convert them with a simple loop. */
+
+void pnm_write_raw_bytes(FILE *wr, int n, uint16_t smp[], uint16_t maxval);
+void pnm_write_raw_shorts(FILE *wr, int n, uint16_t smp[], uint16_t maxval);
+  /* These procedures write the samples {smp[0..n-1]} to {wr}.  They are equivalent to {n} calls to 
+    {pnm_write_raw_byte} or {pnm_write_raw_short}, respectively,
+    but convert the samples into a buffer and write it with {fwrite} in blocks
+    of up to {PNM_RAW_BLOCK_BYTES} bytes. */
+
+#define PNM_RAW_BLOCK_BYTES 8192
+  /* Size of the buffer used by {pnm_read_raw_bytes} and similar procedures. */
+
 bool_t pnm_uint_leq(uint32_t x, uint32_t xmax);
   /* Returns TRUE iff {x <= xmax}.  Handy hack to avoid warnings
      about "comparison always true due to limited data range". */
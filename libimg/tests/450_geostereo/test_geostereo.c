@@ -2,7 +2,7 @@
 #define PROG_DESC "test of {float_image_geostereo.h} and {float_image_geostereo_uniscale.h}"
 #define PROG_VERS "1.0"
 
-/* Last edited on 2017-06-26 04:20:01 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:55:42 by stolfilocal */ 
 /* Created on 2009-06-02 by J. Stolfi, UNICAMP */
 
 #define test_geostereo_COPYRIGHT \
@@ -18,6 +18,7 @@
 #include <bool.h>
 #include <jsfile.h>
 #include <affirm.h>
+#include <wt_table.h>
 #include <float_image.h>
 #include <float_image_read_pnm.h>
 #include <float_image_write_pnm.h>
@@ -37,6 +38,32 @@ void do_geostereo_tests(char *name0, char *name1, int32_t NC, int32_t ncands);
     "out/disp-{ncands}.{ext}" and "out/score-{ncands}.{ext} where {ext}
     is "fni" always, "pgm" if {ncands} is 1, "ppm" if {ncands} is 3. */
 
+void check_same_maps
+  ( float_image_t *f1, 
+    float_image_t *f2, 
+    int32_t nwx, 
+    int32_t nwy,
+    float_image_t *fd, 
+    float_image_t *fs, 
+    float_image_t *gd, 
+    float_image_t *gs
+  );
+  /* Checks whether the dispmap and scoremap {fd,fs} computed by
+    {float_image_geostereo_uniscale} from images {f1,f2} with an {nwx}
+    by {nwy} window agree with the maps {gd,gs} computed by
+    {float_image_geostereo_uniscale_volume}.  Fails with an error
+    message if they do not.
+    
+    The two procedures add the same terms in different orders, so their
+    scores may differ by rounding errors.  Where the score is nearly
+    constant over a range of displacements (e.g. where the images are
+    flat) those errors may create or destroy local minima, and so change
+    the lesser candidates.  Therefore, at pixels where the maps are not
+    identical, the procedure only requires that the best scores agree,
+    and that every score in {gs} is the score that
+    {float_image_geostereo_single_disp_score} gives for the 
+    displacement in {gd}, apart from rounding errors. */
+
 float_image_t *get_test_image(char *name, int32_t NC);
   /* Reads a test image from "in/{name}.{ext}" where {ext} is "pgm"
     if {NC} is 1, "ppm" if it is 3. */ 
@@ -85,6 +112,20 @@ void do_geostereo_tests(char *name0, char *name1, int32_t NC, int32_t ncands)
         ncands,
         &imgd, &imgs
       );
+      
+    /* Compare with the cost-volume version: */
+    float_image_t *imgdv; /* Displacement map. */
+    float_image_t *imgsv; /* Score map. */
+    float_image_geostereo_uniscale_volume
+      ( img0, img1, 
+        nwx, nwy, 
+        dmin, dmax, 
+        ncands, 0,
+        &imgdv, &imgsv
+      );
+    check_same_maps(img0, img1, nwx, nwy, imgd, imgs, imgdv, imgsv);
+    float_image_free(imgdv);
+    float_image_free(imgsv);
     
     write_image(imgd, "disp", dmin, dmax);
     double smax = 1.0; /* Guessing. */
@@ -97,6 +138,81 @@ void do_geostereo_tests(char *name0, char *name1, int32_t NC, int32_t ncands)
     float_image_free(img1);
   }   
 
+void check_same_maps
+  ( float_image_t *f1, 
+    float_image_t *f2, 
+    int32_t nwx, 
+    int32_t nwy,
+    float_image_t *fd, 
+    float_image_t *fs, 
+    float_image_t *gd, 
+    float_image_t *gs
+  )
+  {
+    int32_t NC, NX, NY;
+    float_image_get_size(fd, &NC, &NX, &NY);
+    float_image_check_size(fs, NC, NX, NY);
+    float_image_check_size(gd, NC, NX, NY);
+    float_image_check_size(gs, NC, NX, NY);
+    int32_t NCI = (int32_t)f1->sz[0];
+    
+    /* Window weights, as in {float_image_geostereo_uniscale}: */
+    double wtx[nwx]; wt_table_fill_binomial(nwx, wtx);
+    double wty[nwy]; wt_table_fill_binomial(nwy, wty);
+    double wt[nwx*nwy];
+    for (int32_t iy = 0; iy < nwy; iy++)
+      { for (int32_t ix = 0; ix < nwx; ix++) { wt[ix + nwx*iy] = wtx[ix]*wty[iy]; } }
+    double smp1[NCI*nwx*nwy], smp2[NCI*nwx*nwy];
+    
+    double tol = 1.0e-6; /* Relative tolerance for scores, which are stored as {float}. */
+    int32_t ndif = 0; /* Number of pixels where the maps are not identical. */
+    int32_t nbad = 0; /* Number of pixels where they disagree. */
+    for (int32_t y = 0; y < NY; y++)
+      { for (int32_t x = 0; x < NX; x++)
+          { bool_t same = TRUE;
+            for (int32_t c = 0; c < NC; c++)
+              { float fdv = float_image_get_sample(fd, c, x, y);
+                float gdv = float_image_get_sample(gd, c, x, y);
+                float fsv = float_image_get_sample(fs, c, x, y);
+                float gsv = float_image_get_sample(gs, c, x, y);
+                if ((fdv != gdv) || (fsv != gsv)) { same = FALSE; }
+              }
+            if (same) { continue; }
+            ndif++;
+            /* The best scores must agree: */
+            double fs0 = float_image_get_sample(fs, 0, x, y);
+            double gs0 = float_image_get_sample(gs, 0, x, y);
+            bool_t ok = (fabs(fs0 - gs0) <= tol*(1.0 + fabs(fs0)));
+            /* Each candidate in {gd,gs} must have the right score: */
+            for (int32_t c = 0; (c < NC) && ok; c++)
+              { double gdv = float_image_get_sample(gd, c, x, y);
+                double gsv = float_image_get_sample(gs, c, x, y);
+                if (isfinite(gdv))
+                  { double sv = float_image_geostereo_single_disp_score
+                      ( f1, f2, (uint32_t)x, (uint32_t)y, gdv, 
+                        (uint32_t)nwx, (uint32_t)nwy, wt, FALSE, smp1, smp2
+                      );
+                    ok = (fabs(gsv - sv) <= tol*(1.0 + fabs(sv)));
+                  }
+                else
+                  { ok = (gsv == +INF); }
+              }
+            if (! ok)
+              { if (nbad < 10) 
+                  { fprintf(stderr, "  x = %d y = %d\n", x, y);
+                    for (int32_t c = 0; c < NC; c++)
+                      { fprintf(stderr, "    d = %10.3f %10.3f", float_image_get_sample(fd, c, x, y), float_image_get_sample(gd, c, x, y));
+                        fprintf(stderr, "  s = %10.6f %10.6f\n", float_image_get_sample(fs, c, x, y), float_image_get_sample(gs, c, x, y));
+                      }
+                  }
+                nbad++;
+              }
+          }
+      }
+    fprintf(stderr, "  %d pixels differ, %d disagree\n", ndif, nbad);
+    demand(nbad == 0, "volume and direct maps disagree");
+  }
+
 float_image_t *get_test_image(char *name, int32_t NC)
   {
     demand((NC == 1) || (NC == 3), "bad num of channels");
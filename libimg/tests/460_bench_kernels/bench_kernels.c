@@ -0,0 +1,222 @@
+#define PROG_NAME "bench_kernels"
+#define PROG_DESC "measures the throughput of some {libimg} kernels"
+#define PROG_VERS "1.0"
+
+/* Last edited on 2026-10-19 13:23:25 by stolfi */
+/* Created on 2026-10-19 by J. Stolfi, UNICAMP */
+
+#define PROG_COPYRIGHT \
+  "Copyright  2026  by the State University of Campinas (UNICAMP)"
+
+#define PROG_HELP \
+  "  " PROG_NAME " [ {BASEFILE} ] > {OUTFILE}"
+
+#define PROG_INFO \
+  "  Runs benchmarks of image transformation, filtering, interpolation" \
+  ", stereo matching, box statistics and pyramids, for several image sizes and thread counts," \
+  " and writes the results to {stdout} in the format of {tfn_bench_write}." \
+  "  If {BASEFILE} is given, also compares the results with those in" \
+  " that file and writes the comparison to {stderr}.  Returns status 1" \
+  " if any benchmark got slower than the baseline."
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsfile.h>
+#include <jsrandom.h>
+#include <timefunc.h>
+#include <r2.h>
+#include <r2x2.h>
+#include <ix.h>
+#include <float_image.h>
+#include <float_image_transform.h>
+#include <float_image_filter.h>
+#include <float_image_interpolate.h>
+#include <float_image_geostereo_uniscale.h>
+#include <float_image_sat.h>
+#include <float_image_mscale.h>
+
+#define MIN_USEC (500000.0)
+  /* Min total real time of each benchmark. */
+
+#define TOL (0.10)
+  /* Relative tolerance for regressions. */
+
+int main (int argc, char **argv);
+
+typedef struct bk_data_t
+  { float_image_t *A;   /* Input image. */
+    float_image_t *A2;  /* Second input image (for stereo). */
+    float_image_t *B;   /* Output image. */
+    int32_t nth;        /* Number of threads. */
+  } bk_data_t;
+  /* Data for the benchmarks. */
+
+float_image_t *bk_make_image(int32_t NC, int32_t NX, int32_t NY, double shift);
+  /* Creates a smooth random-looking image, displaced {shift}
+    pixels to the right. */
+
+void bk_transform_proc(void *arg);
+  /* Rotates the image {A} into {B} with {float_image_transform_all}. */
+
+void bk_rotate_map(r2_t *p, r2x2_t *J);
+  /* The inverse map for {bk_transform_proc}. */
+
+void bk_filter_proc(void *arg);
+  /* Copies {A} into {B} and applies {float_image_filter_gaussian_band}
+    to {B}, so that {A} is not changed.  The time includes the copy. */
+
+void bk_resample_proc(void *arg);
+  /* Resamples {A} into {B} with {float_image_interpolate_grid_image}. */
+
+void bk_stereo_proc(void *arg);
+  /* Matches {A} and {A2} with {float_image_geostereo_uniscale_volume}. */
+
+void bk_boxstats_proc(void *arg);
+  /* Computes the local mean and variance of channel 0 of {A} in a
+    large square window, with {float_image_sat_local_avg_var}. */
+
+void bk_pyramid_proc(void *arg);
+  /* Builds a 5-level pyramid of {A} with {float_image_mscale_pyramid_new}. */
+
+static double bk_ctr; /* Center coordinate for {bk_rotate_map}. */
+
+int main (int argc, char **argv)
+  {
+    demand(argc <= 2, "usage: " PROG_HELP);
+    
+    int32_t NC = 3;
+    int32_t nsz = 2;
+    int32_t size[2] = { 256, 1024 };
+    int32_t nnth = 3;
+    int32_t nth[3] = { 1, 2, 4 };
+    int32_t nbmax = nsz*(2 + 4*nnth);
+    tfn_bench_t B[nbmax];
+    int32_t nb = 0;
+    
+    int32_t isz, ith;
+    for (isz = 0; isz < nsz; isz++)
+      { int32_t N = size[isz];
+        int64_t npix = ((int64_t)N)*N;
+        bk_data_t D;
+        D.A = bk_make_image(NC, N, N, 0.0);
+        D.A2 = bk_make_image(NC, N, N, 3.5);
+        D.B = float_image_new(NC, N, N);
+        D.nth = 1;
+        bk_ctr = 0.5*N;
+        
+        B[nb] = tfn_bench_run("float_image_transform_all", npix, 1, "pixels", (double)npix, &bk_transform_proc, &D, MIN_USEC);
+        tfn_bench_write(stdout, &(B[nb])); nb++;
+        
+        B[nb] = tfn_bench_run("float_image_filter_gaussian_band", npix, 1, "pixels", (double)npix, &bk_filter_proc, &D, MIN_USEC);
+        tfn_bench_write(stdout, &(B[nb])); nb++;
+        
+        for (ith = 0; ith < nnth; ith++)
+          { D.nth = nth[ith];
+            B[nb] = tfn_bench_run("float_image_interpolate_grid_image", npix, D.nth, "pixels", (double)npix, &bk_resample_proc, &D, MIN_USEC);
+            tfn_bench_write(stdout, &(B[nb])); nb++;
+            B[nb] = tfn_bench_run("float_image_geostereo_uniscale_volume", npix, D.nth, "pixels", (double)npix, &bk_stereo_proc, &D, MIN_USEC);
+            tfn_bench_write(stdout, &(B[nb])); nb++;
+            B[nb] = tfn_bench_run("float_image_sat_local_avg_var", npix, D.nth, "pixels", (double)npix, &bk_boxstats_proc, &D, MIN_USEC);
+            tfn_bench_write(stdout, &(B[nb])); nb++;
+            B[nb] = tfn_bench_run("float_image_mscale_pyramid_new", npix, D.nth, "pixels", (double)npix, &bk_pyramid_proc, &D, MIN_USEC);
+            tfn_bench_write(stdout, &(B[nb])); nb++;
+          }
+        assert(nb <= nbmax);
+        
+        float_image_free(D.A);
+        float_image_free(D.A2);
+        float_image_free(D.B);
+      }
+      
+    int32_t nslow = 0;
+    if (argc == 2)
+      { FILE *rd = open_read(argv[1], TRUE);
+        int32_t nr;
+        tfn_bench_t *R;
+        tfn_bench_read(rd, &nr, &R);
+        fclose(rd);
+        nslow = tfn_bench_compare(stderr, nb, B, nr, R, TOL);
+      }
+    return (nslow > 0 ? 1 : 0);
+  }
+
+float_image_t *bk_make_image(int32_t NC, int32_t NX, int32_t NY, double shift)
+  {
+    float_image_t *A = float_image_new(NC, NX, NY);
+    srandom(4615);
+    int32_t c, x, y;
+    for (c = 0; c < NC; c++)
+      { double fx = 0.05 + 0.3*drandom(), fy = 0.05 + 0.3*drandom();
+        double ph = 2*M_PI*drandom();
+        for (y = 0; y < NY; y++)
+          { for (x = 0; x < NX; x++)
+              { double v = 0.5 + 0.25*sin(fx*(x - shift) + ph)*cos(fy*y) + 0.05*drandom();
+                float_image_set_sample(A, c, x, y, (float)v);
+              }
+          }
+      }
+    return A;
+  }
+
+void bk_rotate_map(r2_t *p, r2x2_t *J)
+  {
+    double ca = cos(0.3), sa = sin(0.3);
+    double x = p->c[0] - bk_ctr, y = p->c[1] - bk_ctr;
+    p->c[0] = bk_ctr + ca*x - sa*y;
+    p->c[1] = bk_ctr + sa*x + ca*y;
+    if (J != NULL)
+      { r2x2_t R = (r2x2_t){ .c = {{ ca, sa }, { -sa, ca }} };
+        r2x2_mul(J, &R, J);
+      }
+  }
+
+void bk_transform_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    float_image_transform_all(D->A, ix_reduction_SINGLE, &bk_rotate_map, 0.5f, TRUE, 1, NULL, D->B);
+  }
+
+void bk_filter_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    r2_t wMin = (r2_t){{ 4.0, 4.0 }};
+    r2_t wMax = (r2_t){{ 32.0, 32.0 }};
+    float_image_assign(D->B, D->A);
+    float_image_filter_gaussian_band(D->B, &wMin, &wMax, FALSE, FALSE);
+  }
+
+void bk_resample_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    double N = (double)D->A->sz[1];
+    double s = 0.75;
+    float_image_interpolate_grid_image(D->A, 0.125*N, s, 0.125*N, s, 1, ix_reduction_PXMIRR, D->B, D->nth);
+  }
+
+void bk_stereo_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    float_image_t *fd = NULL, *fs = NULL;
+    float_image_geostereo_uniscale_volume(D->A, D->A2, 5, 5, -8.0, +8.0, 2, D->nth, &fd, &fs);
+    float_image_free(fd);
+    float_image_free(fs);
+  }
+
+void bk_boxstats_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    float_image_sat_local_avg_var(D->A, 0, 15, D->B, 0, D->B, 1, D->nth);
+  }
+
+void bk_pyramid_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    float_image_mscale_pyramid_t *P = float_image_mscale_pyramid_new(D->A, NULL, 5, 1, 1, 3, FALSE, D->nth);
+    float_image_mscale_pyramid_free(P);
+  }
@@ -0,0 +1,121 @@
+#define PROG_NAME "test_local_avg_var"
+#define PROG_DESC "test of {float_image_local_avg_var} and {float_image_sat.h}"
+#define PROG_VERS "1.0"
+
+/* Last edited on 2026-10-19 17:55:10 by stolfi */ 
+/* Created on 2026-10-19 by J. Stolfi, UNICAMP */
+
+#define test_local_avg_var_COPYRIGHT \
+  "Copyright \xa9 2026  by the State University of Campinas (UNICAMP)"
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsmath.h>
+#include <jsrandom.h>
+#include <float_image.h>
+#include <float_image_sat.h>
+
+int32_t main(int32_t argn, char **argv);
+
+void do_test(int32_t NX, int32_t NY, int32_t hw, int32_t DX, int32_t DY, double pnan, double pinf);
+  /* Creates a random image {A} with {NX} columns and {NY} rows, whose samples
+    are {NAN} with probability {pnan}, {INF} with probability {pinf},
+    and random numbers in {[0_1]} otherwise; except that if {pinf} is
+    positive the sample nearest the center is always {+INF}.  Computes the local averages
+    and variances of {A} with uniform weights and window half-width {hw}
+    into images {M,V} with {NX+2*DX} columns and {NY+2*DY} rows, with
+    {float_image_local_avg_var} (which uses summed-area tables).  Checks
+    the results against {float_image_get_local_avg_var}. */
+
+bool_t same_value(double a, double b, double tol);
+  /* TRUE if {a} and {b} are both {NAN}, or both the same infinity,
+    or both finite and differ by at most {tol}. */
+
+/* IMPLEMENTATIONS */
+
+int32_t main (int32_t argc, char **argv)
+  {
+    srandom(4615);
+    do_test(20, 20, 2, 0, 0, 0.00, 0.00);
+    do_test(20, 20, 2, 0, 0, 0.05, 0.00);
+    do_test(20, 20, 2, 0, 0, 0.00, 0.0025);
+    do_test(23, 17, 1, 0, 0, 0.10, 0.02);
+    do_test(23, 17, 3, 2, 1, 0.10, 0.02);
+    do_test(31, 12, 0, 0, 0, 0.10, 0.05);
+    do_test(12, 31, 5, 0, 0, 0.30, 0.01);
+    do_test(1, 1, 4, 3, 3, 0.00, 0.00);
+    fprintf(stderr, "done.\n");
+    return 0;
+  }
+
+void do_test(int32_t NX, int32_t NY, int32_t hw, int32_t DX, int32_t DY, double pnan, double pinf)
+  {
+    fprintf(stderr, "NX = %d NY = %d hw = %d DX = %d DY = %d pnan = %.4f pinf = %.4f\n", NX, NY, hw, DX, DY, pnan, pinf);
+    float_image_t *A = float_image_new(1, NX, NY);
+    int32_t x, y;
+    int32_t nnan = 0, ninf = 0;
+    for (y = 0; y < NY; y++)
+      { for (x = 0; x < NX; x++)
+          { double r = drandom();
+            float v;
+            if (r < pnan) 
+              { v = NAN; nnan++; }
+            else if (r < pnan + pinf)
+              { v = (drandom() < 0.5 ? -INF : +INF); ninf++; }
+            else
+              { v = (float)drandom(); }
+            if ((pinf > 0) && (x == NX/2) && (y == NY/2) && (! isinf(v))) { v = +INF; ninf++; }
+            float_image_set_sample(A, 0, x, y, v);
+          }
+      }
+    fprintf(stderr, "  %d NAN samples, %d infinite samples\n", nnan, ninf);
+
+    /* Uniform weights, so that {float_image_local_avg_var} uses the tables: */
+    int32_t nw = 2*hw + 1;
+    double wt[nw];
+    int32_t k;
+    for (k = 0; k < nw; k++) { wt[k] = 1.0; }
+    int32_t NXM = NX + 2*DX, NYM = NY + 2*DY;
+    float_image_t *M = float_image_new(1, NXM, NYM);
+    float_image_t *V = float_image_new(1, NXM, NYM);
+    float_image_local_avg_var(A, 0, hw, wt, M, 0, V, 0);
+
+    int32_t nbad = 0, nfin = 0;
+    for (y = 0; y < NYM; y++)
+      { for (x = 0; x < NXM; x++)
+          { double avg, var;
+            float_image_get_local_avg_var(A, 0, x - DX, y - DY, hw, wt, &avg, &var);
+            /* The results are stored as {float}: */
+            avg = (float)avg; var = (float)var;
+            double avgT = float_image_get_sample(M, 0, x, y);
+            double varT = float_image_get_sample(V, 0, x, y);
+            if (isfinite(avgT)) { nfin++; }
+            if ((! same_value(avg, avgT, 1.0e-5)) || (! same_value(var, varT, 1.0e-5)))
+              { if (nbad < 10)
+                  { fprintf(stderr, "  x = %d y = %d", x, y);
+                    fprintf(stderr, "  avg = %14.8f %14.8f  var = %14.8f %14.8f\n", avg, avgT, var, varT);
+                  }
+                nbad++;
+              }
+          }
+      }
+    fprintf(stderr, "  %d finite averages, %d mismatches\n", nfin, nbad);
+    demand(nbad == 0, "summed-area tables and direct sums disagree");
+    float_image_free(A);
+    float_image_free(M);
+    float_image_free(V);
+  }
+
+bool_t same_value(double a, double b, double tol)
+  {
+    if (isnan(a) || isnan(b)) { return isnan(a) && isnan(b); }
+    if (isinf(a) || isinf(b)) { return (a == b); }
+    return fabs(a - b) <= tol;
+  }
@@ -0,0 +1,492 @@
+#define PROG_NAME "test_RGB_quant"
+#define PROG_DESC "test of {uint16_image_RGB_table.h}, {uint16_image_RGB_medcut.h}, and {uint16_image_RGB_remap.h}"
+#define PROG_VERS "1.0"
+
+/* Last edited on 2026-10-19 13:05:51 by stolfi */ 
+/* Created on 2026-10-19 by J. Stolfi, UNICAMP */
+
+#define test_RGB_quant_COPYRIGHT \
+  "Copyright \xa9 2026  by the State University of Campinas (UNICAMP)"
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsrandom.h>
+#include <jspnm.h>
+#include <uint16_image.h>
+#include <uint16_image_RGB_hist.h>
+#include <uint16_image_RGB_table.h>
+#include <uint16_image_RGB_medcut.h>
+#include <uint16_image_RGB_remap.h>
+
+int32_t main(int32_t argn, char **argv);
+
+void test_table(int32_t n, uint16_t maxval);
+  /* Adds {n} random colors with samples in {0..maxval} to an empty
+    {uint16_image_RGB_table}, one at a time, and checks that the table
+    grows as needed, that {uint16_image_RGB_table_lookup} finds the
+    value of every color added (and -1 for other colors), and that
+    {uint16_image_RGB_table_to_hist} lists every color exactly once. */
+
+void test_hist_build(int32_t NX, int32_t NY, uint16_t maxval);
+  /* Builds the histogram of a random image with {NX} columns and {NY} rows
+    with {uint16_image_RGB_hist_build}, and compares it with the one
+    obtained by sorting the pixels.  Also checks that
+    {uint16_image_RGB_table_build} returns NULL if {maxcolors} is too small. */
+
+void test_median_cut(int32_t NX, int32_t NY, int32_t ncl, int32_t K);
+  /* Applies {uint16_image_RGB_median_cut} to the histogram of a random
+    image with {NX} columns and {NY} rows, whose pixels are scattered around
+    {ncl} random colors, asking for {K} colors.  Compares the palette with
+    the one computed by {ref_median_cut}.
+    
+    The image has {maxval = 63} and at most 4000 pixels, so that the box
+    spreads are integers less than {2^24}, and hence are computed exactly 
+    as {float}s in any order. */
+
+uint16_image_RGB_hist_vector ref_median_cut
+  ( uint16_image_RGB_hist_vector ch, 
+    int colors, 
+    uint16_t maxval, 
+    int *newcolorsp,
+    bool_t *tieP
+  );
+  /* A simple version of {uint16_image_RGB_median_cut} that keeps the boxes
+    in an array, looks for the box of largest spread by sequential search,
+    and splits it by sorting its entries.  Should produce the same set of
+    colors, except that the result is undefined if a box that was not 
+    split has the same spread as one that was split.  Sets {*tieP} 
+    to TRUE if that happens. */
+
+void ref_set_box
+  ( uint16_image_RGB_hist_vector ch, 
+    int lo, 
+    int hi, 
+    uint16_t maxval,
+    float ctr[],
+    ppm_pixel_t *rep,
+    int *lax,
+    double *spread
+  );
+  /* Computes the centroid {ctr[0..2]}, the representative color {*rep},
+    the axis {*lax} of largest spread, and the spread {*spread} of the 
+    box with entries {ch[lo..hi]}, by the same formulas as
+    {uint16_image_RGB_median_cut}. */
+
+void test_remap(uint16_t maxval, int32_t ncolors, int32_t nbits, int32_t nth);
+  /* Builds a {uint16_image_RGB_remap_grid_t} with {nbits} and {nth} 
+    for a random palette of {ncolors} colors with samples in {0..maxval}.
+    Checks {uint16_image_RGB_remap_grid_lookup} and {uint16_image_RGB_remap_image}
+    against {brute_nearest}. */
+
+int32_t brute_nearest(ppm_pixel_t *pal, int32_t ncolors, ppm_pixel_t *p);
+  /* Index of the color in {pal[0..ncolors-1]} nearest to {*p}, with 
+    ties broken in favor of the lowest index, by exhaustive search. */
+
+ppm_pixel_t random_color(uint16_t maxval);
+  /* A random color with samples in {0..maxval}. */
+
+int color_cmp(const void *a, const void *b);
+  /* Compares the colors of two {uint16_image_RGB_hist_item}s in 
+    lexicographic order. */
+
+int pixel_cmp(const void *a, const void *b);
+  /* Compares two {ppm_pixel_t}s in lexicographic order. */
+
+/* IMPLEMENTATIONS */
+
+int32_t main (int32_t argc, char **argv)
+  {
+    srandom(4615);
+    
+    test_table(10, 65535);
+    test_table(5000, 15);
+    test_table(200000, 65535);
+    
+    test_hist_build(40, 30, 255);
+    test_hist_build(300, 200, 7);
+
+    test_median_cut(60, 60, 5, 16);
+    test_median_cut(60, 60, 20, 64);
+    test_median_cut(50, 40, 1, 8);
+    test_median_cut(30, 20, 3, 600);
+    test_median_cut(5, 4, 1, 50);
+    int32_t t;
+    for (t = 0; t < 10; t++) { test_median_cut(40 + t, 50, 3 + t, 4 + 5*t); }
+
+    int32_t nbits;
+    for (nbits = 0; nbits <= 6; nbits++) { test_remap(255, 40, nbits, 1); }
+    test_remap(65535, 100, 4, 3);
+    test_remap(65535, 1, 3, 0);
+    test_remap(1000, 256, 5, 0);
+    test_remap(7, 10, 8, 2);
+    test_remap(255, 500, 4, 0);
+
+    fprintf(stderr, "done.\n");
+    return 0;
+  }
+
+void test_table(int32_t n, uint16_t maxval)
+  {
+    fprintf(stderr, "test_table n = %d maxval = %d\n", n, maxval);
+    
+    /* Generate the colors, and find the distinct ones {col[0..nd-1]}: */
+    ppm_pixel_t *add = notnull(malloc(n*sizeof(ppm_pixel_t)), "no mem");
+    ppm_pixel_t *col = notnull(malloc(n*sizeof(ppm_pixel_t)), "no mem");
+    int32_t i;
+    for (i = 0; i < n; i++) { add[i] = random_color(maxval); col[i] = add[i]; }
+    qsort(col, n, sizeof(ppm_pixel_t), &pixel_cmp);
+    int32_t nd = 0;
+    for (i = 0; i < n; i++) 
+      { if ((nd == 0) || (pixel_cmp(&(col[nd-1]), &(col[i])) != 0)) { col[nd] = col[i]; nd++; } }
+    
+    /* Add them to the table, with the index in {col} as value: */
+    uint16_image_RGB_table cht = uint16_image_RGB_table_alloc();
+    uint32_t size0 = cht->size;
+    for (i = 0; i < n; i++)
+      { ppm_pixel_t *q = bsearch(&(add[i]), col, nd, sizeof(ppm_pixel_t), &pixel_cmp);
+        assert(q != NULL);
+        int r = uint16_image_RGB_table_add(cht, &(add[i]), (int)(q - col));
+        demand(r >= 0, "table add failed");
+        demand(2*cht->count <= cht->size, "table too full");
+        demand((cht->size & (cht->size - 1)) == 0, "table size not a power of 2");
+      }
+    demand(cht->count == nd, "wrong count");
+    if (2*nd > size0) { demand(cht->size > size0, "table did not grow"); }
+    fprintf(stderr, "  %d distinct colors, %u slots\n", nd, cht->size);
+    
+    /* Check the lookups: */
+    for (i = 0; i < nd; i++) 
+      { demand(uint16_image_RGB_table_lookup(cht, &(col[i])) == i, "lookup failed"); }
+    for (i = 0; i < 1000; i++) 
+      { ppm_pixel_t p = random_color(maxval);
+        ppm_pixel_t *q = bsearch(&p, col, nd, sizeof(ppm_pixel_t), &pixel_cmp);
+        int v = uint16_image_RGB_table_lookup(cht, &p);
+        demand(v == (q == NULL ? -1 : (int)(q - col)), "lookup of random color failed");
+      }
+
+    /* Replacing values must not add entries: */
+    for (i = 0; i < nd; i += 7) { uint16_image_RGB_table_add(cht, &(col[i]), -i); }
+    demand(cht->count == nd, "count changed on replacement");
+    for (i = 0; i < nd; i++) 
+      { demand(uint16_image_RGB_table_lookup(cht, &(col[i])) == (i % 7 == 0 ? -i : i), "replacement failed"); }
+    
+    /* Check the conversion to histogram: */
+    uint16_image_RGB_hist_vector chv = uint16_image_RGB_table_to_hist(cht, nd);
+    qsort(chv, nd, sizeof(struct uint16_image_RGB_hist_item), &color_cmp);
+    for (i = 0; i < nd; i++) { demand(pixel_cmp(&(chv[i].color), &(col[i])) == 0, "bad hist entry"); }
+    
+    uint16_image_RGB_hist_free(chv);
+    uint16_image_RGB_table_free(cht);
+    free(col);
+    free(add);
+  }
+
+void test_hist_build(int32_t NX, int32_t NY, uint16_t maxval)
+  {
+    fprintf(stderr, "test_hist_build NX = %d NY = %d maxval = %d\n", NX, NY, maxval);
+    int32_t chns = 3;
+    int32_t npix = NX*NY;
+    uint16_image_t *img = uint16_image_new(NX, NY, chns);
+    img->maxval = maxval;
+    ppm_pixel_t *pix = notnull(malloc(npix*sizeof(ppm_pixel_t)), "no mem");
+    int32_t x, y, c, i;
+    for (y = 0; y < NY; y++)
+      { for (x = 0; x < NX; x++)
+          { ppm_pixel_t p = random_color(maxval);
+            for (c = 0; c < chns; c++) { img->smp[y][x*chns + c] = p.c[c]; }
+            pix[y*NX + x] = p;
+          }
+      }
+    
+    int colors;
+    uint16_image_RGB_hist_vector chv = uint16_image_RGB_hist_build(img->smp, chns, NX, NY, npix, &colors);
+    demand(chv != NULL, "hist build failed");
+    qsort(chv, colors, sizeof(struct uint16_image_RGB_hist_item), &color_cmp);
+    
+    /* Compare with the counts obtained by sorting: */
+    qsort(pix, npix, sizeof(ppm_pixel_t), &pixel_cmp);
+    int32_t nd = 0;
+    i = 0;
+    while (i < npix)
+      { int32_t j = i + 1;
+        while ((j < npix) && (pixel_cmp(&(pix[i]), &(pix[j])) == 0)) { j++; }
+        demand(nd < colors, "too few colors in hist");
+        demand(pixel_cmp(&(chv[nd].color), &(pix[i])) == 0, "wrong color in hist");
+        demand(chv[nd].value == j - i, "wrong count in hist");
+        nd++;
+        i = j;
+      }
+    demand(nd == colors, "too many colors in hist");
+    fprintf(stderr, "  %d distinct colors\n", nd);
+    
+    /* Too many colors: */
+    int colors2;
+    uint16_image_RGB_table cht = uint16_image_RGB_table_build(img->smp, chns, NX, NY, nd - 1, &colors2);
+    demand(cht == NULL, "table build should have failed");
+    
+    uint16_image_RGB_hist_free(chv);
+    free(pix);
+    uint16_image_free(img);
+  }
+
+void test_median_cut(int32_t NX, int32_t NY, int32_t ncl, int32_t K)
+  {
+    fprintf(stderr, "test_median_cut NX = %d NY = %d ncl = %d K = %d\n", NX, NY, ncl, K);
+    uint16_t maxval = 63;
+    int32_t chns = 3;
+    assert(NX*NY <= 4000);
+    
+    /* Make an image whose pixels are scattered around {ncl} colors: */
+    ppm_pixel_t cl[ncl];
+    int32_t k, x, y, c;
+    for (k = 0; k < ncl; k++) { cl[k] = random_color(maxval); }
+    uint16_image_t *img = uint16_image_new(NX, NY, chns);
+    img->maxval = maxval;
+    for (y = 0; y < NY; y++)
+      { for (x = 0; x < NX; x++)
+          { ppm_pixel_t *p = &(cl[int32_abrandom(0, ncl-1)]);
+            for (c = 0; c < chns; c++) 
+              { int32_t v = p->c[c] + int32_abrandom(-5, +5);
+                img->smp[y][x*chns + c] = (uint16_t)(v < 0 ? 0 : (v > maxval ? maxval : v));
+              }
+          }
+      }
+    
+    int colors;
+    uint16_image_RGB_hist_vector ch1 = uint16_image_RGB_hist_build(img->smp, chns, NX, NY, NX*NY, &colors);
+    uint16_image_RGB_hist_vector ch2 = uint16_image_RGB_hist_build(img->smp, chns, NX, NY, NX*NY, &colors);
+    
+    int n1 = K, n2 = K;
+    bool_t tie = FALSE;
+    uint16_image_RGB_hist_vector cm1 = uint16_image_RGB_median_cut(ch1, colors, maxval, &n1);
+    uint16_image_RGB_hist_vector cm2 = ref_median_cut(ch2, colors, maxval, &n2, &tie);
+    fprintf(stderr, "  %d colors in image, %d in palette%s\n", colors, n1, (tie ? " (tie, not compared)" : ""));
+    demand((n1 >= 1) && (n1 <= K) && (n1 <= colors), "bad palette size");
+    if (! tie)
+      { demand(n1 == n2, "palette sizes differ");
+        qsort(cm1, n1, sizeof(struct uint16_image_RGB_hist_item), &color_cmp);
+        qsort(cm2, n2, sizeof(struct uint16_image_RGB_hist_item), &color_cmp);
+        for (k = 0; k < n1; k++) 
+          { demand(pixel_cmp(&(cm1[k].color), &(cm2[k].color)) == 0, "palettes differ"); }
+      }
+    
+    free(cm1);
+    free(cm2);
+    uint16_image_RGB_hist_free(ch1);
+    uint16_image_RGB_hist_free(ch2);
+    uint16_image_free(img);
+  }
+
+uint16_image_RGB_hist_vector ref_median_cut
+  ( uint16_image_RGB_hist_vector ch, 
+    int colors, 
+    uint16_t maxval, 
+    int *newcolorsp,
+    bool_t *tieP
+  )
+  {
+    int K = (*newcolorsp);
+    int lo[K], hi[K], lax[K];
+    float ctr[K][3];
+    ppm_pixel_t rep[K];
+    double spread[K];
+    
+    lo[0] = 0; hi[0] = colors - 1;
+    ref_set_box(ch, lo[0], hi[0], maxval, ctr[0], &(rep[0]), &(lax[0]), &(spread[0]));
+    int nb = 1;
+    double smin = INFINITY; /* Smallest spread of any box that was split. */
+    while (nb < K)
+      { /* Find the box {b} with largest spread: */
+        int b = 0, k, i;
+        for (k = 1; k < nb; k++) { if (spread[k] > spread[b]) { b = k; } }
+        if (spread[b] <= 0.0) { break; }
+        if (spread[b] < smin) { smin = spread[b]; }
+        
+        /* Sort its entries along the axis {ax} and split at the centroid: */
+        int ax = lax[b];
+        for (i = lo[b] + 1; i <= hi[b]; i++)
+          { struct uint16_image_RGB_hist_item t = ch[i];
+            int j = i;
+            while ((j > lo[b]) && (ch[j-1].color.c[ax] > t.color.c[ax])) { ch[j] = ch[j-1]; j--; }
+            ch[j] = t;
+          }
+        i = lo[b];
+        while ((i <= hi[b]) && ((float)ch[i].color.c[ax] < ctr[b][ax])) { i++; }
+        assert((i > lo[b]) && (i <= hi[b]));
+        lo[nb] = i; hi[nb] = hi[b];
+        hi[b] = i - 1;
+        ref_set_box(ch, lo[b], hi[b], maxval, ctr[b], &(rep[b]), &(lax[b]), &(spread[b]));
+        ref_set_box(ch, lo[nb], hi[nb], maxval, ctr[nb], &(rep[nb]), &(lax[nb]), &(spread[nb]));
+        nb++;
+      }
+    /* The choice among boxes with equal spreads matters only if some 
+      of them were not split: */
+    (*tieP) = FALSE;
+    int k;
+    for (k = 0; k < nb; k++) { if ((spread[k] > 0.0) && (spread[k] >= smin)) { (*tieP) = TRUE; } }
+    
+    uint16_image_RGB_hist_vector cm = notnull(malloc(nb*sizeof(struct uint16_image_RGB_hist_item)), "no mem");
+    for (k = 0; k < nb; k++) { cm[k].color = rep[k]; cm[k].value = 0; }
+    (*newcolorsp) = nb;
+    return cm;
+  }
+
+void ref_set_box
+  ( uint16_image_RGB_hist_vector ch, 
+    int lo, 
+    int hi, 
+    uint16_t maxval,
+    float ctr[],
+    ppm_pixel_t *rep,
+    int *lax,
+    double *spread
+  )
+  {
+    int i, c;
+    double S[3];
+    for (c = 0; c < 3; c++)
+      { uint16_t vmin = maxval, vmax = 0;
+        double sumv = 0, sumw = 0;
+        for (i = lo; i <= hi; i++)
+          { uint16_t v = ch[i].color.c[c];
+            if (v < vmin) { vmin = v; }
+            if (v > vmax) { vmax = v; }
+            sumv += ch[i].value*(double)v;
+            sumw += ch[i].value;
+          }
+        if (vmin >= vmax)
+          { ctr[c] = vmin; rep->c[c] = vmin; }
+        else
+          { double fv = sumv/sumw;
+            int64_t zv = (int64_t)(fv + 0.5);
+            if (zv > vmax) { zv = vmax; }
+            if (zv < vmin) { zv = vmin; }
+            ctr[c] = (float)fv;
+            rep->c[c] = (uint16_t)zv;
+          }
+        S[c] = 0;
+        for (i = lo; i <= hi; i++)
+          { double d = (double)ch[i].color.c[c] - (double)rep->c[c];
+            S[c] += ch[i].value*d*d;
+          }
+      }
+    /* Same choice of axis as {uint16_image_RGB_median_cut}: */
+    if ((S[0] >= S[1]) && (S[0] >= S[2]))
+      { (*lax) = 0; }
+    else if ((S[1] >= S[0]) && (S[0] >= S[2]))
+      { (*lax) = 1; }
+    else
+      { (*lax) = 2; }
+    (*spread) = S[*lax];
+  }
+
+void test_remap(uint16_t maxval, int32_t ncolors, int32_t nbits, int32_t nth)
+  {
+    fprintf(stderr, "test_remap maxval = %d ncolors = %d nbits = %d nth = %d\n", maxval, ncolors, nbits, nth);
+    uint16_image_RGB_hist_vector cm = notnull(malloc(ncolors*sizeof(struct uint16_image_RGB_hist_item)), "no mem");
+    ppm_pixel_t pal[ncolors];
+    int32_t j, i, c;
+    for (j = 0; j < ncolors; j++) 
+      { /* Include some repeated colors, to test the tie-breaking: */
+        cm[j].color = ((j > 0) && (j % 9 == 0) ? cm[j/3].color : random_color(maxval)); 
+        cm[j].value = 0;
+        pal[j] = cm[j].color;
+      }
+    uint16_image_RGB_remap_grid_t *G = uint16_image_RGB_remap_grid_new(cm, ncolors, maxval, nbits, nth);
+    demand(G->NL <= (1 << nbits), "too many cell layers");
+    int32_t ncells = G->NL*G->NL*G->NL;
+    fprintf(stderr, "  %d cells, %.2f candidates per cell\n", ncells, ((double)G->start[ncells])/ncells);
+    
+    /* Check random pixels and pixels near the palette colors: */
+    for (i = 0; i < 20000; i++)
+      { ppm_pixel_t p;
+        if (i % 2 == 0)
+          { p = random_color(maxval); }
+        else
+          { p = pal[int32_abrandom(0, ncolors-1)];
+            for (c = 0; c < 3; c++)
+              { int32_t v = p.c[c] + int32_abrandom(-2, +2);
+                p.c[c] = (uint16_t)(v < 0 ? 0 : (v > maxval ? maxval : v));
+              }
+          }
+        int32_t jb = brute_nearest(pal, ncolors, &p);
+        int32_t jg = uint16_image_RGB_remap_grid_lookup(G, &p);
+        if (jg != jb)
+          { fprintf(stderr, "  p = ( %d %d %d ) brute = %d grid = %d\n", p.c[0], p.c[1], p.c[2], jb, jg);
+            demand(FALSE, "grid lookup failed");
+          }
+      }
+    
+    /* Check the remapping of whole images, with 3 channels and with 1: */
+    int32_t NX = 97, NY = 61, chns;
+    for (chns = 1; chns <= 3; chns += 2)
+      { uint16_image_t *img = uint16_image_new(NX, NY, chns);
+        img->maxval = maxval;
+        uint16_image_t *idx = uint16_image_new(NX, NY, 1);
+        idx->maxval = 65535;
+        int32_t x, y;
+        for (y = 0; y < NY; y++)
+          { for (x = 0; x < NX; x++)
+              { ppm_pixel_t p = random_color(maxval);
+                for (c = 0; c < chns; c++) { img->smp[y][x*chns + c] = p.c[c]; }
+              }
+          }
+        uint16_image_RGB_remap_image(img, G, idx, nth);
+        for (y = 0; y < NY; y++)
+          { for (x = 0; x < NX; x++)
+              { ppm_pixel_t p;
+                for (c = 0; c < 3; c++) { p.c[c] = img->smp[y][x*chns + (chns == 1 ? 0 : c)]; }
+                demand(idx->smp[y][x] == brute_nearest(pal, ncolors, &p), "image remap failed");
+              }
+          }
+        uint16_image_free(idx);
+        uint16_image_free(img);
+      }
+    
+    uint16_image_RGB_remap_grid_free(G);
+    free(cm);
+  }
+
+int32_t brute_nearest(ppm_pixel_t *pal, int32_t ncolors, ppm_pixel_t *p)
+  {
+    int32_t jb = -1;
+    int64_t db = INT64_MAX;
+    int32_t j, c;
+    for (j = 0; j < ncolors; j++)
+      { int64_t d = 0;
+        for (c = 0; c < 3; c++) { int64_t e = (int64_t)p->c[c] - pal[j].c[c]; d += e*e; }
+        if (d < db) { db = d; jb = j; }
+      }
+    return jb;
+  }
+
+ppm_pixel_t random_color(uint16_t maxval)
+  {
+    ppm_pixel_t p;
+    int32_t c;
+    for (c = 0; c < 3; c++) { p.c[c] = (uint16_t)int32_abrandom(0, maxval); }
+    return p;
+  }
+
+int color_cmp(const void *a, const void *b)
+  {
+    const struct uint16_image_RGB_hist_item *ha = a, *hb = b;
+    return pixel_cmp(&(ha->color), &(hb->color));
+  }
+
+int pixel_cmp(const void *a, const void *b)
+  {
+    const ppm_pixel_t *pa = a, *pb = b;
+    int32_t c;
+    for (c = 0; c < 3; c++) 
+      { if (pa->c[c] != pb->c[c]) { return (pa->c[c] < pb->c[c] ? -1 : +1); } }
+    return 0;
+  }
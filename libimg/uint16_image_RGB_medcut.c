@@ -1,9 +1,12 @@
 /* See ppm_medcutx.h
-** Last edited on 2017-06-21 00:32:28 by stolfilocal
+** Last edited on 2026-10-19 12:27:17 by stolfilocal
 **
 ** Copyright (C) 1989, 1991 by Jef Poskanzer. See note at end of file.
 */
 
+#include <stdlib.h>
+
+#include <bool.h>
 #include <affirm.h>
 #include <jspnm.h>
 
@@ -80,11 +83,20 @@ void ppm_box_spread(
   /* Compute the box spread {*spreadp} and largest 
     dimension {*laxp}, relative to the appointed representative {rep}. */
 
-int uint16_image_RGB_red_compare(const uint16_image_RGB_hist_vector ch1, const uint16_image_RGB_hist_vector ch2);
+int ppm_box_partition(uint16_image_RGB_hist_vector ch, int lo, int hi, int lax, float ctrv);
+  /* Rearranges the entries {ch[lo..hi]} so that those whose sample
+    {c[lax]} is less than {ctrv} come before all the others.  Returns
+    the index of the first entry of the second group (which is {hi+1}
+    if that group is empty).  Runs in time proportional to {hi-lo+1}. */
 
-int uint16_image_RGB_green_compare(const uint16_image_RGB_hist_vector ch1, const uint16_image_RGB_hist_vector ch2);
+void ppm_box_heap_up(ppm_box_vector bv, int *hp, int k);
+  /* Restores the heap property of {hp[0..k]}, assuming that it holds
+    for {hp[0..k-1]}.  The heap {hp} holds indices into {bv}, with 
+    the box of largest spread at the top {hp[0]}. */
 
-int uint16_image_RGB_blue_compare(const uint16_image_RGB_hist_vector ch1, const uint16_image_RGB_hist_vector ch2);
+void ppm_box_heap_down(ppm_box_vector bv, int *hp, int n);
+  /* Restores the heap property of {hp[0..n-1]}, assuming that it
+    holds except that {hp[0]} may be too small. */
 
 int ppm_spread_compare(const ppm_box *b1, const ppm_box *b2);
 
@@ -103,14 +115,17 @@ uint16_image_RGB_hist_vector uint16_image_RGB_median_cut
   {
     uint16_image_RGB_hist_vector cm; /* The colormap */
     ppm_box_vector bv;   /* The box tree */
+    int *hp;             /* Heap of box indices, by decreasing spread. */
     register int i;
     int boxes;
 
     bv = new_ppm_box_vector(*newcolorsp);
+    hp = (int *)pnm_malloc((*newcolorsp)*sizeof(int));
 
     /* Set up the initial box. */
     
-    ppm_set_box(&(bv[0]), ch, 0, colors, maxval);
+    ppm_set_box(&(bv[0]), ch, 0, colors-1, maxval);
+    hp[0] = 0;
     boxes = 1;
 
     /* Main loop: split boxes until we have enough. */
@@ -119,39 +134,39 @@ uint16_image_RGB_hist_vector uint16_image_RGB_median_cut
         register int lo, hi;
         int lax;
         float ctrv;
-        qcomparefn cmp;
         
-        /* Box 0 should have the largest spread. */
-        if (bv[0].spread <= 0.0) break; /* exact */
-        lo = bv[0].lo;
-        hi = bv[0].hi;
+        /* The box {b} at the top of the heap has the largest spread. */
+        ppm_box *b = &(bv[hp[0]]);
+        if (b->spread <= 0.0) break; /* exact */
+        lo = b->lo;
+        hi = b->hi;
         if (lo >= hi) pnm_error("bad ppm_box spread");
-        lax = bv[0].longaxis;
-        
-        /* Sort box colors in the direction of largest spread: */
+        lax = b->longaxis;
         switch(lax)
           { 
-            case 0: cmp = (qcomparefn) uint16_image_RGB_red_compare;   ctrv = bv[0].cR; break;
-            case 1: cmp = (qcomparefn) uint16_image_RGB_green_compare; ctrv = bv[0].cG; break;
-            case 2: cmp = (qcomparefn) uint16_image_RGB_blue_compare;  ctrv = bv[0].cB; break;
-            default: pnm_error("huh?"); cmp = NULL; ctrv = 0;
+            case 0: ctrv = b->cR; break;
+            case 1: ctrv = b->cG; break;
+            case 2: ctrv = b->cB; break;
+            default: pnm_error("huh?"); ctrv = 0;
           }
-        qsort((void*)&(ch[lo]), hi-lo+1, sizeof(struct uint16_image_RGB_hist_item), cmp); 
         
         /* Split colors in two groups at centroid: */
-        for (i = lo; i <= hi; ++i)
-          { uint16_t v = ch[i].color.c[lax];
-            if ((float)v >= ctrv) break;
-          }
+        i = ppm_box_partition(ch, lo, hi, lax, ctrv);
         if ((i > hi) || (i <= lo)) pnm_error("bad centroid in pgm box");
-        ppm_set_box(&(bv[0]), ch, lo, i-1, maxval);
+        ppm_set_box(b, ch, lo, i-1, maxval);
         ppm_set_box(&(bv[boxes]), ch, i, hi, maxval);
+        
+        /* Update the heap: */
+        ppm_box_heap_down(bv, hp, boxes);
+        hp[boxes] = boxes;
+        ppm_box_heap_up(bv, hp, boxes);
         ++boxes;
-
-        /* Sort to bring the worst boxes to the top. */
-        qsort((void*) bv, boxes, sizeof(ppm_box), (qcomparefn) ppm_spread_compare);
       }
 
+    /* List the boxes by decreasing spread, as in the original algorithm: */
+    qsort((void*) bv, boxes, sizeof(ppm_box), (qcomparefn) ppm_spread_compare);
+    free(hp);
+
     /* Ok, we've got enough boxes.  Collect their centroids: */
     cm = uint16_image_RGB_hist_vector_new(boxes);
     for (i = 0; i < boxes; ++i) 
@@ -281,19 +296,41 @@ void ppm_box_spread
       }
   }
 
-int uint16_image_RGB_red_compare(uint16_image_RGB_hist_vector ch1, uint16_image_RGB_hist_vector ch2)
+int ppm_box_partition(uint16_image_RGB_hist_vector ch, int lo, int hi, int lax, float ctrv)
   {
-    return (int) ch1->color.c[0] - (int) ch2->color.c[0];
+    int i = lo, j = hi;
+    while (TRUE)
+      { while ((i <= j) && ((float)ch[i].color.c[lax] < ctrv)) { i++; }
+        while ((i <= j) && ((float)ch[j].color.c[lax] >= ctrv)) { j--; }
+        if (i >= j) { return i; }
+        struct uint16_image_RGB_hist_item t = ch[i]; ch[i] = ch[j]; ch[j] = t;
+        i++; j--;
+      }
   }
 
-int uint16_image_RGB_green_compare(uint16_image_RGB_hist_vector ch1, uint16_image_RGB_hist_vector ch2)
+void ppm_box_heap_up(ppm_box_vector bv, int *hp, int k)
   {
-    return (int) ch1->color.c[1] - (int) ch2->color.c[1];
+    int t = hp[k];
+    while (k > 0)
+      { int p = (k - 1)/2;
+        if (bv[hp[p]].spread >= bv[t].spread) { break; }
+        hp[k] = hp[p]; k = p;
+      }
+    hp[k] = t;
   }
 
-int uint16_image_RGB_blue_compare(uint16_image_RGB_hist_vector ch1, uint16_image_RGB_hist_vector ch2)
+void ppm_box_heap_down(ppm_box_vector bv, int *hp, int n)
   {
-    return (int) ch1->color.c[2] - (int) ch2->color.c[2];
+    int k = 0;
+    int t = hp[0];
+    while (TRUE)
+      { int s = 2*k + 1;
+        if (s >= n) { break; }
+        if ((s + 1 < n) && (bv[hp[s+1]].spread > bv[hp[s]].spread)) { s++; }
+        if (bv[t].spread >= bv[hp[s]].spread) { break; }
+        hp[k] = hp[s]; k = s;
+      }
+    hp[k] = t;
   }
 
 int ppm_spread_compare(const ppm_box *b1, const ppm_box *b2)
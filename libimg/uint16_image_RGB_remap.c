@@ -0,0 +1,229 @@
+/* See uint16_image_RGB_remap.h */
+/* Last edited on 2026-10-19 12:27:17 by stolfi */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <affirm.h>
+#include <jsthread.h>
+#include <jspnm.h>
+
+#include <uint16_image.h>
+#include <uint16_image_RGB_hist.h>
+#include <uint16_image_RGB_remap.h>
+
+/* INTERNAL PROTOTYPES */
+
+#define uint16_image_RGB_remap_BAND_ROWS 16
+  /* Number of image rows in each band of the parallel remapping. */
+
+typedef struct u16rm_job_t
+  { uint16_image_RGB_remap_grid_t *G;  /* The grid being built or used. */
+    int64_t *thr;                       /* Per-cell distance thresholds. */
+    uint16_image_t *img;                /* Image to remap. */
+    uint16_image_t *idx;                /* Image of palette indices. */
+  } u16rm_job_t;
+  /* Arguments for the parallel passes. */
+
+void uint16_image_RGB_remap_cell_range(uint16_image_RGB_remap_grid_t *G, int i, int a[], int b[]);
+  /* Sets {a[0..2]} and {b[0..2]} to the min and max samples 
+    of the pixels in cell {i} of {G}. */
+
+int64_t uint16_image_RGB_remap_box_dist_sqr(ppm_pixel_t *p, int a[], int b[], int64_t *maxP);
+  /* Returns the minimum squared distance from {*p} to any pixel in 
+    the box {[a[0]..b[0]]x[a[1]..b[1]]x[a[2]..b[2]]}, and stores 
+    the maximum one in {*maxP}. */
+
+void uint16_image_RGB_remap_count_cells(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Computes the distance threshold {job->thr[k]} and stores the number
+    of candidates of cell {k} into {G->start[k+1]}, for {k} in {ini..fin},
+    where {job} is {arg} and {G} is {job->G}. */
+
+void uint16_image_RGB_remap_fill_cells(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Stores the candidates of cells {ini..fin} of {job->G} into
+    its {cand} vector, where {job} is {arg}. */
+
+void uint16_image_RGB_remap_rows(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Remaps rows {ini..fin} of {job->img} into {job->idx}, where {job} is {arg}. */
+
+/* IMPLEMENTATIONS */
+
+uint16_image_RGB_remap_grid_t *uint16_image_RGB_remap_grid_new
+  ( uint16_image_RGB_hist_vector cm,
+    int ncolors,
+    uint16_t maxval,
+    int nbits,
+    int nth
+  )
+  {
+    demand((ncolors > 0) && (ncolors <= 65536), "invalid palette size");
+    demand((nbits >= 0) && (nbits <= 8), "invalid {nbits}");
+    uint16_image_RGB_remap_grid_t *G = notnull(malloc(sizeof(uint16_image_RGB_remap_grid_t)), "no mem");
+    G->maxval = maxval;
+    G->ncolors = ncolors;
+    G->pal = notnull(malloc(ncolors*sizeof(ppm_pixel_t)), "no mem");
+    int j;
+    for (j = 0; j < ncolors; j++)
+      { ppm_pixel_t *q = &(cm[j].color);
+        demand((q->c[0] <= maxval) && (q->c[1] <= maxval) && (q->c[2] <= maxval), "palette color out of range");
+        G->pal[j] = *q;
+      }
+
+    /* Choose the cell size: */
+    G->shift = 0;
+    while ((maxval >> G->shift) >= (1 << nbits)) { G->shift++; }
+    G->NL = (maxval >> G->shift) + 1;
+    int ncells = G->NL*G->NL*G->NL;
+
+    /* Count the candidates of each cell, then fill the lists: */
+    G->start = notnull(malloc((ncells + 1)*sizeof(int)), "no mem");
+    int64_t *thr = notnull(malloc(ncells*sizeof(int64_t)), "no mem");
+    u16rm_job_t job = (u16rm_job_t){ .G = G, .thr = thr };
+    jsthread_run_ranges(ncells, G->NL, nth, &uint16_image_RGB_remap_count_cells, &job);
+    int k;
+    G->start[0] = 0;
+    for (k = 0; k < ncells; k++) { G->start[k+1] += G->start[k]; }
+    G->cand = notnull(malloc(G->start[ncells]*sizeof(int)), "no mem");
+    jsthread_run_ranges(ncells, G->NL, nth, &uint16_image_RGB_remap_fill_cells, &job);
+    free(thr);
+    return G;
+  }
+
+void uint16_image_RGB_remap_cell_range(uint16_image_RGB_remap_grid_t *G, int i, int a[], int b[])
+  {
+    int c;
+    for (c = 0; c < 3; c++)
+      { int ic = i % G->NL; i = i / G->NL;
+        a[c] = (ic << G->shift);
+        b[c] = ((ic + 1) << G->shift) - 1;
+        if (b[c] > G->maxval) { b[c] = G->maxval; }
+      }
+  }
+
+int64_t uint16_image_RGB_remap_box_dist_sqr(ppm_pixel_t *p, int a[], int b[], int64_t *maxP)
+  {
+    int64_t dmin = 0, dmax = 0;
+    int c;
+    for (c = 0; c < 3; c++)
+      { int v = p->c[c];
+        int64_t d;
+        d = (v < a[c] ? a[c] - v : (v > b[c] ? v - b[c] : 0));
+        dmin += d*d;
+        d = (v - a[c] > b[c] - v ? v - a[c] : b[c] - v);
+        dmax += d*d;
+      }
+    (*maxP) = dmax;
+    return dmin;
+  }
+
+void uint16_image_RGB_remap_count_cells(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    u16rm_job_t *job = (u16rm_job_t *)arg;
+    uint16_image_RGB_remap_grid_t *G = job->G;
+    int k, j;
+    int a[3], b[3];
+    for (k = ini; k <= fin; k++)
+      { uint16_image_RGB_remap_cell_range(G, k, a, b);
+        /* Any pixel in the cell is within distance {sqrt(t)} of some palette color: */
+        int64_t t = INT64_MAX, dmax;
+        for (j = 0; j < G->ncolors; j++)
+          { (void)uint16_image_RGB_remap_box_dist_sqr(&(G->pal[j]), a, b, &dmax);
+            if (dmax < t) { t = dmax; }
+          }
+        /* So only colors within that distance of the cell can be nearest: */
+        int n = 0;
+        for (j = 0; j < G->ncolors; j++)
+          { if (uint16_image_RGB_remap_box_dist_sqr(&(G->pal[j]), a, b, &dmax) <= t) { n++; } }
+        job->thr[k] = t;
+        G->start[k+1] = n;
+      }
+  }
+
+void uint16_image_RGB_remap_fill_cells(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    u16rm_job_t *job = (u16rm_job_t *)arg;
+    uint16_image_RGB_remap_grid_t *G = job->G;
+    int k, j;
+    int a[3], b[3];
+    int64_t dmax;
+    for (k = ini; k <= fin; k++)
+      { uint16_image_RGB_remap_cell_range(G, k, a, b);
+        int n = G->start[k];
+        for (j = 0; j < G->ncolors; j++)
+          { if (uint16_image_RGB_remap_box_dist_sqr(&(G->pal[j]), a, b, &dmax) <= job->thr[k])
+              { G->cand[n] = j; n++; }
+          }
+        assert(n == G->start[k+1]);
+      }
+  }
+
+int uint16_image_RGB_remap_grid_lookup(uint16_image_RGB_remap_grid_t *G, ppm_pixel_t *p)
+  {
+    int sh = G->shift, NL = G->NL;
+    int k = ((p->c[2] >> sh)*NL + (p->c[1] >> sh))*NL + (p->c[0] >> sh);
+    int *cj = &(G->cand[G->start[k]]);
+    int n = G->start[k+1] - G->start[k];
+    int jbest = -1;
+    int64_t dbest = INT64_MAX;
+    int r;
+    for (r = 0; r < n; r++)
+      { ppm_pixel_t *q = &(G->pal[cj[r]]);
+        int64_t dR = (int64_t)p->c[0] - q->c[0];
+        int64_t dG = (int64_t)p->c[1] - q->c[1];
+        int64_t dB = (int64_t)p->c[2] - q->c[2];
+        int64_t d = dR*dR + dG*dG + dB*dB;
+        if (d < dbest) { dbest = d; jbest = cj[r]; }
+      }
+    assert(jbest >= 0);
+    return jbest;
+  }
+
+void uint16_image_RGB_remap_grid_free(uint16_image_RGB_remap_grid_t *G)
+  {
+    free(G->pal);
+    free(G->start);
+    free(G->cand);
+    free(G);
+  }
+
+void uint16_image_RGB_remap_image
+  ( uint16_image_t *img, 
+    uint16_image_RGB_remap_grid_t *G, 
+    uint16_image_t *idx,
+    int nth
+  )
+  {
+    demand((idx->cols == img->cols) && (idx->rows == img->rows), "image sizes do not match");
+    demand(idx->chns == 1, "index image must have one channel");
+    demand(img->chns >= 1, "image has no channels");
+    demand(img->maxval == G->maxval, "inconsistent {maxval}");
+    u16rm_job_t job = (u16rm_job_t){ .G = G, .img = img, .idx = idx };
+    jsthread_run_ranges(img->rows, uint16_image_RGB_remap_BAND_ROWS, nth, &uint16_image_RGB_remap_rows, &job);
+  }
+
+void uint16_image_RGB_remap_rows(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    u16rm_job_t *job = (u16rm_job_t *)arg;
+    uint16_image_t *img = job->img;
+    int chns = img->chns;
+    int y, x;
+    for (y = ini; y <= fin; y++)
+      { uint16_t *sP = img->smp[y];
+        uint16_t *dP = job->idx->smp[y];
+        /* Runs of equal pixels are common, so remember the last one: */
+        ppm_pixel_t prev = (ppm_pixel_t){{ 0, 0, 0 }};
+        int jprev = -1;
+        for (x = 0; x < img->cols; x++)
+          { ppm_pixel_t p;
+            p.c[0] = sP[0];
+            p.c[1] = (chns > 1 ? sP[1] : p.c[0]);
+            p.c[2] = (chns > 2 ? sP[2] : p.c[0]);
+            sP += chns;
+            if ((jprev < 0) || (! ppm_equal(&p, &prev)))
+              { jprev = uint16_image_RGB_remap_grid_lookup(job->G, &p); prev = p; }
+            dP[x] = (uint16_t)jprev;
+          }
+      }
+  }
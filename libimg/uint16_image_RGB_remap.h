@@ -0,0 +1,65 @@
+/* uint16_image_RGB_remap.h - fast mapping of RGB pixels to the nearest color of a palette */
+/* Last edited on 2026-10-19 12:27:17 by stolfi */ 
+
+#ifndef uint16_image_RGB_remap_H
+#define uint16_image_RGB_remap_H
+
+#include <stdint.h>
+
+#include <jspnm.h>
+#include <uint16_image.h>
+#include <uint16_image_RGB_hist.h>
+
+typedef struct uint16_image_RGB_remap_grid_t
+  { uint16_t maxval;    /* Max valid sample value. */
+    int ncolors;        /* Number of palette colors. */
+    ppm_pixel_t *pal;   /* The palette colors {pal[0..ncolors-1]}. */
+    int shift;          /* A sample {v} lies in cell layer {v >> shift}. */
+    int NL;             /* Number of cell layers along each axis. */
+    int *start;         /* The candidates of cell {k} are {cand[start[k]..start[k+1]-1]}. */
+    int *cand;          /* Candidate palette indices, in increasing order within each cell. */
+  } uint16_image_RGB_remap_grid_t;
+  /* A structure that speeds up the search for the palette color nearest
+    to a given RGB pixel.  
+    
+    The RGB cube {[0..maxval]^3} is divided into {NL^3} rectangular cells.
+    The cell with layer indices {iR,iG,iB} has index {k = (iB*NL + iG)*NL + iR},
+    and its list of candidates contains every palette color that could be 
+    the nearest one (by Euclidean distance) to some pixel in that cell. */
+
+uint16_image_RGB_remap_grid_t *uint16_image_RGB_remap_grid_new
+  ( uint16_image_RGB_hist_vector cm,  /* The palette. */
+    int ncolors,                      /* Number of entries in {cm}. */
+    uint16_t maxval,                  /* Max valid sample value. */
+    int nbits,                        /* Max bits of each cell index. */
+    int nth                           /* Number of threads to use. */
+  );
+  /* Builds a lookup grid for the palette colors {cm[0..ncolors-1].color}.
+    The grid has at most {2^nbits} cell layers along each axis.  The
+    candidate lists are computed with {nth} threads (or the default number
+    of threads if {nth} is zero); the result does not depend on {nth}. */
+
+int uint16_image_RGB_remap_grid_lookup(uint16_image_RGB_remap_grid_t *G, ppm_pixel_t *p);
+  /* Returns the index of the palette color nearest to {*p}.  
+    If two or more colors are at the same minimum distance, 
+    returns the one with smallest index. The samples of {*p}
+    must be in {0..G.maxval}. */
+
+void uint16_image_RGB_remap_grid_free(uint16_image_RGB_remap_grid_t *G);
+  /* Frees all storage of {G}, including the record {*G} itself. */
+
+void uint16_image_RGB_remap_image
+  ( uint16_image_t *img, 
+    uint16_image_RGB_remap_grid_t *G, 
+    uint16_image_t *idx,
+    int nth
+  );
+  /* Stores into each pixel of the single-channel image {idx} the index of 
+    the palette color nearest to the corresponding pixel of {img}, as 
+    returned by {uint16_image_RGB_remap_grid_lookup}.  The two images must
+    have the same size, and {img} must have the same {maxval} as {G}.
+    Images with fewer than 3 channels are expanded by replicating channel 0.
+    The rows are processed in bands by {nth} threads (or the default
+    number of threads if {nth} is zero). */
+
+#endif
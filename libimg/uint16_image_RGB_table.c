@@ -1,5 +1,5 @@
 /* See uint16_image_RGB_table.h
-** Last edited on 2009-01-07 03:13:15 by stolfi
+** Last edited on 2026-10-19 12:27:17 by stolfi
 **
 ** Copied from Jef Poskanzer's libppm3.c - ppm utility library part 3
 **
@@ -13,24 +13,67 @@
 ** implied warranty.
 */
 
-#include <affirm.h>
+#include <assert.h>
+#include <stdlib.h>
 #include <stdint.h>
 
+#include <affirm.h>
+
 #include <jspnm.h>
 
 #include <uint16_image_RGB_hist.h>
 #include <uint16_image_RGB_table.h>
 
-#define HASH_SIZE 20023
+#define uint16_image_RGB_table_MIN_SIZE 1024
+  /* Initial number of slots in a table. */
+
+uint64_t uint16_image_RGB_table_pack_pixel(ppm_pixel_t *p);
+  /* Packs the samples of {*p} into a 48-bit integer, and adds 1 so that
+    the result is never zero. */
+
+ppm_pixel_t uint16_image_RGB_table_unpack_pixel(uint64_t key);
+  /* The inverse of {uint16_image_RGB_table_pack_pixel}. */
+
+uint32_t uint16_image_RGB_table_find_slot(uint16_image_RGB_table cht, uint64_t key);
+  /* Returns the slot of {cht} that holds {key}, or the empty slot 
+    where it should be inserted. */
+
+void uint16_image_RGB_table_grow(uint16_image_RGB_table cht);
+  /* Doubles the number of slots in {cht}, rehashing all entries. */
 
-uint32_t uint16_image_RGB_table_hash_pixel(ppm_pixel_t *p);
-  /* Computes a hash index for an RGB pixel. */
+uint64_t uint16_image_RGB_table_pack_pixel(ppm_pixel_t *p)
+  { return ((((uint64_t)p->c[0]) << 32) | (((uint64_t)p->c[1]) << 16) | ((uint64_t)p->c[2])) + 1; }
 
-uint32_t uint16_image_RGB_table_hash_pixel(ppm_pixel_t *p)
-  { uint32_t r = p->c[0];
-    uint32_t g = p->c[1];
-    uint32_t b = p->c[2];
-    return ((r * 33023 + g * 30013 + b * 27011) & 0x7fffffff) % HASH_SIZE;
+ppm_pixel_t uint16_image_RGB_table_unpack_pixel(uint64_t key)
+  { key--;
+    return (ppm_pixel_t){{ (uint16_t)(key >> 32), (uint16_t)(key >> 16), (uint16_t)key }};
+  }
+
+uint32_t uint16_image_RGB_table_find_slot(uint16_image_RGB_table cht, uint64_t key)
+  { uint32_t mask = cht->size - 1;
+    /* Fibonacci hashing; the high bits of the product are the best mixed: */
+    uint32_t s = (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while ((cht->key[s] != 0) && (cht->key[s] != key)) { s = (s + 1) & mask; }
+    return s;
+  }
+
+void uint16_image_RGB_table_grow(uint16_image_RGB_table cht)
+  { uint32_t osize = cht->size;
+    uint64_t *okey = cht->key;
+    int *oval = cht->val;
+    cht->size = 2*osize;
+    cht->key = (uint64_t *)notnull(calloc(cht->size, sizeof(uint64_t)), "no mem");
+    cht->val = (int *)notnull(malloc(cht->size*sizeof(int)), "no mem");
+    uint32_t s;
+    for (s = 0; s < osize; s++)
+      { if (okey[s] != 0)
+          { uint32_t t = uint16_image_RGB_table_find_slot(cht, okey[s]);
+            cht->key[t] = okey[s];
+            cht->val[t] = oval[s];
+          }
+      }
+    free(okey);
+    free(oval);
   }
 
 uint16_image_RGB_table uint16_image_RGB_table_build
@@ -41,12 +84,8 @@ uint16_image_RGB_table uint16_image_RGB_table_build
     int maxcolors, 
     int *colorsP )
   {
-    uint16_image_RGB_table cht;
-    uint16_image_RGB_bucket chl;
-    int col, row, hash;
-
-    cht = uint16_image_RGB_table_alloc( );
-    *colorsP = 0;
+    uint16_image_RGB_table cht = uint16_image_RGB_table_alloc();
+    int col, row;
 
     /* Go through the entire image, building a hash table of colors. */
     for (row = 0; row < rows; ++row)
@@ -58,68 +97,67 @@ uint16_image_RGB_table uint16_image_RGB_table_build
             if (chns > 1) { p.c[1] = *sP; sP++; } else {p.c[1] = p.c[0]; }
             if (chns > 2) { p.c[2] = *sP; sP++; } else {p.c[2] = p.c[0]; }
             if (chns > 3) { sP += (chns-3); }
-            hash = uint16_image_RGB_table_hash_pixel(&p);
-            for (chl = cht[hash]; chl != (uint16_image_RGB_bucket)NULL; chl = chl->next)
-              { if (ppm_equal(&(chl->ch.color), &p)) break; }
-            if (chl != (uint16_image_RGB_bucket)NULL) 
-              { ++(chl->ch.value); }
+            uint64_t key = uint16_image_RGB_table_pack_pixel(&p);
+            uint32_t s = uint16_image_RGB_table_find_slot(cht, key);
+            if (cht->key[s] != 0)
+              { ++(cht->val[s]); }
             else
-              { if (++(*colorsP) > maxcolors)
+              { if ((int)cht->count >= maxcolors)
                   { uint16_image_RGB_table_free(cht);
+                    *colorsP = maxcolors + 1;
                     return (uint16_image_RGB_table)NULL;
                   }
-                chl = (uint16_image_RGB_bucket)pnm_malloc(sizeof(struct uint16_image_RGB_bucket_item));
-                chl->ch.color = p;
-                chl->ch.value = 1;
-                chl->next = cht[hash];
-                cht[hash] = chl;
+                cht->key[s] = key;
+                cht->val[s] = 1;
+                cht->count++;
+                if (2*cht->count > cht->size) { uint16_image_RGB_table_grow(cht); }
               }
           }
       }
+    *colorsP = (int)cht->count;
     return cht;
   }
 
 uint16_image_RGB_table uint16_image_RGB_table_alloc(void)
   {
-    uint16_image_RGB_table cht;
-    int i;
-
-    cht = (uint16_image_RGB_table)pnm_malloc(HASH_SIZE * sizeof(uint16_image_RGB_bucket));
-
-    for (i = 0; i < HASH_SIZE; ++i) { cht[i] = (uint16_image_RGB_bucket)NULL; }
-
+    uint16_image_RGB_table cht = (uint16_image_RGB_table)notnull(malloc(sizeof(uint16_image_RGB_table_rec)), "no mem");
+    cht->size = uint16_image_RGB_table_MIN_SIZE;
+    cht->count = 0;
+    cht->key = (uint64_t *)notnull(calloc(cht->size, sizeof(uint64_t)), "no mem");
+    cht->val = (int *)notnull(malloc(cht->size*sizeof(int)), "no mem");
     return cht;
   }
 
 int uint16_image_RGB_table_add(uint16_image_RGB_table cht, ppm_pixel_t* colorP, int value)
   {
-    register int hash;
-    register uint16_image_RGB_bucket chl;
-
-    chl = (uint16_image_RGB_bucket)pnm_malloc(sizeof(struct uint16_image_RGB_bucket_item));
-    hash = uint16_image_RGB_table_hash_pixel(colorP);
-    chl->ch.color = *colorP;
-    chl->ch.value = value;
-    chl->next = cht[hash];
-    cht[hash] = chl;
+    uint64_t key = uint16_image_RGB_table_pack_pixel(colorP);
+    uint32_t s = uint16_image_RGB_table_find_slot(cht, key);
+    if (cht->key[s] == 0)
+      { cht->key[s] = key;
+        cht->count++;
+      }
+    cht->val[s] = value;
+    if (2*cht->count > cht->size) { uint16_image_RGB_table_grow(cht); }
     return 0;
   }
 
 uint16_image_RGB_hist_vector uint16_image_RGB_table_to_hist(uint16_image_RGB_table cht, int maxcolors)
   {
     uint16_image_RGB_hist_vector chv;
-    uint16_image_RGB_bucket chl;
-    int i, j;
+    uint32_t s;
+    int j;
 
     /* Now collate the hash table into a simple colorhist array. */
     chv = (uint16_image_RGB_hist_vector)pnm_malloc(maxcolors * sizeof(struct uint16_image_RGB_hist_item));
 
     /* Loop through the hash table. */
     j = 0;
-    for (i = 0; i < HASH_SIZE; ++i)
-      { for (chl = cht[i]; chl != (uint16_image_RGB_bucket)NULL; chl = chl->next)
+    for (s = 0; s < cht->size; ++s)
+      { if (cht->key[s] != 0)
           { /* Add the new entry. */
-            chv[j] = chl->ch;
+            assert(j < maxcolors);
+            chv[j].color = uint16_image_RGB_table_unpack_pixel(cht->key[s]);
+            chv[j].value = cht->val[s];
             ++j;
           }
       }
@@ -129,29 +167,23 @@ uint16_image_RGB_hist_vector uint16_image_RGB_table_to_hist(uint16_image_RGB_tab
 
 uint16_image_RGB_table uint16_image_RGB_hist_to_table(uint16_image_RGB_hist_vector chv, int colors)
   {
-    uint16_image_RGB_table cht;
-    int i, hash;
-    ppm_pixel_t color;
-    uint16_image_RGB_bucket chl;
-
-    cht = uint16_image_RGB_table_alloc();
+    uint16_image_RGB_table cht = uint16_image_RGB_table_alloc();
+    int i;
 
     for (i = 0; i < colors; ++i)
-      { color = chv[i].color;
-        hash = uint16_image_RGB_table_hash_pixel(&color);
-        for (chl = cht[hash]; chl != (uint16_image_RGB_bucket)NULL; chl = chl->next)
-          { if (ppm_equal(&(chl->ch.color), &color))
-              { pnm_error
-                  ( "same color found twice - %u %u %u", 
-                    color.c[0], color.c[1], color.c[2]
-                  );
-              }
+      { ppm_pixel_t color = chv[i].color;
+        uint64_t key = uint16_image_RGB_table_pack_pixel(&color);
+        uint32_t s = uint16_image_RGB_table_find_slot(cht, key);
+        if (cht->key[s] != 0)
+          { pnm_error
+              ( "same color found twice - %u %u %u", 
+                color.c[0], color.c[1], color.c[2]
+              );
           }
-        chl = (uint16_image_RGB_bucket)pnm_malloc( sizeof(struct uint16_image_RGB_bucket_item));
-        chl->ch.color = color;
-        chl->ch.value = i;
-        chl->next = cht[hash];
-        cht[hash] = chl;
+        cht->key[s] = key;
+        cht->val[s] = i;
+        cht->count++;
+        if (2*cht->count > cht->size) { uint16_image_RGB_table_grow(cht); }
       }
 
     return cht;
@@ -159,25 +191,14 @@ uint16_image_RGB_table uint16_image_RGB_hist_to_table(uint16_image_RGB_hist_vect
 
 int uint16_image_RGB_table_lookup(uint16_image_RGB_table cht, ppm_pixel_t* colorP)
   {
-    int hash;
-    uint16_image_RGB_bucket chl;
-    hash = uint16_image_RGB_table_hash_pixel(colorP);
-    for (chl = cht[hash]; chl != (uint16_image_RGB_bucket)NULL; chl = chl->next)
-      { if (ppm_equal(&(chl->ch.color), colorP))
-          { return chl->ch.value; }
-      }
-    return -1;
+    uint64_t key = uint16_image_RGB_table_pack_pixel(colorP);
+    uint32_t s = uint16_image_RGB_table_find_slot(cht, key);
+    return (cht->key[s] != 0 ? cht->val[s] : -1);
   }
 
 void uint16_image_RGB_table_free(uint16_image_RGB_table cht)
   {
-    int i;
-    uint16_image_RGB_bucket chl, chlnext;
-    for (i = 0; i < HASH_SIZE; ++i)
-      { for (chl = cht[i]; chl != (uint16_image_RGB_bucket)NULL; chl = chlnext)
-          { chlnext = chl->next;
-            free(chl);
-          }
-      }
+    free(cht->key);
+    free(cht->val);
     free(cht);
   }
@@ -1,16 +1,27 @@
 /* uint16_image_RGB_table.h - hash table of RGB colors */
-/* Last edited on 2009-01-07 01:40:57 by stolfi */ 
+/* Last edited on 2026-10-19 12:27:17 by stolfi */ 
 
 #ifndef uint16_image_RGB_table_H
 #define uint16_image_RGB_table_H
 
+#include <stdint.h>
+
 #include <jspnm.h>
 #include <uint16_image_RGB_hist.h>
 
-typedef struct uint16_image_RGB_bucket_item *uint16_image_RGB_bucket;
-typedef struct uint16_image_RGB_bucket_item { struct uint16_image_RGB_hist_item ch; uint16_image_RGB_bucket next; } uint16_image_RGB_bucket_item;
+typedef struct uint16_image_RGB_table_rec
+  { uint32_t size;   /* Number of slots, a power of 2. */
+    uint32_t count;  /* Number of slots in use. */
+    uint64_t *key;   /* {key[s]} is the packed color in slot {s} plus 1, or 0 if the slot is empty. */
+    int *val;        /* {val[s]} is the value associated with the color in slot {s}. */
+  } uint16_image_RGB_table_rec;
+  /* A hash table that associates an integer value to each of a set of RGB colors.
+    
+    The three samples of a color are packed into a single 48-bit key,
+    and the table uses open addressing with linear probing.  The number
+    of slots is doubled whenever the table becomes half full. */
 
-typedef uint16_image_RGB_bucket *uint16_image_RGB_table;
+typedef uint16_image_RGB_table_rec *uint16_image_RGB_table;
 
 uint16_image_RGB_table uint16_image_RGB_table_build
   ( uint16_t **samples,
@@ -19,14 +30,22 @@ uint16_image_RGB_table uint16_image_RGB_table_build
     int rows, 
     int maxcolors, 
     int *colorsP );
+  /* Returns a table that maps each distinct color of the given samples
+    to the number of pixels with that color, and stores in {*colorsP}
+    the number of distinct colors.  Returns NULL if there are more
+    than {maxcolors} of them.  Pixels with fewer than 3 channels are
+    expanded by replicating channel 0; extra channels are ignored. */
 
 int uint16_image_RGB_table_lookup (uint16_image_RGB_table cht, ppm_pixel_t *colorP);
+  /* The value associated with the color {*colorP}, or -1 if that
+    color is not in the table. */
 
 uint16_image_RGB_hist_vector uint16_image_RGB_table_to_hist (uint16_image_RGB_table cht, int maxcolors);
 uint16_image_RGB_table uint16_image_RGB_hist_to_table (uint16_image_RGB_hist_vector chv, int colors);
 
 int uint16_image_RGB_table_add (uint16_image_RGB_table cht, ppm_pixel_t *colorP, int value);
-  /* Returns -1 on failure. */
+  /* Associates the {value} to the color {*colorP}, replacing
+    any previous value. Returns -1 on failure. */
 
 uint16_image_RGB_table uint16_image_RGB_table_alloc (void);
 
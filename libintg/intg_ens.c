@@ -0,0 +1,324 @@
+/* See intg_ens.h. */
+/* Last edited on 2026-10-19 12:10:41 by stolfi */
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsthread.h>
+
+#include <intg_gen.h>
+#include <intg_ens.h>
+
+/* INTERNAL PROTOTYPES */
+
+typedef struct intg_ens_job_t
+  { intg_ens_method_t *M;
+    intg_ens_rhs_t *rhs;
+    void *arg;
+    int n;
+    int N;
+    double *s;
+    Time t0, t1, dt, dtMin, dtMax;
+    Dist tol;
+    int nl;          /* Lanes per batch. */
+    int *nsteps;
+    bool_t *aborted; /* {aborted[b]} tells whether batch {b} was aborted. */
+  } intg_ens_job_t;
+  /* Arguments of {intg_ens_integrate} for the threads. */
+
+void intg_ens_do_batches(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Integrates the batches {ini..fin} of the ensemble described by the
+    {intg_ens_job_t} record {*arg}. */
+
+bool_t intg_ens_batch
+  ( intg_ens_job_t *job,
+    int k0,
+    int m,
+    double *wk,
+    bool_t *fl
+  );
+  /* Integrates the trajectories {k0..k0+m-1} of the ensemble described
+    by {job}, using {wk[0..intg_ens_work_size(M,n,m)-1]} and {fl[0..2*m-1]}
+    as work areas.  Returns TRUE if the integration was aborted by the
+    right-hand side. */
+
+int intg_ens_work_size(intg_ens_method_t *M, int n, int nl);
+  /* Number of {double}s needed by {intg_ens_batch} for a batch of
+    {nl} lanes. */
+
+Time intg_ens_adjust(intg_ens_method_t *M, Time dt, Dist error, Dist tol, Time dtMin, Time dtMax);
+  /* Computes the next step size as described under {intg_ens_method_t}. */
+
+/* Maximum scale factor allowed in {adjust}: */
+#define MaxScale (10.0)
+
+/* Minimum scale factor allowed in {adjust}: */
+#define MinScale (1.0/MaxScale)
+
+/* IMPLEMENTATIONS */
+
+intg_ens_method_t intg_ens_method_Euler(void)
+  { intg_ens_method_t M = (intg_ens_method_t){ .descr = "Euler", .ns = 0 };
+    M.b[0] = 1.0;
+    M.e[0] = 1.0; M.e_dt = TRUE;
+    M.order = 2.0; M.safety = 0.95;
+    return M;
+  }
+
+intg_ens_method_t intg_ens_method_RKF2(void)
+  { intg_ens_method_t M = (intg_ens_method_t){ .descr = "RKF2", .ns = 1 };
+    M.a[1][0] = 0.5;
+    M.b[0] = 1.0; M.b[1] = 0.0;
+    M.e[0] = 0.5; M.e[1] = -0.5; M.e_dt = TRUE;
+    M.order = 3.0; M.safety = 0.95;
+    return M;
+  }
+
+intg_ens_method_t intg_ens_method_RKF4(void)
+  { intg_ens_method_t M = (intg_ens_method_t){ .descr = "RKF4", .ns = 5 };
+
+    M.a[1][0] = 1.0/4.0;
+
+    M.a[2][0] = 3.0/32.0;
+    M.a[2][1] = 9.0/32.0;
+
+    M.a[3][0] = 1932.0/2197.0;
+    M.a[3][1] = -7200.0/2197.0;
+    M.a[3][2] = 7296.0/2197.0;
+
+    M.a[4][0] = 439.0/216.0;
+    M.a[4][1] = -8.0;
+    M.a[4][2] = 3680.0/513.0;
+    M.a[4][3] = -845.0/4104.0;
+
+    M.a[5][0] = -8.0/27.0;
+    M.a[5][1] = 2.0;
+    M.a[5][2] = -3544.0/2565.0;
+    M.a[5][3] = 1859.0/4104.0;
+    M.a[5][4] = -11.0/40.0;
+
+    M.b[0] = 25.0/216.0;
+    M.b[1] = 0.0;
+    M.b[2] = 1408.0/2565.0;
+    M.b[3] = 2197.0/4104.0;
+    M.b[4] = -1.0/5.0;
+    M.b[5] = 0.0;
+
+    M.e[0] = 1.0/360.0;
+    M.e[1] = 0.0;
+    M.e[2] = -128.0/4275.0;
+    M.e[3] = -2197.0/75240.0;
+    M.e[4] = 1.0/50.0;
+    M.e[5] = 2.0/55.0;
+    M.e_dt = FALSE;
+
+    M.order = 4.0; M.safety = 0.840896415253;
+    return M;
+  }
+
+Time intg_ens_adjust(intg_ens_method_t *M, Time dt, Dist error, Dist tol, Time dtMin, Time dtMax)
+  { double scale;
+    if (error > 0.0)
+      { scale = M->safety * pow(tol/error, 1.0/M->order);
+        if (scale < MinScale) { scale = MinScale; }
+        if (scale > MaxScale) { scale = MaxScale; }
+      }
+    else
+      { scale = MaxScale; }
+    dt = scale * dt;
+    if (dt < dtMin) { dt = dtMin; }
+    if (dt > dtMax) { dt = dtMax; }
+    return dt;
+  }
+
+int intg_ens_integrate
+  ( intg_ens_method_t *M,
+    intg_ens_rhs_t *rhs,
+    void *arg,
+    int n,
+    int N,
+    double s[],
+    Time t0,
+    Time t1,
+    Time dt,
+    Time dtMin,
+    Time dtMax,
+    Dist tol,
+    int nl,
+    int nth,
+    int nsteps[]
+  )
+  { demand((M->ns >= 0) && (M->ns <= intg_ens_MAX_STAGES), "invalid method");
+    demand((dtMin > 0) && (dtMin <= dt) && (dt <= dtMax), "invalid step sizes");
+    if (nl == 0) { nl = intg_ens_DEFAULT_LANES; }
+    demand(nl > 0, "invalid lane count");
+    if (N <= 0) { return 0; }
+
+    int nb = (N + nl - 1)/nl; /* Number of batches. */
+    bool_t *aborted = notnull(malloc(nb*sizeof(bool_t)), "no mem");
+    intg_ens_job_t job = (intg_ens_job_t)
+      { .M = M, .rhs = rhs, .arg = arg, .n = n, .N = N, .s = s,
+        .t0 = t0, .t1 = t1, .dt = dt, .dtMin = dtMin, .dtMax = dtMax, .tol = tol,
+        .nl = nl, .nsteps = nsteps, .aborted = aborted
+      };
+    jsthread_run_ranges(nb, 1, nth, &intg_ens_do_batches, &job);
+
+    int nab = 0;
+    int b;
+    for (b = 0; b < nb; b++)
+      { if (aborted[b]) { nab += (b < nb - 1 ? nl : N - b*nl); } }
+    free(aborted);
+    return nab;
+  }
+
+int intg_ens_work_size(intg_ens_method_t *M, int n, int nl)
+  { /* States {Sa,Sm,Sb} and velocities {V[0..ns]}, plus 5 lane vectors: */
+    return (3 + M->ns + 1)*n*nl + 5*nl;
+  }
+
+void intg_ens_do_batches(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  { intg_ens_job_t *job = (intg_ens_job_t *)arg;
+    int nl = job->nl;
+    double *wk = notnull(malloc(intg_ens_work_size(job->M, job->n, nl)*sizeof(double)), "no mem");
+    bool_t *fl = notnull(malloc(2*nl*sizeof(bool_t)), "no mem");
+    int b;
+    for (b = ini; b <= fin; b++)
+      { int k0 = b*nl;
+        int m = (k0 + nl <= job->N ? nl : job->N - k0);
+        job->aborted[b] = intg_ens_batch(job, k0, m, wk, fl);
+      }
+    free(wk);
+    free(fl);
+  }
+
+bool_t intg_ens_batch
+  ( intg_ens_job_t *job,
+    int k0,
+    int m,
+    double *wk,
+    bool_t *fl
+  )
+  { intg_ens_method_t *M = job->M;
+    intg_ens_rhs_t *rhs = job->rhs;
+    int n = job->n;
+    int ns = M->ns;
+    int nv = n*m; /* Elements in a batch state vector. */
+    Time t1 = job->t1;
+    int i, j, k, r;
+
+    /* Carve the work area: */
+    double *Sa = wk;         /* Current states. */
+    double *Sm = Sa + nv;    /* Intermediate states. */
+    double *Sb = Sm + nv;    /* Tentative final states. */
+    double *V[intg_ens_MAX_STAGES+1]; /* {V[0]} are velocities at {Sa}, {V[j]} at stage {j}. */
+    for (j = 0; j <= ns; j++) { V[j] = Sb + (j+1)*nv; }
+    double *tl = V[ns] + nv;   /* {tl[k]} is the current time of lane {k}. */
+    double *dtl = tl + m;      /* {dtl[k]} is the current step size of lane {k}. */
+    double *h = dtl + m;       /* {h[k]} is the size of the current step of lane {k}, or 0. */
+    double *ts = h + m;        /* {ts[k]} is the time of the current stage of lane {k}. */
+    double *err2 = ts + m;     /* {err2[k]} is the error norm squared of the current step. */
+    assert(err2 + m == wk + intg_ens_work_size(M, n, m));
+    bool_t *act = fl;          /* {act[k]} tells whether lane {k} has not reached {t1} yet. */
+    bool_t *newv = fl + m;     /* {newv[k]} tells whether lane {k} needs the velocity at {Sa}. */
+
+    /* Gather the initial states and initialize the lanes: */
+    for (k = 0; k < m; k++)
+      { double *sk = &(job->s[(k0 + k)*n]);
+        for (i = 0; i < n; i++) { Sa[i*m + k] = sk[i]; }
+        tl[k] = job->t0;
+        dtl[k] = job->dt;
+        act[k] = (tl[k] < t1);
+        newv[k] = act[k];
+        if (job->nsteps != NULL) { job->nsteps[k0 + k] = 0; }
+      }
+
+    while (TRUE)
+      { /* Count the active lanes and get their velocities at {Sa}: */
+        int nact = 0, nnew = 0;
+        for (k = 0; k < m; k++) { nact += act[k]; nnew += newv[k]; }
+        if (nact == 0) { break; }
+        if (nnew > 0)
+          { /* Evaluate into {Sm}, since the other lanes of {V[0]} must be preserved: */
+            if (rhs(m, k0, tl, n, Sa, Sm, newv, job->arg)) { return TRUE; }
+            for (i = 0; i < n; i++)
+              { double *sm = &(Sm[i*m]), *v0 = &(V[0][i*m]);
+                for (k = 0; k < m; k++) { if (newv[k]) { v0[k] = sm[k]; } }
+              }
+          }
+
+        /* Choose the step sizes, zero for inactive lanes: */
+        for (k = 0; k < m; k++)
+          { double hk = (t1 - tl[k] < dtl[k] ? t1 - tl[k] : dtl[k]);
+            h[k] = (act[k] ? hk : 0.0);
+          }
+
+        /* Evaluate the intermediate stages: */
+        for (j = 1; j <= ns; j++)
+          { double cj = 0;
+            for (r = 0; r < j; r++) { cj += M->a[j][r]; }
+            for (k = 0; k < m; k++) { ts[k] = tl[k] + h[k]*cj; }
+            for (i = 0; i < n; i++)
+              { double *sa = &(Sa[i*m]), *sm = &(Sm[i*m]);
+                for (k = 0; k < m; k++) { sm[k] = 0; }
+                for (r = 0; r < j; r++)
+                  { double ajr = M->a[j][r];
+                    if (ajr == 0) { continue; }
+                    double *vr = &(V[r][i*m]);
+                    for (k = 0; k < m; k++) { sm[k] += (h[k]*ajr)*vr[k]; }
+                  }
+                for (k = 0; k < m; k++) { sm[k] = sa[k] + sm[k]; }
+              }
+            if (rhs(m, k0, ts, n, Sm, V[j], act, job->arg)) { return TRUE; }
+          }
+
+        /* Compute the final states and the error norms: */
+        for (k = 0; k < m; k++) { err2[k] = 0; }
+        for (i = 0; i < n; i++)
+          { double *sa = &(Sa[i*m]), *sb = &(Sb[i*m]), *eb = &(Sm[i*m]);
+            for (k = 0; k < m; k++) { sb[k] = 0; eb[k] = 0; }
+            for (r = 0; r <= ns; r++)
+              { double br = M->b[r], er = M->e[r];
+                double *vr = &(V[r][i*m]);
+                if (br != 0) { for (k = 0; k < m; k++) { sb[k] += (h[k]*br)*vr[k]; } }
+                if (er != 0)
+                  { if (M->e_dt)
+                      { for (k = 0; k < m; k++) { eb[k] += (h[k]*er)*vr[k]; } }
+                    else
+                      { for (k = 0; k < m; k++) { eb[k] += er*vr[k]; } }
+                  }
+              }
+            for (k = 0; k < m; k++)
+              { sb[k] = sa[k] + sb[k];
+                err2[k] += eb[k]*eb[k];
+              }
+          }
+
+        /* Accept or reject the step in each active lane, and adjust its step size: */
+        for (k = 0; k < m; k++)
+          { newv[k] = FALSE;
+            if (! act[k]) { continue; }
+            double error = sqrt(err2[k]);
+            bool_t ok = ((error < job->tol) || (h[k] <= job->dtMin));
+            if (ok)
+              { for (i = 0; i < n; i++) { Sa[i*m + k] = Sb[i*m + k]; }
+                tl[k] = (h[k] == t1 - tl[k] ? t1 : tl[k] + h[k]);
+                if (job->nsteps != NULL) { job->nsteps[k0 + k]++; }
+                act[k] = (tl[k] < t1);
+                newv[k] = act[k];
+              }
+            dtl[k] = intg_ens_adjust(M, h[k], error, job->tol, job->dtMin, job->dtMax);
+          }
+      }
+
+    /* Scatter the final states: */
+    for (k = 0; k < m; k++)
+      { double *sk = &(job->s[(k0 + k)*n]);
+        for (i = 0; i < n; i++) { sk[i] = Sa[i*m + k]; }
+      }
+    return FALSE;
+  }
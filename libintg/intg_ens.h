@@ -0,0 +1,134 @@
+/* intg_ens.h - lockstep integration of ensembles of ODE trajectories. */
+/* Last edited on 2026-10-19 12:10:41 by stolfi */
+
+#ifndef intg_ens_H
+#define intg_ens_H
+
+#include <bool.h>
+#include <intg_gen.h>
+
+/*
+  These tools integrate many trajectories {s_k(t)} of the same
+  ordinary differential equation {ds/dt = rhs(t,s)}, with different
+  initial states or different parameters (e.g. a parameter sweep or
+  a cloud of initial conditions).
+
+  The trajectories are processed in /batches/ of {nl} consecutive
+  trajectories, the /lanes/ of the batch. The states of a batch are
+  stored by coordinate ("structure of arrays"), so that the same
+  coordinate of all lanes is contiguous in memory; the right-hand side
+  is evaluated for all lanes in a single call; and each integration
+  step is a set of simple loops over the lanes that the compiler can
+  vectorize. Each lane has its own time and adaptive step size; lanes
+  that have finished, or that do not need an evaluation at some point,
+  are flagged as inactive in the call. Different batches are
+  integrated in parallel by separate threads. */
+
+typedef bool_t intg_ens_rhs_t
+  ( int nl,        /* Number of lanes in the batch. */
+    int k0,        /* Index of the trajectory in lane 0. */
+    Time t[],      /* Time of each lane. */
+    int n,         /* Dimension of state vector. */
+    double s[],    /* (IN) States of the lanes. */
+    double v[],    /* (OUT) Velocities of the lanes. */
+    bool_t act[],  /* Tells which lanes must be evaluated. */
+    void *arg      /* Client data. */
+  );
+  /* Called by the ensemble integrator to evaluate the right-hand side
+    of the differential equation at time {t[k]} and state
+    {(s[i*nl + k] : i \in 0..n-1)}, for every lane {k} in {0..nl-1}
+    with {act[k]} TRUE. Coordinate {i} of the result for that lane
+    must be stored into {v[i*nl + k]}.  Lane {k} is trajectory number
+    {k0 + k} of the ensemble, which may be used to select its parameters.
+
+    The procedure may evaluate the inactive lanes too, and may
+    store anything into their elements of {v}. If the result is
+    {TRUE}, the integration of the whole batch is aborted.
+
+    The procedure will be called concurrently for different batches,
+    so it must not modify any data that is shared between them,
+    including {*arg}, without proper synchronization. */
+
+#define intg_ens_MAX_STAGES 5
+  /* Max number of additional evaluations of the right-hand side per step. */
+
+typedef struct intg_ens_method_t
+  { char *descr;   /* Printable description of the method. */
+    int ns;        /* Number of additional evaluations per step. */
+    double a[intg_ens_MAX_STAGES+1][intg_ens_MAX_STAGES];
+      /* Stage {j} is evaluated at state {sa + h*SUM{a[j][r]*v[r] : r \in 0..j-1}}. */
+    double b[intg_ens_MAX_STAGES+1];
+      /* The final state is {sa + h*SUM{b[r]*v[r] : r \in 0..ns}}. */
+    double e[intg_ens_MAX_STAGES+1];
+      /* The error estimate is {SUM{e[r]*v[r] : r \in 0..ns}}, times {h} if {e_dt}. */
+    bool_t e_dt;   /* Tells whether the error estimate is to be multiplied by {h}. */
+    double order;  /* Exponent of the step size adjustment rule. */
+    double safety; /* Safety factor of the step size adjustment rule. */
+  } intg_ens_method_t;
+  /* An explicit Runge-Kutta method, with an embedded error estimate.
+
+    A step of size {h} from time {ta} and state {sa} starts with
+    the velocity {v[0] = rhs(ta,sa)}.  Then, for each {j} in {1..ns},
+    the velocity {v[j]} is {rhs(ta + h*c[j], sm[j])}, where {sm[j]}
+    is the state defined by row {a[j]}, and {c[j]} is the sum of that
+    row.
+
+    Given the size {h} of a step and the norm {error} of its error
+    estimate, the next step size is {h*safety*(tol/error)^(1/order)},
+    with the factor clipped to {[0.1 _ 10]}, and the result clipped to
+    {[dtMin _ dtMax]}. */
+
+intg_ens_method_t intg_ens_method_Euler(void);
+intg_ens_method_t intg_ens_method_RKF2(void);
+intg_ens_method_t intg_ens_method_RKF4(void);
+  /* These procedures return the methods of the integrators
+    {Intg_Euler_T}, {Intg_RKF2_T}, and {Intg_RKF4_T}, respectively,
+    with the same step formulas, error estimates and step
+    size adjustment rules. */
+
+#define intg_ens_DEFAULT_LANES 64
+  /* Default number of lanes per batch. */
+
+int intg_ens_integrate
+  ( intg_ens_method_t *M, /* The integration method. */
+    intg_ens_rhs_t *rhs,  /* Computes the right-hand side. */
+    void *arg,            /* Client data for {rhs}. */
+    int n,                /* Dimension of state vector. */
+    int N,                /* Number of trajectories. */
+    double s[],           /* (IN/OUT) States of all trajectories. */
+    Time t0,              /* Integration start time. */
+    Time t1,              /* Integration stopping time. */
+    Time dt,              /* Initial time step. */
+    Time dtMin,           /* Minimum time step. */
+    Time dtMax,           /* Maximum time step. */
+    Dist tol,             /* Error tolerance per step. */
+    int nl,               /* Number of lanes per batch, or 0 for the default. */
+    int nth,              /* Number of threads, or 0 for one per processor. */
+    int nsteps[]          /* (OUT) Number of steps of each trajectory, or NULL. */
+  );
+  /* Integrates {N} trajectories of the equation {ds/dt = rhs(t,s)} from
+    time {t0} to time {t1}, with the method {M}.
+
+    The initial state of trajectory {k} must be given in {s[k*n + i]}
+    for {i} in {0..n-1}, and is replaced by its final state.
+
+    Each trajectory is integrated with adaptive stepsize control, as
+    described in {intg_gen.h}: each step from time {ta} starts with size
+    {h = min(dt, t1-ta)}, where {dt} is the current step size of the
+    trajectory; the step is accepted if the Euclidean norm of its error
+    estimate is less than {tol}, or if {h <= dtMin}; and in either
+    case the {dt} of the trajectory is adjusted as described under
+    {intg_ens_method_t}. If {dtMin == dtMax}, every step is accepted,
+    so the integration is done with fixed step size. Requires
+    {0 < dtMin <= dt <= dtMax}.
+
+    The trajectories are processed in batches of {nl} lanes (or
+    {intg_ens_DEFAULT_LANES} if {nl} is zero), distributed among
+    {nth} threads. The number of steps taken by trajectory {k} is
+    returned in {nsteps[k]}, if {nsteps} is not NULL.
+
+    Returns the number of trajectories whose batch was aborted
+    because {rhs} returned TRUE. The states of those trajectories are
+    left undefined. */
+
+#endif
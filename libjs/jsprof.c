@@ -0,0 +1,287 @@
+/* See jsprof.h */
+/* Last edited on 2026-10-19 13:25:06 by stolfi */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jstime.h>
+#include <jswsize.h>
+
+#include <jsprof.h>
+
+typedef struct jsprof_node_t
+  { char *name;                   /* Name of the stage or counter. */
+    int32_t ix;                   /* Index of the stage, or {-1}. */
+    bool_t counter;               /* TRUE if this node is a counter. */
+    int64_t ncalls;               /* Number of completed calls of the stage. */
+    double real_usec;             /* Total real time of completed calls. */
+    int64_t count;                /* Total of the counter. */
+    double t_start;               /* Clock at the last {jsprof_enter}. */
+    struct jsprof_node_t *parent; /* Parent node, or NULL for the root. */
+    struct jsprof_node_t *child;  /* First child node, or NULL. */
+    struct jsprof_node_t *next;   /* Next sibling, or NULL. */
+    struct jsprof_node_t *root_next; /* For roots, next root in the list of all threads. */
+  } jsprof_node_t;
+  /* A node of the profile tree of a thread. */
+
+static __thread jsprof_node_t *jsprof_cur = NULL;
+  /* Current stage of this thread, or NULL if the thread has no tree yet. */
+
+static __thread bool_t jsprof_worker = FALSE;
+  /* TRUE between {jsprof_worker_begin} and {jsprof_worker_end}. */
+
+static jsprof_node_t *jsprof_roots = NULL;
+  /* The roots of the trees of all live threads, except workers. */
+
+static jsprof_node_t *jsprof_exited = NULL;
+  /* The merged trees of all threads that have exited, or NULL. */
+
+static pthread_mutex_t jsprof_lock = PTHREAD_MUTEX_INITIALIZER;
+  /* Protects {jsprof_roots} and {jsprof_exited}. */
+
+static pthread_key_t jsprof_key;
+static pthread_once_t jsprof_key_once = PTHREAD_ONCE_INIT;
+  /* A key whose value in each thread is the root of its tree, so
+    that {jsprof_thread_exit} is called when the thread exits. */
+
+/* INTERNAL PROTOTYPES */
+
+jsprof_node_t *jsprof_node_new(char *name, int32_t ix, bool_t counter, jsprof_node_t *parent);
+  /* Allocates a new node with zero accumulators, and appends it
+    to the children of {parent} (if not NULL), so that siblings are
+    kept in order of creation. */
+
+jsprof_node_t *jsprof_get_child(jsprof_node_t *p, char *name, int32_t ix, bool_t counter);
+  /* Returns the child of {p} with the given {name}, {ix} and {counter},
+    creating it if it does not exist yet. */
+
+jsprof_node_t *jsprof_get_cur(void);
+  /* Returns the current stage of this thread, creating the thread's
+    root if needed. */
+
+void jsprof_make_key(void);
+  /* Creates {jsprof_key}. */
+
+void jsprof_thread_exit(void *r);
+  /* Unlinks the root {r} of an exiting thread from {jsprof_roots},
+    merges its tree into {jsprof_exited}, and frees it. */
+
+void jsprof_merge(jsprof_node_t *dst, jsprof_node_t *src);
+  /* Adds the accumulators of all descendants of {src} to the
+    corresponding descendants of {dst}, creating them as needed. */
+
+void jsprof_print(FILE *wr, jsprof_node_t *p, int depth);
+  /* Prints the children of {p} and their descendants, indented by
+    {depth} levels. */
+
+void jsprof_clear(jsprof_node_t *p);
+  /* Sets to zero the accumulators of {p} and all its descendants. */
+
+void jsprof_free(jsprof_node_t *p);
+  /* Frees {p} and all its descendants. */
+
+/* IMPLEMENTATIONS */
+
+void jsprof_enter(char *name, int32_t ix)
+  {
+    jsprof_node_t *p = jsprof_get_child(jsprof_get_cur(), name, ix, FALSE);
+    p->t_start = real_time_usec();
+    jsprof_cur = p;
+  }
+
+void jsprof_leave(char *name)
+  {
+    double t_stop = real_time_usec();
+    jsprof_node_t *p = jsprof_cur;
+    demand((p != NULL) && (p->parent != NULL), "no open stage");
+    demand(strcmp(p->name, name) == 0, "mismatched {jsprof_leave}");
+    p->ncalls++;
+    p->real_usec += t_stop - p->t_start;
+    jsprof_cur = p->parent;
+  }
+
+void jsprof_count(char *name, int64_t n)
+  {
+    jsprof_node_t *p = jsprof_get_child(jsprof_get_cur(), name, -1, TRUE);
+    p->count += n;
+  }
+
+void jsprof_dump(FILE *wr)
+  {
+    jsprof_node_t *M = jsprof_node_new("", -1, FALSE, NULL);
+    pthread_mutex_lock(&jsprof_lock);
+    jsprof_node_t *r;
+    for (r = jsprof_roots; r != NULL; r = r->root_next) { jsprof_merge(M, r); }
+    if (jsprof_exited != NULL) { jsprof_merge(M, jsprof_exited); }
+    pthread_mutex_unlock(&jsprof_lock);
+    fprintf(wr, "%-48s %10s %12s %7s\n", "stage", "calls", "real_ms", "%parent");
+    jsprof_print(wr, M, 0);
+    fflush(wr);
+    jsprof_free(M);
+  }
+
+void jsprof_reset(void)
+  {
+    pthread_mutex_lock(&jsprof_lock);
+    jsprof_node_t *r;
+    for (r = jsprof_roots; r != NULL; r = r->root_next) { jsprof_clear(r); }
+    if (jsprof_exited != NULL) { jsprof_clear(jsprof_exited); }
+    pthread_mutex_unlock(&jsprof_lock);
+  }
+
+void jsprof_worker_begin(void)
+  {
+    demand(jsprof_cur == NULL, "thread already has a profile tree");
+    jsprof_worker = TRUE;
+  }
+
+void *jsprof_worker_end(void)
+  {
+    demand(jsprof_worker, "not a worker thread");
+    jsprof_node_t *r = jsprof_cur;
+    demand((r == NULL) || (r->parent == NULL), "worker has open stages");
+    jsprof_cur = NULL;
+    jsprof_worker = FALSE;
+    return (void *)r;
+  }
+
+void jsprof_worker_join(void *tree)
+  {
+    jsprof_node_t *r = (jsprof_node_t *)tree;
+    if (r == NULL) { return; }
+    if (r->child != NULL) { jsprof_merge(jsprof_get_cur(), r); }
+    jsprof_free(r);
+  }
+
+jsprof_node_t *jsprof_node_new(char *name, int32_t ix, bool_t counter, jsprof_node_t *parent)
+  {
+    jsprof_node_t *p = notnull(malloc(sizeof(jsprof_node_t)), "no mem");
+    p->name = name;
+    p->ix = ix;
+    p->counter = counter;
+    p->ncalls = 0;
+    p->real_usec = 0;
+    p->count = 0;
+    p->t_start = 0;
+    p->parent = parent;
+    p->child = NULL;
+    p->next = NULL;
+    p->root_next = NULL;
+    if (parent != NULL) 
+      { jsprof_node_t **pp = &(parent->child);
+        while ((*pp) != NULL) { pp = &((*pp)->next); }
+        (*pp) = p;
+      }
+    return p;
+  }
+
+jsprof_node_t *jsprof_get_child(jsprof_node_t *p, char *name, int32_t ix, bool_t counter)
+  {
+    jsprof_node_t *q;
+    for (q = p->child; q != NULL; q = q->next)
+      { if 
+          ( (q->ix == ix) && (q->counter == counter) && 
+            ((q->name == name) || (strcmp(q->name, name) == 0))
+          )
+          { return q; }
+      }
+    return jsprof_node_new(name, ix, counter, p);
+  }
+
+jsprof_node_t *jsprof_get_cur(void)
+  {
+    if (jsprof_cur == NULL)
+      { jsprof_node_t *r = jsprof_node_new("", -1, FALSE, NULL);
+        if (! jsprof_worker)
+          { /* Make the tree visible to {jsprof_dump}, until the thread exits: */
+            pthread_once(&jsprof_key_once, &jsprof_make_key);
+            pthread_mutex_lock(&jsprof_lock);
+            r->root_next = jsprof_roots;
+            jsprof_roots = r;
+            pthread_mutex_unlock(&jsprof_lock);
+            pthread_setspecific(jsprof_key, r);
+          }
+        jsprof_cur = r;
+      }
+    return jsprof_cur;
+  }
+
+void jsprof_make_key(void)
+  {
+    int res = pthread_key_create(&jsprof_key, &jsprof_thread_exit);
+    demand(res == 0, "pthread_key_create failed");
+  }
+
+void jsprof_thread_exit(void *r)
+  {
+    jsprof_node_t *rr = (jsprof_node_t *)r;
+    pthread_mutex_lock(&jsprof_lock);
+    jsprof_node_t **pp = &jsprof_roots;
+    while ((*pp) != rr) { assert((*pp) != NULL); pp = &((*pp)->root_next); }
+    (*pp) = rr->root_next;
+    if (jsprof_exited == NULL) { jsprof_exited = jsprof_node_new("", -1, FALSE, NULL); }
+    jsprof_merge(jsprof_exited, rr);
+    pthread_mutex_unlock(&jsprof_lock);
+    jsprof_free(rr);
+    jsprof_cur = NULL;
+  }
+
+void jsprof_merge(jsprof_node_t *dst, jsprof_node_t *src)
+  {
+    jsprof_node_t *s;
+    for (s = src->child; s != NULL; s = s->next)
+      { jsprof_node_t *d = jsprof_get_child(dst, s->name, s->ix, s->counter);
+        d->ncalls += s->ncalls;
+        d->real_usec += s->real_usec;
+        d->count += s->count;
+        jsprof_merge(d, s);
+      }
+  }
+
+void jsprof_print(FILE *wr, jsprof_node_t *p, int depth)
+  {
+    jsprof_node_t *q;
+    for (q = p->child; q != NULL; q = q->next)
+      { char lab[48];
+        if (q->ix >= 0)
+          { snprintf(lab, sizeof(lab), "%*s%s[%d]", 2*depth, "", q->name, q->ix); }
+        else
+          { snprintf(lab, sizeof(lab), "%*s%s", 2*depth, "", q->name); }
+        if (q->counter)
+          { fprintf(wr, ("%-48s %10" int64_d_fmt " (count)\n"), lab, q->count); }
+        else 
+          { fprintf(wr, ("%-48s %10" int64_d_fmt " %12.3f"), lab, q->ncalls, q->real_usec/1000.0);
+            if ((p->parent != NULL) && (p->real_usec > 0))
+              { fprintf(wr, " %6.1f%%", 100.0*q->real_usec/p->real_usec); }
+            fprintf(wr, "\n");
+            jsprof_print(wr, q, depth + 1);
+          }
+      }
+  }
+
+void jsprof_clear(jsprof_node_t *p)
+  {
+    p->ncalls = 0;
+    p->real_usec = 0;
+    p->count = 0;
+    jsprof_node_t *q;
+    for (q = p->child; q != NULL; q = q->next) { jsprof_clear(q); }
+  }
+
+void jsprof_free(jsprof_node_t *p)
+  {
+    jsprof_node_t *q = p->child;
+    while (q != NULL) 
+      { jsprof_node_t *r = q->next;
+        jsprof_free(q);
+        q = r;
+      }
+    free(p);
+  }
@@ -0,0 +1,105 @@
+/* Hierarchical timers and counters for profiling library procedures. */
+/* Last edited on 2026-10-19 12:45:08 by stolfi */
+
+#ifndef jsprof_H
+#define jsprof_H
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+
+/* 
+  These tools accumulate the real time spent in named /stages/ of a
+  computation, and named event counts, organized as a tree.  
+  
+  Calling {jsprof_enter(name,ix)} opens a stage that is a child of the
+  stage currently open in the same thread (or of the thread's root,
+  if none); {jsprof_leave(name)} closes it, and adds the elapsed real
+  time (from {real_time_usec}) to its tree node.  All calls with the
+  same {name} and {ix} under the same parent stage accumulate into
+  the same node.  Thus a recursive procedure that opens a stage on
+  entry produces one tree level per recursion level, while a loop
+  over scales or iterations can use {ix} to keep them apart.
+  
+  Each thread has its own tree, so that the accumulators need no
+  locking.  {jsprof_dump} merges the trees of all threads.  When a
+  thread exits, its tree is merged into a common tree of exited
+  threads, and freed.
+  
+  The extra threads created by {jsthread_run_ranges} use
+  {jsprof_worker_begin}, {jsprof_worker_end}, and {jsprof_worker_join},
+  so that the stages they open are merged, when they finish, under the
+  stage that was current in the calling thread.  Thus the tree has the
+  same shape whatever the number of threads; but the times of stages
+  that ran in parallel are added over all threads, and may exceed the
+  time of the parent stage.
+  
+  Library procedures should use the macros {jsprof_ENTER},
+  {jsprof_ENTER_IX}, {jsprof_LEAVE}, and {jsprof_COUNT}, rather than
+  the procedures.  If the library is compiled with {jsprof_ENABLED}
+  defined as 0 (e.g. with "-Djsprof_ENABLED=0"), these macros expand
+  to nothing and have no cost.  Otherwise the cost is two clock reads
+  and a short list search per stage, so the stages should not be too
+  fine-grained (e.g. per level or per iteration, not per pixel). */
+
+#ifndef jsprof_ENABLED
+#define jsprof_ENABLED 1
+#endif
+
+#if (jsprof_ENABLED)
+#define jsprof_ENTER(name) jsprof_enter((name), -1)
+#define jsprof_ENTER_IX(name,ix) jsprof_enter((name), (ix))
+#define jsprof_LEAVE(name) jsprof_leave((name))
+#define jsprof_COUNT(name,n) jsprof_count((name), (n))
+#else
+#define jsprof_ENTER(name) do { } while (0)
+#define jsprof_ENTER_IX(name,ix) do { } while (0)
+#define jsprof_LEAVE(name) do { } while (0)
+#define jsprof_COUNT(name,n) do { } while (0)
+#endif
+
+void jsprof_enter(char *name, int32_t ix);
+  /* Opens the stage with name {name} and index {ix} (which may be {-1}
+    meaning `no index'), as a child of the current stage of this
+    thread.  The string {name} is not copied, so it should be a
+    literal or otherwise permanent. */
+
+void jsprof_leave(char *name);
+  /* Closes the current stage of this thread, and adds to it the
+    real time elapsed since the matching {jsprof_enter}.  Fails if
+    the name of the current stage is not {name}. */
+
+void jsprof_count(char *name, int64_t n);
+  /* Adds {n} to the counter {name}, which is a child node
+    of the current stage of this thread. */
+
+void jsprof_dump(FILE *wr);
+  /* Writes to {wr} the merged tree of all threads, one node per line,
+    indented by depth.  For each stage, prints the number of calls,
+    the total real time in milliseconds, and the percentage of the
+    parent's time.  For each counter, prints its total.
+    
+    Should be called only when no other thread is inside an
+    instrumented procedure.  Stages that are still open do not
+    include the time since they were entered. */
+
+void jsprof_worker_begin(void);
+  /* Declares that the current thread is about to do work on behalf of
+    another thread.  Until the next {jsprof_worker_end}, the stages and
+    counters of this thread will go into a new private tree. */
+
+void *jsprof_worker_end(void);
+  /* Returns the private tree that was built by the current thread since
+    the last {jsprof_worker_begin}, or NULL if there is none, as an opaque
+    pointer.  The current thread must not have any open stage. */
+
+void jsprof_worker_join(void *tree);
+  /* Merges the tree {tree} returned by {jsprof_worker_end} under the
+    current stage of the calling thread, and frees it.  Does nothing
+    if {tree} is NULL. */
+
+void jsprof_reset(void);
+  /* Sets to zero all call counts, times, and counters of all threads. 
+    Same restrictions as {jsprof_dump}. */
+
+#endif
@@ -1,5 +1,5 @@
 /* See jsrandom.h */
-/* Last edited on 2020-12-06 18:28:43 by jstolfi */
+/* Last edited on 2026-10-19 12:41:45 by jstolfi */
 
 #define _GNU_SOURCE
 #include <stdio.h>
@@ -8,12 +8,46 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <assert.h>
 
+#include <bool.h>
 #include <affirm.h>
 
 #include <jsrandom.h>
 
+/* GENERATOR SELECTION */
+
+#define jsrandom_THREAD_STATE_SIZE 128
+  /* Size in bytes of the state of a thread-private generator. */
+
+static __thread bool_t jsrandom_thread_active = FALSE;
+static __thread struct random_data jsrandom_thread_data;
+static __thread char jsrandom_thread_state[jsrandom_THREAD_STATE_SIZE];
+  /* The private generator of the current thread, if {jsrandom_thread_active}. */
+
+long int jsrandom_next(void);
+  /* Returns the next value of the private generator of the current thread, 
+    if it has one, or of {random} otherwise. */
+
+long int jsrandom_next(void)
+  { if (! jsrandom_thread_active) { return random(); }
+    int32_t r;
+    int res = random_r(&jsrandom_thread_data, &r);
+    assert(res == 0);
+    return (long int)r;
+  }
+
+void jsrandom_thread_seed(uint32_t seed)
+  { memset(&jsrandom_thread_data, 0, sizeof(struct random_data));
+    int res = initstate_r(seed, jsrandom_thread_state, jsrandom_THREAD_STATE_SIZE, &jsrandom_thread_data);
+    demand(res == 0, "{initstate_r} failed");
+    jsrandom_thread_active = TRUE;
+  }
+
+void jsrandom_thread_release(void)
+  { jsrandom_thread_active = FALSE; }
+
 /* SIMPLE INTEGER RANDOM FUNCTIONS */
 
 #define MASK_22 ((1 << 22)-1)
@@ -31,8 +65,8 @@
 uint32_t uint32_random(void)
   { affirm(U32RMAX >= MASK_22, "range of {random} is insufficient");
     affirm(((U32RMAX + 1) & U32RMAX) == 0, "range of {random} is not power of 2");
-    uint32_t a = (random() & MASK_12);
-    uint32_t b = (random() & MASK_22);
+    uint32_t a = (jsrandom_next() & MASK_12);
+    uint32_t b = (jsrandom_next() & MASK_22);
     return (a << 22) | b; 
   }
 
@@ -44,9 +78,9 @@ int32_t int32_random(void)
 uint64_t uint64_random(void)
   { affirm(U32RMAX >= MASK_22, "range of {random} is insufficient");
     affirm(((U32RMAX + 1) & U32RMAX) == 0, "range of {random} is not power of 2");
-    uint64_t a = (random() & MASK_20);
-    uint64_t b = (random() & MASK_22);
-    uint64_t c = (random() & MASK_22);
+    uint64_t a = (jsrandom_next() & MASK_20);
+    uint64_t b = (jsrandom_next() & MASK_22);
+    uint64_t c = (jsrandom_next() & MASK_22);
     return (a << 44) | (b << 22) | c; 
   }
 
@@ -61,7 +95,7 @@ uint32_t uint32_mrandom(uint32_t max)
   {
     /* Some simple cases: */
     if (max == 0) { return 0; }
-    if (max == (uint32_t)RAND_MAX) { return (uint32_t)random(); }
+    if (max == (uint32_t)RAND_MAX) { return (uint32_t)jsrandom_next(); }
     /* If {max} is {2^k-1}, just take the lower bits: */
     if ((max & (max+1)) == 0) { return (uint32_random() & max); }
     
@@ -86,7 +120,7 @@ uint64_t uint64_mrandom(uint64_t max)
   {
     /* Some simple cases: */
     if (max == 0) { return 0; }
-    if (max == (uint64_t)RAND_MAX) { return (uint64_t)random(); }
+    if (max == (uint64_t)RAND_MAX) { return (uint64_t)jsrandom_next(); }
     if (max == (uint64_t)UINT32_MAX) { return (uint64_t)uint32_random(); }
     if (max == UINT64_MAX) { return uint64_random(); }
     /* If {max} is small enough, use the 32-bit version: */
@@ -171,16 +205,16 @@ int64_t int64_abrandom(int64_t a, int64_t b)
   
 float frandom(void)
   {
-    double rnd = (double)(random() & 8388607);
+    double rnd = (double)(jsrandom_next() & 8388607);
     return (float)(rnd/8388608.0);
   }
 
 double drandom(void)
   {
     double d = 0.0;
-    double rnd1 = (double)(random() & 536870911);
+    double rnd1 = (double)(jsrandom_next() & 536870911);
     d = (d + rnd1)/536870912.0;
-    double rnd2 = (double)(random() & 8388607);
+    double rnd2 = (double)(jsrandom_next() & 8388607);
     d = (d + rnd2)/8388608.0;
     return (d);
   }
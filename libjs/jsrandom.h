@@ -2,7 +2,7 @@
 #define jsrandom_H
 
 /* Alternative random generator functions */
-/* Last edited on 2021-06-25 19:03:13 by jstolfi */
+/* Last edited on 2026-10-19 12:41:45 by jstolfi */
 
 #define _GNU_SOURCE
 #include <stdint.h>
@@ -14,8 +14,22 @@
   is hoped to be at least {2^22-1}. To get a repeatable or truly random
   sequence of values, call {srandom} from that library with a suitable
   {unsigned int} seed value.
+  
+  Alternatively, a thread may use a private generator, as described below.
 */
 
+void jsrandom_thread_seed(uint32_t seed);
+  /* From now on, the procedures of this interface, when called by the
+    current thread, will draw their values from a generator private to
+    that thread, initialized with the given {seed}, instead of {random}.
+    Calling this procedure again restarts that generator with the new 
+    {seed}.  This lets parallel tasks get repeatable random sequences
+    that do not depend on how they are scheduled. */
+
+void jsrandom_thread_release(void);
+  /* Makes the procedures of this interface, when called by the current
+    thread, go back to using {random}. */
+
 int32_t int32_random(void);
 int64_t int64_random(void);
   /* Returns a random 32-bit or 64-bit signed integer (all bits random). 
@@ -0,0 +1,122 @@
+/* See jsthread.h */
+/* Last edited on 2026-10-19 12:45:08 by jstolfi */
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsprof.h>
+#include <jsthread.h>
+
+typedef struct jsthread_job_t
+  { int32_t n;                    /* Number of items. */
+    int32_t chunk;                /* Number of items per range. */
+    int32_t next;                 /* First item not yet handed out. */
+    pthread_mutex_t lock;         /* Protects {next}. */
+    jsthread_range_proc_t *proc;  /* Client procedure. */
+    void *arg;                    /* Client argument. */
+  } jsthread_job_t;
+  /* The shared state of a {jsthread_run_ranges} call. */
+
+typedef struct jsthread_worker_t
+  { jsthread_job_t *job;  /* The shared job. */
+    int32_t ith;          /* Index of this thread. */
+    void *prof;           /* Profile tree built by this thread (see {jsprof_worker_end}). */
+  } jsthread_worker_t;
+  /* Argument of a worker thread. */
+
+void *jsthread_worker_main(void *wp);
+  /* Main procedure of each worker thread: grabs ranges from the
+    job {((jsthread_worker_t *)wp)->job} until there are none left. */
+
+int32_t jsthread_num_cpus(void)
+  { long np = sysconf(_SC_NPROCESSORS_ONLN);
+    if (np < 1) { np = 1; }
+    if (np > 1024) { np = 1024; }
+    return (int32_t)np;
+  }
+
+int32_t jsthread_choose_count(int32_t nth, int32_t n)
+  { demand(nth >= 0, "invalid thread count");
+    if (nth == 0) { nth = jsthread_num_cpus(); }
+    if (nth > n) { nth = n; }
+    if (nth < 1) { nth = 1; }
+    return nth;
+  }
+
+void jsthread_run_ranges
+  ( int32_t n,
+    int32_t chunk,
+    int32_t nth,
+    jsthread_range_proc_t *proc,
+    void *arg
+  )
+  { demand(n >= 0, "invalid item count");
+    demand(chunk >= 0, "invalid chunk size");
+    if (n == 0) { return; }
+    nth = jsthread_choose_count(nth, n);
+    if (chunk == 0) { chunk = (n + nth - 1)/nth; }
+
+    if (nth == 1)
+      { /* Do it all in the calling thread: */
+        int32_t ini = 0;
+        while (ini < n)
+          { int32_t fin = (n - ini <= chunk ? n - 1 : ini + chunk - 1);
+            proc(arg, 0, ini, fin);
+            ini = fin + 1;
+          }
+        return;
+      }
+
+    jsthread_job_t job;
+    job.n = n;
+    job.chunk = chunk;
+    job.next = 0;
+    job.proc = proc;
+    job.arg = arg;
+    pthread_mutex_init(&(job.lock), NULL);
+
+    jsthread_worker_t *wk = notnull(malloc(nth*sizeof(jsthread_worker_t)), "no mem");
+    pthread_t *tid = notnull(malloc(nth*sizeof(pthread_t)), "no mem");
+    int32_t ith;
+    for (ith = 0; ith < nth; ith++)
+      { wk[ith].job = &job;
+        wk[ith].ith = ith;
+        wk[ith].prof = NULL;
+      }
+    for (ith = 1; ith < nth; ith++)
+      { int res = pthread_create(&(tid[ith]), NULL, &jsthread_worker_main, &(wk[ith]));
+        demand(res == 0, "pthread_create failed");
+      }
+    (void)jsthread_worker_main(&(wk[0]));
+    for (ith = 1; ith < nth; ith++)
+      { int res = pthread_join(tid[ith], NULL);
+        demand(res == 0, "pthread_join failed");
+        jsprof_worker_join(wk[ith].prof);
+      }
+    pthread_mutex_destroy(&(job.lock));
+    free(tid);
+    free(wk);
+  }
+
+void *jsthread_worker_main(void *wp)
+  { jsthread_worker_t *wk = (jsthread_worker_t *)wp;
+    jsthread_job_t *job = wk->job;
+    if (wk->ith > 0) { jsprof_worker_begin(); }
+    while (TRUE)
+      { /* Grab the next range: */
+        pthread_mutex_lock(&(job->lock));
+        int32_t ini = job->next;
+        int32_t fin = (job->n - ini <= job->chunk ? job->n - 1 : ini + job->chunk - 1);
+        job->next = fin + 1;
+        pthread_mutex_unlock(&(job->lock));
+        if (ini >= job->n) { break; }
+        job->proc(job->arg, wk->ith, ini, fin);
+      }
+    if (wk->ith > 0) { wk->prof = jsprof_worker_end(); }
+    return NULL;
+  }
@@ -0,0 +1,53 @@
+/* Simple parallel loops over index ranges, with POSIX threads. */
+/* Last edited on 2026-10-19 12:45:08 by jstolfi */
+
+#ifndef jsthread_H
+#define jsthread_H
+
+#define _GNU_SOURCE
+#include <stdint.h>
+
+typedef void jsthread_range_proc_t(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Type of a client procedure that performs some task for all items
+    with indices {ini..fin}, on behalf of thread number {ith}.
+
+    The procedure may be called concurrently by different threads, on
+    disjoint index ranges. Therefore it must not modify any data
+    shared with other calls, except through its own synchronization.
+    The thread index {ith} may be used to select per-thread scratch
+    areas. */
+
+int32_t jsthread_num_cpus(void);
+  /* Returns the number of processors that are currently available to the
+    process (at least 1). */
+
+int32_t jsthread_choose_count(int32_t nth, int32_t n);
+  /* Returns the number of threads that should be used to process
+    {n} items when the client requests {nth} threads.  If {nth} is zero,
+    uses {jsthread_num_cpus()} instead.  The result is never greater
+    than {n} and never less than 1. */
+
+void jsthread_run_ranges
+  ( int32_t n,
+    int32_t chunk,
+    int32_t nth,
+    jsthread_range_proc_t *proc,
+    void *arg
+  );
+  /* Calls {proc(arg,ith,ini,fin)} for consecutive index ranges
+    {ini..fin} that cover {0..n-1} exactly once.
+
+    The number of threads to use is {jsthread_choose_count(nth,n)}.
+    Each thread repeatedly grabs the next range of {chunk} consecutive
+    indices (the last range may be shorter) until all {n} indices have
+    been handed out. If {chunk} is zero, the items are split into at
+    most one range per thread, as equal in size as possible.
+
+    If the chosen thread count is 1, all calls are made by the calling
+    thread, with {ith = 0}, and no threads are created. Otherwise the
+    procedure creates {nth - 1} extra threads, does its share of the work
+    as thread {ith=0}, and returns only after all threads have finished.
+    Any {jsprof} stages opened by the extra threads are merged under
+    the current stage of the calling thread (see {jsprof_worker_begin}). */
+
+#endif
@@ -0,0 +1,219 @@
+#define PROG_NAME "bench_kernels"
+#define PROG_DESC "measures the throughput of some {libjs} kernels"
+#define PROG_VERS "1.0"
+
+/* Last edited on 2026-10-19 12:56:32 by stolfi */
+/* Created on 2026-10-19 by J. Stolfi, UNICAMP */
+
+#define PROG_COPYRIGHT \
+  "Copyright  2026  by the State University of Campinas (UNICAMP)"
+
+#define PROG_HELP \
+  "  " PROG_NAME " [ {BASEFILE} ] > {OUTFILE}"
+
+#define PROG_INFO \
+  "  Runs benchmarks of the hash table {bvtable.h}, the priority queue" \
+  " {pqueue.h}, the optimum-path forest {opf.h}, and the matrix" \
+  " product of {rmxn.h} for several problem sizes, and writes the results" \
+  " to {stdout} in the format of {tfn_bench_write}.  If {BASEFILE} is" \
+  " given, also compares the results with those in that file" \
+  " and writes the comparison to {stderr}.  Returns status 1" \
+  " if any benchmark got slower than the baseline."
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsfile.h>
+#include <jsmath.h>
+#include <jsrandom.h>
+#include <bvhash.h>
+#include <bvtable.h>
+#include <pqueue.h>
+#include <opf.h>
+#include <rmxn.h>
+#include <timefunc.h>
+
+#define MIN_USEC (200000.0)
+  /* Min total real time of each benchmark. */
+
+#define TOL (0.10)
+  /* Relative tolerance for regressions. */
+
+int main (int argc, char **argv);
+
+typedef struct bk_data_t
+  { uint32_t n;       /* Number of items. */
+    uint64_t *key;    /* The items, {key[0..n-1]}. */
+    double *val;      /* Item values for the priority queue. */
+    double *A, *B;    /* Operand matrices for {rmxn_mul}, {n} by {n}. */
+    double *M;        /* Result matrix for {rmxn_mul}, {n} by {n}. */
+  } bk_data_t;
+  /* Data for the benchmarks. */
+
+void bk_bvtable_proc(void *arg);
+  /* Adds all items of the {bk_data_t} {*arg} to a new {bvtable_t},
+    then looks them up again. */
+
+void bk_pqueue_proc(void *arg);
+  /* Inserts items {0..n-1} of the {bk_data_t} {*arg} into a new
+    {pqueue_t}, with values {val[0..n-1]}, then removes them in order. */
+
+void bk_opf_proc(void *arg);
+  /* Builds the optimum-path forest of the complete graph on the {n}
+    points {bk_pt[0..n-1]}, with Euclidean arc costs and max path costs.
+    Every tenth point is a root candidate. */
+
+void bk_rmxn_mul_proc(void *arg);
+  /* Computes the product {M = A*B} of the matrices in the {bk_data_t} {*arg}. */
+
+double bk_arc_cost(int u, int v);
+double bk_path_cost(double Ca, double Cp);
+  /* Arc and path cost functions for {opf_build_complete}. */
+
+double *bk_pt = NULL;
+  /* Coordinates of the graph vertices for {bk_opf_proc}; vertex {u}
+    is {(bk_pt[2*u],bk_pt[2*u+1])}. */
+
+uint64_t bk_hash(void *p, size_t sz);
+int bk_cmp(void *x, void *y, size_t sz);
+  /* Hash and comparison procedures for {bvtable_t}. */
+
+int main (int argc, char **argv)
+  {
+    demand(argc <= 2, "usage: " PROG_HELP);
+    
+    int32_t nsz = 3;
+    uint32_t size[3] = { 10000, 100000, 1000000 };
+    uint32_t nvert[3] = { 250, 500, 1000 };  /* Vertex counts for {opf_build_complete}. */
+    uint32_t msize[3] = { 64, 128, 256 };    /* Matrix sizes for {rmxn_mul}. */
+    int32_t nb = 0;
+    tfn_bench_t B[4*nsz];
+    
+    int32_t isz;
+    for (isz = 0; isz < nsz; isz++)
+      { uint32_t n = size[isz];
+        bk_data_t D;
+        D.n = n;
+        D.key = notnull(malloc(n*sizeof(uint64_t)), "no mem");
+        D.val = notnull(malloc(n*sizeof(double)), "no mem");
+        srandom(4615 + n);
+        uint32_t i;
+        for (i = 0; i < n; i++) { D.key[i] = uint64_random(); D.val[i] = drandom(); }
+        
+        B[nb] = tfn_bench_run("bvtable_add_get", n, 0, "items", 2.0*n, &bk_bvtable_proc, &D, MIN_USEC);
+        tfn_bench_write(stdout, &(B[nb])); nb++;
+        B[nb] = tfn_bench_run("pqueue_insert_delete", n, 0, "items", 2.0*n, &bk_pqueue_proc, &D, MIN_USEC);
+        tfn_bench_write(stdout, &(B[nb])); nb++;
+        
+        free(D.key); free(D.val);
+      }
+      
+    for (isz = 0; isz < nsz; isz++)
+      { uint32_t n = nvert[isz];
+        bk_pt = notnull(malloc(2*n*sizeof(double)), "no mem");
+        srandom(4615 + n);
+        uint32_t i;
+        for (i = 0; i < 2*n; i++) { bk_pt[i] = drandom(); }
+        bk_data_t D;
+        D.n = n;
+        B[nb] = tfn_bench_run("opf_build_complete", n, 0, "arcs", (double)n*(double)n, &bk_opf_proc, &D, MIN_USEC);
+        tfn_bench_write(stdout, &(B[nb])); nb++;
+        free(bk_pt); bk_pt = NULL;
+      }
+      
+    for (isz = 0; isz < nsz; isz++)
+      { uint32_t n = msize[isz];
+        bk_data_t D;
+        D.n = n;
+        D.A = rmxn_alloc(n, n);
+        D.B = rmxn_alloc(n, n);
+        D.M = rmxn_alloc(n, n);
+        srandom(4615 + n);
+        uint32_t i;
+        for (i = 0; i < n*n; i++) { D.A[i] = drandom(); D.B[i] = drandom(); }
+        double nops = (double)n*(double)n*(double)n;
+        B[nb] = tfn_bench_run("rmxn_mul", n, 0, "mult-adds", nops, &bk_rmxn_mul_proc, &D, MIN_USEC);
+        tfn_bench_write(stdout, &(B[nb])); nb++;
+        free(D.A); free(D.B); free(D.M);
+      }
+      
+    int32_t nslow = 0;
+    if (argc == 2)
+      { FILE *rd = open_read(argv[1], TRUE);
+        int32_t nr;
+        tfn_bench_t *R;
+        tfn_bench_read(rd, &nr, &R);
+        fclose(rd);
+        nslow = tfn_bench_compare(stderr, nb, B, nr, R, TOL);
+      }
+    return (nslow > 0 ? 1 : 0);
+  }
+
+void bk_bvtable_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    bvtable_t *tb = bvtable_new(sizeof(uint64_t), D->n);
+    uint32_t i;
+    for (i = 0; i < D->n; i++) { (void)bvtable_add(tb, &(D->key[i]), &bk_hash, &bk_cmp); }
+    for (i = 0; i < D->n; i++) 
+      { uint32_t ie = bvtable_get_index(tb, &(D->key[i]), &bk_hash, &bk_cmp);
+        assert(ie != UINT32_MAX);
+      }
+    uint32_t ne;
+    void *pe;
+    bvtable_close(tb, &ne, &pe);
+    free(pe);
+  }
+
+void bk_pqueue_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    pqueue_t *Q = pqueue_new();
+    pqueue_realloc(Q, D->n, D->n);
+    uint32_t i;
+    for (i = 0; i < D->n; i++) { pqueue_insert(Q, i, D->val[i]); }
+    for (i = 0; i < D->n; i++) { pqueue_delete(Q, pqueue_head(Q)); }
+    pqueue_free(Q);
+  }
+
+void bk_opf_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    int n = (int)D->n;
+    double *C = notnull(malloc(n*sizeof(double)), "no mem");
+    int *P = notnull(malloc(n*sizeof(int)), "no mem");
+    int *R = notnull(malloc(n*sizeof(int)), "no mem");
+    int u;
+    for (u = 0; u < n; u++) { C[u] = ((u % 10) == 0 ? 0.5*bk_pt[2*u] : +INF); }
+    opf_build_complete(n, C, &bk_arc_cost, &bk_path_cost, P, R, FALSE);
+    free(C); free(P); free(R);
+  }
+
+void bk_rmxn_mul_proc(void *arg)
+  {
+    bk_data_t *D = (bk_data_t *)arg;
+    int32_t n = (int32_t)D->n;
+    rmxn_mul(n, n, n, D->A, D->B, D->M);
+  }
+
+double bk_arc_cost(int u, int v)
+  { double dx = bk_pt[2*u] - bk_pt[2*v];
+    double dy = bk_pt[2*u+1] - bk_pt[2*v+1];
+    return hypot(dx, dy);
+  }
+
+double bk_path_cost(double Ca, double Cp)
+  { return fmax(Ca, Cp); }
+
+uint64_t bk_hash(void *p, size_t sz)
+  { return bvhash_bytes(p, sz); }
+
+int bk_cmp(void *x, void *y, size_t sz)
+  { uint64_t a = *((uint64_t *)x), b = *((uint64_t *)y);
+    return (a < b ? -1 : (a > b ? +1 : 0));
+  }
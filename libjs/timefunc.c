@@ -1,9 +1,15 @@
 /* See timefunc.h */
-/* Last edited on 2011-12-21 20:45:29 by stolfi */
+/* Last edited on 2026-10-19 12:08:16 by stolfi */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <assert.h>
 
+#include <affirm.h>
+#include <bool.h>
+#include <fget.h>
 #include <jstime.h>
 #include <jswsize.h>
 #include <timefunc.h>
@@ -36,4 +42,121 @@ void time_func(char *title, tfn_func_t ex_func, tfn_func_t ex_null, int64_t effo
     double avg_time = (stop-start-tare)/((double)ntimes_func);
     fprintf(stderr, "  average ns/call =  %7.1f\n", 1000*avg_time);
   }
- 
+
+tfn_bench_t tfn_bench_run
+  ( char *name,
+    int64_t size,
+    int32_t nth,
+    char *unit,
+    double units,
+    tfn_bench_proc_t *proc,
+    void *arg,
+    double min_usec
+  )
+  { 
+    /* Warm-up run: */
+    proc(arg);
+    
+    /* Timed runs: */
+    int64_t nrep = 0;
+    double real_min = +INFINITY;
+    double real_tot = 0;
+    double user_tot = 0;
+    while ((nrep < 3) || (real_tot < min_usec))
+      { double real_start = real_time_usec();
+        double user_start = user_cpu_time_usec();
+        proc(arg);
+        double user_stop = user_cpu_time_usec();
+        double real_stop = real_time_usec();
+        double real = real_stop - real_start;
+        if (real < real_min) { real_min = real; }
+        real_tot += real;
+        user_tot += user_stop - user_start;
+        nrep++;
+      }
+    
+    /* Avoid division by zero when the clock is too coarse: */
+    if (real_min <= 0) { real_min = real_tot/((double)nrep); }
+    if (real_min <= 0) { real_min = 1.0e-3; }
+    
+    tfn_bench_t B;
+    B.name = name;
+    B.size = size;
+    B.nth = nth;
+    B.unit = unit;
+    B.units = units;
+    B.nrep = nrep;
+    B.real_usec = real_min;
+    B.user_usec = user_tot/((double)nrep);
+    B.rate = units/real_min*1.0e6;
+    return B;
+  }
+
+void tfn_bench_write(FILE *wr, tfn_bench_t *B)
+  {
+    fprintf(wr, ("%s %" int64_d_fmt " %d %s"), B->name, B->size, B->nth, B->unit);
+    fprintf(wr, (" %.6e %.3f %.3f %" int64_d_fmt "\n"), B->rate, B->real_usec, B->user_usec, B->nrep);
+    fflush(wr);
+  }
+
+void tfn_bench_read(FILE *rd, int32_t *nP, tfn_bench_t **BP)
+  {
+    int32_t nmax = 16;
+    tfn_bench_t *B = notnull(malloc(nmax*sizeof(tfn_bench_t)), "no mem");
+    int32_t n = 0;
+    while (TRUE)
+      { fget_skip_formatting_chars(rd);
+        int c = fgetc(rd);
+        if (c == EOF) { break; }
+        if (c == '#') { fget_skip_to_eol(rd); continue; }
+        ungetc(c, rd);
+        if (n >= nmax)
+          { nmax = 2*nmax;
+            B = notnull(realloc(B, nmax*sizeof(tfn_bench_t)), "no mem");
+          }
+        tfn_bench_t *Bi = &(B[n]);
+        Bi->name = fget_string(rd);
+        Bi->size = fget_int64(rd);
+        Bi->nth = fget_int32(rd);
+        Bi->unit = fget_string(rd);
+        Bi->rate = fget_double(rd);
+        Bi->real_usec = fget_double(rd);
+        Bi->user_usec = fget_double(rd);
+        Bi->nrep = fget_int64(rd);
+        Bi->units = Bi->rate*Bi->real_usec/1.0e6;
+        fget_eol(rd);
+        n++;
+      }
+    (*nP) = n;
+    (*BP) = B;
+  }
+
+int32_t tfn_bench_compare(FILE *wr, int32_t nb, tfn_bench_t B[], int32_t nr, tfn_bench_t R[], double tol)
+  {
+    int32_t nslow = 0;
+    int32_t i, j;
+    for (i = 0; i < nb; i++)
+      { tfn_bench_t *Bi = &(B[i]);
+        /* Look for the baseline of {Bi}: */
+        tfn_bench_t *Rj = NULL;
+        for (j = 0; (j < nr) && (Rj == NULL); j++)
+          { if 
+              ( (strcmp(R[j].name, Bi->name) == 0) && 
+                (R[j].size == Bi->size) && 
+                (R[j].nth == Bi->nth)
+              )
+              { Rj = &(R[j]); }
+          }
+        fprintf(wr, ("%s %" int64_d_fmt " %d %.6e"), Bi->name, Bi->size, Bi->nth, Bi->rate);
+        if (Rj == NULL)
+          { fprintf(wr, " %5.3f new\n", 1.0); }
+        else
+          { double ratio = Bi->rate/Rj->rate;
+            char *verdict = (ratio < 1 - tol ? "slower" : (ratio > 1 + tol ? "faster" : "same"));
+            if (ratio < 1 - tol) { nslow++; }
+            fprintf(wr, " %5.3f %s\n", ratio, verdict);
+          }
+      }
+    fflush(wr);
+    return nslow;
+  }
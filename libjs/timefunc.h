@@ -3,6 +3,7 @@
 #ifndef timefunc_H
 #define timefunc_H
 
+#include <stdio.h>
 #include <stdint.h>
 
 typedef int64_t tfn_func_t(int64_t effort);
@@ -17,5 +18,73 @@ void time_func(char *title, tfn_func_t ex_func, tfn_func_t ex_null, int64_t effo
     wastes the same loop control overhead, but without 
     actually calling {f}. */
 
+/* BENCHMARKS
+
+  The following tools measure the throughput of a computation (a
+  /kernel/) in work units per second, e.g. pixels/s or edges/s, for
+  various problem sizes and thread counts.  The results can be written
+  to a file in a simple text format, one benchmark per line, and later
+  compared against a previous run of the same benchmarks (the
+  /baseline/), to detect performance regressions. */
+
+typedef void tfn_bench_proc_t(void *arg);
+  /* A procedure that performs once the computation to be measured,
+    with the data and parameters {arg}. */
+
+typedef struct tfn_bench_t
+  { char *name;        /* Name of the kernel, without blanks. */
+    int64_t size;      /* Problem size (number of pixels, elements, etc.). */
+    int32_t nth;       /* Number of threads used, or 0 if not applicable. */
+    char *unit;        /* Name of the work unit, without blanks (e.g. "pixels", "edges", "nnz"). */
+    double units;      /* Number of work units processed in each run. */
+    int64_t nrep;      /* Number of runs that were timed. */
+    double real_usec;  /* Minimum real time of one run, in microseconds. */
+    double user_usec;  /* Mean user CPU time of one run, in microseconds. */
+    double rate;       /* Work units per second of real time, namely {units/real_usec*1.0e6}. */
+  } tfn_bench_t;
+  /* The result of a benchmark.  The triple {(name,size,nth)} identifies
+    the benchmark when comparing with a baseline. */
+
+tfn_bench_t tfn_bench_run
+  ( char *name,
+    int64_t size,
+    int32_t nth,
+    char *unit,
+    double units,
+    tfn_bench_proc_t *proc,
+    void *arg,
+    double min_usec
+  );
+  /* Calls {proc(arg)} once to warm up caches, then repeatedly, until
+    at least three runs have been made and at least {min_usec}
+    microseconds of real time have elapsed.  Returns the result of the
+    benchmark.  The real time is taken from the fastest run, since
+    slower runs are usually due to interference from other processes;
+    the user CPU time is the mean over all timed runs.
+    
+    The strings {name} and {unit} are not copied. */
+
+void tfn_bench_write(FILE *wr, tfn_bench_t *B);
+  /* Writes {B} to {wr} as a single line with the fields {name},
+    {size}, {nth}, {unit}, {rate}, {real_usec}, {user_usec}, and {nrep},
+    separated by blanks. */
+
+void tfn_bench_read(FILE *rd, int32_t *nP, tfn_bench_t **BP);
+  /* Reads from {rd} zero or more lines in the format written by
+    {tfn_bench_write}, until end-of-file. Blank lines and lines that
+    start with '#' are ignored.  Stores the number {n} of benchmarks
+    read into {*nP}, and a newly allocated array with those benchmarks
+    into {*BP}.  The field {units} is recomputed from {rate} and
+    {real_usec}.  The strings {name} and {unit} are newly allocated. */
+
+int32_t tfn_bench_compare(FILE *wr, int32_t nb, tfn_bench_t B[], int32_t nr, tfn_bench_t R[], double tol);
+  /* Compares each benchmark {B[0..nb-1]} with the baseline benchmark
+    in {R[0..nr-1]} that has the same {name}, {size}, and {nth}, if
+    any.  Writes to {wr} one line for each {B[i]}, with its {name},
+    {size}, {nth}, its {rate}, the ratio of that rate to the baseline
+    rate, and a verdict: "slower" if the ratio is less than {1-tol},
+    "faster" if it is greater than {1+tol}, "same" otherwise, or "new"
+    if there is no baseline.  Returns the number of "slower" verdicts. */
+
 #endif
 
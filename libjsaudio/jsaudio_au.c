@@ -1,5 +1,5 @@
 /* See jsaudio_au.h */
-/* Last edited on 2017-01-02 13:43:58 by jstolfi */
+/* Last edited on 2026-10-19 13:01:43 by jstolfi */
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -61,22 +61,52 @@ sound_t jsa_read_au_file(FILE *rd)
     /* Reads the file header: */
     au_file_header_t h = jsa_read_au_file_header(rd);
     
-    /* Compute number of channels {nc} and samples per channel {ns}: */
     int nc = h.channels;
-    int bps = jsa_au_file_bytes_per_sample(h.encoding);
-    int ns = h.data_size / nc / bps;
-    assert(h.data_size == ns * nc * bps); 
-    
-    /* Allocates the {sound_t} structure and fills header data: */
-    sound_t s = jsa_allocate_sound(nc, ns);
-    s.fsmp = (double)h.sample_rate;
-    s.ns = ns;
-    s.nc = nc;
-    
-    /* Reads the samples: */
-    jsa_read_au_file_samples(rd, &h, &s, 0, ns);
+    if (h.data_size != 0xffffffff)
+      { /* Compute number of samples per channel {ns}: */
+        int bps = jsa_au_file_bytes_per_sample(h.encoding);
+        int ns = h.data_size / nc / bps;
+        assert(h.data_size == ns * nc * bps); 
+
+        /* Allocates the {sound_t} structure and fills header data: */
+        sound_t s = jsa_allocate_sound(nc, ns);
+        s.fsmp = (double)h.sample_rate;
+        s.ns = ns;
+        s.nc = nc;
 
-    return s;
+        /* Reads the samples: */
+        jsa_read_au_file_samples(rd, &h, &s, 0, ns);
+        return s;
+      }
+    else
+      { /* Data size not known, read interleaved values until EOF: */
+        int nvmax = jsa_BLOCK_SIZE; /* Allocated size of {v}. */
+        int nv = 0; /* Number of values read so far. */
+        double *v = malloc(nvmax*sizeof(double));
+        assert(v != NULL);
+        while (1)
+          { if (nv + jsa_BLOCK_SIZE > nvmax)
+              { nvmax = 2*nvmax;
+                v = realloc(v, nvmax*sizeof(double));
+                assert(v != NULL);
+              }
+            int nr = jsa_read_au_file_values(rd, h.encoding, jsa_BLOCK_SIZE, &(v[nv]));
+            nv += nr;
+            if (nr < jsa_BLOCK_SIZE) { break; }
+          }
+          
+        /* Allocates the {sound_t} structure and separates the channels: */
+        int ns = nv/nc;
+        sound_t s = jsa_allocate_sound(nc, ns);
+        s.fsmp = (double)h.sample_rate;
+        s.ns = ns;
+        s.nc = nc;
+        int c, i;
+        for (c = 0; c < nc; c++)
+          { for (i = 0; i < ns; i++) { s.sv[c][i] = v[i*nc + c]; } }
+        free(v);
+        return s;
+      }
   }
      
 au_file_header_t jsa_read_au_file_header(FILE *rd)
@@ -96,8 +126,7 @@ au_file_header_t jsa_read_au_file_header(FILE *rd)
         ((h.encoding >= 23) && (h.encoding <= 27))
       ); 
     assert(h.sample_rate > 0);
-    assert(h.data_size > 0);           /* Requires explicit {data_size}. */
-    assert(h.data_size != 0xffffffff); /* Requires explicit {data_size}. */
+    assert(h.data_size > 0);  /* May be {0xffffffff}, meaning "until EOF". */
     assert((h.channels >= 1) && (h.channels <= 16));
     
     /* Consume stream until first data byte: */
@@ -114,9 +143,7 @@ void jsa_skip_au_file_samples(FILE *rd, au_file_header_t *h, int ns)
   {
     int bps = jsa_au_file_bytes_per_sample(h->encoding); /* Bytes per sample. */
     int bskip = ns * bps; /* Bytes to skip. */
-    int i;
-    for (i = 0; i < bskip; i++)
-      { int c = fgetc(rd); assert(c != EOF); }
+    jsa_skip_bytes(rd, bskip);
   }
 
 void jsa_read_au_file_samples(FILE *rd, au_file_header_t *h, sound_t *s, int skip, int ns)
@@ -129,40 +156,49 @@ void jsa_read_au_file_samples(FILE *rd, au_file_header_t *h, sound_t *s, int ski
     assert(skip >= 0);
     assert(skip + ns <= s->ns);
 
-    /* Loop on samples and channels: */
-    int enc = h->encoding; /* A shorter name for the encoding tag. */
-    int i;
-    for (i = 0; i < ns; i++) 
-      { int c;
+    /* Read the samples in blocks of at most {nb} multichannel samples: */
+    int nb = jsa_BLOCK_SIZE/nc; 
+    double buf[jsa_BLOCK_SIZE];
+    int i0 = 0;
+    while (i0 < ns) 
+      { int ni = (ns - i0 < nb ? ns - i0 : nb); /* Samples per channel in this block. */
+        int nv = ni*nc; /* Values in this block. */
+        int nr = jsa_read_au_file_values(rd, h->encoding, nv, buf);
+        assert(nr == nv);
+        /* Separate the channels: */
+        int c;
         for (c = 0; c < nc; c++)
-          { double dv;
-            switch(enc)
-              {
-                case 3:
-                  { /* Reads 16 bit integer, converts to {double}. */
-                    short rv = jsa_read_short_be(rd);
-                    dv = ((double)rv)/SCALE_SHORT;
-                  }
-                  break;
-                case 5:
-                  { /* Reads 32 bit integer, converts to {double}. */
-                    int rv = jsa_read_int_be(rd);
-                    dv = ((double)rv)/SCALE_INT;
-                  }
-                  break;
-                case 6:
-                  { /* Reads 32 bit float, converts to {double}. */
-                    float rv = jsa_read_float_be(rd);
-                    dv = (double)rv;
-                  }
-                  break;
-                default:
-                  fprintf(stderr, "decoding of encoding type %d is not supported\n", enc);
-                  exit(1);
-              }
-            s->sv[c][i] = dv;
+          { double *sv = &(s->sv[c][skip + i0]);
+            int i;
+            for (i = 0; i < ni; i++) { sv[i] = buf[i*nc + c]; }
           }
+        i0 += ni;
+      }
+  }
+
+int jsa_read_au_file_values(FILE *rd, int enc, int nv, double v[])
+  { assert(nv <= jsa_BLOCK_SIZE);
+    union { short s[jsa_BLOCK_SIZE]; int i[jsa_BLOCK_SIZE]; float f[jsa_BLOCK_SIZE]; } buf;
+    int nr = 0, i;
+    switch(enc)
+      {
+        case 3: 
+          nr = jsa_read_some_shorts_be(rd, nv, buf.s);
+          for (i = 0; i < nr; i++) { v[i] = ((double)buf.s[i])/SCALE_SHORT; }
+          break;
+        case 5: 
+          nr = jsa_read_some_ints_be(rd, nv, buf.i);
+          for (i = 0; i < nr; i++) { v[i] = ((double)buf.i[i])/SCALE_INT; }
+          break;
+        case 6: 
+          nr = jsa_read_some_floats_be(rd, nv, buf.f);
+          for (i = 0; i < nr; i++) { v[i] = (double)buf.f[i]; }
+          break;
+        default:
+          fprintf(stderr, "decoding of encoding type %d is not supported\n", enc);
+          exit(1);
       }
+    return nr;
   }
   
 void jsa_write_au_file(FILE *wr, sound_t *s)
@@ -207,13 +243,20 @@ void jsa_write_au_file_samples(FILE *wr, au_file_header_t *h, sound_t *s, int sk
     assert(skip + ns <= s->ns);
     assert(h->encoding == 6); /* For now. */
     
-    int i;
-    for (i = 0; i < ns; i++) 
-      { int c;
-        for (c = 0; c < s->nc; c++)
-          { float fv = (float)(s->sv[c][skip + i]);
-            jsa_write_float_be(wr, &fv);
+    /* Write the samples in blocks of at most {nb} multichannel samples: */
+    int nc = s->nc;
+    int nb = jsa_BLOCK_SIZE/nc;
+    float buf[jsa_BLOCK_SIZE];
+    int i0 = 0;
+    while (i0 < ns) 
+      { int ni = (ns - i0 < nb ? ns - i0 : nb); /* Samples per channel in this block. */
+        int i, c;
+        for (c = 0; c < nc; c++)
+          { double *sv = &(s->sv[c][skip + i0]);
+            for (i = 0; i < ni; i++) { buf[i*nc + c] = (float)sv[i]; }
           }
+        jsa_write_floats_be(wr, ni*nc, buf);
+        i0 += ni;
       }
     fflush(wr);
   }
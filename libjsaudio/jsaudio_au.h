@@ -1,5 +1,5 @@
 /* jsaudio_au.h - Sun AU audio file I/O */
-/* Last edited on 2006-10-29 10:04:54 by stolfi */
+/* Last edited on 2026-10-19 13:01:43 by stolfi */
 
 /* 
   Derived from {rusound.h}, created by Rumiko Oishi Stolfi
@@ -18,7 +18,9 @@
 
 sound_t jsa_read_au_file(FILE *rd);
   /*  Reads from file {rd} a sound file in Sun's ".au" format. 
-    Returns the samples as a {sound_t} structure. */
+    Returns the samples as a {sound_t} structure.  If the data size
+    in the header is unspecified ({0xffffffff}), reads samples
+    until end-of-file. */
      
 void jsa_write_au_file(FILE *wr, sound_t *s);
   /* Writes to file {wr} the sound clip {s},
@@ -113,7 +115,9 @@ int jsa_au_file_bytes_per_sample(int enc);
 
 au_file_header_t jsa_read_au_file_header(FILE *rd);
   /* Reads the header of a Sun ".au" audio file from stream {rd}. 
-    Leaves the stream positioned just before the first sample data byte. */
+    Leaves the stream positioned just before the first sample data byte.
+    The {data_size} field may be {0xffffffff}, meaning that the 
+    sample data extends to the end of the file. */
 
 void jsa_skip_au_file_samples(FILE *rd, au_file_header_t *h, int ns);
   /* Skips {ns} samples of a Sun ".au" file opened as stream {rd}.
@@ -130,6 +134,15 @@ void jsa_read_au_file_samples(FILE *rd, au_file_header_t *h, sound_t *s, int ski
     Fails if {skip..skip+ns-1} is not a subset of {0..s.ns-1}, or if
     EOF is encountered prematurely. */
 
+int jsa_read_au_file_values(FILE *rd, int enc, int nv, double v[]);
+  /* Reads from {rd} up to {nv} consecutive sample values with encoding
+    {enc}, converts them to {double} with the same scale as the
+    samples of a {sound_t}, and stores them into {v[0..nv-1]}. The
+    values of different channels are left interleaved, as in the file.
+    Returns the number of values actually read, which is less than
+    {nv} only if EOF was found.  Requires {nv <= jsa_BLOCK_SIZE}.
+    Currently supports only encodings 3, 5, and 6. */
+
 void jsa_write_au_file_header(FILE *wr, au_file_header_t *h);
   /* Writes a Sun ".au" file header, with data taken from {h}, to stream {wr}. */
   
@@ -1,9 +1,10 @@
 /* See jsaudio_io.h */
-/* Last edited on 2017-01-02 21:31:00 by jstolfi */
+/* Last edited on 2026-10-19 13:01:43 by jstolfi */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <assert.h>
 
 #include <jsaudio_io.h>
@@ -70,6 +71,52 @@ float jsa_read_float_be(FILE *rd)
     return r;
   }
 
+void jsa_read_shorts_be(FILE *rd, int n, short v[])
+  { int nr = jsa_read_some_shorts_be(rd, n, v); assert(nr == n); }
+
+void jsa_read_ints_be(FILE *rd, int n, int v[])
+  { int nr = jsa_read_some_ints_be(rd, n, v); assert(nr == n); }
+
+void jsa_read_floats_be(FILE *rd, int n, float v[])
+  { int nr = jsa_read_some_floats_be(rd, n, v); assert(nr == n); }
+
+int jsa_read_some_shorts_be(FILE *rd, int n, short v[])
+  { int nr = (int)fread(v, 2, n, rd);
+    uint8_t *b = (uint8_t *)v;
+    int i;
+    for (i = 0; i < nr; i++, b += 2)
+      { uint16_t u = (uint16_t)((b[0] << 8) | b[1]);
+        memcpy(&(v[i]), &u, 2);
+      }
+    return nr;
+  }
+
+int jsa_read_some_ints_be(FILE *rd, int n, int v[])
+  { assert(sizeof(int) == 4);
+    int nr = (int)fread(v, 4, n, rd);
+    uint8_t *b = (uint8_t *)v;
+    int i;
+    for (i = 0; i < nr; i++, b += 4)
+      { uint32_t u = (((uint32_t)b[0]) << 24) | (((uint32_t)b[1]) << 16) | (((uint32_t)b[2]) << 8) | b[3];
+        memcpy(&(v[i]), &u, 4);
+      }
+    return nr;
+  }
+
+int jsa_read_some_floats_be(FILE *rd, int n, float v[])
+  { assert(sizeof(float) == 4);
+    return jsa_read_some_ints_be(rd, n, (int *)v);
+  }
+
+void jsa_skip_bytes(FILE *rd, int n)
+  { uint8_t buf[jsa_BLOCK_SIZE];
+    while (n > 0)
+      { int nb = (n < jsa_BLOCK_SIZE ? n : jsa_BLOCK_SIZE);
+        size_t nr = fread(buf, 1, nb, rd); assert(nr == nb);
+        n -= nb;
+      }
+  }
+
 void jsa_write_uint32_be(FILE *wr, uint32_t *p)
   { uint32_t u = (*p);
     fputc((u & 0xff000000) >> 24,wr);
@@ -83,3 +130,40 @@ void jsa_write_float_be(FILE *wr, float *p)
     uint32_t u = (*(uint32_t*)p);
     jsa_write_uint32_be(wr, &u); 
   }
+
+void jsa_write_shorts_be(FILE *wr, int n, short v[])
+  { uint8_t buf[2*jsa_BLOCK_SIZE];
+    int k = 0;
+    while (k < n)
+      { int m = (n - k < jsa_BLOCK_SIZE ? n - k : jsa_BLOCK_SIZE);
+        int i;
+        for (i = 0; i < m; i++)
+          { uint16_t u; memcpy(&u, &(v[k+i]), 2);
+            buf[2*i] = (uint8_t)(u >> 8); buf[2*i+1] = (uint8_t)(u & 0xff);
+          }
+        size_t nw = fwrite(buf, 2, m, wr); assert(nw == m);
+        k += m;
+      }
+  }
+
+void jsa_write_ints_be(FILE *wr, int n, int v[])
+  { assert(sizeof(int) == 4);
+    uint8_t buf[4*jsa_BLOCK_SIZE];
+    int k = 0;
+    while (k < n)
+      { int m = (n - k < jsa_BLOCK_SIZE ? n - k : jsa_BLOCK_SIZE);
+        int i;
+        for (i = 0; i < m; i++)
+          { uint32_t u; memcpy(&u, &(v[k+i]), 4);
+            buf[4*i] = (uint8_t)(u >> 24); buf[4*i+1] = (uint8_t)((u >> 16) & 0xff);
+            buf[4*i+2] = (uint8_t)((u >> 8) & 0xff); buf[4*i+3] = (uint8_t)(u & 0xff);
+          }
+        size_t nw = fwrite(buf, 4, m, wr); assert(nw == m);
+        k += m;
+      }
+  }
+
+void jsa_write_floats_be(FILE *wr, int n, float v[])
+  { assert(sizeof(float) == 4);
+    jsa_write_ints_be(wr, n, (int *)v);
+  }
@@ -1,5 +1,5 @@
 /* jsaudio_io.h - basic I/O tools for audio files */
-/* Last edited on 2006-10-29 20:24:16 by stolfi */
+/* Last edited on 2026-10-19 13:01:43 by stolfi */
 
 /* Created by Jorge Stolfi on sep/2006. */
 
@@ -35,6 +35,29 @@ float jsa_read_float_be(FILE *rd);
 void jsa_read_chars(FILE *rd, int n, char s[]);
   /* Reads the next {n} characters in {rd}, stores them in {s[0..n-1]}. */
 
+/* READING BLOCKS OF DATA */
+
+/* The following procedures read {n} consecutive values of the 
+  given type from {rd}, with a single {fread}, and store them into {v[0..n-1]}.
+  The result is the same as that of {n} calls to the corresponding
+  single-value procedures above, but much faster. */
+
+void jsa_read_shorts_be(FILE *rd, int n, short v[]);
+void jsa_read_ints_be(FILE *rd, int n, int v[]);
+void jsa_read_floats_be(FILE *rd, int n, float v[]);
+
+/* The following procedures are like the above, except that they stop
+  at end-of-file.  They return the number of values actually read,
+  which is less than {n} only if EOF was found.  A partial value at
+  the end of the file is discarded. */
+
+int jsa_read_some_shorts_be(FILE *rd, int n, short v[]);
+int jsa_read_some_ints_be(FILE *rd, int n, int v[]);
+int jsa_read_some_floats_be(FILE *rd, int n, float v[]);
+
+void jsa_skip_bytes(FILE *rd, int n);
+  /* Reads and discards the next {n} bytes of {rd}. */
+
 /* WRITING DATA */
 
 void jsa_write_uint32_be(FILE *wr, uint32_t *p);
@@ -43,4 +66,15 @@ void jsa_write_uint32_be(FILE *wr, uint32_t *p);
 void jsa_write_float_be(FILE *wr, float *p);
   /* Writes a 32-bit float {*p} to file {wr}. */
 
+void jsa_write_shorts_be(FILE *wr, int n, short v[]);
+void jsa_write_ints_be(FILE *wr, int n, int v[]);
+void jsa_write_floats_be(FILE *wr, int n, float v[]);
+  /* These procedures write the values {v[0..n-1]} to {wr}, big-endian,
+    with a single {fwrite}. The result is the same as that of {n} calls to 
+    the single-value writing procedures.  The array {v} is not changed. */
+
+#define jsa_BLOCK_SIZE 4096
+  /* A convenient number of values to read or write at a time with
+    the block procedures above. */
+
 #endif
@@ -0,0 +1,525 @@
+/* See jsaudio_stream.h */
+/* Last edited on 2026-10-19 13:01:43 by stolfi */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+
+#include <jsaudio.h>
+#include <jsaudio_au.h>
+#include <jsaudio_io.h>
+#include <jsaudio_stream.h>
+
+/* INTERNAL PROTOTYPES */
+
+jsa_stage_t *jsa_stage_new(char *descr, int nci, int nco, double rate, jsa_stage_proc_t *proc, int nst);
+  /* Allocates a stage record with the given fields, and a state
+    vector {st} with {nst} elements, all zero. */
+
+void jsa_stage_gain_proc(double st[], jsa_block_t *in, jsa_block_t *out);
+void jsa_stage_mix_proc(double st[], jsa_block_t *in, jsa_block_t *out);
+void jsa_stage_biquad_proc(double st[], jsa_block_t *in, jsa_block_t *out);
+void jsa_stage_resample_proc(double st[], jsa_block_t *in, jsa_block_t *out);
+  /* The processing procedures of the stages created by {jsa_stage_gain},
+    {jsa_stage_mix}, {jsa_stage_biquad}, and {jsa_stage_resample}. */
+
+typedef struct jsa_ring_t
+  { int cap;               /* Max number of elements. */
+    jsa_block_t **e;       /* The elements are {e[(head + k) % cap]} for {k} in {0..count-1}. */
+    int head;              /* Index of the oldest element. */
+    int count;             /* Number of elements. */
+    pthread_mutex_t lock;  /* Protects the fields above. */
+    pthread_cond_t nonempty; /* Signaled when an element is added. */
+    pthread_cond_t nonfull;  /* Signaled when an element is removed. */
+  } jsa_ring_t;
+  /* A first-in-first-out queue of block pointers, to pass
+    blocks between threads. A NULL element is used to signal
+    the end of the stream. */
+
+void jsa_ring_init(jsa_ring_t *Q, int cap);
+  /* Initializes {*Q} as an empty queue with room for {cap} elements. */
+
+void jsa_ring_put(jsa_ring_t *Q, jsa_block_t *b);
+  /* Appends {b} to the queue {Q}, waiting until there is room for it. */
+
+jsa_block_t *jsa_ring_get(jsa_ring_t *Q);
+  /* Removes the oldest element of {Q} and returns it, waiting until
+    there is one. */
+
+void jsa_ring_destroy(jsa_ring_t *Q);
+  /* Frees the internal storage of {Q}, but not the blocks. */
+
+typedef struct jsa_stream_job_t
+  { jsa_au_reader_t *R;  /* The input file. */
+    jsa_chain_t *C;      /* The processing chain. */
+    jsa_au_writer_t *W;  /* The output file. */
+    jsa_ring_t inFree;   /* Input blocks available for reading. */
+    jsa_ring_t inFull;   /* Input blocks ready for processing. */
+    jsa_ring_t outFree;  /* Output blocks available for processing. */
+    jsa_ring_t outFull;  /* Output blocks ready for writing. */
+  } jsa_stream_job_t;
+  /* Data shared by the threads of {jsa_stream_run}. */
+
+void *jsa_stream_reader_thread(void *arg);
+void *jsa_stream_writer_thread(void *arg);
+  /* The bodies of the reading and writing threads of {jsa_stream_run}.
+    The argument {arg} is the {jsa_stream_job_t} of the run. */
+
+/* IMPLEMENTATIONS */
+
+jsa_block_t *jsa_block_new(int nc, int nmax)
+  { assert(nc >= 1);
+    assert(nmax >= 1);
+    jsa_block_t *b = malloc(sizeof(jsa_block_t));
+    assert(b != NULL);
+    b->smp = malloc(((size_t)nc)*nmax*sizeof(float));
+    assert(b->smp != NULL);
+    b->fsmp = 0.0;
+    b->nc = nc;
+    b->nmax = nmax;
+    b->ns = 0;
+    return b;
+  }
+
+void jsa_block_free(jsa_block_t *b)
+  { free(b->smp);
+    free(b);
+  }
+
+jsa_stage_t *jsa_stage_new(char *descr, int nci, int nco, double rate, jsa_stage_proc_t *proc, int nst)
+  { assert((nci >= 1) && (nco >= 1));
+    assert(rate > 0);
+    jsa_stage_t *S = malloc(sizeof(jsa_stage_t));
+    assert(S != NULL);
+    S->descr = descr;
+    S->nci = nci;
+    S->nco = nco;
+    S->rate = rate;
+    S->proc = proc;
+    S->st = malloc((nst > 0 ? nst : 1)*sizeof(double));
+    assert(S->st != NULL);
+    int i;
+    for (i = 0; i < nst; i++) { S->st[i] = 0.0; }
+    return S;
+  }
+
+void jsa_stage_free(jsa_stage_t *S)
+  { free(S->st);
+    free(S);
+  }
+
+jsa_stage_t *jsa_stage_gain(int nc, double g[])
+  { jsa_stage_t *S = jsa_stage_new("gain", nc, nc, 1.0, &jsa_stage_gain_proc, nc);
+    int c;
+    for (c = 0; c < nc; c++) { S->st[c] = g[c]; }
+    return S;
+  }
+
+void jsa_stage_gain_proc(double st[], jsa_block_t *in, jsa_block_t *out)
+  { int ns = in->ns;
+    assert(ns <= out->nmax);
+    int c, k;
+    for (c = 0; c < in->nc; c++)
+      { float g = (float)st[c];
+        float *x = &(in->smp[c*in->nmax]);
+        float *y = &(out->smp[c*out->nmax]);
+        for (k = 0; k < ns; k++) { y[k] = g*x[k]; }
+      }
+    out->ns = ns;
+    out->fsmp = in->fsmp;
+  }
+
+jsa_stage_t *jsa_stage_mix(int nci, int nco, double M[])
+  { jsa_stage_t *S = jsa_stage_new("mix", nci, nco, 1.0, &jsa_stage_mix_proc, nci*nco + 1);
+    int i;
+    for (i = 0; i < nci*nco; i++) { S->st[i] = M[i]; }
+    S->st[nci*nco] = nci;
+    return S;
+  }
+
+void jsa_stage_mix_proc(double st[], jsa_block_t *in, jsa_block_t *out)
+  { int ns = in->ns;
+    int nci = in->nc;
+    assert(st[out->nc*nci] == nci);
+    assert(ns <= out->nmax);
+    int c, d, k;
+    for (c = 0; c < out->nc; c++)
+      { float *y = &(out->smp[c*out->nmax]);
+        for (k = 0; k < ns; k++) { y[k] = 0.0f; }
+        for (d = 0; d < nci; d++)
+          { float m = (float)st[c*nci + d];
+            if (m == 0.0f) { continue; }
+            float *x = &(in->smp[d*in->nmax]);
+            for (k = 0; k < ns; k++) { y[k] += m*x[k]; }
+          }
+      }
+    out->ns = ns;
+    out->fsmp = in->fsmp;
+  }
+
+jsa_stage_t *jsa_stage_biquad(int nc, double b[], double a[])
+  { assert(a[0] != 0);
+    /* State: the normalized coefficients {b0,b1,b2,a1,a2}, then {z1[c],z2[c]} for each channel. */
+    jsa_stage_t *S = jsa_stage_new("biquad", nc, nc, 1.0, &jsa_stage_biquad_proc, 5 + 2*nc);
+    S->st[0] = b[0]/a[0];
+    S->st[1] = b[1]/a[0];
+    S->st[2] = b[2]/a[0];
+    S->st[3] = a[1]/a[0];
+    S->st[4] = a[2]/a[0];
+    return S;
+  }
+
+void jsa_stage_biquad_proc(double st[], jsa_block_t *in, jsa_block_t *out)
+  { int ns = in->ns;
+    assert(ns <= out->nmax);
+    double b0 = st[0], b1 = st[1], b2 = st[2], a1 = st[3], a2 = st[4];
+    int c, k;
+    for (c = 0; c < in->nc; c++)
+      { float *x = &(in->smp[c*in->nmax]);
+        float *y = &(out->smp[c*out->nmax]);
+        /* Transposed direct form II: */
+        double z1 = st[5 + 2*c], z2 = st[6 + 2*c];
+        for (k = 0; k < ns; k++)
+          { double xk = x[k];
+            double yk = b0*xk + z1;
+            z1 = b1*xk - a1*yk + z2;
+            z2 = b2*xk - a2*yk;
+            y[k] = (float)yk;
+          }
+        st[5 + 2*c] = z1; st[6 + 2*c] = z2;
+      }
+    out->ns = ns;
+    out->fsmp = in->fsmp;
+  }
+
+jsa_stage_t *jsa_stage_resample(int nc, double fin, double fout)
+  { assert((fin > 0) && (fout > 0));
+    /* State: the step {q = fin/fout}, the index {j} of the next output sample,
+      the number {i0} of input samples consumed, and the last input
+      sample {prev[c]} of each channel. */
+    jsa_stage_t *S = jsa_stage_new("resample", nc, nc, fout/fin, &jsa_stage_resample_proc, 3 + nc);
+    S->st[0] = fin/fout;
+    return S;
+  }
+
+void jsa_stage_resample_proc(double st[], jsa_block_t *in, jsa_block_t *out)
+  { int ns = in->ns;
+    int nc = in->nc;
+    double q = st[0];
+    double j = st[1];
+    double i0 = st[2];
+    double *prev = &(st[3]);
+    int no = 0;
+    while (1)
+      { /* Position of output sample {j} relative to the first sample of {in}: */
+        double p = j*q - i0;
+        if (p > ns - 1) { break; }
+        int i = (int)floor(p);
+        assert(i >= (i0 > 0 ? -1 : 0));
+        double f = p - i;
+        assert(no < out->nmax);
+        int c;
+        for (c = 0; c < nc; c++)
+          { float *x = &(in->smp[c*in->nmax]);
+            double x0 = (i < 0 ? prev[c] : x[i]);
+            double x1 = (f == 0 ? x0 : x[i+1]);
+            out->smp[c*out->nmax + no] = (float)((1 - f)*x0 + f*x1);
+          }
+        no++; j++;
+      }
+    if (ns > 0)
+      { int c;
+        for (c = 0; c < nc; c++) { prev[c] = in->smp[c*in->nmax + ns - 1]; }
+      }
+    st[1] = j;
+    st[2] = i0 + ns;
+    out->ns = no;
+    out->fsmp = in->fsmp/q;
+  }
+
+jsa_chain_t *jsa_chain_new(int nst, jsa_stage_t *S[], int nc, int nmax)
+  { assert(nst >= 0);
+    jsa_chain_t *C = malloc(sizeof(jsa_chain_t));
+    assert(C != NULL);
+    C->nst = nst;
+    C->S = malloc((nst + 1)*sizeof(jsa_stage_t *));
+    C->tmp = malloc((nst + 1)*sizeof(jsa_block_t *));
+    assert((C->S != NULL) && (C->tmp != NULL));
+    C->nci = nc;
+    C->nmax_in = nmax;
+    C->rate = 1.0;
+    int i;
+    for (i = 0; i < nst; i++)
+      { assert(S[i]->nci == nc);
+        C->S[i] = S[i];
+        nc = S[i]->nco;
+        if (S[i]->rate != 1.0) { nmax = (int)ceil(nmax*S[i]->rate) + 1; }
+        C->rate *= S[i]->rate;
+        C->tmp[i] = (i < nst - 1 ? jsa_block_new(nc, nmax) : NULL);
+      }
+    C->nco = nc;
+    C->nmax_out = nmax;
+    return C;
+  }
+
+void jsa_chain_process(jsa_chain_t *C, jsa_block_t *in, jsa_block_t *out)
+  { assert(in->nc == C->nci);
+    assert(in->ns <= C->nmax_in);
+    assert(out->nc == C->nco);
+    assert(out->nmax >= C->nmax_out);
+    if (C->nst == 0)
+      { int c, k;
+        for (c = 0; c < in->nc; c++)
+          { float *x = &(in->smp[c*in->nmax]);
+            float *y = &(out->smp[c*out->nmax]);
+            for (k = 0; k < in->ns; k++) { y[k] = x[k]; }
+          }
+        out->ns = in->ns;
+        out->fsmp = in->fsmp;
+        return;
+      }
+    jsa_block_t *src = in;
+    int i;
+    for (i = 0; i < C->nst; i++)
+      { jsa_block_t *dst = (i == C->nst - 1 ? out : C->tmp[i]);
+        C->S[i]->proc(C->S[i]->st, src, dst);
+        src = dst;
+      }
+  }
+
+void jsa_chain_free(jsa_chain_t *C)
+  { int i;
+    for (i = 0; i < C->nst - 1; i++) { jsa_block_free(C->tmp[i]); }
+    free(C->tmp);
+    free(C->S);
+    free(C);
+  }
+
+jsa_au_reader_t jsa_au_reader_open(FILE *rd)
+  { jsa_au_reader_t R;
+    R.rd = rd;
+    R.h = jsa_read_au_file_header(rd);
+    R.nc = R.h.channels;
+    R.fsmp = (double)R.h.sample_rate;
+    if (R.h.data_size != 0xffffffff)
+      { int bps = jsa_au_file_bytes_per_sample(R.h.encoding);
+        R.ns = R.h.data_size / R.nc / bps;
+        assert(R.h.data_size == R.ns * R.nc * bps);
+        R.nleft = R.ns;
+      }
+    else
+      { /* Data extends to EOF: */
+        R.ns = -1;
+        R.nleft = INT64_MAX;
+      }
+    return R;
+  }
+
+int jsa_au_read_block(jsa_au_reader_t *R, jsa_block_t *b)
+  { int nc = R->nc;
+    assert(b->nc == nc);
+    int ns = (int)(R->nleft < b->nmax ? R->nleft : b->nmax);
+
+    /* Read the samples in pieces of at most {nb} multichannel samples: */
+    int nb = jsa_BLOCK_SIZE/nc;
+    double buf[jsa_BLOCK_SIZE];
+    int i0 = 0;
+    while (i0 < ns)
+      { int ni = (ns - i0 < nb ? ns - i0 : nb); /* Samples per channel in this piece. */
+        int nv = ni*nc; /* Values in this piece. */
+        int nr = jsa_read_au_file_values(R->rd, R->h.encoding, nv, buf);
+        if (nr < nv)
+          { /* Hit EOF: */
+            assert(R->ns < 0); /* Premature EOF if data size was given. */
+            ni = nr/nc;
+            ns = i0 + ni;
+            R->nleft = ns;
+          }
+        /* Convert to {float} and separate the channels: */
+        int c;
+        for (c = 0; c < nc; c++)
+          { float *sv = &(b->smp[c*b->nmax + i0]);
+            int i;
+            for (i = 0; i < ni; i++) { sv[i] = (float)buf[i*nc + c]; }
+          }
+        i0 += ni;
+      }
+    R->nleft -= ns;
+    b->ns = ns;
+    b->fsmp = R->fsmp;
+    return ns;
+  }
+
+jsa_au_writer_t jsa_au_writer_open(FILE *wr, int nc, double fsmp)
+  { jsa_au_writer_t W;
+    W.wr = wr;
+    W.ns = 0;
+    W.hpos = ftell(wr);
+
+    /* Build the file header: */
+    W.h.magic = 0x2e736e64; /* ".snd" */
+    W.h.hdr_size = 24;
+    W.h.data_size = 0xffffffff; /* Not known yet. */
+    W.h.encoding = 6; /* For now, use 32-bit float encoding. */
+    W.h.sample_rate = (int)(fsmp + 0.5);
+    if (fabs(fsmp - (double)W.h.sample_rate)/fsmp > 1.0e-4)
+      { fprintf(stderr, "warning: sample rate %14.8e rounded to %d\n", fsmp, W.h.sample_rate); }
+    W.h.channels = nc;
+
+    jsa_write_au_file_header(wr, &(W.h));
+    return W;
+  }
+
+void jsa_au_write_block(jsa_au_writer_t *W, jsa_block_t *b)
+  { int nc = W->h.channels;
+    assert(b->nc == nc);
+    int ns = b->ns;
+
+    /* Write the samples in pieces of at most {nb} multichannel samples: */
+    int nb = jsa_BLOCK_SIZE/nc;
+    float buf[jsa_BLOCK_SIZE];
+    int i0 = 0;
+    while (i0 < ns)
+      { int ni = (ns - i0 < nb ? ns - i0 : nb); /* Samples per channel in this piece. */
+        int i, c;
+        for (c = 0; c < nc; c++)
+          { float *sv = &(b->smp[c*b->nmax + i0]);
+            for (i = 0; i < ni; i++) { buf[i*nc + c] = sv[i]; }
+          }
+        jsa_write_floats_be(W->wr, ni*nc, buf);
+        i0 += ni;
+      }
+    W->ns += ns;
+  }
+
+void jsa_au_writer_close(jsa_au_writer_t *W)
+  { int bps = jsa_au_file_bytes_per_sample(W->h.encoding);
+    uint64_t nbytes = ((uint64_t)W->ns)*W->h.channels*bps;
+    if ((W->hpos >= 0) && (nbytes < 0xffffffff))
+      { long end = ftell(W->wr);
+        if ((end >= 0) && (fseek(W->wr, W->hpos, SEEK_SET) == 0))
+          { W->h.data_size = (uint32_t)nbytes;
+            jsa_write_au_file_header(W->wr, &(W->h));
+            fseek(W->wr, end, SEEK_SET);
+          }
+      }
+    fflush(W->wr);
+  }
+
+void jsa_ring_init(jsa_ring_t *Q, int cap)
+  { assert(cap >= 1);
+    Q->cap = cap;
+    Q->e = malloc(cap*sizeof(jsa_block_t *));
+    assert(Q->e != NULL);
+    Q->head = 0;
+    Q->count = 0;
+    pthread_mutex_init(&(Q->lock), NULL);
+    pthread_cond_init(&(Q->nonempty), NULL);
+    pthread_cond_init(&(Q->nonfull), NULL);
+  }
+
+void jsa_ring_put(jsa_ring_t *Q, jsa_block_t *b)
+  { pthread_mutex_lock(&(Q->lock));
+    while (Q->count >= Q->cap) { pthread_cond_wait(&(Q->nonfull), &(Q->lock)); }
+    Q->e[(Q->head + Q->count) % Q->cap] = b;
+    Q->count++;
+    pthread_cond_signal(&(Q->nonempty));
+    pthread_mutex_unlock(&(Q->lock));
+  }
+
+jsa_block_t *jsa_ring_get(jsa_ring_t *Q)
+  { pthread_mutex_lock(&(Q->lock));
+    while (Q->count == 0) { pthread_cond_wait(&(Q->nonempty), &(Q->lock)); }
+    jsa_block_t *b = Q->e[Q->head];
+    Q->head = (Q->head + 1) % Q->cap;
+    Q->count--;
+    pthread_cond_signal(&(Q->nonfull));
+    pthread_mutex_unlock(&(Q->lock));
+    return b;
+  }
+
+void jsa_ring_destroy(jsa_ring_t *Q)
+  { pthread_cond_destroy(&(Q->nonfull));
+    pthread_cond_destroy(&(Q->nonempty));
+    pthread_mutex_destroy(&(Q->lock));
+    free(Q->e);
+  }
+
+void *jsa_stream_reader_thread(void *arg)
+  { jsa_stream_job_t *job = (jsa_stream_job_t *)arg;
+    while (1)
+      { jsa_block_t *b = jsa_ring_get(&(job->inFree));
+        if (jsa_au_read_block(job->R, b) == 0)
+          { jsa_ring_put(&(job->inFree), b);
+            break;
+          }
+        jsa_ring_put(&(job->inFull), b);
+      }
+    jsa_ring_put(&(job->inFull), NULL);
+    return NULL;
+  }
+
+void *jsa_stream_writer_thread(void *arg)
+  { jsa_stream_job_t *job = (jsa_stream_job_t *)arg;
+    while (1)
+      { jsa_block_t *b = jsa_ring_get(&(job->outFull));
+        if (b == NULL) { break; }
+        jsa_au_write_block(job->W, b);
+        jsa_ring_put(&(job->outFree), b);
+      }
+    return NULL;
+  }
+
+int64_t jsa_stream_run(jsa_au_reader_t *R, jsa_chain_t *C, jsa_au_writer_t *W, int nq)
+  { assert(nq >= 1);
+    assert(C->nci == R->nc);
+    assert(C->nco == W->h.channels);
+    int64_t ns0 = W->ns;
+
+    /* Set up the queues, with room for all blocks plus the end marker: */
+    jsa_stream_job_t job;
+    job.R = R; job.C = C; job.W = W;
+    jsa_ring_init(&(job.inFree), nq + 1);
+    jsa_ring_init(&(job.inFull), nq + 1);
+    jsa_ring_init(&(job.outFree), nq + 1);
+    jsa_ring_init(&(job.outFull), nq + 1);
+    jsa_block_t *bin[nq], *bout[nq];
+    int k;
+    for (k = 0; k < nq; k++)
+      { bin[k] = jsa_block_new(C->nci, C->nmax_in);
+        bout[k] = jsa_block_new(C->nco, C->nmax_out);
+        jsa_ring_put(&(job.inFree), bin[k]);
+        jsa_ring_put(&(job.outFree), bout[k]);
+      }
+
+    /* Start the reader and writer threads: */
+    pthread_t trd, twr;
+    int res;
+    res = pthread_create(&trd, NULL, &jsa_stream_reader_thread, &job); assert(res == 0);
+    res = pthread_create(&twr, NULL, &jsa_stream_writer_thread, &job); assert(res == 0);
+
+    /* Process the blocks in this thread: */
+    while (1)
+      { jsa_block_t *b = jsa_ring_get(&(job.inFull));
+        if (b == NULL) { break; }
+        jsa_block_t *o = jsa_ring_get(&(job.outFree));
+        jsa_chain_process(C, b, o);
+        jsa_ring_put(&(job.inFree), b);
+        jsa_ring_put((o->ns > 0 ? &(job.outFull) : &(job.outFree)), o);
+      }
+    jsa_ring_put(&(job.outFull), NULL);
+
+    res = pthread_join(trd, NULL); assert(res == 0);
+    res = pthread_join(twr, NULL); assert(res == 0);
+
+    for (k = 0; k < nq; k++) { jsa_block_free(bin[k]); jsa_block_free(bout[k]); }
+    jsa_ring_destroy(&(job.inFree));
+    jsa_ring_destroy(&(job.inFull));
+    jsa_ring_destroy(&(job.outFree));
+    jsa_ring_destroy(&(job.outFull));
+    fflush(W->wr);
+    return W->ns - ns0;
+  }
@@ -0,0 +1,194 @@
+/* jsaudio_stream.h - block-by-block streaming processing of audio files */
+/* Last edited on 2026-10-19 13:01:43 by stolfi */
+
+#ifndef jsaudio_stream_H
+#define jsaudio_stream_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <jsaudio.h>
+#include <jsaudio_au.h>
+
+/*
+  These tools process an audio file in consecutive blocks of samples,
+  so that the memory used does not depend on the length of the
+  recording.  The samples are kept as {float}s, with the same
+  scale as the {double} samples of a {sound_t}.
+
+  A /stage/ is an operation that transforms one block into another
+  (e.g. a gain, a channel mix, a filter, or a resampling), and keeps
+  whatever state it needs to continue on the next block.  A /chain/
+  is a sequence of stages, applied in order to each block.
+
+  The procedure {jsa_stream_run} reads, processes, and writes the
+  blocks with three concurrent threads, connected by ring buffers of
+  a fixed number of blocks. */
+
+/* SAMPLE BLOCKS */
+
+typedef struct jsa_block_t
+  { double fsmp;  /* Samples per second per channel. */
+    int nc;       /* Number of channels. */
+    int nmax;     /* Capacity of the block, in samples per channel. */
+    int ns;       /* Number of valid samples per channel. */
+    float *smp;   /* {smp[c*nmax + k]} is sample {k} of channel {c}. */
+  } jsa_block_t;
+  /* A block of {ns} consecutive samples from each of {nc} channels.
+    The samples of each channel are contiguous. */
+
+jsa_block_t *jsa_block_new(int nc, int nmax);
+  /* Allocates a block with {nc} channels and room for {nmax} samples
+    per channel.  The number of valid samples {ns} is set to zero. */
+
+void jsa_block_free(jsa_block_t *b);
+  /* Frees the block {b}, including the record {*b}. */
+
+/* PROCESSING STAGES */
+
+typedef void jsa_stage_proc_t(double st[], jsa_block_t *in, jsa_block_t *out);
+  /* A procedure that processes the samples of block {in}, with
+    parameters and state {st}, and stores the result into block {out}.
+    Must set {out.ns} and {out.fsmp}. */
+
+typedef struct jsa_stage_t
+  { char *descr;           /* Printable description of the stage. */
+    int nci;               /* Number of input channels. */
+    int nco;               /* Number of output channels. */
+    double rate;           /* Ratio of output to input sampling frequency. */
+    jsa_stage_proc_t *proc; /* The processing procedure. */
+    double *st;            /* Parameters and state of the stage. */
+  } jsa_stage_t;
+  /* A processing stage for a stream of blocks with {nci} channels.
+    Each call to {proc} consumes all {ns} samples of the input block
+    and produces at most {ceil(ns*rate) + 1} samples per channel. */
+
+void jsa_stage_free(jsa_stage_t *S);
+  /* Frees the stage {S}, including its state and the record {*S}. */
+
+jsa_stage_t *jsa_stage_gain(int nc, double g[]);
+  /* A stage that multiplies each sample of channel {c} by {g[c]},
+    for {c} in {0..nc-1}. */
+
+jsa_stage_t *jsa_stage_mix(int nci, int nco, double M[]);
+  /* A stage that turns {nci} channels into {nco} channels.  Output
+    channel {c} is the sum of {M[c*nci + d]} times input channel {d},
+    for {d} in {0..nci-1}. */
+
+jsa_stage_t *jsa_stage_biquad(int nc, double b[], double a[]);
+  /* A stage that applies to each channel the recursive filter
+    {a[0]*y[k] = b[0]*x[k] + b[1]*x[k-1] + b[2]*x[k-2] - a[1]*y[k-1] - a[2]*y[k-2]},
+    where {x} is the input and {y} the output.  Samples before
+    the start of the stream are assumed to be zero.  The filter state
+    is kept in {double}. */
+
+jsa_stage_t *jsa_stage_resample(int nc, double fin, double fout);
+  /* A stage that converts a stream sampled at {fin} samples per second
+    into one sampled at {fout} samples per second, by linear
+    interpolation between consecutive input samples.  Output sample
+    {j} is the input signal at time {j/fout}.  Output samples that
+    would need input beyond the last sample of the stream are
+    not generated.
+
+    This stage does not apply any low-pass filter, so it will create
+    aliasing when {fout < fin} unless the input is band-limited (e.g.
+    with {jsa_stage_biquad}). */
+
+/* PROCESSING CHAINS */
+
+typedef struct jsa_chain_t
+  { int nst;            /* Number of stages. */
+    jsa_stage_t **S;    /* The stages are {S[0..nst-1]}. */
+    jsa_block_t **tmp;  /* {tmp[i]} holds the output of stage {S[i]}, for {i} in {0..nst-2}. */
+    int nci;            /* Number of channels of the input blocks. */
+    int nco;            /* Number of channels of the output blocks. */
+    double rate;        /* Ratio of output to input sampling frequency. */
+    int nmax_in;        /* Max samples per channel in an input block. */
+    int nmax_out;       /* Max samples per channel in an output block. */
+  } jsa_chain_t;
+  /* A sequence of stages to be applied to a stream of blocks. */
+
+jsa_chain_t *jsa_chain_new(int nst, jsa_stage_t *S[], int nc, int nmax);
+  /* Creates a chain with the stages {S[0..nst-1]}, for input blocks
+    with {nc} channels and at most {nmax} samples per channel.  The
+    number of input channels of each stage must be the number of
+    output channels of the previous one (or {nc}, for the first
+    stage).  The stages are not copied, and remain owned by the client.
+
+    The chain allocates its own blocks for the intermediate results,
+    so its memory use depends only on {nc}, {nmax} and the stages. */
+
+void jsa_chain_process(jsa_chain_t *C, jsa_block_t *in, jsa_block_t *out);
+  /* Applies all the stages of {C} to the block {in}, and stores the
+    final result into {out}.  The block {in} must have {C.nci} channels
+    and at most {C.nmax_in} samples; the block {out} must have {C.nco}
+    channels and room for {C.nmax_out} samples. If the chain has no stages,
+    the samples are just copied. */
+
+void jsa_chain_free(jsa_chain_t *C);
+  /* Frees the chain {C} and its intermediate blocks, but not its stages. */
+
+/* STREAMING AU FILE I/O */
+
+typedef struct jsa_au_reader_t
+  { FILE *rd;            /* The file being read. */
+    au_file_header_t h;  /* Its header. */
+    int nc;              /* Number of channels. */
+    double fsmp;         /* Samples per second per channel. */
+    int64_t ns;          /* Total samples per channel in the file, or -1 if not known. */
+    int64_t nleft;       /* Samples per channel not read yet, or {INT64_MAX} if not known. */
+  } jsa_au_reader_t;
+  /* The state of a Sun ".au" file being read block by block. */
+
+jsa_au_reader_t jsa_au_reader_open(FILE *rd);
+  /* Reads the header of a Sun ".au" file from {rd}, and returns a
+    reader positioned at the first sample.  If the data size in the
+    header is unspecified ({0xffffffff}), the samples are read until
+    end-of-file. */
+
+int jsa_au_read_block(jsa_au_reader_t *R, jsa_block_t *b);
+  /* Reads the next {min(b.nmax, R.nleft)} samples per channel from {R}
+    into the block {b}, sets {b.ns} and {b.fsmp}, and returns {b.ns}.
+    Returns 0 at the end of the data. Requires {b.nc == R.nc}. */
+
+typedef struct jsa_au_writer_t
+  { FILE *wr;            /* The file being written. */
+    au_file_header_t h;  /* Its header. */
+    long hpos;           /* Position of the header in {wr}, or -1 if not seekable. */
+    int64_t ns;          /* Samples per channel written so far. */
+  } jsa_au_writer_t;
+  /* The state of a Sun ".au" file being written block by block. */
+
+jsa_au_writer_t jsa_au_writer_open(FILE *wr, int nc, double fsmp);
+  /* Writes to {wr} the header of a Sun ".au" file with {nc} channels
+    and sampling frequency {fsmp} (rounded to an integer), in 32-bit
+    float encoding.  The data size is left unspecified ({0xffffffff})
+    until {jsa_au_writer_close}.  If {wr} is not seekable (e.g. a pipe)
+    it stays that way, and the file can be read with {jsa_au_reader_open}
+    or {jsa_read_au_file}, which then read samples until end-of-file. */
+
+void jsa_au_write_block(jsa_au_writer_t *W, jsa_block_t *b);
+  /* Appends the {b.ns} samples of each channel of block {b} to the
+    file of {W}.  Requires {b.nc == W.h.channels}. */
+
+void jsa_au_writer_close(jsa_au_writer_t *W);
+  /* Finishes the file of {W}.  If the file is seekable, rewrites the
+    data size in the header with the number of bytes actually
+    written.  Does not close {W.wr}. */
+
+/* STREAMING PIPELINE */
+
+int64_t jsa_stream_run(jsa_au_reader_t *R, jsa_chain_t *C, jsa_au_writer_t *W, int nq);
+  /* Reads all remaining samples of {R}, processes them with {C}, and
+    writes the results to {W}.  Returns the number of samples per
+    channel written.
+
+    Reading, processing and writing are done by three concurrent
+    threads.  The reader and the processor are connected by a ring
+    buffer of {nq} blocks of size {C.nmax_in}; the processor and the
+    writer by another {nq} blocks of size {C.nmax_out}. Thus the total
+    memory used is fixed, independent of the length of the stream.
+    Requires {nq >= 1}, {C.nci == R.nc}, and {C.nco == W.h.channels}.
+    Does not call {jsa_au_writer_close}. */
+
+#endif
@@ -1,5 +1,5 @@
 /* See {lsq.h} */
-/* Last edited on 2019-12-18 17:14:36 by jstolfi */
+/* Last edited on 2026-10-19 11:36:32 by jstolfi */
 
 #define lsq_C_COPYRIGHT \
   "Copyright  2007  by the State University of Campinas (UNICAMP)"
@@ -19,6 +19,7 @@
 #include <gauss_elim.h>
 
 #include <lsq.h>
+#include <lsq_array.h>
 
 /* INTERNAL PROTOTYPES */
 
@@ -88,18 +89,24 @@ void lsq_compute_matrix_and_rhs
     bool_t verbose
   )
   {
-    /* Allocate storage for data points: */
-    double Xk[nx];  /* Independent variables (argument coordinates). */
-    double Fk[nf];  /* Dependent variables (function samples). */
+    /* The data points are collected in blocks of {nb} and added to {A,B} 
+      with {lsq_array_accum_rows}. */
+    int32_t nb = lsq_BLOCK_ROWS;
+    double *Xb = rmxn_alloc(nb,nx); /* Independent variables (argument coordinates). */
+    double *Fb = rmxn_alloc(nb,nf); /* Dependent variables (function samples). */
+    double *Wb = rn_alloc(nb);      /* Weights. */
 
     /* Generate all test data points, accumulate statistics: */
     rmxn_zero(nx, nx, A);
     rmxn_zero(nx, nf, B);
+    int32_t kb = 0; /* Number of points in the current block. */
     for (int32_t kt = 0; kt < nt; kt++)
       { 
         bool_t verbacc = verbose & (kt < 20); /* Debug the stats accumulator? */
         
         /* Obtain data point number {kt} in {Xk,Fk,Wk}: */
+        double *Xk = &(Xb[kb*nx]);
+        double *Fk = &(Fb[kb*nf]);
         double Wk = NAN;
         gen_data_point(kt, nx, Xk, nf, Fk, &Wk);
         if (verbacc) 
@@ -113,17 +120,27 @@ void lsq_compute_matrix_and_rhs
           }
         demand(Wk >= 0, "reliability weight must be non-negative");
         demand(Wk < +INF, "infinte reliability weights not implemented yet");
+        Wb[kb] = Wk;
+        kb++;
         
         /* Accumulate scalar products on matrix: */
-        for (int32_t ix = 0; ix < nx; ix++)
-          { for (int32_t jx = 0; jx < nx; jx++)
-              { A[ix*nx+jx] += Xk[ix]*Wk*Xk[jx]; }
-            for (int32_t jf = 0; jf < nf; jf++)
-              { B[ix*nf+jf] += Xk[ix]*Wk*Fk[jf]; }
+        if ((kb == nb) || (kt == nt-1))
+          { lsq_array_accum_rows(kb, nx, nf, Xb, Fb, Wb, A, B);
+            kb = 0;
           }
           
         if (verbacc) { fprintf(stderr, "\n"); }
       }
+    
+    /* Replicate the lower half of {A} into the upper half: */
+    for (int32_t i = 1; i < nx; i++) 
+      { for (int32_t j = 0; j < i; j++) 
+         { A[j*nx + i] = A[i*nx + j]; } 
+      }
+    
+    free(Xb);
+    free(Fb);
+    free(Wb);
   }
   
 int32_t lsq_solve_system
@@ -2,7 +2,7 @@
 #define lsq_H
 
 /* Fits a linear map of {R^nx} to {R^nf} by least squares, given sampling proc. */
-/* Last edited on 2019-12-18 15:59:51 by jstolfi */
+/* Last edited on 2026-10-19 11:36:32 by jstolfi */
 
 #define lsq_H_COPYRIGHT \
   "Copyright  2006  by the State University of Campinas (UNICAMP)"
@@ -101,7 +101,18 @@ void lsq_compute_matrix_and_rhs
   /* Calls {gen_data_point(k,nx,Xk,nf,Fk,&Wk)} for {k} in {0..nt-1}, thus
     obtaining {Xk[0..nx-1]}, {Fk[0..nf-1}, and {Wk}. Computes from all those values
     the moment matrix {A} ({nx  nx}) and the right-hand side matrix
-    {B} ({nx  nf}). */
+    {B} ({nx  nf}).
+    
+    The data points are requested in order of increasing {k}, by the
+    calling thread.  They are accumulated in blocks of
+    {lsq_BLOCK_ROWS} points with {lsq_array_accum_rows}; so the
+    cost is dominated by one rank-4 update of {A} and {B} for every
+    four data points. For data points that are already stored in
+    arrays, {lsq_array_compute_matrix_and_rhs} is faster, since it
+    can use several threads. */
+
+#define lsq_BLOCK_ROWS 64
+  /* Number of data points buffered by {lsq_compute_matrix_and_rhs}. */
 
 int32_t lsq_solve_system
   ( int32_t nx, 
@@ -1,5 +1,5 @@
 /* See {lsq_array.h} */
-/* Last edited on 2019-12-18 17:12:11 by jstolfi */
+/* Last edited on 2026-10-19 12:56:51 by jstolfi */
 
 #define lsq_array_C_COPYRIGHT \
   "Copyright © 2014  by the State University of Campinas (UNICAMP)"
@@ -16,6 +16,7 @@
 #include <rmxn.h>
 #include <jsmath.h>
 #include <gauss_elim.h>
+#include <jsthread.h>
 
 #include <lsq.h>
 #include <lsq_array.h>
@@ -32,9 +33,8 @@ int32_t lsq_array_fit
   )
   {
     double *A = rmxn_alloc(nx,nx);
-    lsq_array_compute_matrix(nt, nx, X, W, A);
     double *B = rmxn_alloc(nx,nf);
-    lsq_array_compute_rhs(nt, nx, nf, X, F, W, B);
+    lsq_array_compute_matrix_and_rhs(nt, nx, nf, X, F, W, A, B, 1);
     int32_t rank = lsq_solve_system(nx, nf, A, B, 0,NULL,NULL, U,NULL, verbose);
     free(B);
     free(A);
@@ -43,36 +43,155 @@ int32_t lsq_array_fit
 
 void lsq_array_compute_matrix(int32_t nt, int32_t nx, double X[], double W[], double A[])
   {
-    rmxn_zero(nx, nx, A);
-    /* Fill the lower triangular half of {A}: */ 
-    for (int32_t k = 0; k < nt; k++)
-      { double* Xk = &(X[k*nx]);
-        double Wk = (W != NULL ? W[k] : 1);
-        for (int32_t i = 0; i < nx; i++)
-          { for (int32_t j = 0; j <= i; j++)
-              { double Xkij = Xk[i]*Xk[j];
-                A[i*nx + j] += Wk*Xkij;
+    lsq_array_compute_matrix_and_rhs(nt, nx, 0, X, NULL, W, A, NULL, 1);
+  }
+
+void lsq_array_compute_rhs(int32_t nt, int32_t nx, int32_t nf, double X[], double F[], double W[], double B[])
+  {
+    lsq_array_compute_matrix_and_rhs(nt, nx, nf, X, F, W, NULL, B, 1);
+  }
+
+typedef struct lsq_array_accum_job_t
+  { int32_t nt, nx, nf;
+    double *X, *F, *W;
+    int32_t ns;     /* Number of slabs. */
+    double **Ps;    /* {Ps[s]} is the partial matrix of slab {s}, or NULL. */
+    double **Qs;    /* {Qs[s]} is the partial rhs of slab {s}, or NULL. */
+  } lsq_array_accum_job_t;
+  /* Arguments for {lsq_array_accum_slabs}. */
+
+void lsq_array_accum_slabs(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Accumulates the contributions of slabs {ini..fin} of a 
+    {lsq_array_accum_job_t} into their partial matrices. */
+
+void lsq_array_compute_matrix_and_rhs
+  ( int32_t nt,
+    int32_t nx,
+    int32_t nf,
+    double X[],
+    double F[],
+    double W[],
+    double A[],
+    double B[],
+    int32_t nth
+  )
+  {
+    if ((A == NULL) && (B == NULL)) { return; }
+    if (B == NULL) { nf = 0; F = NULL; }
+    if (A != NULL) { rmxn_zero(nx, nx, A); }
+    if (B != NULL) { rmxn_zero(nx, nf, B); }
+
+    /* Decide the number of slabs {ns}, one per thread: */
+    int32_t ns = jsthread_choose_count(nth, nt/lsq_array_MIN_SLAB_ROWS);
+    if (ns == 1)
+      { lsq_array_accum_rows(nt, nx, nf, X, F, W, A, B); }
+    else
+      { /* Slab 0 accumulates directly into {A,B}, the others into scratch areas: */
+        double **Ps = notnull(malloc(ns*sizeof(double*)), "no mem");
+        double **Qs = notnull(malloc(ns*sizeof(double*)), "no mem");
+        for (int32_t s = 0; s < ns; s++)
+          { bool_t own = (s > 0);
+            Ps[s] = (A == NULL ? NULL : (own ? rmxn_alloc(nx,nx) : A));
+            Qs[s] = (B == NULL ? NULL : (own ? rmxn_alloc(nx,nf) : B));
+            if (own && (A != NULL)) { rmxn_zero(nx, nx, Ps[s]); }
+            if (own && (B != NULL)) { rmxn_zero(nx, nf, Qs[s]); }
+          }
+        lsq_array_accum_job_t job = 
+          (lsq_array_accum_job_t){ .nt = nt, .nx = nx, .nf = nf, .X = X, .F = F, .W = W, .ns = ns, .Ps = Ps, .Qs = Qs };
+        jsthread_run_ranges(ns, 1, ns, &lsq_array_accum_slabs, &job);
+        
+        /* Merge the partial sums, in slab order: */
+        for (int32_t s = 1; s < ns; s++)
+          { if (A != NULL)
+              { for (int32_t i = 0; i < nx; i++)
+                  { double *Ai = &(A[i*nx]), *Pi = &(Ps[s][i*nx]);
+                    for (int32_t j = 0; j <= i; j++) { Ai[j] += Pi[j]; }
+                  }
+                free(Ps[s]);
+              }
+            if (B != NULL) 
+              { for (int32_t ij = 0; ij < nx*nf; ij++) { B[ij] += Qs[s][ij]; }
+                free(Qs[s]);
               }
           }
+        free(Ps);
+        free(Qs);
       }
-    /* Replicate the lower half of {A} into the upper half: */
-    for (int32_t i = 1; i < nx; i++) 
-      { for (int32_t j = 0; j < i; j++) 
-         { A[j*nx + i] = A[i*nx + j]; } 
+
+    if (A != NULL)
+      { /* Replicate the lower half of {A} into the upper half: */
+        for (int32_t i = 1; i < nx; i++) 
+          { for (int32_t j = 0; j < i; j++) 
+             { A[j*nx + i] = A[i*nx + j]; } 
+          }
       }
   }
 
-void lsq_array_compute_rhs(int32_t nt, int32_t nx, int32_t nf, double X[], double F[], double W[], double B[])
+void lsq_array_accum_slabs(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    lsq_array_accum_job_t *job = (lsq_array_accum_job_t *)arg;
+    int32_t nt = job->nt, nx = job->nx, nf = job->nf, ns = job->ns;
+    for (int32_t s = ini; s <= fin; s++)
+      { /* Slab {s} has rows {k0..k1-1}: */
+        int32_t k0 = (int32_t)(((int64_t)nt)*s/ns);
+        int32_t k1 = (int32_t)(((int64_t)nt)*(s+1)/ns);
+        double *Xs = &(job->X[((int64_t)k0)*nx]);
+        double *Fs = (job->F == NULL ? NULL : &(job->F[((int64_t)k0)*nf]));
+        double *Ws = (job->W == NULL ? NULL : &(job->W[k0]));
+        lsq_array_accum_rows(k1 - k0, nx, nf, Xs, Fs, Ws, job->Ps[s], job->Qs[s]);
+      }
+  }
+
+void lsq_array_accum_rows
+  ( int32_t nr,
+    int32_t nx,
+    int32_t nf,
+    double X[],
+    double F[],
+    double W[],
+    double A[],
+    double B[]
+  )
   {
-    rmxn_zero(nx, nf, B);
-    for (int32_t k = 0; k < nt; k++)
-      { double* Xk = &(X[k*nx]);
-        double* Fk = &(F[k*nf]);
+    int32_t k = 0;
+    /* Process the rows four at a time, as rank-4 updates: */
+    while (k + 4 <= nr)
+      { double *X0 = &(X[((int64_t)k)*nx]), *X1 = X0 + nx, *X2 = X1 + nx, *X3 = X2 + nx;
+        double W0 = 1, W1 = 1, W2 = 1, W3 = 1;
+        if (W != NULL) { W0 = W[k]; W1 = W[k+1]; W2 = W[k+2]; W3 = W[k+3]; }
+        double *F0 = NULL, *F1 = NULL, *F2 = NULL, *F3 = NULL;
+        if (B != NULL) { F0 = &(F[((int64_t)k)*nf]); F1 = F0 + nf; F2 = F1 + nf; F3 = F2 + nf; }
+        for (int32_t i = 0; i < nx; i++)
+          { double a0 = W0*X0[i], a1 = W1*X1[i], a2 = W2*X2[i], a3 = W3*X3[i];
+            if (A != NULL)
+              { double *Ai = &(A[i*nx]);
+                for (int32_t j = 0; j <= i; j++)
+                  { Ai[j] += (a0*X0[j] + a1*X1[j]) + (a2*X2[j] + a3*X3[j]); }
+              }
+            if (B != NULL)
+              { double *Bi = &(B[i*nf]);
+                for (int32_t j = 0; j < nf; j++)
+                  { Bi[j] += (a0*F0[j] + a1*F1[j]) + (a2*F2[j] + a3*F3[j]); }
+              }
+          }
+        k += 4;
+      }
+    /* Process the remaining rows one at a time: */
+    while (k < nr)
+      { double *Xk = &(X[((int64_t)k)*nx]);
         double Wk = (W != NULL ? W[k] : 1);
+        double *Fk = (B != NULL ? &(F[((int64_t)k)*nf]) : NULL);
         for (int32_t i = 0; i < nx; i++)
-          { for (int32_t j = 0; j < nf; j++) 
-              { B[i*nf + j] += Wk*Xk[i]*Fk[j]; }
+          { double ak = Wk*Xk[i];
+            if (A != NULL)
+              { double *Ai = &(A[i*nx]);
+                for (int32_t j = 0; j <= i; j++) { Ai[j] += ak*Xk[j]; }
+              }
+            if (B != NULL)
+              { double *Bi = &(B[i*nf]);
+                for (int32_t j = 0; j < nf; j++) { Bi[j] += ak*Fk[j]; }
+              }
           }
+        k++;
       }
   }
-
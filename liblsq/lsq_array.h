@@ -2,7 +2,7 @@
 #define lsq_array_H
 
 /* Fits a linear map of {R^nx} to {R^nf} by least squares, given sample arrays. */
-/* Last edited on 2019-12-18 16:15:59 by jstolfi */
+/* Last edited on 2026-10-19 12:56:51 by jstolfi */
 
 #define lsq_array_H_COPYRIGHT \
   "Copyright © 2014  by the State University of Campinas (UNICAMP)"
@@ -82,4 +82,57 @@ void lsq_array_compute_rhs(int32_t nt, int32_t nx, int32_t nf, double X[], doubl
     {SUM{ W[k]*X[k*nx+i]*F[k*nf+j] : k \in 0..nt-1 }} for all {i} in {0..nx-1}
     and all {j} in {0..nf-1}. */
 
+void lsq_array_compute_matrix_and_rhs
+  ( int32_t nt,
+    int32_t nx,
+    int32_t nf,
+    double X[],
+    double F[],
+    double W[],
+    double A[],
+    double B[],
+    int32_t nth
+  );
+  /* Stores into {A} the same matrix as {lsq_array_compute_matrix(nt,nx,X,W,A)},
+    and into {B} the same matrix as {lsq_array_compute_rhs(nt,nx,nf,X,F,W,B)},
+    with a single pass over the data.  If {A} is NULL, the matrix is not computed;
+    if {B} is NULL, the rhs is not computed, and {nf,F} are ignored.
+
+    When {nt} is large, the data rows are split into consecutive slabs
+    of at least {lsq_array_MIN_SLAB_ROWS} rows, one for each of {nth}
+    threads (one per available processor if {nth} is zero). Each thread
+    accumulates its slab into a private partial matrix and rhs, and the
+    partial sums are then added in slab order. Therefore the result is
+    deterministic for a given thread count, but the rounding errors may
+    differ slightly between different thread counts.
+
+    The procedures {lsq_array_compute_matrix}, {lsq_array_compute_rhs}, 
+    and {lsq_array_fit} call this one with {nth = 1}, so their results
+    are the same on any machine. */
+
+#define lsq_array_MIN_SLAB_ROWS 16384
+  /* Minimum number of data rows per thread in {lsq_array_compute_matrix_and_rhs}. */
+
+void lsq_array_accum_rows
+  ( int32_t nr,
+    int32_t nx,
+    int32_t nf,
+    double X[],
+    double F[],
+    double W[],
+    double A[],
+    double B[]
+  );
+  /* Adds to the lower triangular half of {A} (including the diagonal)
+    the sums {SUM{ W[k]*X[k*nx+i]*X[k*nx+j] : k \in 0..nr-1 }}, for {j <= i};
+    and adds to {B} the sums {SUM{ W[k]*X[k*nx+i]*F[k*nf+j] : k \in 0..nr-1 }}.
+    The upper half of {A} is not changed.  Either {A} or {B} may be NULL, in which case
+    it is not updated (and {F} is not used, if {B} is NULL).  If {W} is NULL,
+    assumes unit weights.
+
+    The rows are processed in groups of four, as rank-4 updates of {A} and {B},
+    so that each element of {A} and {B} is read and written only once for
+    every four data rows.  The inner loops run over consecutive elements and
+    can be vectorized by the compiler. */
+
 #endif
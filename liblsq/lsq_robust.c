@@ -1,5 +1,5 @@
 /* See {lsq_robust.h} */
-/* Last edited on 2019-12-18 16:07:59 by jstolfi */
+/* Last edited on 2026-10-19 12:56:51 by jstolfi */
 
 #define lsq_robust_C_COPYRIGHT \
   "Copyright © 2014  by the State University of Campinas (UNICAMP)"
@@ -44,14 +44,27 @@ void lsq_robust_fit
     double *B = rn_alloc(nx); /* Right-hand side. */
 
     /* Compute the system matrices {A,B}: */
-    lsq_array_compute_matrix(nt, nx, X, W, A);
-
-    /* The matrix does not change: */
-    rmxn_inv_full(nx, A, A);
+    lsq_array_compute_matrix_and_rhs(nt, nx, nf, X, F, W, A, B, 1);
+
+    /* The matrix does not change, so factor it only once: */
+    double *L = rmxn_alloc(nx,nx); /* Cholesky factor of {A}, or inverse of {A}. */
+    bool_t chol = lsq_robust_cholesky(nx, A, L);
+    if (! chol) { rmxn_inv_full(nx, A, L); }
+    
+    auto void solve(void);
+      /* Sets {U} to the solution of {A U = B}, using the factor or inverse {L}. */
+    
+    void solve(void)
+      { if (chol)
+          { rmxn_LT_inv_map_col(nx, L, B, B);
+            rmxn_LT_inv_map_row(nx, B, L, U);
+          }
+        else
+          { rmxn_map_col(nx, nx, L, B, U); }
+      }
 
     /* Solve first without correction: */
-    lsq_array_compute_rhs(nt, nx, nf, X, F, W, B);
-    rmxn_map_col(nx, nx, A, B, U);
+    solve();
     if (report != NULL) { report(0, nt, nx, NULL, F, U); }
 
     if (maxiter > 0)
@@ -106,13 +119,37 @@ void lsq_robust_fit
 
             /* Recompute coeffs using {Fc} instead of {F}: */
             lsq_array_compute_rhs(nt, nx, nf, X, Fc, W, B);
-            rmxn_map_col(nx, nx, A, B, U);
+            solve();
             if (report != NULL) { report(iter, nt, nx, Pc, Fc, U); }
           }
         free(Fa);
         free(Fc);
         if (Pc != P) { free(Pc); }
       }
+    free(L);
+    free(B);
+    free(A);
+  }
+
+bool_t lsq_robust_cholesky(int32_t nx, double A[], double L[])
+  {
+    for (int32_t i = 0; i < nx; i++)
+      { double *Li = &(L[i*nx]);
+        for (int32_t j = 0; j <= i; j++)
+          { double *Lj = &(L[j*nx]);
+            double sum = A[i*nx + j];
+            for (int32_t k = 0; k < j; k++) { sum -= Li[k]*Lj[k]; }
+            if (j < i)
+              { Li[j] = sum/Lj[j]; }
+            else
+              { /* Fail if the pivot is not safely positive: */
+                if ((! (sum > 1.0e-14*fabs(A[i*nx + i]))) || (! isfinite(sum))) { return FALSE; }
+                Li[i] = sqrt(sum);
+              }
+          }
+        for (int32_t j = i+1; j < nx; j++) { Li[j] = 0.0; }
+      }
+    return TRUE;
   }
 
 void lsq_robust_compute_stats
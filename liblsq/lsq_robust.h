@@ -2,7 +2,7 @@
 #define lsq_robust_H
 
 /* Fits a linear map of {R^nx} to {R} to samples by least squares, ignoring outliers. */
-/* Last edited on 2019-12-18 16:06:46 by jstolfi */
+/* Last edited on 2026-10-19 11:36:32 by jstolfi */
 
 #define lsq_robust_H_COPYRIGHT \
   "Copyright © 2014  by the State University of Campinas (UNICAMP)"
@@ -89,6 +89,19 @@ void lsq_robust_fit
 
 /* AUXILIARY PROCEDURES */
 
+bool_t lsq_robust_cholesky(int32_t nx, double A[], double L[]);
+  /* Tries to factor the symmetric {nx  nx} matrix {A} as {L*L'}, where
+    {L} is lower triangular and {L'} is its transpose. Returns {TRUE}
+    if successful. Returns {FALSE} if {A} is not positive definite, or
+    is too close to singular for the factorization to be reliable; in
+    that case the contents of {L} are garbage. The matrix {L} must be
+    distinct from {A}.
+    
+    Used by {lsq_robust_fit} to factor the moment matrix, which is the same 
+    in all iterations, once only. Then each iteration needs only two
+    triangular solves, each with cost {O(nx^2)}. If the factorization fails,
+    {lsq_robust_fit} uses the explicit inverse of the matrix instead. */
+
 void lsq_robust_compute_stats
   ( int32_t nt,
     double Y[],   /* Values to analyze (residuals or function samples, {nt} elements). */
@@ -1,5 +1,5 @@
 /* See {r2_opt.h}. */
-/* Last edited on 2017-06-11 20:39:10 by stolfilocal */
+/* Last edited on 2026-10-19 12:49:50 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <math.h>
@@ -8,6 +8,9 @@
 #include <string.h>
 #include <limits.h>
 #include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
  
  
 #include <bool.h>
@@ -17,17 +20,33 @@
 #include <jsmath.h>
 #include <affirm.h>
 #include <wt_table.h>
+#include <jsthread.h>
 
 #include <sve_minn.h>
 
 #include <r2_opt.h>
 
+#define r2_opt_ENUM_BATCH 64
+  /* Number of candidates evaluated in each parallel batch, per thread. */
+
+typedef struct r2_opt_batch_t
+  { int ni;                  /* Number of points per candidate. */
+    i2_t iscale;             /* Object scaling exponent. */
+    r2_opt_goal_func_t *f2;  /* Goal function. */
+    r2_t *P;                 /* Candidate {b} is {P[b*ni..b*ni+ni-1]}. */
+    double *F;               /* {F[b]} is the goal function value of candidate {b}. */
+  } r2_opt_batch_t;
+  /* A batch of candidate point vectors to be evaluated in parallel. */
+
 /* INTERNAL PROTOTYPES */
 
 bool_t r2_opt_coord_is_variable(double arij, double asij);
   /* Returns {TRUE} iff a coordinate with search radius {arij}
     and search step {asij} is variable; {FALSE} if it is fixed. */
 
+void r2_opt_eval_batch(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Evaluates the goal function at candidates {ini..fin} of the batch {arg}. */
+
 /* IMPLEMENTATIONS */
 
 void r2_opt_single_scale_enum
@@ -38,7 +57,8 @@ void r2_opt_single_scale_enum
     r2_t astp[],              /* Adjustment step for each point. */
     r2_t p[],                 /* (IN/OUT) Corresponding points in each object. */
     double *f2p,              /* (OUT) Goal function value at the best solution. */
-    bool_t debug              /* Prints diagnostics if true. */
+    bool_t debug,             /* Prints diagnostics if true. */
+    int nth                   /* Number of threads to use. */
   )
   {
     if (debug) { fprintf(stderr, ">> enter %s >>\n", __FUNCTION__); }
@@ -73,35 +93,55 @@ void r2_opt_single_scale_enum
       }
     if (debug) { fprintf(stderr, "%d coordinates (%d variable)\n", nc, nv); }
     
-    /* Enumerate all valid vectors {v[0..nc-1]}: */
+    /* Enumerate all valid vectors {v[0..nc-1]}, in batches of up to {nb} candidates: */
+    int nb = r2_opt_ENUM_BATCH*jsthread_choose_count(nth, INT32_MAX);
+    r2_opt_batch_t job = (r2_opt_batch_t){ .ni = ni, .iscale = iscale, .f2 = f2 };
+    job.P = notnull(malloc(nb*ni*sizeof(r2_t)), "no mem");
+    job.F = notnull(malloc(nb*sizeof(double)), "no mem");
     (*f2p) = +INF;   /* Minimum mismatch found so far. */
-    r2_t pv[nc];     /* Trial alignment vector. */
-    while (TRUE) 
-      { /* Compute {pv} from {v}: */
-        for (int i = 0; i < ni; i++)
-          { for (int j = 0; j < 2; j++)
-              { int k = 2*i + j;
-                pv[i].c[j] = p0[i].c[j] + v[k]*astp[i].c[j];
+    bool_t done = FALSE;
+    while (! done) 
+      { /* Collect the next batch of candidates, in enumeration order: */
+        int nbv = 0;
+        while ((nbv < nb) && (! done))
+          { /* Compute the candidate {pv} from {v}: */
+            r2_t *pv = &(job.P[nbv*ni]);
+            for (int i = 0; i < ni; i++)
+              { for (int j = 0; j < 2; j++)
+                  { int k = 2*i + j;
+                    pv[i].c[j] = p0[i].c[j] + v[k]*astp[i].c[j];
+                  }
               }
+            nbv++;
+            /* Increment the next {v[k]} that can be incremented, reset previous ones to min: */
+            int k = 0;
+            while ((k < nc) && (v[k] >= r[k])) { v[k] = -r[k]; k++; }
+            if (k >= nc) { done = TRUE; } else { v[k]++; }
           }
-        /* Evaluate the function at {pv}: */
-        double f2v = f2(ni,pv,iscale);
-        if (f2v < (*f2p))
-          { /* Update the current optimum: */
-            if (debug) { fprintf(stderr, "found better solution f2 = %24.15e\n", f2v); }
-            for (int i = 0; i < ni; i++) { p[i] = pv[i]; }
-            (*f2p) = f2v;
+        /* Evaluate the function at the candidates: */
+        jsthread_run_ranges(nbv, 1, nth, &r2_opt_eval_batch, &job);
+        /* Update the current optimum, scanning the candidates in enumeration order: */
+        for (int b = 0; b < nbv; b++)
+          { double f2v = job.F[b];
+            if (f2v < (*f2p))
+              { if (debug) { fprintf(stderr, "found better solution f2 = %24.15e\n", f2v); }
+                for (int i = 0; i < ni; i++) { p[i] = job.P[b*ni + i]; }
+                (*f2p) = f2v;
+              }
           }
-        /* Increment the next {v[k]} that can be incremented, reset previous ones to min: */
-        { int k = 0;
-          while ((k < nc) && (v[k] >= r[k])) { v[k] = -r[k]; k++; }
-          if (k >= nc){ /* Done: */ return; }
-          v[k]++;
-        }
       }
+    free(job.P);
+    free(job.F);
     if (debug) { fprintf(stderr, "<< leave %s <<\n", __FUNCTION__); }
   }
 
+void r2_opt_eval_batch(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    r2_opt_batch_t *job = (r2_opt_batch_t *)arg;
+    for (int b = ini; b <= fin; b++)
+      { job->F[b] = job->f2(job->ni, &(job->P[b*job->ni]), job->iscale); }
+  }
+
 void r2_opt_single_scale_quadopt
   ( int ni,                   /* Number of points to optimize. */
     i2_t iscale,              /* Object scaling exponent along each axis. */  
@@ -110,7 +150,8 @@ void r2_opt_single_scale_quadopt
     r2_t astp[],              /* Desired adjustment precision for each point. */
     r2_t p[],                 /* (IN) Initial guesses; (OUT) Best solution. */
     double *f2p,              /* (OUT) Goal function value at the best solution. */
-    bool_t debug              /* Prints diagnostics if true. */
+    bool_t debug,             /* Prints diagnostics if true. */
+    int nth                   /* Number of threads to use. */
   )
   {
     if (debug) { fprintf(stderr, ">> enter %s >>\n", __FUNCTION__); }
@@ -156,12 +197,15 @@ void r2_opt_single_scale_quadopt
 
         auto double f2_for_sve(int nx, double x[]);
           /* Computes the minimization goal function from the given argument {x[0..nv-1]}.
-            Expects {nx == nv}. Also sets {p[0..ni-1]} from {x[0..nx-1]}. */
+            Expects {nx == nv}. May be called by several threads at once. */
+
+        /* Remember the goal values, since {sve_minn_iterate_par} may revisit points: */
+        sve_cache_t *C = sve_cache_new(nv, 0.0, 1024);
 
         /* Compute the initial goal function value: */
         double z[nv];
         points_to_vars(p, z);
-        double Fz = f2_for_sve(nv, z);
+        double Fz = sve_cache_eval(C, &f2_for_sve, z);
         
         /* Optimize: */
         sign_t dir = -1; /* Look for minimum. */
@@ -172,14 +216,16 @@ void r2_opt_single_scale_quadopt
         double rMin = fmin(tol, 0.25);   /* Minimum probe simplex radius. */
         double rMax = 0.70;   /* Maximum probe simplex radius. */
         double stop = 0.25*tol; /* Stop when {x} moves less than this. */
-        sve_minn_iterate
+        sve_minn_iterate_par
           ( nv, 
             &f2_for_sve, NULL, 
             z, &Fz,
             dir, dMax, dBox, rIni, rMin, rMax, stop,
             maxIters,
-            debug
+            debug,
+            nth, C
           );
+        sve_cache_free(C);
 
         /* Return the optimal vector: */
         vars_to_points(z, p);
@@ -220,10 +266,12 @@ void r2_opt_single_scale_quadopt
 
         double f2_for_sve(int nx, double x[])
           { assert(nx == nv);
-            /* Convert variables {x[0..nx-1]} to displacements {p[0..ni-1]}: */
-            vars_to_points(x, p);
+            /* Convert variables {x[0..nx-1]} to a private candidate {q[0..ni-1]}: */
+            r2_t q[ni];
+            for (int i = 0; i < ni; i++) { q[i] = p0[i]; }
+            vars_to_points(x, q);
             /* Evaluate the client function: */
-            double Q2 = f2(ni, p, iscale);
+            double Q2 = f2(ni, q, iscale);
             return Q2;
           }
 
@@ -245,7 +293,8 @@ void r2_opt_multi_scale
     r2_t astp[],             /* Adjustment step or desired precision for each point. */
     r2_t p[],                /* (IN) Initial guesses; (OUT) Best solution. */
     double *f2p,             /* (OUT) Goal function value at the best solution. */
-    bool_t debug              /* Prints diagnostics if true. */
+    bool_t debug,            /* Prints diagnostics if true. */
+    int nth                  /* Number of threads to use. */
   )
   {
     if (debug) { fprintf(stderr, ">> enter %s >>\n", __FUNCTION__); }
@@ -315,9 +364,9 @@ void r2_opt_multi_scale
           
             /* Solve the problem at scale {iscale}: */
             if (quadopt)
-              { r2_opt_single_scale_quadopt(ni, iscale, f2, rad, stp, p, f2p, debug); }
+              { r2_opt_single_scale_quadopt(ni, iscale, f2, rad, stp, p, f2p, debug, nth); }
             else
-              { r2_opt_single_scale_enum(ni, iscale, f2, rad, stp, p, f2p, debug); }
+              { r2_opt_single_scale_enum(ni, iscale, f2, rad, stp, p, f2p, debug, nth); }
 
             /* Are we done? */
             if ((iscale.c[0] == 0) && (iscale.c[1] == 0)) { break; }
@@ -340,7 +389,7 @@ void r2_opt_multi_scale
                     double arij = arad[i].c[j];
                     double asij = astp[i].c[j];
                     if (r2_opt_coord_is_variable(arij, asij))
-                      { stp[i].c[j] = 1.0001*arij; }
+                      { stp[i].c[j] = 1.0001*arij; nv1++; }
                     else
                       { stp[i].c[j] = 0.0; }
                   }
@@ -357,6 +406,7 @@ void r2_opt_multi_scale
                     double asij = astp[i].c[j];
                     if (r2_opt_coord_is_variable(arij, asij))
                       { /* The search radius in principle is the previous step: */
+                        nv1++;
                         assert(stp[i].c[j] > 0.0);
                         /* Compute the new search region, clip to the original search region: */
                         double pij = p[i].c[j]; /* Current candidate. */
@@ -2,7 +2,7 @@
 #define r2_opt_H
 
 /* Tools for optimizing a vector of points on the plane. */
-/* Last edited on 2017-06-06 21:40:27 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:49:50 by stolfilocal */ 
 
 #include <bool.h>
 #include <r2.h>
@@ -48,7 +48,12 @@ typedef double r2_opt_goal_func_t(int ni, r2_t p[], i2_t iscale);
   {arad[i].c[j]} is zero or less than {astp[i].c[j]}, the coordinate
   {p[i].c[j]} is considered fixed, and not changed.
 
-  The value of {f2(ni,p,iscale)} is returned on {*f2p}. */
+  The value of {f2(ni,p,iscale)} is returned on {*f2p}.
+  
+  The goal function is evaluated by {nth} threads in parallel (one per
+  processor if {nth} is zero).  If {nth} is not 1, {f2} must be safe to
+  call concurrently from different threads.  The result does not depend
+  on {nth}, as long as {f2} itself does not. */
 
     
 void r2_opt_single_scale_enum
@@ -59,7 +64,8 @@ void r2_opt_single_scale_enum
     r2_t astp[],              /* Adjustment step for each point. */
     r2_t p[],                 /* (IN/OUT) Corresponding points in each object. */
     double *f2p,              /* (OUT) Goal function value at the best solution. */
-    bool_t debug              /* Prints diagnostics if true. */
+    bool_t debug,             /* Prints diagnostics if true. */
+    int nth                   /* Number of threads to use. */
   );
   /* Adjusts a point vector {p[0..ni-1]} so as to minimize the goal
     function function {f2(ni,p,iscale)}. Uses exhaustive enumeration of
@@ -73,7 +79,8 @@ void r2_opt_single_scale_quadopt
     r2_t astp[],              /* Desired adjustment precision for each point. */
     r2_t p[],                 /* (IN) Initial guesses; (OUT) Best solution. */
     double *f2p,              /* (OUT) Goal function value at the best solution. */
-    bool_t debug              /* Prints diagnostics if true. */
+    bool_t debug,             /* Prints diagnostics if true. */
+    int nth                   /* Number of threads to use. */
   );
   /* Adjusts a point vector {p[0..ni-1]} so as to minimize the goal
     function function {f2(ni,p,iscale)}. Uses iterated quadratic
@@ -91,7 +98,8 @@ void r2_opt_multi_scale
     r2_t astp[],             /* Adjustment step or desired precision for each point. */
     r2_t p[],                /* (IN) Initial guesses; (OUT) Best solution. */
     double *f2p,              /* (OUT) Goal function value at the best solution. */
-    bool_t debug              /* Prints diagnostics if true. */
+    bool_t debug,             /* Prints diagnostics if true. */
+    int nth                   /* Number of threads to use. */
   );
   /* Adjusts a point vector {p[0..ni-1]} so as to minimize the goal
     function function {f2(ni,p,(0,0))}. Uses a multiscale point vector
@@ -1,9 +1,12 @@
 /* See {sve_minn.h} */
-/* Last edited on 2017-03-16 21:33:30 by stolfilocal */
+/* Last edited on 2026-10-19 11:55:53 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <math.h>
 #include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
 
 #include <gauss_elim.h>
 #include <bool.h>
@@ -12,6 +15,7 @@
 #include <jsmath.h>
 #include <rmxn.h>
 #include <rmxn_extra.h>
+#include <jsthread.h>
 
 #include <sve_minn.h>
 
@@ -73,6 +77,29 @@ int sve_take_step
     {y}, 1 if it is one of the probe point, and 2 if it is the
     original center itself (i.e. if the step failed altogether). */
 
+typedef struct sve_sample_job_t
+  { int n;         /* Number of arguments of {F}. */
+    sve_goal_t *F; /* The goal function. */
+    double *v;     /* The simplex vertices, by rows. */
+    int *ci;       /* The node {r} to evaluate is the midpoint of corners {ci[r]} */
+    int *cj;       /* and {cj[r]} of the simplex. */
+    double *Fv;    /* The node values. */
+  } sve_sample_job_t;
+  /* Arguments of {sve_sample_function_par} for the threads. */
+
+void sve_sample_nodes(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Evaluates the goal function at the nodes {ini..fin} listed in {job}, where
+    {job} is the {sve_sample_job_t} record {*arg}. */
+
+void sve_get_node(int n, double v[], int i, int j, double x[]);
+  /* Sets {x[0..n-1]} to the midpoint of simplex corners {i,j}. */
+
+void sve_cache_get_key(sve_cache_t *C, double x[], int64_t key[]);
+  /* Computes the quantized key {key[0..C.n-1]} of the point {x[0..C.n-1]}. */
+
+int sve_cache_slot(sve_cache_t *C, int64_t key[]);
+  /* Returns the slot of {C} that may hold the key {key[0..C.n-1]}. */
+
 void sve_print_probes(FILE *wr, int nv, int n, double v[], int nf, double Fv[]);
   /* Prints the probe values {Fv[0..nf-1]} and the probe points.
     Assumes that {v[0..nv*n-1]} are the coordinates of the vertices,
@@ -116,21 +143,140 @@ void sve_minn_step(int n, double Fv[], double cm[])
   }
 
 void sve_sample_function(int n, sve_goal_t *F, double v[], double Fv[])
-  { double x[n];
-    int nv = n + 1;
+  { sve_sample_function_par(n, F, v, Fv, 1, NULL); }
+
+void sve_sample_function_par(int n, sve_goal_t *F, double v[], double Fv[], int nth, sve_cache_t *C)
+  { int nv = n + 1;
+    int nf = nv*(nv+1)/2;
+    if (C != NULL) { demand(C->n == n, "cache has wrong dimension"); }
+
+    /* Collect the corners {ci[r],cj[r]} of the nodes that must be evaluated: */
+    int ci[nf], cj[nf];
+    int ne = 0;
+    double x[n];
     for (int i = 0; i < nv; i++)
       { for (int j = 0; j <= i; j++)
-          { /* Set {x[0..n-1]} to the midpoint of simplex corners {i,j}: */
-            double *vi = &(v[i*n]);
-            double *vj = &(v[j*n]);
-            for (int k = 0; k < n; k++) { x[k] = (vi[k] + vj[k])/2; }
-            /* Get the function's value {F(x)} at {x}, store {F(x)} into {Fv}: */
-            int ij = i*(i+1)/2 + j;
-            Fv[ij] = F(n, x);
+          { if (C != NULL)
+              { sve_get_node(n, v, i, j, x);
+                int ij = i*(i+1)/2 + j;
+                if (sve_cache_get(C, x, &(Fv[ij]))) { continue; }
+              }
+            ci[ne] = i; cj[ne] = j; ne++;
+          }
+      }
+
+    /* Evaluate them: */
+    sve_sample_job_t job = (sve_sample_job_t){ .n = n, .F = F, .v = v, .ci = ci, .cj = cj, .Fv = Fv };
+    jsthread_run_ranges(ne, 1, nth, &sve_sample_nodes, &job);
+
+    /* Save the new values in the cache: */
+    if (C != NULL)
+      { for (int r = 0; r < ne; r++)
+          { int i = ci[r], j = cj[r];
+            sve_get_node(n, v, i, j, x);
+            sve_cache_put(C, x, Fv[i*(i+1)/2 + j]);
           }
       }
   }
 
+void sve_get_node(int n, double v[], int i, int j, double x[])
+  { double *vi = &(v[i*n]);
+    double *vj = &(v[j*n]);
+    for (int k = 0; k < n; k++) { x[k] = (vi[k] + vj[k])/2; }
+  }
+
+void sve_sample_nodes(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  { sve_sample_job_t *job = (sve_sample_job_t *)arg;
+    int n = job->n;
+    double x[n];
+    for (int r = ini; r <= fin; r++)
+      { int i = job->ci[r], j = job->cj[r];
+        sve_get_node(n, job->v, i, j, x);
+        job->Fv[i*(i+1)/2 + j] = job->F(n, x);
+      }
+  }
+
+sve_cache_t *sve_cache_new(int n, double quantum, int size)
+  { demand(n >= 0, "invalid dimension");
+    demand(quantum >= 0, "invalid quantum");
+    demand(size > 0, "invalid cache size");
+    sve_cache_t *C = notnull(malloc(sizeof(sve_cache_t)), "no mem");
+    C->n = n;
+    C->quantum = quantum;
+    C->size = size;
+    C->key = notnull(malloc((size*n + 1)*sizeof(int64_t)), "no mem");
+    C->val = notnull(malloc(size*sizeof(double)), "no mem");
+    C->used = notnull(malloc(size*sizeof(bool_t)), "no mem");
+    for (int s = 0; s < size; s++) { C->used[s] = FALSE; }
+    C->nHits = 0;
+    C->nMisses = 0;
+    return C;
+  }
+
+void sve_cache_get_key(sve_cache_t *C, double x[], int64_t key[])
+  { for (int k = 0; k < C->n; k++)
+      { double xk = x[k];
+        if (C->quantum > 0)
+          { key[k] = (int64_t)llround(xk/C->quantum); }
+        else
+          { if (xk == 0) { xk = 0.0; } /* Make {-0.0} the same as {+0.0}. */
+            memcpy(&(key[k]), &xk, sizeof(int64_t));
+          }
+      }
+  }
+
+int sve_cache_slot(sve_cache_t *C, int64_t key[])
+  { uint64_t h = 1469598103934665603ULL;
+    for (int k = 0; k < C->n; k++)
+      { h ^= (uint64_t)key[k];
+        h *= 1099511628211ULL;
+        h ^= (h >> 29);
+      }
+    return (int)(h % (uint64_t)C->size);
+  }
+
+bool_t sve_cache_get(sve_cache_t *C, double x[], double *FxP)
+  { int n = C->n;
+    int64_t key[n+1];
+    sve_cache_get_key(C, x, key);
+    int s = sve_cache_slot(C, key);
+    if (C->used[s])
+      { int64_t *ks = &(C->key[s*n]);
+        int k = 0;
+        while ((k < n) && (ks[k] == key[k])) { k++; }
+        if (k == n) { (*FxP) = C->val[s]; C->nHits++; return TRUE; }
+      }
+    C->nMisses++;
+    return FALSE;
+  }
+
+void sve_cache_put(sve_cache_t *C, double x[], double Fx)
+  { int n = C->n;
+    int64_t key[n+1];
+    sve_cache_get_key(C, x, key);
+    int s = sve_cache_slot(C, key);
+    int64_t *ks = &(C->key[s*n]);
+    for (int k = 0; k < n; k++) { ks[k] = key[k]; }
+    C->val[s] = Fx;
+    C->used[s] = TRUE;
+  }
+
+double sve_cache_eval(sve_cache_t *C, sve_goal_t *F, double x[])
+  { double Fx;
+    if (! sve_cache_get(C, x, &Fx))
+      { Fx = F(C->n, x);
+        sve_cache_put(C, x, Fx);
+      }
+    return Fx;
+  }
+
+void sve_cache_free(sve_cache_t *C)
+  { free(C->key);
+    free(C->val);
+    free(C->used);
+    free(C);
+  }
+
 void sve_minn_iterate
   ( int n, 
     sve_goal_t *F, 
@@ -147,6 +293,30 @@ void sve_minn_iterate
     int maxIters,
     bool_t debug
   )
+  { sve_minn_iterate_par
+      ( n, F, OK, x, FxP, dir, dMax, dBox, rIni, rMin, rMax, 
+        stop, maxIters, debug, 1, NULL
+      );
+  }
+
+void sve_minn_iterate_par
+  ( int n, 
+    sve_goal_t *F, 
+    sve_pred_t *OK,
+    double x[],
+    double *FxP,
+    sign_t dir, 
+    double dMax,
+    bool_t dBox,
+    double rIni,
+    double rMin, 
+    double rMax,
+    double stop,
+    int maxIters,
+    bool_t debug,
+    int nth,
+    sve_cache_t *C
+  )
   { 
     if (debug) { Pr(Er, ">> enter %s >>\n", __FUNCTION__); }
     bool_t debug_probes = FALSE;     /* TRUE to print probe points & values. */
@@ -248,7 +418,7 @@ void sve_minn_iterate
             rmxn_gen_print(Er, nv, n, v, "%20.16f", "", "\n", "", "    [ ", " ", " ]");
             Pr(Er, "\n");
           } 
-        sve_sample_function(n, F, v, Fv);
+        sve_sample_function_par(n, F, v, Fv, nth, C);
         if (debug && debug_probes)
           { /* Print the probe points and values: */
             Pr(Er, "    probe values and points:\n");
@@ -274,7 +444,7 @@ void sve_minn_iterate
             sve_clip_candidate(n, y, x0, dMax, dBox, debug);
           }
         /* Evaluate at new point: */
-        double Fy = F(n, y);
+        double Fy = (C == NULL ? F(n, y) : sve_cache_eval(C, F, y));
         nEvals++;
         if (debug) 
           { Pr(Er, "    clipped y = \n");
@@ -2,7 +2,7 @@
 #define sve_minn_H
 
 /* Quadratic minimzation by the simplex vertex-edge method. */
-/* Last edited on 2021-06-17 11:22:30 by jstolfi */
+/* Last edited on 2026-10-19 11:55:53 by jstolfi */
 
 /* SIMPLICES
 
@@ -34,6 +34,8 @@
   
   The number of such /nodes/ is {K(n) = (n+1)*(n+2)/2}. */
 
+#include <stdint.h>
+
 #include <bool.h>
 #include <sign.h>
 
@@ -62,6 +64,62 @@ void sve_sample_function(int n, sve_goal_t *F, double v[], double Fv[]);
     More precisely, sets {Fv[i*(i+1)/2+j]} to {F(V(i,j))} for all
     {i,j} such that {0 <= j <= i <= n}. */
 
+/* EVALUATION CACHE
+
+  When the goal function is expensive, it may be worth remembering
+  the values computed at recent points, so that the function is not
+  evaluated twice at the same point. */
+
+typedef struct sve_cache_t
+  { int n;           /* Number of arguments of the goal function. */
+    double quantum;  /* Quantization step of arguments. */
+    int size;        /* Number of slots. */
+    int64_t *key;    /* {key[s*n..s*n+n-1]} is the quantized argument of slot {s}. */
+    double *val;     /* {val[s]} is the function value stored in slot {s}. */
+    bool_t *used;    /* {used[s]} is TRUE if slot {s} holds a value. */
+    int nHits;       /* Number of lookups that found a value. */
+    int nMisses;     /* Number of lookups that did not. */
+  } sve_cache_t;
+  /* A memo table for the values of an {n}-argument goal function. 
+  
+    Each argument vector {x[0..n-1]} is reduced to an integer key 
+    vector by rounding each coordinate {x[k]} to the nearest integer 
+    multiple of {quantum}; or, if {quantum} is zero, by taking the 
+    bits of {x[k]}, so that only identical vectors match. Two points 
+    with the same key are considered the same point.  
+    
+    The table has {size} slots, and each key can be stored only in the
+    slot selected by its hash value; a new entry replaces any older
+    one in the same slot. */
+
+sve_cache_t *sve_cache_new(int n, double quantum, int size);
+  /* Creates an empty cache with {size} slots for a goal function
+    with {n} arguments. The {quantum} should be zero, or much smaller
+    than the precision desired in the minimization. */
+
+bool_t sve_cache_get(sve_cache_t *C, double x[], double *FxP);
+  /* If the cache {C} has a value for the point {x[0..C.n-1]}, stores it
+    into {*FxP} and returns TRUE.  Otherwise returns FALSE. */
+
+void sve_cache_put(sve_cache_t *C, double x[], double Fx);
+  /* Stores into {C} the value {Fx} for the point {x[0..C.n-1]}. */
+
+double sve_cache_eval(sve_cache_t *C, sve_goal_t *F, double x[]);
+  /* Returns the value of {F(C.n,x)}, from the cache {C} if possible; 
+    otherwise evaluates {F} and stores the result into {C}. */
+
+void sve_cache_free(sve_cache_t *C);
+  /* Reclaims all storage used by {C}, including the record {*C}. */
+
+void sve_sample_function_par(int n, sve_goal_t *F, double v[], double Fv[], int nth, sve_cache_t *C);
+  /* Same as {sve_sample_function}, but the nodes of the simplex are
+    evaluated in parallel, by {nth} threads (one per processor if {nth}
+    is zero).  If {C} is not NULL, nodes whose value is in {C} are not
+    evaluated again, and the other values are stored into {C}.
+    
+    If {nth} is not 1, the function {F} must be safe to call concurrently
+    from different threads. */
+
 typedef bool_t sve_pred_t(int n, double x[], double Fx);
   /* The type of a procedure that can be provided as argument to
     {sve_minn_iterate} below. It should check the current solution
@@ -120,6 +178,30 @@ void sve_minn_iterate
     
     If {debug} is TRUE, the procedure prints various diagnostic messages. */
 
+void sve_minn_iterate_par
+  ( int n, 
+    sve_goal_t *F, 
+    sve_pred_t *OK,
+    double x[],
+    double *FxP,
+    sign_t dir,
+    double dMax,
+    bool_t dBox,
+    double rIni,
+    double rMin, 
+    double rMax,
+    double stop,
+    int maxIters,
+    bool_t debug,
+    int nth,
+    sve_cache_t *C
+  );
+  /* Same as {sve_minn_iterate}, but the goal function values at the
+    probe simplex nodes are computed with {sve_sample_function_par},
+    with the given {nth} and {C}.  The cache {C}, if not NULL, is used
+    also for the other evaluations of {F}.  With {nth = 1} and 
+    {C = NULL}, the result is the same as that of {sve_minn_iterate}. */
+
 /* LIMITS */
 
 #define sve_minn_MIN_RADIUS (1.0e-100)
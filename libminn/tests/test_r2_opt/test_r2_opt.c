@@ -2,7 +2,7 @@
 #define PROG_DESC "test of {r2_opt.h}"
 #define PROG_VERS "1.0"
 
-/* Last edited on 2017-06-22 18:12:31 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:49:50 by stolfilocal */ 
 /* Created on 2007-07-11 by J. Stolfi, UNICAMP */
 
 #define tr2o_COPYRIGHT \
@@ -362,16 +362,16 @@ void tr2o_do_one_test
     if (monoscale)
       { if (quadopt)
           { fprintf(stderr, " (single_scale_quadopt)...\n");
-            r2_opt_single_scale_quadopt(NI, iscale, f2_full, arad, astp, psol, &f2sol, debug_opt);
+            r2_opt_single_scale_quadopt(NI, iscale, f2_full, arad, astp, psol, &f2sol, debug_opt, 1);
           }
         else
           { fprintf(stderr, " (single_scale_enum)...\n");
-            r2_opt_single_scale_enum(NI, iscale, f2_full, arad, astp, psol, &f2sol, debug_opt);
+            r2_opt_single_scale_enum(NI, iscale, f2_full, arad, astp, psol, &f2sol, debug_opt, 1);
           }
       }
     else
       { fprintf(stderr, " (multi_scale)...\n");
-        r2_opt_multi_scale(NI, f2_full, quadopt, arad, astp, psol, &f2sol, debug_opt);
+        r2_opt_multi_scale(NI, f2_full, quadopt, arad, astp, psol, &f2sol, debug_opt, 1);
       }
     fprintf(stderr, "done optimizing.\n");
     fprintf(stderr, "%d calls to {f2_full}.\n", nf2);
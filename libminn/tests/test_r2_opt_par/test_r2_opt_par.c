@@ -0,0 +1,111 @@
+/* test_r2_opt_par --- checks that {r2_opt.h} gives the same results with any number of threads */
+/* Last edited on 2026-10-19 14:05:37 by stolfi */
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <bool.h>
+#include <r2.h>
+#include <i2.h>
+#include <affirm.h>
+#include <jsrandom.h>
+
+#include <r2_opt.h>
+
+#define MAX_NI 3
+  /* Max number of points to optimize. */
+
+/* INTERNAL PROTOTYPES */
+
+int main (int argc, char **argv);
+
+void test_r2_opt_par(int ni, int method, int trial);
+  /* Optimizes a test goal function of {ni} points with {nth=1} and 
+    with several values of {nth>1}, and checks that the results are
+    identical.  Uses {r2_opt_single_scale_enum} if {method} is 0,
+    {r2_opt_single_scale_quadopt} if {method} is 1, and 
+    {r2_opt_multi_scale} (enumerative and quadratic) if {method} is 2 or 3. */
+
+double test_goal(int ni, r2_t p[], i2_t iscale);
+  /* A goal function with minimum near {tgt[0..ni-1]}, with 
+    some ripples that get smoother at coarser scales. */
+
+r2_t tgt[MAX_NI];
+  /* Approximate optimum point vector of {test_goal}. */
+
+/* IMPLEMENTATIONS */
+
+int main (int argc, char **argv)
+  { 
+    for (int trial = 0; trial < 12; trial++) 
+      { int ni = 1 + trial % MAX_NI;
+        int method = trial % 4;
+        test_r2_opt_par(ni, method, trial);
+      }
+    fprintf(stderr, "done.\n");
+    return 0;
+  }
+
+void test_r2_opt_par(int ni, int method, int trial)
+  { 
+    fprintf(stderr, "trial %d: ni = %d method = %d\n", trial, ni, method);
+    srandom(4615 + 2*trial);
+    
+    /* Choose the target, the search radii and steps: */
+    r2_t arad[ni], astp[ni], pini[ni];
+    for (int i = 0; i < ni; i++)
+      { for (int j = 0; j < 2; j++)
+          { pini[i].c[j] = 10.0*dabrandom(-1.0, +1.0);
+            arad[i].c[j] = ((i == 1) && (j == 0) ? 0.0 : (method >= 2 ? 8.0 : 2.0));
+            astp[i].c[j] = (method >= 2 ? 0.5 : 0.25);
+            tgt[i].c[j] = pini[i].c[j] + dabrandom(-0.8, +0.8)*arad[i].c[j];
+          }
+      }
+    i2_t iscale = (i2_t){{ 0, 0 }};
+
+    /* Solve with {nth=1}, then with other {nth}: */
+    r2_t pref[ni]; 
+    double fref = NAN;
+    int nths[] = { 1, 2, 3, 5, 0 };
+    for (int k = 0; k < 5; k++)
+      { int nth = nths[k];
+        r2_t p[ni];
+        for (int i = 0; i < ni; i++) { p[i] = pini[i]; }
+        double f2p;
+        srandom(1665 + 2*trial);
+        switch(method)
+          { case 0: r2_opt_single_scale_enum(ni, iscale, &test_goal, arad, astp, p, &f2p, FALSE, nth); break;
+            case 1: r2_opt_single_scale_quadopt(ni, iscale, &test_goal, arad, astp, p, &f2p, FALSE, nth); break;
+            case 2: r2_opt_multi_scale(ni, &test_goal, FALSE, arad, astp, p, &f2p, FALSE, nth); break;
+            case 3: r2_opt_multi_scale(ni, &test_goal, TRUE, arad, astp, p, &f2p, FALSE, nth); break;
+            default: assert(FALSE);
+          }
+        demand(isfinite(f2p), "goal function value not finite");
+        demand(f2p == test_goal(ni, p, iscale), "returned value does not match the returned point");
+        if (k == 0)
+          { for (int i = 0; i < ni; i++) { pref[i] = p[i]; }
+            fref = f2p;
+            fprintf(stderr, "  nth = 1 f2 = %24.16e\n", fref);
+          }
+        else
+          { demand(f2p == fref, "goal function value depends on {nth}");
+            for (int i = 0; i < ni; i++)
+              { demand(r2_eq(&(p[i]), &(pref[i])), "solution depends on {nth}"); }
+          }
+      }
+  }
+
+double test_goal(int ni, r2_t p[], i2_t iscale)
+  {
+    double amp = 0.05/(1 + iscale.c[0] + iscale.c[1]);
+    double sum = 0.0;
+    for (int i = 0; i < ni; i++)
+      { double dx = p[i].c[0] - tgt[i].c[0];
+        double dy = p[i].c[1] - tgt[i].c[1];
+        sum += dx*dx + 2*dy*dy + 0.5*dx*dy + amp*(1 - cos(7*dx)*cos(5*dy));
+      }
+    return sum;
+  }
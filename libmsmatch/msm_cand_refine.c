@@ -1,5 +1,5 @@
 /* See msm_cand_refine.h */
-/* Last edited on 2017-04-28 12:19:22 by stolfilocal */
+/* Last edited on 2026-10-19 12:20:05 by jstolfi */
 
 #define msm_refine_C_COPYRIGHT \
   "Copyright  2005  by the State University of Campinas (UNICAMP)" \
@@ -8,6 +8,8 @@
 #define _GNU_SOURCE
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
 
 #include <affirm.h>
@@ -55,39 +57,53 @@ void msm_cand_refine_fill_tableau
     The parameters {delta,kapa,expand,shrink,maxUnp} are explained
     under {msm_cand_refine}. */
 
-void msm_cand_refine_set_tableau_entry
-  ( int r, /* {R}-coordinate of entry. */
-    int s, /* {S}-coordinate of entry. */
-    msm_seq_desc_t *ap,
-    msm_seq_desc_t *bp,
-    msm_pairing_t *prold,
-    int delta,
-    int kappa,
+msm_rung_t msm_cand_refine_step_origin(msm_rung_t g, int t);
+  /* Returns the origin rung {f} of the step of type {t} that ends at
+    rung {g}.  The step types are numbered as follows: type 0 means
+    that the pairing starts at {g}, and {f} is {msm_rung_none}; type 1
+    is the perfect step, {f = g - (1,1)}; and type {t = 2*unp + j},
+    for {unp} in {1..maxUnp} and {j} in {0..1}, is the atomic step
+    that leaves {unp} datums unpaired on side {j}, namely
+    {f.c[j] = g.c[j] - 1 - unp} and {f.c[1-j] = g.c[1-j] - 1}. */
+
+void msm_cand_refine_fill_diagonal
+  ( int r,                  /* {R}-coordinate of diagonal. */
+    msm_seq_desc_t *seq0,
+    msm_seq_desc_t *seq1,
     int maxUnp,             /* Maximum unpaired datums between rungs. */
     msm_rung_step_score_proc_t *step_score, 
     bool_t may_begin_here,
     bool_t may_end_here,
-    bool_t debug,           /* TRUE to print diagnostics. */
     msm_rung_t *goptp,      /* IN/OUT: the current best choice for the last rung of pairing. */   
-    double *voptp,          /* IN/OUT: score of that pairing, or {+INF}. */   
+    double *voptp,          /* IN/OUT: score of that pairing, or {-INF}. */   
     msm_dyn_tableau_t *tb,  /* WORK: dynamic programming tableau. */
-    int kp,                 /* Hint for index of rung in {prold} whose {R}-coord is {~r}. */
+    double vsel[],          /* WORK: best score for each entry of the diagonal. */
+    uint8_t tsel[],         /* WORK: type of the last step of the best path to each entry. */
     int *n_steps,           /* Number of examined steps (in,out). */
-    int *n_entries          /* Number of tableau entries that were computed. */
+    int *n_entries          /* Number of tableau entries that were computed (in,out). */
   );
-  /* Fills entry of {tb} corresponding to the rung {g} whose {R,S}
-    coordinates are {r,s}. Assumes that {g} is a valid rung for the tableau {tb},
-    given that that the two sequences are {ap,bp} and the old pairing is {prold}.
-    Unless said otherwise, the parameters have the same meanings as
-    for {msm_cand_refine_fill_tableau}.
+  /* Fills all entries of {tb} with {R}-coordinate {r}, whose
+    {S}-range must have been set already.  Assumes that the entries
+    of all earlier diagonals have been filled.  The work arrays
+    {vsel,tsel} must have at least {tb->ns} elements.
     
-    If {may_begin_here} is TRUE, the procedure assumes that the optimum
-    pairing is allowed to begin with the rung {g}.  
+    The diagonal is processed as a whole, one step type at a time (see
+    {msm_cand_refine_step_origin}). Entries that are not valid
+    rungs of the two sequences are set to score {-INF}.  For each step
+    type, the
+    predecessor entries of consecutive entries of diagonal {r} are
+    consecutive entries of a single earlier diagonal, so their scores
+    are read as a contiguous slice of {tb->sc}. The best score and step
+    type of each entry are kept in {vsel,tsel} and copied to the
+    tableau only at the end. The steps are considered in the same order
+    as in the entry-by-entry algorithm, so the results are the same.
     
-    If {may_end_here} is TRUE, the procedure assumes that the optimum 
-    pairing may end with the rung {g}.  In that case, if the best pairing
-    that ends at {g} has a better score than {*voptp}, the procedure 
-    sets {*goptp} to {g} and {*voptp} to that score. */
+    If {may_begin_here} is TRUE, the optimum pairing is allowed to
+    begin at any rung of the diagonal.  If {may_end_here} is TRUE, it
+    may end at any of them; in that case, if the best pairing that
+    ends at some rung {g} of the diagonal has a better score than
+    {*voptp}, the procedure sets {*goptp} to {g} and {*voptp} to that
+    score. */
 
 void msm_cand_refine_compute_r_range
   ( msm_pairing_t *p, 
@@ -218,6 +234,7 @@ void msm_cand_refine_fill_tableau
     msm_pairing_t *prold = cdold->pr;
     
     demand(maxUnp >= 0, "bad {maxUnp}");
+    demand(2*maxUnp + 1 <= UINT8_MAX, "{maxUnp} too large");
     demand(expand >= 0, "bad {expand}");
     demand(shrink >= 0, "bad {shrink}");
     
@@ -236,6 +253,11 @@ void msm_cand_refine_fill_tableau
     int maxds = 2*(kappa + 2*delta);
     /* Make sure that the tableau has all the required elements: */
     msm_dyn_tableau_resize(tb, minr, maxr, maxds);
+    
+    /* Work areas for one diagonal: */
+    double *vsel = notnull(malloc(tb->ns*sizeof(double)), "no mem");
+    uint8_t *tsel = notnull(malloc(tb->ns*sizeof(uint8_t)), "no mem");
+    
     /* Fills the matrix within the band, in diagonal order.
       We process entries one diagonal at a time, in order of 
       increasing R-coordinate. */
@@ -249,187 +271,156 @@ void msm_cand_refine_fill_tableau
         msm_refine_compute_s_range(prold, n0, n1, r, &kp, delta, kappa, &mins, &maxs);
         assert(mins <= maxs);
         msm_dyn_tableau_set_s_range(tb, r, mins, maxs);
-
-        /* Compute all elements in diagonal {r} of the tableau: */
-        int s;
-        for (s = mins; s <= maxs; s += 2)
-          { assert((r + s) % 2 == 0);
-            /* Debugging decision: */
-            int debug_drmin = 50;
-            int debug_drmax = 100;
-            bool_t debug_in_r_range = ((r - minr) >= debug_drmin) & ((r - minr) < debug_drmax);
-            bool_t debug_in_s_range = (s == (mins + maxs)/2);
-            bool_t debug_entry = debug & (debug_in_r_range & debug_in_s_range);
-            /* Check whether the path may begin or end here: */
-            bool_t may_begin_here = (r >= oldminr - expand) && (r <= oldminr + shrink);
-            bool_t may_end_here = (r <= oldmaxr + expand) && (r >= oldmaxr - shrink);
-            /* Fill the tableau entry and update {gopt,vopt}: */
-            msm_cand_refine_set_tableau_entry
-              ( r, s,
-                seq0, seq1, prold, 
-                delta, kappa, maxUnp, 
-                step_score, 
-                may_begin_here, may_end_here, debug_entry,
-                &gopt, &vopt, 
-                tb, kp,
-                n_steps, n_entries
-              );
-          }
+        /* Check whether the path may begin or end here: */
+        bool_t may_begin_here = (r >= oldminr - expand) && (r <= oldminr + shrink);
+        bool_t may_end_here = (r <= oldmaxr + expand) && (r >= oldmaxr - shrink);
+        /* Compute all elements in diagonal {r} of the tableau, update {gopt,vopt}: */
+        msm_cand_refine_fill_diagonal
+          ( r, seq0, seq1, maxUnp, step_score, 
+            may_begin_here, may_end_here,
+            &gopt, &vopt, tb, vsel, tsel,
+            n_steps, n_entries
+          );
+        if (debug && (r - minr < 100) && (r - minr >= 50))
+          { fprintf(stderr, "      diagonal r = %d  s = %d..%d\n", r, mins, maxs); }
       }
     
+    free(vsel);
+    free(tsel);
+    
     /* Return last rung and score of optimum pairing: */
     if (debug) 
       { fprintf (stderr, "      vopt = %23.15f  gopt = (%5d,%5d)\n", vopt, gopt.c[0], gopt.c[1]); }
     (*goptp) = gopt; (*voptp) = vopt;
   }
 
-void msm_cand_refine_set_tableau_entry
-  ( int r, /* {R}-coordinate of entry. */
-    int s, /* {S}-coordinate of entry. */
+void msm_cand_refine_fill_diagonal
+  ( int r,                  /* {R}-coordinate of diagonal. */
     msm_seq_desc_t *seq0,
     msm_seq_desc_t *seq1,
-    msm_pairing_t *prold,
-    int delta,
-    int kappa,
     int maxUnp,             /* Maximum unpaired datums between rungs. */
     msm_rung_step_score_proc_t *step_score, 
     bool_t may_begin_here,
     bool_t may_end_here,
-    bool_t debug,           /* TRUE to print diagnostics. */
     msm_rung_t *goptp,         
     double *voptp,             
     msm_dyn_tableau_t *tb,  /* WORK: dynamic programming tableau. */
-    int kp,                 /* Hint for index of rung in {prold} whose {R}-coord is {~r}. */
+    double vsel[],          /* WORK: best score for each entry of the diagonal. */
+    uint8_t tsel[],         /* WORK: type of the last step of the best path to each entry. */
     int *n_steps,           /* Number of examined steps (in,out). */
     int *n_entries          /* Number of tableau entries that were computed (in,out). */
   )
   {
     int n0 = seq0->size;
     int n1 = seq1->size;
-    /* Compute the X and Y coordinates {i0,i1} of entry: */
-    int i0 = (r + s) / 2;
-    int i1 = (r - s) / 2;
-    msm_rung_t g = (msm_rung_t){{ i0, i1 }}; /* Rung of entry. */
-    if (debug) { fprintf(stderr, "      filling entry [%d,%d]\n", i0, i1); }
-    /* Try to get the tableau entry for {g}: */
-    msm_dyn_entry_t *eg = msm_dyn_tableau_get_entry_address(tb, g);
-    bool_t i0_inside = ((i0 >= 0) && (i0 < n0));
-    bool_t i1_inside = ((i1 >= 0) && (i1 < n1));
-    if ((eg == NULL) || (! i0_inside) || (! i1_inside))
-      { /* Rung {g} is not valid: */
-        if (eg != NULL) 
-          { /* Set tableau entry to null values: */
-            eg->score = -INF; eg->prev = msm_rung_none;
+    
+    /* Get the {S}-range of the diagonal and its entries in the tableau: */
+    int ns = tb->ns;
+    int dr = r - tb->rMin;
+    int mins = tb->sMin.e[dr];
+    int maxs = tb->sMax.e[dr];
+    if (mins > maxs) { return; }
+    int m = (maxs - mins)/2 + 1; /* Number of entries in diagonal. */
+    double *scr = &(tb->sc.e[dr*ns]);
+    msm_dyn_entry_t *evr = &(tb->ev.e[dr*ns]);
+    
+    /* Find the range {vlo..vhi} of entries that are valid rungs,
+      namely with {i0 = (r+s)/2} in {0..n0-1} and {i1 = (r-s)/2} in {0..n1-1}: */
+    int slo = mins, shi = maxs;
+    if (slo < -r) { slo = -r; }
+    if (slo < r - 2*(n1-1)) { slo = r - 2*(n1-1); }
+    if (shi > r) { shi = r; }
+    if (shi > 2*(n0-1) - r) { shi = 2*(n0-1) - r; }
+    int vlo = (slo - mins + 1)/2;
+    int vhi = (shi - mins)/2;
+    if (vhi > m - 1) { vhi = m - 1; }
+    
+    int ds;
+    for (ds = 0; ds < m; ds++) { vsel[ds] = -INF; tsel[ds] = 0; }
+    
+    /* Consider all step types, in the order of the entry-by-entry algorithm: */
+    int nt = 2*maxUnp + 2; /* Number of step types. */
+    int t;
+    for (t = (may_begin_here ? 0 : 1); t < nt; t++)
+      { /* Get the displacements {d0,d1} of the step, and the range {lo..hi} of
+          entries whose predecessor is in the tableau: */
+        int d0, d1;
+        double *scp; /* Scores of the predecessors, {scp[ds]} for {ds} in {lo..hi}. */
+        int lo, hi;
+        if (t == 0)
+          { d0 = d1 = 0; scp = NULL; lo = vlo; hi = vhi; }
+        else
+          { msm_rung_t f = msm_cand_refine_step_origin((msm_rung_t){{ 0, 0 }}, t);
+            d0 = -f.c[0]; d1 = -f.c[1];
+            int rp = r - d0 - d1;
+            if (rp < tb->rMin) { continue; }
+            int drp = rp - tb->rMin;
+            int minsp = tb->sMin.e[drp];
+            int maxsp = tb->sMax.e[drp];
+            if (minsp > maxsp) { continue; }
+            int mp = (maxsp - minsp)/2 + 1;
+            /* Entry {ds} of diagonal {r} comes from entry {ds + c} of diagonal {rp}: */
+            assert((mins - d0 + d1 - minsp) % 2 == 0);
+            int c = (mins - d0 + d1 - minsp)/2;
+            lo = (c < 0 ? -c : 0);
+            hi = mp - 1 - c;
+            if (lo < vlo) { lo = vlo; }
+            if (hi > vhi) { hi = vhi; }
+            scp = &(tb->sc.e[drp*ns + c]);
           }
-        if (debug) { fprintf(stderr, "        entry is not valid\n"); }
-      }
-    else
-      { /* Compute the maximum-score path ending at rung {g}. */
-
-        double vsel = -INF;  /* Score of best path that ends at {g}. */
-        msm_rung_t fsel = msm_rung_none;     /* Previous rung on that path. */
-
-        auto void try_step(msm_rung_t f, int *kpfP);
-          /* If {f} is inside the tableau and the step {f->g} is valid, 
-            computes the score {vtofg} of the best pairing that ends
-            with rung {f}, plus the cost of the step {f->g};
-            if better than {vsel}, updates {fsel=f,vsel=vtofg}.
-            The integer {*kpfP} is a hint to the position in {prold}
-            of a rung with same R-coord as {f}. */
-
-        void try_step(msm_rung_t f, int *kpfP)
-          { double vtof; /* Value of best path to {f}. */
-            if (msm_rung_is_none(&f))
-              { if (debug) { fprintf(stderr, "        start at"); }
-                vtof = 0;
-              }
-            else
-              { if (debug) 
-                  { fprintf(stderr, "        step from [%d,%d]", f.c[0], f.c[1]);
-                    fprintf(stderr, " to [%d,%d]", g.c[0], g.c[1]);
-                    fprintf(stderr, " (%d,%d)", g.c[0]-f.c[0], g.c[1]-f.c[1]);
-                  }
-                msm_dyn_entry_t *ef = msm_dyn_tableau_get_entry_address(tb, f);
-                vtof = (ef == NULL ? -INF : ef->score);
-              }
-            if (vtof == -INF)
-              { /* Rung {f} is outside tableau: */
-                if (debug) { fprintf(stderr, " starts outside tableau"); }
-              }
-            else
-              { /* Rung {f} is inside the tableau: */
-                if (isnan(vtof) || (vtof == +INF))
-                  { fprintf(stderr, "\n** f = (%d,%d) vtof = %9.4f\n", f.c[0], f.c[1], vtof);
-                    assert(FALSE);
-                  }
-                double vfg = step_score(seq0, seq1, &f, &g);
-                (*n_steps)++;
-                double vtofg = vtof + vfg;
-                if (debug) { fprintf(stderr, "  score %9.6f + %9.6f = %9.6f", vtof, vfg, vtofg); }
-                bool_t better;
-                if (vtofg > vsel)
-                  { better = TRUE; }
-                else if (vtofg == vsel)
-                  { better = msm_rung_step_break_tie(f, g, fsel, g); }
-                else
-                  { better = FALSE; }
-                if (better) { vsel = vtofg; fsel = f; }
+        for (ds = lo; ds <= hi; ds++)
+          { double vtof = (t == 0 ? 0.0 : scp[ds]); /* Value of best path to {f}. */
+            if (vtof == -INF) { continue; }
+            if (isnan(vtof) || (vtof == +INF))
+              { fprintf(stderr, "\n** r = %d ds = %d t = %d vtof = %9.4f\n", r, ds, t, vtof);
+                assert(FALSE);
               }
-            if (debug) { fprintf(stderr, "\n"); }
-          }
-        
-        /* Choose between all valid maximum-score paths ending
-          at rung {g}. Namely, consider coming from rung
-          {msm_rung_none} (path starts at {g}) and from every
-          previous valid rung {f} such that (1) the step
-          {f->g} is strictly increasing and atomic, and (2) the step
-          leaves at most {maxUnp} unpaired datums all on 
-          the same sequence. */
-        
-        int kpf = kp; /* Approximate index in {prold} of a rung with R-coord of {f}; */
-        
-        if (may_begin_here) 
-          { /* Consider starting a pairing at {g}: */
-            try_step(msm_rung_none, &kpf);
-          }
-
-        /* Consider a perfect step ending at {g}: */
-        try_step((msm_rung_t){{ i0 - 1, i1 - 1 }}, &kpf);
-
-        /* Consider the imperfect atomic steps ending at {g}: */
-        int unp;
-        for (unp = 1; unp <= maxUnp; unp++)
-          { /* Consider the two {f} rungs that leave {unp} unpaired datums on each side: */
-            int j;
-            for (j = 0; j <= 1; j ++)
-              { msm_rung_t f;
-                f.c[j] = g.c[j] - 1 - unp;
-                f.c[1-j] = g.c[1-j] - 1;
-                try_step(f, &kpf);
+            int s = mins + 2*ds;
+            msm_rung_t g = (msm_rung_t){{ (r + s)/2, (r - s)/2 }};
+            msm_rung_t f = (t == 0 ? msm_rung_none : (msm_rung_t){{ g.c[0] - d0, g.c[1] - d1 }});
+            double vfg = step_score(seq0, seq1, &f, &g);
+            (*n_steps)++;
+            double vtofg = vtof + vfg;
+            bool_t better;
+            if (vtofg > vsel[ds])
+              { better = TRUE; }
+            else if (vtofg == vsel[ds])
+              { msm_rung_t fsel = msm_cand_refine_step_origin(g, tsel[ds]);
+                better = msm_rung_step_break_tie(f, g, fsel, g);
               }
-          }
-
-        /* Save the optimum path and the score in the matrix entry for {g}: */
-        eg->score = vsel; eg->prev = fsel;
-        if (debug)
-          { fprintf(stderr, "      best"); 
-            if (msm_rung_is_none(&fsel))
-              { fprintf(stderr, " start at [%d,%d]", g.c[0], g.c[1]); }
             else
-              { fprintf(stderr, " from [%d,%d]", fsel.c[0], fsel.c[1]);
-                fprintf(stderr, " (%d,%d)", g.c[0]-fsel.c[0], g.c[1]-fsel.c[1]);
-              }
-            fprintf(stderr, " score = %9.6f\n", vsel);
+              { better = FALSE; }
+            if (better) { vsel[ds] = vtofg; tsel[ds] = (uint8_t)t; }
           }
+      }
+    
+    /* Save the optimum paths and scores in the tableau: */
+    for (ds = 0; ds < m; ds++)
+      { int s = mins + 2*ds;
+        msm_rung_t g = (msm_rung_t){{ (r + s)/2, (r - s)/2 }};
+        scr[ds] = vsel[ds];
+        evr[ds].score = vsel[ds];
+        evr[ds].prev = msm_cand_refine_step_origin(g, tsel[ds]);
+        if ((ds < vlo) || (ds > vhi)) { continue; }
         (*n_entries)++;
-        
         if (may_end_here)
           { /* Update the overall best final rung {gopt} and best score {vopt}: */
-            if (vsel > (*voptp)) { (*voptp) = vsel; (*goptp) = g; }
+            if (vsel[ds] > (*voptp)) { (*voptp) = vsel[ds]; (*goptp) = g; }
           }
       }
   }
 
+msm_rung_t msm_cand_refine_step_origin(msm_rung_t g, int t)
+  { if (t == 0) { return msm_rung_none; }
+    msm_rung_t f = (msm_rung_t){{ g.c[0] - 1, g.c[1] - 1 }};
+    if (t >= 2)
+      { int unp = t/2;
+        int j = t % 2;
+        f.c[j] -= unp;
+      }
+    return f;
+  }
+
 void msm_cand_refine_compute_r_range
   ( msm_pairing_t *p, 
     int n0, 
@@ -1,11 +1,12 @@
 /* See msm_cand_vec.h */
-/* Last edited on 2018-03-04 22:57:55 by stolfilocal */
+/* Last edited on 2026-10-19 11:42:12 by jstolfi */
 
 #define msm_cand_vec_C_COPYRIGHT \
   "Copyright  2005  by the State University of Campinas (UNICAMP)"
 
 #define _GNU_SOURCE
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
@@ -17,6 +18,7 @@
 #include <jsrandom.h>
 #include <jsmath.h>
 #include <jswsize.h>
+#include <jsthread.h>
 
 #include <msm_basic.h>
 #include <msm_rung.h>
@@ -25,6 +27,7 @@
 #include <msm_cand_vec.h>
 #include <msm_cand_refine.h>
 #include <msm_dyn.h>
+#include <msm_seed.h>
 
 #define msm_cand_vec_checking_level 2
   /* Define this as positive to get paranoid checking. */
@@ -57,13 +60,15 @@ void msm_cand_vec_scan_alignment
     int i0,
     msm_seq_desc_t *seq1,
     int i1,
+    int64_t ng,
     msm_rung_step_score_proc_t *step_score,
     int64_t minRungs,   /* Min number of rungs in a valid subpairing. */
     double minScore,    /* Ignore candidates with score lower than this. */
     msm_subpairing_use_proc_t *use  /* What to do with candidates. */
   );
   /* Scans the perfect pairing {p} between sequences {seq0,seq1} that starts
-    with rungs {(i0,i1)} and has {ng} rungs. Calls {use} on some set of
+    with rungs {(i0,i1)} and has {ng} rungs, which must fit in both sequences. 
+    Calls {use} on some set of
     pairwise disjoint candidates found in it that have at least
     {minRungs} rungs and score at least {minScore}, hopefully with large
     scores.
@@ -72,6 +77,33 @@ void msm_cand_vec_scan_alignment
     scores of its steps, plus the steps from nowhere to the first rung
     and from the ar rung to nowhere. */
 
+void msm_cand_vec_scan_and_store
+  ( msm_seq_desc_t *seq0,
+    int i0,
+    msm_seq_desc_t *seq1,
+    int i1,
+    int64_t ng,
+    msm_rung_step_score_proc_t *step_score,
+    int64_t minRungs,
+    double minScore,
+    int maxCands,
+    msm_cand_vec_t *cdv,
+    int *ncdP,
+    double *lowScoreP
+  );
+  /* Scans the perfect pairing that starts with rung {(i0,i1)}
+    and has {ng} rungs, with {msm_cand_vec_scan_alignment}, and adds the candidates
+    found in it to the list {cdv->e[0..*ncdP-1]}, which is sorted by decreasing
+    score and holds at most {maxCands} entries.  Only candidates with score
+    at least {*lowScoreP} are considered; the procedure updates {*lowScoreP}
+    to the minimum score needed to enter the list.
+    
+    A valid sub-pairing is a set of consecutive rungs from the pairing 
+    that has at least {minRungs} and at most {min(n0,n1)} rungs. A
+    candidate is a valid sub-pairing whose score is positive and
+    better than that of any of proper valid sub-pairing or
+    super-pairing. */
+
 msm_cand_vec_t msm_cand_vec_get_best_perfect
   ( msm_seq_desc_t *seq0,
     msm_seq_desc_t *seq1,
@@ -96,13 +128,7 @@ msm_cand_vec_t msm_cand_vec_get_best_perfect
     auto void scan_alignment(int i0, int i1, int64_t ng);
       /* Scans the perfect pairing {p} that starts with rung {(i0,i1)}
         and has {ng} rungs, and adds all candidates found in it to the
-        heap.
-        
-        A valid sub-pairing is a set of consecutive rungs from {p}
-        that has at least {minRungs} and at most {min(n0,n1)} rungs. A
-        candidate is a valid sub-pairing whose score is positive and
-        better than that of any of proper valid sub-pairing or
-        super-pairing. */
+        list. */
 
     /* Scan all maximal-length perfect pairings, collect best cands: */
     msm_pairing_enum_alignments(n0, n1,  &scan_alignment); 
@@ -113,41 +139,123 @@ msm_cand_vec_t msm_cand_vec_get_best_perfect
     return cdv; 
 
     void scan_alignment(int i0, int i1, int64_t ng)
-      {
-        auto void store_cand(int64_t kmin, int64_t kmax, double score);
-          /* Stores into the sorted list {cdv} the pairing
-            {(i0+k,i1+k)} for {k=kmin,..kmax}. Assumes that its
-            score is {score}. The procedure is a no-op if the pairing
-            is not among the best {maxCands} entries found so far, or
-            is already in the list. */
-
-        msm_cand_vec_scan_alignment(seq0, i0, seq1, i1, step_score, minRungs, lowScore, &store_cand);
-     
-        void store_cand(int64_t kmin, int64_t kmax, double score)
-          { /* Check inex validity: */
-            assert(kmin <= kmax);
-            msm_rung_t gini = (msm_rung_t){{ (int32_t)(i0 + kmin), (int32_t)(i1 + kmin) }};
-            msm_rung_t gfin = (msm_rung_t){{ (int32_t)(i0 + kmax), (int32_t)(i1 + kmax) }};
-            assert((gini.c[0] >= 0) && (gfin.c[0] < n0));
-            assert((gini.c[1] >= 0) && (gfin.c[1] < n1));
-            int64_t ns = kmax - kmin + 1;
-            if (DEBLEV(2))
-              { fprintf
-                  ( stderr, 
-                    ("  got candidate from (%d,%d) to (%d,%d) steps = %" int64_d_fmt " score = %24.16e\n"), 
-                    gini.c[0], gini.c[1], gfin.c[0], gfin.c[1], ns, score
-                  ); 
-              }
-            affirm(score >= lowScore, "bad score");
-            msm_pairing_t *pr = msm_pairing_perfect(gini, (int)ns);
-            msm_cand_t cd = msm_cand_from_pairing(seq0, seq1, pr, score);
-            double frac = +INF;
-            msm_cand_vec_insert(&cdv, &ncd, (int)minRungs, maxCands, &cd, frac);
-            /* Update the current min useful score: */
-            lowScore = (ncd < maxCands ? minScore : cdv.e[ncd-1].score);
-            if (DEBLEV(1)) { fprintf(stderr, "  %d candidates, min score = %24.16e\n", ncd, lowScore); }
+      { /* The alignment must start at the beginning of one of the sequences: */
+        affirm((i0 == 0) || (i1 == 0), "bad {i0,i1}");
+        ng = imin(n0 - i0, n1 - i1);
+        msm_cand_vec_scan_and_store
+          ( seq0, i0, seq1, i1, ng, step_score, minRungs, minScore, maxCands, &cdv, &ncd, &lowScore );
+      }
+  }
+
+msm_cand_vec_t msm_cand_vec_get_best_seeded
+  ( msm_seq_desc_t *seq0,
+    msm_seq_desc_t *seq1,
+    msm_seed_key_t key0[],
+    msm_seed_key_t key1[],
+    int32_t k,
+    int32_t maxOcc,
+    int32_t maxGap,
+    msm_rung_step_score_proc_t *step_score,
+    int64_t minRungs, 
+    double minScore,
+    int maxCands,
+    int32_t nth
+  )
+  {
+    int n0 = seq0->size; 
+    int n1 = seq1->size; 
+    demand(maxGap >= 0, "invalid {maxGap}");
+
+    /* Find the seeds: */
+    msm_seed_index_t *X = msm_seed_index_new(n0, key0, k);
+    msm_seed_vec_t sdv = msm_seed_find(X, n1, key1, maxOcc, maxGap, nth);
+    msm_seed_index_free(X);
+    if (DEBLEV(1)) { fprintf(stderr, "  found %d seeds\n", sdv.ne); }
+
+    msm_cand_vec_t cdv = msm_cand_vec_new(maxCands);
+    int ncd = 0;
+    double lowScore = minScore; /* Current minimum score for storage. */
+    
+    /* Scan the extended seeds, merging overlapping ones on the same diagonal: */
+    int js = 0;
+    while (js < sdv.ne)
+      { msm_seed_t *sd = &(sdv.e[js]);
+        int32_t d = sd->i1 - sd->i0; /* Diagonal of seed. */
+        /* Extended range of {i1} is {ini..fin}: */
+        int32_t ini = sd->i1 - maxGap;
+        int32_t fin = sd->i1 + sd->len - 1 + maxGap;
+        js++;
+        while ((js < sdv.ne) && (sdv.e[js].i1 - sdv.e[js].i0 == d) && (sdv.e[js].i1 - maxGap <= fin + 1))
+          { fin = sdv.e[js].i1 + sdv.e[js].len - 1 + maxGap; js++; }
+        /* Clip to both sequences: */
+        ini = imax(ini, imax(0, d));
+        fin = imin(fin, imin(n1 - 1, n0 - 1 + d));
+        int64_t ng = fin - ini + 1;
+        if (ng >= minRungs)
+          { msm_cand_vec_scan_and_store
+              ( seq0, ini - d, seq1, ini, ng, step_score, minRungs, minScore, maxCands, &cdv, &ncd, &lowScore );
           }
       }
+    free(sdv.e);
+
+    /* Trim the candidate vector to the number of cands actually found: */
+    msm_cand_vec_trim(&cdv, ncd);
+    return cdv; 
+  }
+
+void msm_cand_vec_scan_and_store
+  ( msm_seq_desc_t *seq0,
+    int i0,
+    msm_seq_desc_t *seq1,
+    int i1,
+    int64_t ng,
+    msm_rung_step_score_proc_t *step_score,
+    int64_t minRungs,
+    double minScore,
+    int maxCands,
+    msm_cand_vec_t *cdv,
+    int *ncdP,
+    double *lowScoreP
+  )
+  {
+    int n0 = seq0->size; 
+    int n1 = seq1->size; 
+
+    auto void store_cand(int64_t kmin, int64_t kmax, double score);
+      /* Stores into the sorted list {cdv} the pairing
+        {(i0+k,i1+k)} for {k=kmin,..kmax}. Assumes that its
+        score is {score}. The procedure is a no-op if the pairing
+        is not among the best {maxCands} entries found so far, or
+        is already in the list. */
+
+    msm_cand_vec_scan_alignment(seq0, i0, seq1, i1, ng, step_score, minRungs, (*lowScoreP), &store_cand);
+    return;
+ 
+    void store_cand(int64_t kmin, int64_t kmax, double score)
+      { /* Check inex validity: */
+        assert(kmin <= kmax);
+        msm_rung_t gini = (msm_rung_t){{ (int32_t)(i0 + kmin), (int32_t)(i1 + kmin) }};
+        msm_rung_t gfin = (msm_rung_t){{ (int32_t)(i0 + kmax), (int32_t)(i1 + kmax) }};
+        assert((gini.c[0] >= 0) && (gfin.c[0] < n0));
+        assert((gini.c[1] >= 0) && (gfin.c[1] < n1));
+        int64_t ns = kmax - kmin + 1;
+        if (DEBLEV(2))
+          { fprintf
+              ( stderr, 
+                ("  got candidate from (%d,%d) to (%d,%d) steps = %" int64_d_fmt " score = %24.16e\n"), 
+                gini.c[0], gini.c[1], gfin.c[0], gfin.c[1], ns, score
+              ); 
+          }
+        affirm(score >= (*lowScoreP), "bad score");
+        msm_pairing_t *pr = msm_pairing_perfect(gini, (int)ns);
+        msm_cand_t cd = msm_cand_from_pairing(seq0, seq1, pr, score);
+        double frac = +INF;
+        msm_cand_vec_insert(cdv, ncdP, (int)minRungs, maxCands, &cd, frac);
+        /* Update the current min useful score: */
+        int ncd = (*ncdP);
+        (*lowScoreP) = (ncd < maxCands ? minScore : cdv->e[ncd-1].score);
+        if (DEBLEV(1)) { fprintf(stderr, "  %d candidates, min score = %24.16e\n", ncd, (*lowScoreP)); }
+      }
   }
 
 void msm_cand_vec_scan_alignment
@@ -155,6 +263,7 @@ void msm_cand_vec_scan_alignment
     int i0,
     msm_seq_desc_t *seq1,
     int i1,
+    int64_t ng,
     msm_rung_step_score_proc_t *step_score,
     int64_t minRungs,   /* Min number of rungs in a valid subpairing. */
     double minScore,    /* Ignore candidates with score lower than this. */
@@ -166,10 +275,8 @@ void msm_cand_vec_scan_alignment
 
     affirm((i0 >= 0) && (i0 < n0), "bad {i0}");
     affirm((i1 >= 0) && (i1 < n1), "bad {i1}");
-    affirm((i0 == 0) || (i1 == 0), "bad {i0,i1}");
+    affirm((ng <= n0 - i0) && (ng <= n1 - i1), "bad {ng}");
     
-    /* Get max number of rungs {ng} with this alignment: */
-    int64_t ng = imin(n0 - i0, n1 - i1);  
     if (DEBLEV(1))
       { fprintf
           ( stderr, ("\nalignment (%d,%d:%" int64_d_fmt ") minScore = %12.6f\n"),
@@ -186,7 +293,8 @@ void msm_cand_vec_scan_alignment
       the sub-pairing of {p} with maximum score that ends with each rung
       {k}. */
 
-    double psc[ng]; /* {psc[k]} is the score of the best sub-pairing that ends at rung {k}. */
+    double *psc = notnull(malloc(ng*sizeof(double)), "no mem"); 
+      /* {psc[k]} is the score of the best sub-pairing that ends at rung {k}. */
     
     /*  Scans the rungs {(i0+k,i1+k)} for {k} from {0} to {ng-1}. At
       each rung there are two choices: start a new sub-pairing with that
@@ -222,6 +330,7 @@ void msm_cand_vec_scan_alignment
           }
       }
     use_previous(kcur, ng-1);
+    free(psc);
     return;
     
     void use_previous(int64_t kini, int64_t kmax)
@@ -375,6 +484,25 @@ msm_cand_vec_t msm_cand_vec_make_increasing(msm_cand_vec_t *cdv, int minIncrEach
     return cdvnew;
   }
 
+typedef struct msm_cand_vec_refine_job_t
+  { msm_cand_vec_t *cdvold;   /* Candidates to refine. */
+    msm_cand_t *cdref;        /* Refined candidates. */
+    int delta, kappa, expand, shrink, maxUnp;
+    msm_rung_step_score_proc_t *step_score;
+    bool_t verbose;
+    msm_dyn_tableau_t *tbt;   /* Tableau of each thread. */
+    int *n_steps_t;           /* Step counter of each thread. */
+    int *n_entries_t;         /* Entry counter of each thread. */
+  } msm_cand_vec_refine_job_t;
+  /* Arguments of {msm_cand_vec_refine_range}.  The fields
+    {delta,kappa,expand,shrink,maxUnp,step_score,verbose} are
+    passed to {msm_cand_refine}. */
+
+void msm_cand_vec_refine_range(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Refines candidates {job->cdvold[ini..fin]} into {job->cdref[ini..fin]},
+    using the tableau and counters of thread {ith}, where {job} is
+    {(msm_cand_vec_refine_job_t *)arg}. */
+
 msm_cand_vec_t msm_cand_vec_refine
   ( msm_cand_vec_t *cdvold,
     msm_seq_desc_t *seq0, 
@@ -387,6 +515,7 @@ msm_cand_vec_t msm_cand_vec_refine
     msm_rung_step_score_proc_t *step_score,
     bool_t verbose,
     msm_dyn_tableau_t *tb, 
+    int nth,
     int minCover,
     int maxCands,
     double frac
@@ -401,13 +530,43 @@ msm_cand_vec_t msm_cand_vec_refine
       { msm_cand_t *cdoi = &(cdvold->e[ic]);
         demand(msm_seq_desc_equal(&(cdoi->seq[0]), seq0, FALSE), "wrong seq 0");
         demand(msm_seq_desc_equal(&(cdoi->seq[1]), seq1, FALSE), "wrong seq 1");
-        
-        msm_cand_t cdni = msm_cand_refine
-          ( cdoi, delta, kappa, expand, shrink, maxUnp, step_score, verbose, tb, &n_steps, &n_entries );
-          
-        msm_cand_vec_insert(&cdvnew, &ncnew, minCover, maxCands, &cdni, frac);
       }
+    
+    /* Refine all candidates, in parallel: */
+    nth = jsthread_choose_count(nth, cdvold->ne);
+    msm_cand_t *cdref = notnull(malloc((cdvold->ne + 1)*sizeof(msm_cand_t)), "no mem");
+    msm_dyn_tableau_t *tbt = notnull(malloc(nth*sizeof(msm_dyn_tableau_t)), "no mem");
+    int *n_steps_t = notnull(malloc(nth*sizeof(int)), "no mem");
+    int *n_entries_t = notnull(malloc(nth*sizeof(int)), "no mem");
+    int ith;
+    for (ith = 0; ith < nth; ith++) 
+      { tbt[ith] = (ith == 0 ? (*tb) : msm_dyn_tableau_new());
+        n_steps_t[ith] = 0;
+        n_entries_t[ith] = 0;
+      }
+    
+    msm_cand_vec_refine_job_t job = (msm_cand_vec_refine_job_t)
+      { .cdvold = cdvold, .cdref = cdref,
+        .delta = delta, .kappa = kappa, .expand = expand, .shrink = shrink, .maxUnp = maxUnp,
+        .step_score = step_score, .verbose = verbose,
+        .tbt = tbt, .n_steps_t = n_steps_t, .n_entries_t = n_entries_t
+      };
+    jsthread_run_ranges(cdvold->ne, 1, nth, &msm_cand_vec_refine_range, &job);
+    
+    /* Insert the refined candidates in the original order: */
+    for (ic = 0; ic < cdvold->ne; ic++)
+      { msm_cand_vec_insert(&cdvnew, &ncnew, minCover, maxCands, &(cdref[ic]), frac); }
     msm_cand_vec_trim(&cdvnew, ncnew);
+    
+    for (ith = 0; ith < nth; ith++) 
+      { n_steps += n_steps_t[ith];
+        n_entries += n_entries_t[ith];
+        if (ith == 0) { (*tb) = tbt[ith]; } else { msm_dyn_tableau_free(&(tbt[ith])); }
+      }
+    free(n_entries_t);
+    free(n_steps_t);
+    free(tbt);
+    free(cdref);
     fprintf
       ( stderr, "refined candidate vactor: %d entries, %.1f steps per entry\n",
         n_entries, ((double)n_steps)/n_entries
@@ -415,6 +574,19 @@ msm_cand_vec_t msm_cand_vec_refine
     return cdvnew;
   }
 
+void msm_cand_vec_refine_range(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  { msm_cand_vec_refine_job_t *job = (msm_cand_vec_refine_job_t *)arg;
+    int jc;
+    for (jc = ini; jc <= fin; jc++)
+      { job->cdref[jc] = msm_cand_refine
+          ( &(job->cdvold->e[jc]), 
+            job->delta, job->kappa, job->expand, job->shrink, job->maxUnp, 
+            job->step_score, job->verbose, 
+            &(job->tbt[ith]), &(job->n_steps_t[ith]), &(job->n_entries_t[ith])
+          );
+      }
+  }
+
 void msm_cand_vec_insert
   ( msm_cand_vec_t *cdv,
     int *ncandP,
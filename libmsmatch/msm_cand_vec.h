@@ -2,7 +2,7 @@
 #define msm_cand_vec_H
 
 /* Tools for lists of candidates. */
-/* Last edited on 2017-04-28 10:31:02 by stolfilocal */
+/* Last edited on 2026-10-19 11:42:12 by jstolfi */
 
 #define msm_cand_vec_H_COPYRIGHT \
   "Copyright  2005  by the State University of Campinas (UNICAMP)"
@@ -13,6 +13,7 @@
 #include <msm_pairing.h>
 #include <msm_cand.h>
 #include <msm_dyn.h>
+#include <msm_seed.h>
 
 #include <vec.h>
 
@@ -36,7 +37,43 @@ msm_cand_vec_t msm_cand_vec_get_best_perfect
     
     The score of a pairing is taken to be be the sum of the
     {step_score} for all its steps, plus the scores of the steps from  
-    nowhere to the first rung, and from the last rung to nowhere. */
+    nowhere to the first rung, and from the last rung to nowhere. 
+    
+    The procedure scans all {n0+n1-1} alignments of the two sequences, so
+    its cost is {O(n0*n1)}.  For long sequences, consider
+    {msm_cand_vec_get_best_seeded}. */
+
+msm_cand_vec_t msm_cand_vec_get_best_seeded
+  ( msm_seq_desc_t *seq0,
+    msm_seq_desc_t *seq1,
+    msm_seed_key_t key0[],
+    msm_seed_key_t key1[],
+    int32_t k,
+    int32_t maxOcc,
+    int32_t maxGap,
+    msm_rung_step_score_proc_t *step_score,
+    int64_t minRungs, 
+    double minScore,
+    int maxCands,
+    int32_t nth
+  );
+  /* Similar to {msm_cand_vec_get_best_perfect}, but considers only the
+    parts of the alignments that are near seeds found by hashing windows of
+    quantized samples.
+    
+    Namely, builds a seed index (see {msm_seed.h}) for the windows of length {k} of the 
+    keys {key0[0..seq0.size-1]}, and looks up the windows of {key1[0..seq1.size-1]}
+    with {msm_seed_find(X,seq1.size,key1,maxOcc,maxGap,nth)}.  Each seed 
+    is extended by {maxGap} rungs in both directions (clipped to the
+    sequences), overlapping extended seeds on the same diagonal are merged, 
+    and the resulting perfect pairings are scanned for candidates as in 
+    {msm_cand_vec_get_best_perfect}.
+    
+    The cost of finding the seeds is roughly proportional to
+    {n0 + n1} plus the number of hits; the cost of scoring is
+    proportional to the total length of the extended seeds, instead of
+    {n0*n1}.  Only the seed search uses {nth} threads; the {step_score}
+    procedure is called by the calling thread only. */
 
 void msm_cand_vec_throw
   ( int ntr,
@@ -90,6 +127,7 @@ msm_cand_vec_t msm_cand_vec_refine
     msm_rung_step_score_proc_t *step_score, 
     bool_t verbose,
     msm_dyn_tableau_t *tb, 
+    int nth,
     int minCover,
     int maxCands,
     double frac
@@ -107,7 +145,15 @@ msm_cand_vec_t msm_cand_vec_refine
     candidate {B} if the fraction of rungs of {A} that are in {B} is
     {frac} or more.
     
-    The {verbose} flag is passed to each {msm_cand_refine} call. */
+    The {verbose} flag is passed to each {msm_cand_refine} call.
+    
+    The candidates are refined independently of each other, with
+    {nth} threads (see {jsthread_run_ranges}); thread 0 uses the
+    tableau {tb}, and each other thread uses a private tableau.  If
+    {nth} is zero, uses one thread per available processor.  The
+    refined candidates are then inserted into the result in the
+    original order of {cdv}, so the result does not depend on {nth}.
+    If {nth} is not 1, {step_score} must be safe for concurrent calls. */
 
 void msm_cand_vec_insert
   ( msm_cand_vec_t *cdv,
@@ -1,5 +1,5 @@
 /* See {msm_dyn.h} */
-/* Last edited on 2013-10-22 02:07:46 by stolfilocal */
+/* Last edited on 2026-10-19 11:41:30 by jstolfi */
 
 #define msm_dyn_C_COPYRIGHT \
   "Copyright  2005  by the State University of Campinas (UNICAMP)" \
@@ -28,6 +28,7 @@ msm_dyn_tableau_t msm_dyn_tableau_new(void)
     tb.sMax = int_vec_new(0);
     tb.ns = 0;
     tb.ev = msm_dyn_entry_vec_new(0);
+    tb.sc = double_vec_new(0);
     return tb;
   }
     
@@ -48,6 +49,7 @@ void msm_dyn_tableau_resize(msm_dyn_tableau_t *tb, int rMin, int rMax, int maxds
     demand(maxds % 2 == 0, "maxds should be even");
     tb->ns = maxds/2 + 1;
     msm_dyn_entry_vec_expand(&(tb->ev), tb->nr*tb->ns - 1);
+    double_vec_expand(&(tb->sc), tb->nr*tb->ns - 1);
   }
     
 void msm_dyn_tableau_set_s_range(msm_dyn_tableau_t *tb, int r, int sMin, int sMax)
@@ -69,6 +71,7 @@ void msm_dyn_tableau_set_s_range(msm_dyn_tableau_t *tb, int r, int sMin, int sMa
         for (ds = 0; ds < ne; ds++)
           { int k = dr*tb->ns + ds;
             tb->ev.e[k] = (msm_dyn_entry_t){ -INF, msm_rung_none };
+            tb->sc.e[k] = -INF;
           }
       }
   }
@@ -144,5 +147,6 @@ void msm_dyn_tableau_free(msm_dyn_tableau_t *tb)
   { free(tb->sMin.e);
     free(tb->sMax.e);
     free(tb->ev.e);
+    free(tb->sc.e);
   }
 
@@ -2,7 +2,7 @@
 #define msm_dyn_H
 
 /* Dynamic programming tableaus for incremental optimum pairing. */
-/* Last edited on 2013-10-22 02:05:43 by stolfilocal */
+/* Last edited on 2026-10-19 11:40:12 by jstolfi */
 
 #define msm_dyn_H_COPYRIGHT \
   "Copyright  2005  by the State University of Campinas (UNICAMP)" \
@@ -33,6 +33,7 @@ typedef struct msm_dyn_tableau_t
     int_vec_t sMax;        /* The maximum S-coord for each R-coord {r} is {sMax[r-rMin]}. */
     int ns;                /* Max number of S-coord values for any {r}. */
     msm_dyn_entry_vec_t ev; /* Tableau entries. */
+    double_vec_t sc;       /* Scores of the entries, in the same layout as {ev}. */
   } msm_dyn_tableau_t;
   /* A tableau for incremental dynamic programming. 
 
@@ -43,7 +44,13 @@ typedef struct msm_dyn_tableau_t
     is represented in {T} if and only if {rMin <= r <= rMax}, and
     {sMin[r-rMin] <= s <= sMax[r-rMin]}. The corresponding entry is
     stored in {ev[dr*ns + ds]}, where {dr = r - rMin}, and 
-    {ds = (s-sMin[dr])/2}. */
+    {ds = (s-sMin[dr])/2}.
+    
+    The vector {sc} is a copy of the {.score} fields of {ev}, with the
+    same indexing, so that the scores of all entries with the same
+    R-coordinate are contiguous in memory.  It is meant for procedures
+    that fill the tableau one whole diagonal at a time (see
+    {msm_cand_refine}); they must keep {sc} and {ev} consistent. */
     
 msm_dyn_tableau_t msm_dyn_tableau_new(void);
   /* Returns a tableau with zero space, that is, {rMax < rMin}, {nr = ns = 0}. */
@@ -58,7 +65,7 @@ void msm_dyn_tableau_resize(msm_dyn_tableau_t *tb, int rMin, int rMax, int maxds
     
     The function sets {tb.rMin = rMin}, {tb.rMax = rMax}, and {tb.ns =
     maxds + 1}. It also recomputes {tb.nr = rMax - rMin + 1} and reallocates
-    the vectors {tb.sMin}, {tb.sMax}, and {tb.ev} as needed to contain
+    the vectors {tb.sMin}, {tb.sMax}, {tb.ev}, and {tb.sc} as needed to contain
     all elements. The bounds {tb.sMin[dr]} and {tb.sMax[dr]} are set
     to an empty interval, for all {dr} in {0..tb.nr-1}. */
     
@@ -66,7 +73,7 @@ void msm_dyn_tableau_set_s_range(msm_dyn_tableau_t *tb, int r, int sMin, int sMa
   /* Sets the values of {sMin[dr]} and {sMax[dr]} to the given values,
     where {dr = r - rMin}. Initializes all tableau elements with R-coordinate
     {r} and S-coordinates in the range {sMin..sMax} to have score {-INF} and
-    previous rung {msm_rung_none}. Requires {r} to be in {tb.rMin..tb.rMax},
+    previous rung {msm_rung_none}, in both {ev} and {sc}. Requires {r} to be in {tb.rMin..tb.rMax},
     and also {sMax - sMin < tb.ns}. */
     
 void msm_dyn_tableau_get_s_range(msm_dyn_tableau_t *tb, int r, int *sMin, int *sMax);
@@ -1,5 +1,5 @@
 /* See msm_multi.h */
-/* Last edited on 2017-04-28 10:45:57 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:10:00 by jstolfi */ 
 
 #define msm_multi_C_COPYRIGHT \
   "Copyright  2005  by the State University of Campinas (UNICAMP)" \
@@ -17,6 +17,7 @@
 #include <msm_cand_refine.h>
 
 #include <affirm.h>
+#include <jsprof.h>
 
 msm_cand_vec_t msm_multi_find_matches
   ( msm_cand_vec_t *cdvini,
@@ -33,6 +34,7 @@ msm_cand_vec_t msm_multi_find_matches
     int shrink,
     int maxUnp,
     msm_rung_step_score_proc_t *step_score,
+    int nth,
     msm_multi_report_proc_t *report,
     bool_t verbose
   )
@@ -41,6 +43,8 @@ msm_cand_vec_t msm_multi_find_matches
 
     /* Current candidate set: */
     msm_cand_vec_t cdv = msm_cand_vec_new(0);
+    
+    jsprof_ENTER("msm_multi_find_matches");
 
     /* Multiscale search and refine at all scales: */
     int level;
@@ -48,6 +52,7 @@ msm_cand_vec_t msm_multi_find_matches
       { 
         /* Scale reduction factor from original strings: */
         int scale = 1 << level;
+        jsprof_ENTER_IX("level", level);
 
         fprintf(stderr, "\n");
         fprintf(stderr, "= = = = = = = = = = = = = = = = = = = = = = = = = = = = = =\n");
@@ -68,7 +73,9 @@ msm_cand_vec_t msm_multi_find_matches
             fprintf(stderr, "mapping %d candidates", cdv.ne);
             fprintf(stderr, " from level %d to level %d ...\n", level+1, level);
             /* Map the candidates: */
+            jsprof_ENTER("map");
             cdvraw = msm_cand_vec_map(&cdv, seq0, seq1);
+            jsprof_LEAVE("map");
           }
 
         /* Reclaim the previous {cdv} candidate list, if not shared: */
@@ -86,12 +93,16 @@ msm_cand_vec_t msm_multi_find_matches
             int mincov = minSamples[level];
             fprintf(stderr, "  min covered samples in each sequence %d\n", mincov);
             assert(mincov > 0);
+            jsprof_ENTER("refine");
+            jsprof_COUNT("candidates_in", cdvraw.ne);
             cdv = msm_cand_vec_refine 
               ( &cdvraw, seq0, seq1, 
                 delta, kappa, expand, shrink, maxUnp,
-                step_score, verbose, &tb, 
+                step_score, verbose, &tb, nth,
                 mincov, nprune, frac
               );
+            jsprof_COUNT("candidates_out", cdv.ne);
+            jsprof_LEAVE("refine");
           }
         else
           { /* Let {cdv} be an alias for {cdvraw}: */
@@ -107,9 +118,11 @@ msm_cand_vec_t msm_multi_find_matches
         fprintf(stderr, "= = = = = = = = = = = = = = = = = = = = = = = = = = = = = =\n");
         fprintf(stderr, "\n");
 
+        jsprof_LEAVE("level");
       }
     
     msm_dyn_tableau_free(&tb);
+    jsprof_LEAVE("msm_multi_find_matches");
 
     fprintf(stderr, "mapped and refined %d candidates at finest level\n", cdv.ne);
     return cdv;
@@ -2,7 +2,7 @@
 #define msm_multi_H
 
 /* Multiscale DNA matching */
-/* Last edited on 2017-04-28 10:31:14 by stolfilocal */ 
+/* Last edited on 2026-10-19 11:23:00 by jstolfi */ 
 
 #define msm_multi_H_COPYRIGHT \
   "Copyright  2005  by the State University of Campinas (UNICAMP)" \
@@ -49,6 +49,7 @@ msm_cand_vec_t msm_multi_find_matches
     int shrink,
     int maxUnp,
     msm_rung_step_score_proc_t *step_score,
+    int nth,
     msm_multi_report_proc_t *report,
     bool_t verbose
   );
@@ -81,7 +82,8 @@ msm_cand_vec_t msm_multi_find_matches
     are at least {frac} times the number of rungs of {ca}.
     
     The parameters {delta,kappa,expand,shrink,maxUnp} are explained under
-    {msm_cand_refine}.
+    {msm_cand_refine}.  At each level the candidates are refined with {nth}
+    threads, as explained under {msm_cand_vec_refine}.
     
     If {report} is not NULL, the procedure calls {report(seq0, seq1,
     cdvmap, cdvfin)} at each level of the matching procedure, from
@@ -0,0 +1,241 @@
+/* See msm_seed.h */
+/* Last edited on 2026-10-19 11:42:12 by jstolfi */
+
+#define msm_seed_C_COPYRIGHT \
+  "Copyright \xa9 2026  by the State University of Campinas (UNICAMP)"
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsthread.h>
+#include <vec.h>
+
+#include <msm_seed.h>
+
+vec_typeimpl(msm_seed_vec_t,msm_seed_vec,msm_seed_t);
+
+/* INTERNAL PROTOTYPES */
+
+#define msm_seed_HASH_MUL (1099511628211LLU)
+  /* Multiplier of the polynomial window hash. */
+
+#define msm_seed_BUCKET_MUL (11400714819323198485LLU)
+  /* Multiplier used to map hashes to buckets. */
+
+uint64_t msm_seed_window_hash(msm_seed_key_t key[], int32_t k);
+  /* Computes the hash of the window {key[0..k-1]}, namely
+    {SUM{ (key[t]+1)*M^(k-1-t) : t \in 0..k-1 }} modulo {2^64}, where
+    {M} is {msm_seed_HASH_MUL}. */
+
+uint64_t msm_seed_hash_power(int32_t k);
+  /* Returns {M^(k-1)} modulo {2^64}, where {M} is {msm_seed_HASH_MUL}. */
+
+typedef struct msm_seed_hit_t { int32_t d; int32_t i1; } msm_seed_hit_t;
+  /* A hit between window {i1-d} of the indexed sequence and window {i1} of the query. */
+
+int msm_seed_hit_cmp(const void *a, const void *b);
+  /* Compares two {msm_seed_hit_t} by diagonal {d}, then by {i1}. */
+
+typedef struct msm_seed_query_t
+  { msm_seed_index_t *X;
+    int32_t n1;
+    msm_seed_key_t *key1;
+    int32_t maxOcc;
+    int32_t *nh;            /* {nh[ith]} is the number of hits found by thread {ith}. */
+    msm_seed_hit_t **hit;   /* {hit[ith][0..nh[ith]-1]} are the hits found by thread {ith}. */
+    int32_t *mh;            /* {mh[ith]} is the allocated size of {hit[ith]}. */
+  } msm_seed_query_t;
+  /* Arguments for {msm_seed_query_range}. */
+
+void msm_seed_query_range(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Looks up the query windows {ini..fin} of a {msm_seed_query_t},
+    appends the hits to the list of thread {ith}. */
+
+/* IMPLEMENTATIONS */
+
+msm_seed_index_t *msm_seed_index_new(int32_t n, msm_seed_key_t key[], int32_t k)
+  {
+    demand(k >= 1, "invalid window length");
+    demand(n >= 0, "invalid sequence length");
+    msm_seed_index_t *X = notnull(malloc(sizeof(msm_seed_index_t)), "no mem");
+    X->n = n;
+    X->k = k;
+    X->key = notnull(malloc((n + 1)*sizeof(msm_seed_key_t)), "no mem");
+    if (n > 0) { memcpy(X->key, key, n*sizeof(msm_seed_key_t)); }
+    int32_t nw = (n >= k ? n - k + 1 : 0);
+    X->nw = nw;
+    
+    /* Choose the number of buckets {nb = 2^lnb >= nw}: */
+    int32_t lnb = 0;
+    while ((lnb < 30) && ((1 << lnb) < nw)) { lnb++; }
+    int32_t nb = (1 << lnb);
+    X->nb = nb;
+    
+    /* Compute the hash of every window: */
+    uint64_t *wh = notnull(malloc((nw + 1)*sizeof(uint64_t)), "no mem");
+    uint64_t pk = msm_seed_hash_power(k);
+    uint64_t h = 0;
+    for (int32_t i = 0; i < nw; i++)
+      { if (i == 0)
+          { h = msm_seed_window_hash(key, k); }
+        else
+          { h = (h - (key[i-1] + 1LLU)*pk)*msm_seed_HASH_MUL + (key[i+k-1] + 1LLU); }
+        wh[i] = h;
+      }
+    
+    /* Distribute the windows into buckets, in increasing order of start: */
+    X->bstart = notnull(malloc((nb + 1)*sizeof(int32_t)), "no mem");
+    X->pos = notnull(malloc((nw + 1)*sizeof(int32_t)), "no mem");
+    X->hash = notnull(malloc((nw + 1)*sizeof(uint64_t)), "no mem");
+    int32_t *bw = notnull(malloc((nw + 1)*sizeof(int32_t)), "no mem"); /* Bucket of each window. */
+    for (int32_t b = 0; b <= nb; b++) { X->bstart[b] = 0; }
+    for (int32_t i = 0; i < nw; i++)
+      { bw[i] = (lnb == 0 ? 0 : (int32_t)((wh[i]*msm_seed_BUCKET_MUL) >> (64 - lnb)));
+        X->bstart[bw[i] + 1]++;
+      }
+    for (int32_t b = 0; b < nb; b++) { X->bstart[b+1] += X->bstart[b]; }
+    int32_t *next = notnull(malloc(nb*sizeof(int32_t)), "no mem");
+    for (int32_t b = 0; b < nb; b++) { next[b] = X->bstart[b]; }
+    for (int32_t i = 0; i < nw; i++)
+      { int32_t j = next[bw[i]]; next[bw[i]]++;
+        X->pos[j] = i;
+        X->hash[j] = wh[i];
+      }
+    free(next);
+    free(bw);
+    free(wh);
+    return X;
+  }
+
+void msm_seed_index_free(msm_seed_index_t *X)
+  { free(X->key);
+    free(X->bstart);
+    free(X->pos);
+    free(X->hash);
+    free(X);
+  }
+
+msm_seed_vec_t msm_seed_find
+  ( msm_seed_index_t *X,
+    int32_t n1,
+    msm_seed_key_t key1[],
+    int32_t maxOcc,
+    int32_t maxGap,
+    int32_t nth
+  )
+  {
+    int32_t k = X->k;
+    int32_t nw1 = (n1 >= k ? n1 - k + 1 : 0); /* Number of query windows. */
+    
+    /* Collect the hits, with one list per thread: */
+    int32_t nt = jsthread_choose_count(nth, nw1);
+    msm_seed_query_t Q = (msm_seed_query_t)
+      { .X = X, .n1 = n1, .key1 = key1, .maxOcc = maxOcc,
+        .nh = notnull(malloc(nt*sizeof(int32_t)), "no mem"),
+        .hit = notnull(malloc(nt*sizeof(msm_seed_hit_t*)), "no mem"),
+        .mh = notnull(malloc(nt*sizeof(int32_t)), "no mem")
+      };
+    for (int32_t t = 0; t < nt; t++) { Q.nh[t] = 0; Q.mh[t] = 0; Q.hit[t] = NULL; }
+    if ((nw1 > 0) && (X->nw > 0)) 
+      { jsthread_run_ranges(nw1, 0, nt, &msm_seed_query_range, &Q); }
+    
+    /* Gather all hits and sort them by diagonal and position: */
+    int64_t nh = 0;
+    for (int32_t t = 0; t < nt; t++) { nh += Q.nh[t]; }
+    msm_seed_hit_t *hit = notnull(malloc((nh + 1)*sizeof(msm_seed_hit_t)), "no mem");
+    nh = 0;
+    for (int32_t t = 0; t < nt; t++) 
+      { if (Q.nh[t] > 0) { memcpy(&(hit[nh]), Q.hit[t], Q.nh[t]*sizeof(msm_seed_hit_t)); }
+        nh += Q.nh[t];
+        free(Q.hit[t]);
+      }
+    free(Q.nh); free(Q.hit); free(Q.mh);
+    qsort(hit, nh, sizeof(msm_seed_hit_t), &msm_seed_hit_cmp);
+    
+    /* Chain hits on the same diagonal into seeds: */
+    msm_seed_vec_t sdv = msm_seed_vec_new(0);
+    int32_t ns = 0;
+    int64_t j = 0;
+    while (j < nh)
+      { int32_t d = hit[j].d;
+        int32_t ifirst = hit[j].i1, ilast = ifirst;
+        j++;
+        while ((j < nh) && (hit[j].d == d) && (hit[j].i1 - ilast <= maxGap))
+          { ilast = hit[j].i1; j++; }
+        msm_seed_vec_expand(&sdv, ns);
+        sdv.e[ns] = (msm_seed_t){ .i0 = ifirst - d, .i1 = ifirst, .len = ilast - ifirst + k };
+        ns++;
+      }
+    msm_seed_vec_trim(&sdv, ns);
+    free(hit);
+    return sdv;
+  }
+
+void msm_seed_query_range(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    msm_seed_query_t *Q = (msm_seed_query_t *)arg;
+    msm_seed_index_t *X = Q->X;
+    msm_seed_key_t *key1 = Q->key1;
+    int32_t k = X->k;
+    int32_t lnb = 0;
+    while ((1 << lnb) < X->nb) { lnb++; }
+    uint64_t pk = msm_seed_hash_power(k);
+    
+    auto bool_t same(int32_t i0, int32_t i1);
+      /* TRUE if window {i0} of {X} has the same keys as query window {i1}. */
+    
+    bool_t same(int32_t i0, int32_t i1)
+      { return (memcmp(&(X->key[i0]), &(key1[i1]), k*sizeof(msm_seed_key_t)) == 0); }
+    
+    uint64_t h = 0;
+    for (int32_t i1 = ini; i1 <= fin; i1++)
+      { if (i1 == ini)
+          { h = msm_seed_window_hash(&(key1[i1]), k); }
+        else
+          { h = (h - (key1[i1-1] + 1LLU)*pk)*msm_seed_HASH_MUL + (key1[i1+k-1] + 1LLU); }
+        int32_t b = (lnb == 0 ? 0 : (int32_t)((h*msm_seed_BUCKET_MUL) >> (64 - lnb)));
+        int32_t jini = X->bstart[b], jlim = X->bstart[b+1];
+        if (Q->maxOcc > 0)
+          { /* Count the matches, skip the window if too many: */
+            int32_t nocc = 0;
+            for (int32_t j = jini; (j < jlim) && (nocc <= Q->maxOcc); j++)
+              { if ((X->hash[j] == h) && same(X->pos[j], i1)) { nocc++; } }
+            if (nocc > Q->maxOcc) { continue; }
+          }
+        for (int32_t j = jini; j < jlim; j++)
+          { if ((X->hash[j] == h) && same(X->pos[j], i1))
+              { if (Q->nh[ith] >= Q->mh[ith])
+                  { Q->mh[ith] = 2*Q->mh[ith] + 1024;
+                    Q->hit[ith] = notnull(realloc(Q->hit[ith], Q->mh[ith]*sizeof(msm_seed_hit_t)), "no mem");
+                  }
+                Q->hit[ith][Q->nh[ith]] = (msm_seed_hit_t){ .d = i1 - X->pos[j], .i1 = i1 };
+                Q->nh[ith]++;
+              }
+          }
+      }
+  }
+
+uint64_t msm_seed_window_hash(msm_seed_key_t key[], int32_t k)
+  { uint64_t h = 0;
+    for (int32_t t = 0; t < k; t++) { h = h*msm_seed_HASH_MUL + (key[t] + 1LLU); }
+    return h;
+  }
+
+uint64_t msm_seed_hash_power(int32_t k)
+  { uint64_t p = 1;
+    for (int32_t t = 1; t < k; t++) { p *= msm_seed_HASH_MUL; }
+    return p;
+  }
+
+int msm_seed_hit_cmp(const void *a, const void *b)
+  { const msm_seed_hit_t *ha = (const msm_seed_hit_t *)a;
+    const msm_seed_hit_t *hb = (const msm_seed_hit_t *)b;
+    if (ha->d != hb->d) { return (ha->d < hb->d ? -1 : +1); }
+    if (ha->i1 != hb->i1) { return (ha->i1 < hb->i1 ? -1 : +1); }
+    return 0;
+  }
@@ -0,0 +1,96 @@
+#ifndef msm_seed_H
+#define msm_seed_H
+
+/* Hashed window index for finding diagonal seed matches between two sequences. */
+/* Last edited on 2026-10-19 11:42:12 by jstolfi */
+
+#define msm_seed_H_COPYRIGHT \
+  "Copyright  2026  by the State University of Campinas (UNICAMP)"
+
+#include <stdint.h>
+
+#include <vec.h>
+
+#include <msm_basic.h>
+
+/* SEED INDEX
+  
+  The tools in this module find long runs of rungs {(i0+t,i1+t)} where
+  two sequences have identical sample values, without examining all
+  pairs {(i0,i1)}. They are meant to provide initial candidates for
+  very long sequences, where the all-alignments search of
+  {msm_cand_vec_get_best_perfect} is too expensive.
+  
+  Since {msm_seq_desc_t} does not store sample values, the client must
+  provide for each sequence a vector of /keys/, where {key[i]} is
+  an integer obtained by quantizing the value of sample {i}.  For
+  nucleotide sequences the key may be simply the base code; for
+  encoded ({dnae_sample_enc_t}) or other real-valued samples, each
+  coordinate may be quantized to a few levels and the levels packed
+  into a single integer.
+  
+  A /window/ is a set of {k} consecutive samples. Two windows /match/
+  if their keys are identical. */
+
+typedef uint32_t msm_seed_key_t;
+  /* A quantized sample value. */
+
+typedef struct msm_seed_index_t
+  { int32_t n;            /* Number of samples of the indexed sequence. */
+    int32_t k;            /* Window length. */
+    msm_seed_key_t *key;  /* Copy of the sample keys {key[0..n-1]}. */
+    int32_t nw;           /* Number of windows ({max(0,n-k+1)}). */
+    int32_t nb;           /* Number of hash buckets (a power of 2). */
+    int32_t *bstart;      /* Windows of bucket {b} are {pos[bstart[b]..bstart[b+1]-1]}. */
+    int32_t *pos;         /* Start indices of all windows, grouped by bucket. */
+    uint64_t *hash;       /* {hash[j]} is the full hash of window {pos[j]}. */
+  } msm_seed_index_t;
+  /* An index of all windows of length {k} of some sequence.  The
+    windows of each bucket are listed in increasing order of their 
+    start index. */
+
+msm_seed_index_t *msm_seed_index_new(int32_t n, msm_seed_key_t key[], int32_t k);
+  /* Builds an index for all windows of length {k} of a sequence whose
+    sample keys are {key[0..n-1]}.  The index has its own copy of the
+    keys. The cost is {O(n)} time and space. */
+
+void msm_seed_index_free(msm_seed_index_t *X);
+  /* Releases all storage used by {X}, including {*X} itself. */
+
+typedef struct msm_seed_t 
+  { int32_t i0;    /* Index of first sample on side 0. */
+    int32_t i1;    /* Index of first sample on side 1. */
+    int32_t len;   /* Number of rungs. */
+  } msm_seed_t;
+  /* A seed, namely the perfect pairing {(i0+t,i1+t)} for {t} in {0..len-1}. */
+
+vec_typedef(msm_seed_vec_t,msm_seed_vec,msm_seed_t);
+
+msm_seed_vec_t msm_seed_find
+  ( msm_seed_index_t *X,
+    int32_t n1,
+    msm_seed_key_t key1[],
+    int32_t maxOcc,
+    int32_t maxGap,
+    int32_t nth
+  );
+  /* Looks up each window of the sequence with keys {key1[0..n1-1]} in
+    the index {X}, and returns the seeds formed by the matches.
+    
+    Each pair of matching windows with start indices {i0} (in the indexed
+    sequence) and {i1} (in the query sequence) is a /hit/, that lies on the
+    diagonal {i1-i0}.  Windows of the query that match more than
+    {maxOcc} windows of {X} (e.g. low-complexity repeats) are
+    ignored, unless {maxOcc} is zero.  Hits on the same diagonal whose
+    start indices differ by at most {maxGap} are chained into a single
+    seed, that extends from the first sample of the first window to
+    the last sample of the last one.  Thus each seed has at least {k} rungs,
+    and seeds on the same diagonal are separated by more than {maxGap-k}
+    rungs.
+    
+    The seeds are returned sorted by diagonal {i1-i0}, and by {i1} within
+    each diagonal. The queries are distributed among {nth} threads (one
+    per available processor, if {nth} is zero). The result does not
+    depend on {nth}. */
+
+#endif
@@ -1,5 +1,5 @@
 /* See pst_signature.h */
-/* Last edited on 2016-03-16 16:09:18 by stolfilocal */ 
+/* Last edited on 2026-10-19 12:02:58 by stolfilocal */ 
 
 #define _GNU_SOURCE
 #include <stdio.h>
@@ -9,14 +9,51 @@
 
 #include <vec.h>
 #include <affirm.h>
+#include <jsthread.h>
 #include <float_image.h>
 
 #include <pst_basic.h>
 #include <pst_signature.h>
+#include <pst_signature_index.h>
 #include <pst_normal_map.h>
 
 #define ltn_normals_debug TRUE
 
+/* INTERNAL PROTOTYPES */
+
+int pst_signature_match
+  ( int NF,               /* Number of light fields. */
+    int NC,               /* Number of color channels. */
+    signature_t sig[],    /* Normalized light signature for each channel (size {NC}). */ 
+    light_table_t *tab,   /* Light-to-normal table extracted from gauge. */
+    int kHint,            /* Probable best entry of {tab}, or -1. */
+    double *dsq,          /* (OUT) Discrepancy squared between {sig} and best match from table. */
+    r3_t *nrm,            /* (OUT) Normal associated to best match in table. */
+    float clr[]           /* (OUT) Intrinisc scene color (size {NC}). */
+  );
+  /* Same as {pst_signature_search_table}, but also returns the index
+    of the best entry in {tab}.  If {tab} has a search index, {kHint}
+    is passed to {pst_signature_index_find_best}; otherwise it is ignored. */
+
+typedef struct pst_signature_job_t
+  { int NG;                  /* Number of light gauges. */
+    light_table_t **tab;     /* The light-to-normal tables of the gauges. */
+    image_vec_t *IMGV;       /* Photos of the scene. */
+    int maxval;              /* Number of quantization levels in original quantized images. */
+    double noise;            /* Standard deviation of additional per-sample noise. */
+    float_image_t *NRM;      /* (OUT) Nomal map of the scene. */
+    float_image_t *CLR;      /* (OUT) Intrinsic color map of the scene. */
+    float_image_t *DIF;      /* (OUT) Strangeness map of the scene. */
+  } pst_signature_job_t;
+  /* Arguments of {pst_signature_normals_from_photos} for the threads. */
+
+void pst_signature_normals_from_photos_rows(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Computes the normal, color, and strangeness maps of
+    {pst_signature_normals_from_photos} in rows {ini..fin}.
+    The argument {arg} must be the {pst_signature_job_t} of the call. */
+
+/* IMPLEMENTATIONS */
+
 void pst_signature_extract 
   ( image_vec_t *IMGV, /* Scene images under {NF} different light fields. */
     int maxval,        /* Maxval of original (quantized) images. */                 
@@ -85,6 +122,9 @@ light_table_t *pst_signature_build_table
     int NY = (int)(IMGV->e[0]->sz[2]);  /* Number of rows in each image. */ 
     light_table_t *tab = (light_table_t *)notnull(malloc(sizeof(light_table_t)), "no mem");
     tab->pos = *pos;
+    tab->NF = NF;
+    tab->NC = NC;
+    tab->idx = NULL;
     tab->nrm = r3_vec_new(0);  /* {nrm[k]} is the normal of entry {k}. */
     tab->sig = (signature_vec_t *)notnull(malloc(NC*sizeof(signature_vec_t)), "no mem");
     int c;
@@ -120,6 +160,7 @@ light_table_t *pst_signature_build_table
     /* Trim vectors to exact size: */
     r3_vec_trim(&(tab->nrm), NE);
     for (c = 0; c < NC; c++) { signature_vec_trim(&(tab->sig[c]), NE); }
+    if (cubify) { tab->idx = pst_signature_index_new(tab); }
     return tab;
   }
 
@@ -135,7 +176,20 @@ void pst_signature_search_table
     float clr[]           /* (OUT) Intrinisc scene color (size {NC}). */
   )
   {
-    int NS = NF*NC;
+    (void)pst_signature_match(NF, NC, sig, tab, -1, dsq, nrm, clr);
+  }
+
+int pst_signature_match
+  ( int NF,
+    int NC,
+    signature_t sig[],
+    light_table_t *tab,
+    int kHint,
+    double *dsq,
+    r3_t *nrm,
+    float clr[]
+  )
+  {
     int NE = tab->NE;
     
     auto double ediff2(signature_t *sigA, signature_t *sigB);
@@ -149,34 +203,40 @@ void pst_signature_search_table
       { /* We need {E[\abs{(sigA + delA) - (sigB + delB)}^2]}. */
         double sum_d2 = 0.0;
         int j;
-        for (j = 0; j < NS; j++) 
+        for (j = 0; j < NF; j++) 
           { double dj = sigA->rin[j] - sigB->rin[j];
             sum_d2 += dj*dj;
           }
         return sum_d2 + sigA->var + sigB->var;
       }
       
-    /* Brute force search: */
     int kBest = -1;
     double d2Best = +INF;
-    { int k;
-      for (k = 0; k < NE; k++)
-        { /* Compute distances for each channel: */
-          double sum_wd2 = 0.0;
-          double sum_w = 0.0;
-          int c;
-          for (c = 0; c < NC; c++)
-            { signature_t *sigAc = &(sig[c]);
-              signature_t *sigBck = &(tab->sig[c].e[k]);
-              double cd2 = ediff2(sigAc, sigBck);
-              double w = 1.0/(sigAc->var + sigBck->var);
-              sum_wd2 += w*cd2;
-              sum_w += w;
-            }
-          double d2 = sum_wd2/sum_w;
-          if (d2 < d2Best) { kBest = k; d2Best = d2; }
-        }
-    }
+    if (tab->idx != NULL)
+      { /* Indexed search: */
+        kBest = pst_signature_index_find_best(tab->idx, sig, kHint, &d2Best);
+      }
+    else
+      { /* Brute force search: */
+        int k;
+        for (k = 0; k < NE; k++)
+          { /* Compute distances for each channel: */
+            double sum_wd2 = 0.0;
+            double sum_w = 0.0;
+            int c;
+            for (c = 0; c < NC; c++)
+              { signature_t *sigAc = &(sig[c]);
+                signature_t *sigBck = &(tab->sig[c].e[k]);
+                double cd2 = ediff2(sigAc, sigBck);
+                double w = 1.0/(sigAc->var + sigBck->var);
+                sum_wd2 += w*cd2;
+                sum_w += w;
+              }
+            double d2 = sum_wd2/sum_w;
+            if (d2 < d2Best) { kBest = k; d2Best = d2; }
+          }
+      }
+    demand(kBest >= 0, "no valid match in light table");
 
     /* Return normal and mismatch of best match: */
     (*nrm) = tab->nrm.e[kBest];
@@ -190,6 +250,7 @@ void pst_signature_search_table
           clr[c] = (float)cc;
         }
     }        
+    return kBest;
   }
 
 signature_t pst_signature_new(int NF)
@@ -206,6 +267,7 @@ void pst_signature_normals_from_photos
     image_vec_t *IMGV, 
     int maxval,
     double noise,
+    int nth,
     float_image_t *NRM,
     float_image_t *CLR,
     float_image_t *DIF
@@ -231,6 +293,20 @@ void pst_signature_normals_from_photos
     demand(DIF->sz[2] == NY, "bad num rows in strangeness map");
     
     /* Process scene images, store normal images: */
+    pst_signature_job_t job = (pst_signature_job_t)
+      { .NG = NG, .tab = tab, .IMGV = IMGV, .maxval = maxval, .noise = noise,
+        .NRM = NRM, .CLR = CLR, .DIF = DIF
+      };
+    jsthread_run_ranges(NY, 1, nth, &pst_signature_normals_from_photos_rows, &job);
+  }
+
+void pst_signature_normals_from_photos_rows(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    pst_signature_job_t *job = (pst_signature_job_t *)arg;
+    image_vec_t *IMGV = job->IMGV;
+    int NF = IMGV->ne;
+    int NC = (int)(IMGV->e[0]->sz[0]);
+    int NX = (int)(IMGV->e[0]->sz[1]);
     int c, x, y;
     r3_t nrm;         /* Computed normal vector of scene surface at some pixel. */
     float clr[NC];    /* Computed intrinsic color of scene surface at some pixel. */
@@ -238,32 +314,37 @@ void pst_signature_normals_from_photos
     signature_t sig[NC]; /* Light signature at pixel {(x,y)}. */
     for (c = 0; c < NC; c++) { sig[c] = pst_signature_new(NF); }          
     /* Process scene pixels: */
-    for (y = 0; y < NY; y++)
-      { for (x = 0; x < NX; x++)
+    for (y = ini; y <= fin; y++)
+      { int gPrev = -1; /* Table used for the previous pixel in this row. */
+        int kPrev = -1; /* Best entry of {gPrev} for that pixel. */
+        for (x = 0; x < NX; x++)
           { r2_t pos = (r2_t){{ x + 0.5, y + 0.5}}; /* Nominal pixel position. */
             /* Get light signature of scene surface at pixel {(x,y)} in each channel: */
             for (c = 0; c < NC; c++)
-              { pst_signature_extract(IMGV, maxval, noise, c, x, y, &(sig[c])); }
+              { pst_signature_extract(IMGV, job->maxval, job->noise, c, x, y, &(sig[c])); }
             
             /* Find light field gauge closest to pixel: */
             int gBest = -1;
             { double d2Best = +INF;
               int g;
-              for (g = 0; g < NG; g++)
-                { double d2 = r2_dist_sqr(&pos, &(tab[g]->pos)); 
+              for (g = 0; g < job->NG; g++)
+                { double d2 = r2_dist_sqr(&pos, &(job->tab[g]->pos)); 
                   if (d2 < d2Best) { d2Best = d2; gBest = g; }
                 }
             }
             /* Map light signature to normal and intrinstic color: */
-            pst_signature_search_table(NF, NC, sig, pos, NG, tab[gBest], &dsq, &nrm, clr);
+            int kHint = (gBest == gPrev ? kPrev : -1);
+            kPrev = pst_signature_match(NF, NC, sig, job->tab[gBest], kHint, &dsq, &nrm, clr);
+            gPrev = gBest;
             /* Save discrepancy in {DIF}: */
-            float_image_set_sample(DIF, 0, x, y, (float)sqrt(dsq));
+            float_image_set_sample(job->DIF, 0, x, y, (float)sqrt(dsq));
             /* Save normal vector in {NRM}: */
-            pst_normal_map_set_pixel(NRM, x, y, &nrm);
+            pst_normal_map_set_pixel(job->NRM, x, y, &nrm);
             /* Save intrinisc color in {CLR}: */
-            for (c = 0; c < NC; c++) { float_image_set_sample(CLR, c, x, y, clr[c]); }
+            for (c = 0; c < NC; c++) { float_image_set_sample(job->CLR, c, x, y, clr[c]); }
           }
       }
+    for (c = 0; c < NC; c++) { free(sig[c].rin); }
   }
 
 vec_typeimpl(signature_vec_t,signature_vec,signature_t);
@@ -2,7 +2,7 @@
 #define pst_signature_H
 
 /* pst_signature.h -- procedures for computing normals from light signatures. */
-/* Last edited on 2006-04-28 23:25:15 by stolfi */
+/* Last edited on 2026-10-19 12:02:58 by stolfi */
 
 #include <pst_basic.h>
 
@@ -64,12 +64,17 @@ typedef struct light_table_t /* A table that maps light signatures to normal vec
     int NE;                /* Number of color channels. */
     r3_vec_t nrm;          /* {nrm[k]} is the normal vector associated with entry {k}. */
     signature_vec_t *sig;  /* {sig[c][k]} is the light signature in channel {c} for that normal. */
+    struct pst_signature_index_t *idx; /* Search index for the table, or NULL. */
   } light_table_t;
   /* A light table stored the normalized light signatures extracted
     from the light gauge images. Each entry {k} of the table comes from
     some pixel of those images, that was considered valid by some
     criterion.  The table contains the normal at that pixel, and
-    the normalized light signatures for each color channel. */
+    the normalized light signatures for each color channel.
+    
+    If {idx} is not NULL, it is a search index for the table (see
+    {pst_signature_index.h}), that is used instead of a sequential
+    scan of all entries. */
 
 light_table_t *pst_signature_build_table
   ( r2_t *pos,            /* Position in scene images where table is most valid. */
@@ -86,7 +91,7 @@ light_table_t *pst_signature_build_table
     
     The images {IMGV[0..NF-1]} must have the same dimensions and the same 
     number {NC} of channels. If {cubify} is true, the table will be
-    provided with a bucket grid accelerator. */
+    provided with a search index. */
 
 void pst_signature_search_table
   ( int NF,               /* Number of light fields. */
@@ -117,6 +122,7 @@ void pst_signature_normals_from_photos
     image_vec_t *IMGV,       /* {IMGV[0..NF-1]} are photos of a scene under {NF} light fields. */
     int maxval,              /* Number of quantization levels in original quantized images. */
     double noise,            /* Standard deviation of additional per-sample noise. */
+    int nth,                 /* Number of threads, or 0 for one per processor. */
     float_image_t *NRM,      /* (OUT) Nomal map of the scene. */
     float_image_t *CLR,      /* (OUT) Intrinsic color map of the scene. */
     float_image_t *DIF       /* (OUT) Strangeness map of the scene. */
@@ -149,7 +155,12 @@ void pst_signature_normals_from_photos
     difference between its appeareance in the photos and the
     appearance of the matching gauge pixel, after accounting for
     differences in intrinsic color. The value 0 means a perfect match;
-    the value 1 means the largest mismatch possible. */
+    the value 1 means the largest mismatch possible. 
+    
+    The rows of the scene are distributed among {nth} threads.  Within
+    each row, the best match of each pixel is used as the starting
+    guess for the search of the next one, when the tables have search
+    indices. */
 
 
 #endif
@@ -0,0 +1,284 @@
+/* See pst_signature_index.h */
+/* Last edited on 2026-10-19 15:02:44 by stolfi */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <affirm.h>
+
+#include <pst_basic.h>
+#include <pst_signature.h>
+#include <pst_signature_index.h>
+
+/* INTERNAL PROTOTYPES */
+
+int pst_signature_index_build_node(pst_signature_index_t *I, int ini, int fin);
+  /* Creates a node of the k-d tree of {I} for rows {ini..fin-1},
+    computes its boxes, and returns its index.  If the node has more
+    than {pst_signature_index_LEAF_SIZE} rows, also builds its subtrees,
+    rearranging the rows as needed. */
+
+void pst_signature_index_select(pst_signature_index_t *I, int ini, int fin, int mid, int t);
+  /* Rearranges the rows {ini..fin-1} of {I} so that row {mid} has the
+    value of coordinate {t} that would be there if the rows were sorted by that
+    coordinate; rows {ini..mid-1} have that coordinate less than or equal
+    to it, and rows {mid+1..fin-1} greater than or equal to it. */
+
+void pst_signature_index_swap_rows(pst_signature_index_t *I, int a, int b);
+  /* Swaps rows {a} and {b} of {I}, with their variances and indices. */
+
+double pst_signature_index_row_dsq(pst_signature_index_t *I, signature_t sig[], int k);
+  /* Returns the discrepancy between {sig[0..NC-1]} and row {k} of {I},
+    computed exactly as in {pst_signature_search_table}. */
+
+double pst_signature_index_node_dsq(pst_signature_index_t *I, signature_t sig[], int n);
+  /* Returns a lower bound for the discrepancy between {sig[0..NC-1]} and
+    any row of node {n} of {I}. */
+
+void pst_signature_index_search(pst_signature_index_t *I, signature_t sig[], int n, int *kbestP, double *dbestP);
+  /* Searches the subtree of {I} with root node {n} for an entry that
+    is better than the current best {*kbestP,*dbestP}, and
+    updates these variables if found. */
+
+/* IMPLEMENTATIONS */
+
+pst_signature_index_t *pst_signature_index_new(light_table_t *tab)
+  {
+    int NF = tab->NF;
+    int NC = tab->NC;
+    int NE = tab->NE;
+    int ND = NC*NF;
+    pst_signature_index_t *I = notnull(malloc(sizeof(pst_signature_index_t)), "no mem");
+    I->NF = NF;
+    I->NC = NC;
+    I->NE = NE;
+    /* Copy the signatures into the contiguous matrix: */
+    I->X = notnull(malloc(((size_t)NE*ND + 1)*sizeof(double)), "no mem");
+    I->V = notnull(malloc(((size_t)NE*NC + 1)*sizeof(double)), "no mem");
+    I->ix = notnull(malloc((NE + 1)*sizeof(int)), "no mem");
+    int k, c, i;
+    for (k = 0; k < NE; k++)
+      { for (c = 0; c < NC; c++)
+          { signature_t *sig = &(tab->sig[c].e[k]);
+            double *xkc = &(I->X[(size_t)k*ND + c*NF]);
+            for (i = 0; i < NF; i++) { xkc[i] = sig->rin[i]; }
+            I->V[k*NC + c] = sig->var;
+          }
+        I->ix[k] = k;
+      }
+    /* Build the tree: */
+    int maxNN = 2*NE + 1;
+    I->node = notnull(malloc(maxNN*sizeof(pst_signature_node_t)), "no mem");
+    I->box = notnull(malloc(((size_t)2*maxNN*ND + 1)*sizeof(double)), "no mem");
+    I->vbox = notnull(malloc(((size_t)2*maxNN*NC + 1)*sizeof(double)), "no mem");
+    I->NN = 0;
+    if (NE > 0)
+      { int root = pst_signature_index_build_node(I, 0, NE);
+        assert(root == 0);
+      }
+    assert(I->NN <= maxNN);
+    I->row = notnull(malloc((NE + 1)*sizeof(int)), "no mem");
+    for (k = 0; k < NE; k++) { I->row[I->ix[k]] = k; }
+    return I;
+  }
+
+void pst_signature_index_free(pst_signature_index_t *I)
+  { if (I != NULL)
+      { free(I->X);
+        free(I->V);
+        free(I->ix);
+        free(I->row);
+        free(I->node);
+        free(I->box);
+        free(I->vbox);
+        free(I);
+      }
+  }
+
+int pst_signature_index_build_node(pst_signature_index_t *I, int ini, int fin)
+  {
+    int NC = I->NC;
+    int ND = NC*I->NF;
+    int n = I->NN; I->NN++;
+    pst_signature_node_t *nd = &(I->node[n]);
+    nd->ini = ini;
+    nd->fin = fin;
+    nd->sub[0] = nd->sub[1] = -1;
+
+    /* Compute the boxes: */
+    double *bx = &(I->box[(size_t)2*ND*n]);
+    double *vb = &(I->vbox[(size_t)2*NC*n]);
+    int t, c, k;
+    for (t = 0; t < ND; t++) { bx[2*t] = +INF; bx[2*t+1] = -INF; }
+    for (c = 0; c < NC; c++) { vb[2*c] = +INF; vb[2*c+1] = -INF; }
+    for (k = ini; k < fin; k++)
+      { double *xk = &(I->X[(size_t)k*ND]);
+        for (t = 0; t < ND; t++)
+          { if (xk[t] < bx[2*t]) { bx[2*t] = xk[t]; }
+            if (xk[t] > bx[2*t+1]) { bx[2*t+1] = xk[t]; }
+          }
+        double *vk = &(I->V[k*NC]);
+        for (c = 0; c < NC; c++)
+          { if (vk[c] < vb[2*c]) { vb[2*c] = vk[c]; }
+            if (vk[c] > vb[2*c+1]) { vb[2*c+1] = vk[c]; }
+          }
+      }
+
+    if (fin - ini > pst_signature_index_LEAF_SIZE)
+      { /* Choose the axis {tmax} with largest extent: */
+        int tmax = -1;
+        double emax = 0;
+        for (t = 0; t < ND; t++)
+          { double et = bx[2*t+1] - bx[2*t];
+            if (et > emax) { tmax = t; emax = et; }
+          }
+        if (tmax >= 0)
+          { /* Split at the median along that axis: */
+            int mid = (ini + fin)/2;
+            pst_signature_index_select(I, ini, fin, mid, tmax);
+            int sub0 = pst_signature_index_build_node(I, ini, mid);
+            int sub1 = pst_signature_index_build_node(I, mid, fin);
+            /* Note: {nd} is still valid since {I->node} is not reallocated. */
+            nd->sub[0] = sub0;
+            nd->sub[1] = sub1;
+          }
+      }
+    return n;
+  }
+
+void pst_signature_index_select(pst_signature_index_t *I, int ini, int fin, int mid, int t)
+  {
+    int ND = I->NC*I->NF;
+    int lo = ini, hi = fin - 1;
+    while (hi > lo)
+      { /* Partition {lo..hi} around the value of the middle row: */
+        double v = I->X[(size_t)((lo + hi)/2)*ND + t];
+        int a = lo, b = hi;
+        while (a <= b)
+          { while (I->X[(size_t)a*ND + t] < v) { a++; }
+            while (I->X[(size_t)b*ND + t] > v) { b--; }
+            if (a <= b) { pst_signature_index_swap_rows(I, a, b); a++; b--; }
+          }
+        /* Now rows {lo..b} are {<= v}, rows {a..hi} are {>= v}, rows {b+1..a-1} are {== v}: */
+        if (mid <= b)
+          { hi = b; }
+        else if (mid >= a)
+          { lo = a; }
+        else
+          { break; }
+      }
+  }
+
+void pst_signature_index_swap_rows(pst_signature_index_t *I, int a, int b)
+  {
+    if (a == b) { return; }
+    int NC = I->NC;
+    int ND = NC*I->NF;
+    double *xa = &(I->X[(size_t)a*ND]);
+    double *xb = &(I->X[(size_t)b*ND]);
+    int t, c;
+    for (t = 0; t < ND; t++) { double tmp = xa[t]; xa[t] = xb[t]; xb[t] = tmp; }
+    double *va = &(I->V[a*NC]);
+    double *vb = &(I->V[b*NC]);
+    for (c = 0; c < NC; c++) { double tmp = va[c]; va[c] = vb[c]; vb[c] = tmp; }
+    { int tmp = I->ix[a]; I->ix[a] = I->ix[b]; I->ix[b] = tmp; }
+  }
+
+double pst_signature_index_row_dsq(pst_signature_index_t *I, signature_t sig[], int k)
+  {
+    int NF = I->NF;
+    int NC = I->NC;
+    double *xk = &(I->X[(size_t)k*NC*NF]);
+    double *vk = &(I->V[k*NC]);
+    double sum_wd2 = 0.0;
+    double sum_w = 0.0;
+    int c, j;
+    for (c = 0; c < NC; c++)
+      { double *rin = sig[c].rin;
+        double *xkc = &(xk[c*NF]);
+        double sum_d2 = 0.0;
+        for (j = 0; j < NF; j++)
+          { double dj = rin[j] - xkc[j];
+            sum_d2 += dj*dj;
+          }
+        double cd2 = sum_d2 + sig[c].var + vk[c];
+        double w = 1.0/(sig[c].var + vk[c]);
+        sum_wd2 += w*cd2;
+        sum_w += w;
+      }
+    return sum_wd2/sum_w;
+  }
+
+double pst_signature_index_node_dsq(pst_signature_index_t *I, signature_t sig[], int n)
+  {
+    /* Since {w_c*cd2_c = w_c*D_c + 1}, the discrepancy is
+      {(NC + SUM{w_c*D_c})/SUM{w_c}}, where {D_c} is the squared
+      distance in channel {c} and {w_c = 1/(var_c + V_c)}. */
+    int NF = I->NF;
+    int NC = I->NC;
+    double *bx = &(I->box[(size_t)2*NC*NF*n]);
+    double *vb = &(I->vbox[(size_t)2*NC*n]);
+    double num = (double)NC;
+    double den = 0.0;
+    int c, j;
+    for (c = 0; c < NC; c++)
+      { double *rin = sig[c].rin;
+        double *bxc = &(bx[2*c*NF]);
+        double sum_d2 = 0.0;
+        for (j = 0; j < NF; j++)
+          { double gj = 0.0;
+            if (rin[j] < bxc[2*j])
+              { gj = bxc[2*j] - rin[j]; }
+            else if (rin[j] > bxc[2*j+1])
+              { gj = rin[j] - bxc[2*j+1]; }
+            sum_d2 += gj*gj;
+          }
+        num += sum_d2/(sig[c].var + vb[2*c+1]);
+        den += 1.0/(sig[c].var + vb[2*c]);
+      }
+    /* Allow for rounding errors, so that ties are not missed: */
+    return (num/den)*(1.0 - 1.0e-12);
+  }
+
+int pst_signature_index_find_best(pst_signature_index_t *I, signature_t sig[], int kHint, double *dsqP)
+  {
+    int c;
+    for (c = 0; c < I->NC; c++) { demand(sig[c].var >= 0, "invalid signature variance"); }
+    int kbest = -1;
+    double dbest = +INF;
+    if ((kHint >= 0) && (kHint < I->NE))
+      { kbest = kHint;
+        dbest = pst_signature_index_row_dsq(I, sig, I->row[kHint]);
+      }
+    if (I->NE > 0) { pst_signature_index_search(I, sig, 0, &kbest, &dbest); }
+    (*dsqP) = dbest;
+    return kbest;
+  }
+
+void pst_signature_index_search(pst_signature_index_t *I, signature_t sig[], int n, int *kbestP, double *dbestP)
+  {
+    pst_signature_node_t *nd = &(I->node[n]);
+    if (nd->sub[0] < 0)
+      { /* Leaf node, scan its rows: */
+        int r;
+        for (r = nd->ini; r < nd->fin; r++)
+          { double d2 = pst_signature_index_row_dsq(I, sig, r);
+            int k = I->ix[r];
+            if ((d2 < (*dbestP)) || ((d2 == (*dbestP)) && (k < (*kbestP))))
+              { (*kbestP) = k; (*dbestP) = d2; }
+          }
+      }
+    else
+      { /* Visit the nearest child first: */
+        int s0 = nd->sub[0], s1 = nd->sub[1];
+        double d0 = pst_signature_index_node_dsq(I, sig, s0);
+        double d1 = pst_signature_index_node_dsq(I, sig, s1);
+        if (d1 < d0) { int tmp = s0; s0 = s1; s1 = tmp; double tmd = d0; d0 = d1; d1 = tmd; }
+        if (d0 <= (*dbestP)) { pst_signature_index_search(I, sig, s0, kbestP, dbestP); }
+        if (d1 <= (*dbestP)) { pst_signature_index_search(I, sig, s1, kbestP, dbestP); }
+      }
+  }
@@ -0,0 +1,76 @@
+#ifndef pst_signature_index_H
+#define pst_signature_index_H
+
+/* pst_signature_index.h -- fast search of light signature tables. */
+/* Last edited on 2026-10-19 15:02:44 by stolfi */
+
+#include <pst_basic.h>
+#include <pst_signature.h>
+
+/*
+  These tools speed up the search for the best match of a pixel's
+  light signatures in a {light_table_t}, as done by
+  {pst_signature_search_table}.
+
+  The signatures of each table entry, in all {NC} channels, are
+  concatenated into a single vector with {NF*NC} coordinates.  Those
+  vectors are stored in a contiguous matrix, whose rows are organized
+  as a k-d tree.  Since the signatures are determined by the normal
+  direction, they lie near a two-dimensional surface, and a query
+  usually needs to examine only a few leaves of the tree. */
+
+#define pst_signature_index_LEAF_SIZE 8
+  /* Max number of rows in a leaf node of the k-d tree. */
+
+typedef struct pst_signature_node_t
+  { int ini;       /* First row of the node. */
+    int fin;       /* Last row of the node plus one. */
+    int sub[2];    /* Indices of the children nodes, or -1 if leaf. */
+  } pst_signature_node_t;
+  /* A node of the k-d tree of a {pst_signature_index_t}. */
+
+typedef struct pst_signature_index_t
+  { int NF;        /* Number of light fields. */
+    int NC;        /* Number of color channels. */
+    int NE;        /* Number of table entries. */
+    double *X;     /* Row {k} is {X[k*NC*NF + c*NF + i]} for {c} in {0..NC-1}, {i} in {0..NF-1}. */
+    double *V;     /* {V[k*NC + c]} is the noise variance of row {k} in channel {c}. */
+    int *ix;       /* {ix[k]} is the index in the table of the entry in row {k}. */
+    int *row;      /* {row[ix[k]] = k} for all {k}. */
+    int NN;        /* Number of nodes in the k-d tree. */
+    pst_signature_node_t *node; /* The nodes of the tree; node 0 is the root. */
+    double *box;   /* The box of node {n} on axis {t} is {[box[2*(ND*n+t)] _ box[2*(ND*n+t)+1]]}, {ND=NC*NF}. */
+    double *vbox;  /* The range of {V} in node {n}, channel {c}, is {[vbox[2*(NC*n+c)] _ vbox[2*(NC*n+c)+1]]}. */
+  } pst_signature_index_t;
+  /* A search structure for the entries of a light table.  Row {k} of {X}
+    holds the relative intensities {sig[c].e[ix[k]].rin[0..NF-1]} of all
+    channels {c}.  Each node of the tree holds a contiguous range of
+    rows. An internal node has two children that split its rows in
+    two halves, by the median value along the axis of maximum extent.
+    The root holds all rows. */
+
+pst_signature_index_t *pst_signature_index_new(light_table_t *tab);
+  /* Builds a search index for the entries of {tab}.  The index has its
+    own copy of the signatures, so it remains valid if the signatures
+    of {tab} are modified later; but not if entries are added or
+    removed. */
+
+void pst_signature_index_free(pst_signature_index_t *I);
+  /* Deallocates all storage of {I} including the header {*I} itself. */
+
+int pst_signature_index_find_best(pst_signature_index_t *I, signature_t sig[], int kHint, double *dsqP);
+  /* Returns the index {k} of the table entry that best matches the
+    light signatures {sig[0..NC-1]}, with the same discrepancy measure
+    used by {pst_signature_search_table}, and stores that discrepancy
+    into {*dsqP}.  If two or more entries have the same minimum
+    discrepancy, returns the one with smallest index {k}.
+
+    If {kHint} is a valid table entry index, its discrepancy is
+    computed first, so that the search starts with a good bound.  A
+    good hint, such as the result for an adjacent pixel, makes the
+    search faster; the result does not depend on it.
+
+    Requires {sig[c].var > 0} for all {c}, or positive variances
+    in the table. */
+
+#endif
@@ -1,5 +1,5 @@
 /* See pst_slope_map.h */
-/* Last edited on 2017-01-04 18:25:21 by stolfilocal */
+/* Last edited on 2026-10-19 12:10:00 by stolfilocal */
 
 #define _GNU_SOURCE
 #include <stdio.h>
@@ -11,6 +11,7 @@
 #include <jsfile.h>
 #include <r2.h>
 #include <jswsize.h>
+#include <jsprof.h>
 
 #include <pst_basic.h>
 #include <pst_imgsys.h>
@@ -88,6 +89,9 @@ void pst_slope_map_to_depth_map_recursive
 
     int indent = 2*level+2; /* Indentation for messages. */
 
+    jsprof_ENTER_IX("pst_slope_map_to_depth_map_recursive", level);
+    jsprof_COUNT("pixels", ((int64_t)NX_Z)*NY_Z);
+
     if (verbose)
       { fprintf(stderr, "%*sEntering level %d with G size %d%d ...\n", indent, "", level, NX_G, NY_G); }
 
@@ -118,7 +122,9 @@ void pst_slope_map_to_depth_map_recursive
         if (verbose) { fprintf(stderr, "%*sShrinking slope and weight maps ...\n", indent, ""); }
         float_image_t *SIG; 
         float_image_t *SIW;
+        jsprof_ENTER("shrink");
         pst_slope_and_weight_map_shrink(IG,IW, &SIG,&SIW);
+        jsprof_LEAVE("shrink");
         
         /* Compute the half-scale height map: */
         float_image_t *SOZ, *SOW;
@@ -132,7 +138,9 @@ void pst_slope_map_to_depth_map_recursive
         
         /* Expand the computed height map to double size: */
         if (verbose) { fprintf(stderr, "%*sExpanding height map to %d%d ...\n", indent, "", NX_Z, NY_Z); }
+        jsprof_ENTER("expand");
         pst_height_map_expand(SOZ, SOW, OZ, OW);
+        jsprof_LEAVE("expand");
           
         /* Free the working storage: */
         float_image_free(SIG);
@@ -148,7 +156,9 @@ void pst_slope_map_to_depth_map_recursive
         int NP_Z = NX_Z*NY_Z;
         if (verbose) { fprintf(stderr, "%*sBuilding linear system for %d pixels ...\n", indent, "", NP_Z); }
         bool_t full = FALSE; /* Should be parameter. FALSE means exclude indeterminate pixels. */
+        jsprof_ENTER("build_system");
         pst_imgsys_t *S = pst_slope_map_build_integration_system(IG, IW, full);
+        jsprof_LEAVE("build_system");
         if (OW != NULL) { pst_slope_map_extract_system_weight_image(S, OW); }
         if (verbose) { fprintf(stderr, "%*sSystem has %d equations and %d unknowns\n", indent, "", S->N, S->N); }
         if (reportSys != NULL) { reportSys(level, S); }
@@ -159,7 +169,9 @@ void pst_slope_map_to_depth_map_recursive
         int szero = 1; /* Should be parameter. 1 means adjust sum to zero, 0 let it float. */
         int *ord = NULL;
         if (topoSort) { ord = pst_imgsys_sort_equations(S); }
+        jsprof_ENTER("solve");
         pst_slope_map_solve_system(S, OZ, ord, maxIter, convTol, para, szero, verbose, level, reportIter, reportHeights);
+        jsprof_LEAVE("solve");
         pst_imgsys_free(S);
         if (ord != NULL) { free(ord); }
       }
@@ -175,6 +187,7 @@ void pst_slope_map_to_depth_map_recursive
             indent, "", level, OZ->sz[1], OZ->sz[2]
           );
       }
+    jsprof_LEAVE("pst_slope_map_to_depth_map_recursive");
   }
 
 void pst_slope_and_weight_map_shrink
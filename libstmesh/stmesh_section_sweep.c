@@ -0,0 +1,279 @@
+/* See {stmesh_section_sweep.h}. */
+/* Last edited on 2026-10-19 11:02:33 by jstolfi */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsthread.h>
+
+#include <stmesh.h>
+#include <stmesh_section.h>
+#include <stmesh_section_sweep.h>
+
+/* INTERNAL PROTOTYPES */
+
+typedef struct stmesh_section_sweep_end_t
+  { stmesh_edge_unx_t uxe;  /* Index of the mesh edge. */
+    uint32_t id;            /* Segment index {s} times 2 plus end index {r}. */
+  } stmesh_section_sweep_end_t;
+  /* An end of a section segment, which lies on a mesh edge. */
+
+typedef struct stmesh_section_sweep_work_t
+  { uint32_t na_max;                   /* Allocated size of per-segment tables. */
+    stmesh_section_zspan_t *act;       /* The active faces. */
+    stmesh_edge_t *se;                 /* Crossed sides of the active faces, two per face. */
+    stmesh_section_sweep_end_t *end;   /* Segment ends sorted by edge index. */
+    uint32_t *pos;                     /* {pos[id]} is the index of end {id} in {end}. */
+    bool_t *used;                      /* {used[s]} tells whether segment {s} has been chained. */
+    uint32_t *estart;                  /* Path starts for {stmesh_section_make}. */
+    stmesh_edge_t *pe;                 /* Path edges for {stmesh_section_make}. */
+  } stmesh_section_sweep_work_t;
+  /* Work areas for one sweep over a range of planes.  The active
+    face list {act} has {na_max} entries; {se,end,pos,pe} have
+    {2*na_max}, and {used,estart} have {na_max+1}. */
+
+typedef struct stmesh_section_sweep_job_t
+  { stmesh_section_sweep_t *swp;  /* The face index. */
+    int32_t *pZ;                  /* The plane {Z}-coordinates. */
+    stmesh_section_t **sec;       /* Where to store the sections. */
+  } stmesh_section_sweep_job_t;
+  /* Arguments of {stmesh_section_sweep_range}. */
+
+void stmesh_section_sweep_range(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Computes the sections {job->sec[ini..fin]} by the planes
+    {job->pZ[ini..fin]} with a single sweep, where {job} is
+    {(stmesh_section_sweep_job_t *)arg}. */
+
+void stmesh_section_sweep_work_expand(stmesh_section_sweep_work_t *wk, uint32_t na);
+  /* Makes sure that the work areas of {wk} can hold {na} active faces. */
+
+void stmesh_section_sweep_work_free(stmesh_section_sweep_work_t *wk);
+  /* Reclaims the work areas of {wk}, but not the record {*wk}. */
+
+stmesh_section_t *stmesh_section_sweep_chain
+  ( stmesh_t mesh,
+    int32_t pZ,
+    uint32_t na,
+    stmesh_section_sweep_work_t *wk
+  );
+  /* Builds the section of {mesh} at plane {pZ}, given the indices
+    {wk->act[0..na-1].uxf} of the faces that cross that plane. */
+
+int stmesh_section_sweep_zspan_cmp(const void *a, const void *b);
+  /* Compares two {stmesh_section_zspan_t} records by {.minZ}, then by {.uxf}. */
+
+int stmesh_section_sweep_end_cmp(const void *a, const void *b);
+  /* Compares two {stmesh_section_sweep_end_t} records by {.uxe}, then by {.id}. */
+
+/* IMPLEMENTATIONS */
+
+stmesh_section_sweep_t *stmesh_section_sweep_new(stmesh_t mesh)
+  {
+    stmesh_section_sweep_t *swp = notnull(malloc(sizeof(stmesh_section_sweep_t)), "no mem");
+    uint32_t nf = stmesh_face_count(mesh);
+    swp->mesh = mesh;
+    swp->nf = nf;
+    swp->fz = notnull(malloc((nf == 0 ? 1 : nf)*sizeof(stmesh_section_zspan_t)), "no mem");
+    stmesh_face_unx_t uxf;
+    for (uxf = 0; uxf < nf; uxf++)
+      { stmesh_face_t f = stmesh_get_face(mesh, uxf);
+        stmesh_section_zspan_t *fzi = &(swp->fz[uxf]);
+        stmesh_face_get_zrange(f, &(fzi->minZ), &(fzi->maxZ));
+        fzi->uxf = uxf;
+      }
+    qsort(swp->fz, nf, sizeof(stmesh_section_zspan_t), &stmesh_section_sweep_zspan_cmp);
+    return swp;
+  }
+
+void stmesh_section_sweep_free(stmesh_section_sweep_t *swp)
+  {
+    free(swp->fz);
+    free(swp);
+  }
+
+stmesh_section_t *stmesh_section_sweep_one(stmesh_section_sweep_t *swp, int32_t pZ)
+  {
+    stmesh_section_t *sec = NULL;
+    stmesh_section_sweep_many(swp, 1, &pZ, 1, &sec);
+    return sec;
+  }
+
+void stmesh_section_sweep_many
+  ( stmesh_section_sweep_t *swp,
+    uint32_t np,
+    int32_t pZ[],
+    int32_t nth,
+    stmesh_section_t *sec[]
+  )
+  {
+    demand(np <= INT32_MAX, "too many planes");
+    uint32_t ip;
+    for (ip = 1; ip < np; ip++) { demand(pZ[ip-1] < pZ[ip], "planes not sorted"); }
+    stmesh_section_sweep_job_t job = (stmesh_section_sweep_job_t){ .swp = swp, .pZ = pZ, .sec = sec };
+    jsthread_run_ranges((int32_t)np, 0, nth, &stmesh_section_sweep_range, &job);
+  }
+
+void stmesh_section_sweep_range(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    bool_t debug = FALSE;
+
+    stmesh_section_sweep_job_t *job = (stmesh_section_sweep_job_t *)arg;
+    stmesh_section_sweep_t *swp = job->swp;
+    uint32_t nf = swp->nf;
+    stmesh_section_zspan_t *fz = swp->fz;
+
+    stmesh_section_sweep_work_t wk = (stmesh_section_sweep_work_t){ .na_max = 0 };
+    stmesh_section_sweep_work_expand(&wk, 1);
+    uint32_t na = 0;  /* Number of active faces. */
+    uint32_t kf = 0;  /* Faces {fz[0..kf-1]} have been considered for activation. */
+    int32_t ip;
+    for (ip = ini; ip <= fin; ip++)
+      { int32_t pZi = job->pZ[ip];
+
+        /* Drop the faces that are now entirely below the plane: */
+        uint32_t ka = 0, ja;
+        for (ja = 0; ja < na; ja++)
+          { if (wk.act[ja].maxZ > pZi) { wk.act[ka] = wk.act[ja]; ka++; } }
+        na = ka;
+
+        /* Add the faces that start below the plane: */
+        while ((kf < nf) && (fz[kf].minZ < pZi))
+          { if (fz[kf].maxZ > pZi)
+              { stmesh_section_sweep_work_expand(&wk, na+1);
+                wk.act[na] = fz[kf]; na++;
+              }
+            kf++;
+          }
+
+        if (debug) { fprintf(stderr, "thread %d plane %d at Z = %+d: %u active faces\n", ith, ip, pZi, na); }
+        job->sec[ip] = stmesh_section_sweep_chain(swp->mesh, pZi, na, &wk);
+      }
+    stmesh_section_sweep_work_free(&wk);
+  }
+
+stmesh_section_t *stmesh_section_sweep_chain
+  ( stmesh_t mesh,
+    int32_t pZ,
+    uint32_t na,
+    stmesh_section_sweep_work_t *wk
+  )
+  {
+    /* Collect the crossed sides of all active faces: */
+    uint32_t s;
+    for (s = 0; s < na; s++)
+      { stmesh_face_t f = stmesh_get_face(mesh, wk->act[s].uxf);
+        stmesh_face_get_sliced_sides(mesh, f, pZ, &(wk->se[2*s]));
+        uint32_t r;
+        for (r = 0; r < 2; r++)
+          { uint32_t id = 2*s + r;
+            wk->end[id].uxe = stmesh_edge_get_unx(mesh, wk->se[id]);
+            wk->end[id].id = id;
+          }
+        wk->used[s] = FALSE;
+      }
+
+    /* Group the segment ends by edge: */
+    uint32_t nend = 2*na;
+    qsort(wk->end, nend, sizeof(stmesh_section_sweep_end_t), &stmesh_section_sweep_end_cmp);
+    uint32_t j;
+    for (j = 0; j < nend; j++) { wk->pos[wk->end[j].id] = j; }
+
+    /* Chain the segments into paths, open ones first: */
+    uint32_t nc = 0;  /* Number of paths found. */
+    uint32_t nv = 0;  /* Number of path vertices (edges) found. */
+    wk->estart[0] = 0;
+    int pass;
+    for (pass = 0; pass < 2; pass++)
+      { uint32_t ga = 0; /* Start of current edge group in {end}. */
+        while (ga < nend)
+          { uint32_t gb = ga + 1; /* End of group. */
+            while ((gb < nend) && (wk->end[gb].uxe == wk->end[ga].uxe)) { gb++; }
+            bool_t odd = (((gb - ga) % 2) != 0);
+            if ((pass == 1) || odd)
+              { /* Start paths at this edge while it has unused segments: */
+                while (TRUE)
+                  { /* Find an unused segment {s} incident to the current group {ca..cb-1}: */
+                    uint32_t ca = ga, cb = gb;
+                    uint32_t k = ca;
+                    while ((k < cb) && wk->used[wk->end[k].id/2]) { k++; }
+                    if (k >= cb) { break; }
+                    /* Start a new path: */
+                    wk->pe[nv] = wk->se[wk->end[k].id]; nv++;
+                    while (k < cb)
+                      { uint32_t id = wk->end[k].id;
+                        s = id/2;
+                        wk->used[s] = TRUE;
+                        uint32_t oid = id ^ 1u; /* The other end of {s}. */
+                        wk->pe[nv] = wk->se[oid]; nv++;
+                        /* Move to the group of the other end: */
+                        uint32_t oj = wk->pos[oid];
+                        ca = oj; while ((ca > 0) && (wk->end[ca-1].uxe == wk->end[oj].uxe)) { ca--; }
+                        cb = oj + 1; while ((cb < nend) && (wk->end[cb].uxe == wk->end[oj].uxe)) { cb++; }
+                        k = ca;
+                        while ((k < cb) && wk->used[wk->end[k].id/2]) { k++; }
+                      }
+                    nc++;
+                    wk->estart[nc] = nv;
+                  }
+              }
+            ga = gb;
+          }
+      }
+    assert(nv == na + nc);
+    for (s = 0; s < na; s++) { assert(wk->used[s]); }
+
+    return stmesh_section_make(mesh, pZ, nc, wk->estart, wk->pe);
+  }
+
+void stmesh_section_sweep_work_expand(stmesh_section_sweep_work_t *wk, uint32_t na)
+  {
+    if (na <= wk->na_max) { return; }
+    uint32_t na_max = 2*wk->na_max + 16;
+    if (na_max < na) { na_max = na; }
+    wk->act = notnull(realloc(wk->act, na_max*sizeof(stmesh_section_zspan_t)), "no mem");
+    wk->se = notnull(realloc(wk->se, 2*na_max*sizeof(stmesh_edge_t)), "no mem");
+    wk->end = notnull(realloc(wk->end, 2*na_max*sizeof(stmesh_section_sweep_end_t)), "no mem");
+    wk->pos = notnull(realloc(wk->pos, 2*na_max*sizeof(uint32_t)), "no mem");
+    wk->used = notnull(realloc(wk->used, (na_max+1)*sizeof(bool_t)), "no mem");
+    wk->estart = notnull(realloc(wk->estart, (na_max+1)*sizeof(uint32_t)), "no mem");
+    wk->pe = notnull(realloc(wk->pe, 2*na_max*sizeof(stmesh_edge_t)), "no mem");
+    wk->na_max = na_max;
+  }
+
+void stmesh_section_sweep_work_free(stmesh_section_sweep_work_t *wk)
+  {
+    free(wk->act);
+    free(wk->se);
+    free(wk->end);
+    free(wk->pos);
+    free(wk->used);
+    free(wk->estart);
+    free(wk->pe);
+  }
+
+int stmesh_section_sweep_zspan_cmp(const void *a, const void *b)
+  {
+    const stmesh_section_zspan_t *fa = (const stmesh_section_zspan_t *)a;
+    const stmesh_section_zspan_t *fb = (const stmesh_section_zspan_t *)b;
+    if (fa->minZ < fb->minZ) { return -1; }
+    if (fa->minZ > fb->minZ) { return +1; }
+    if (fa->uxf < fb->uxf) { return -1; }
+    if (fa->uxf > fb->uxf) { return +1; }
+    return 0;
+  }
+
+int stmesh_section_sweep_end_cmp(const void *a, const void *b)
+  {
+    const stmesh_section_sweep_end_t *ea = (const stmesh_section_sweep_end_t *)a;
+    const stmesh_section_sweep_end_t *eb = (const stmesh_section_sweep_end_t *)b;
+    if (ea->uxe < eb->uxe) { return -1; }
+    if (ea->uxe > eb->uxe) { return +1; }
+    if (ea->id < eb->id) { return -1; }
+    if (ea->id > eb->id) { return +1; }
+    return 0;
+  }
@@ -0,0 +1,84 @@
+/* Slicing a mesh at many planes with a sweeping {Z}-interval index. */
+/* Last edited on 2026-10-19 10:41:07 by jstolfi */
+
+#ifndef stmesh_section_sweep_H
+#define stmesh_section_sweep_H
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+
+#include <bool.h>
+
+#include <stmesh.h>
+#include <stmesh_section.h>
+
+typedef struct stmesh_section_zspan_t
+  { int32_t minZ;           /* Minimum quantized {Z} of the face's corners. */
+    int32_t maxZ;           /* Maximum quantized {Z} of the face's corners. */
+    stmesh_face_unx_t uxf;  /* Index of the face in the mesh. */
+  } stmesh_section_zspan_t;
+  /* The {Z}-extent of a face of a mesh. */
+
+typedef struct stmesh_section_sweep_t
+  { stmesh_t mesh;                /* The mesh being sliced. */
+    uint32_t nf;                  /* Number of faces in {mesh}. */
+    stmesh_section_zspan_t *fz;   /* The {Z}-extents of all faces, sorted by {.minZ}. */
+  } stmesh_section_sweep_t;
+  /* An index of the faces of {mesh} by their {Z}-extents, for
+    efficient slicing at many horizontal planes.
+
+    The entries {fz[0..nf-1]} are sorted by increasing {.minZ},
+    with ties broken by increasing {.uxf}.  A sweep over planes with
+    increasing {Z} can then keep a list of the /active/ faces (those
+    whose {Z}-range straddles the current plane) by appending faces
+    from {fz} as their {.minZ} is passed and dropping them when their
+    {.maxZ} is passed.  Slicing {np} planes this way costs
+    {O(nf*log(nf) + np + K)}, where {K} is the total number of
+    face-plane crossings, instead of {O(np*nf)}. */
+
+stmesh_section_sweep_t *stmesh_section_sweep_new(stmesh_t mesh);
+  /* Builds the {Z}-interval index of the faces of {mesh}.  The {mesh}
+    must not be modified or reclaimed while the index is in use. */
+
+void stmesh_section_sweep_free(stmesh_section_sweep_t *swp);
+  /* Reclaims the storage used by the index {swp}, including the
+    descriptor {*swp} itself, but not the mesh. */
+
+stmesh_section_t *stmesh_section_sweep_one(stmesh_section_sweep_t *swp, int32_t pZ);
+  /* Computes the cross-section of the mesh of {swp} by the horizontal
+    plane with quantized {Z}-coordinate {pZ}.  Equivalent to
+    {stmesh_section_sweep_many} with a single plane and one thread. */
+
+void stmesh_section_sweep_many
+  ( stmesh_section_sweep_t *swp,
+    uint32_t np,
+    int32_t pZ[],
+    int32_t nth,
+    stmesh_section_t *sec[]
+  );
+  /* Computes the cross-sections of the mesh of {swp} by the {np}
+    horizontal planes with quantized {Z}-coordinates {pZ[0..np-1]}, and
+    stores them in {sec[0..np-1]}.  The sections are newly allocated
+    with {stmesh_section_make}, and should be reclaimed by the client
+    with {stmesh_section_free}.
+
+    The {pZ} values must be strictly increasing, and no plane may go
+    through a vertex of the mesh. (If the mesh was built with
+    even-quantized vertices, any odd {pZ} is safe.)
+
+    The cross-section at each plane is obtained by collecting the
+    faces that cross the plane, computing the two sides of each
+    face that are crossed by it, and chaining the resulting segments
+    through their shared edges into paths.  Chaining starts from the
+    edges that have an odd number of incident crossing faces (which
+    yield open paths), then closes the remaining loops.  If an edge
+    has more than two incident crossing faces, the segments are
+    paired in arbitrary order.
+
+    The list of planes is split into {nth} contiguous ranges that are
+    processed in parallel, each by an independent sweep (see
+    {jsthread_run_ranges}).  If {nth} is zero, uses one thread per
+    available processor. */
+
+#endif
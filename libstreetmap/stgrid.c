@@ -0,0 +1,150 @@
+/* See stgrid.h */
+/* Last edited on 2026-10-19 11:26:34 by jstolfi */
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdlib.h>
+
+#include <stgrid.h>
+#include <stmap.h>
+
+#include <bool.h>
+#include <affirm.h>
+#include <jsmath.h>
+
+void st_grid_get_cell(st_VertexGrid *g, Point p, int *ixP, int *iyP);
+  /* Returns in {*ixP,*iyP} the indices of the grid cell that contains
+    {p}, or the nearest cell if {p} lies outside the grid. */
+
+st_VertexGrid *st_grid_new(Map *m, double step)
+  { st_VertexGrid *g = (st_VertexGrid *)malloc(sizeof(st_VertexGrid));
+    affirm(g != NULL, "out of memory while allocating vertex grid");
+    int nv = m->nv;
+    g->nv = nv;
+
+    /* Get the bounding box of all vertices: */
+    Interval xr, yr;
+    if (nv > 0)
+      { st_map_get_bbox(m, &xr, &yr); }
+    else
+      { xr = (Interval){ 0, 0 }; yr = (Interval){ 0, 0 }; }
+    double wx = xr.hi - xr.lo;
+    double wy = yr.hi - yr.lo;
+
+    /* Choose the cell size, if not given, and the grid dimensions: */
+    if (step <= 0)
+      { double area = wx*wy;
+        if (area > 0)
+          { step = sqrt(2*area/(nv + 1)); }
+        else
+          { step = fmax(wx, wy)/(0.5*nv + 1); }
+        if (step <= 0) { step = 1.0; }
+      }
+    int nx, ny;
+    while (TRUE)
+      { nx = (int)floor(wx/step) + 1;
+        ny = (int)floor(wy/step) + 1;
+        /* Avoid too many empty cells: */
+        if (((double)nx)*((double)ny) <= 4.0*nv + 16) { break; }
+        step *= 1.5;
+      }
+    g->xlo = xr.lo; g->ylo = yr.lo;
+    g->step = step;
+    g->nx = nx; g->ny = ny;
+
+    /* Count the vertices in each cell: */
+    int nc = nx*ny;
+    g->cstart = (int *)malloc((nc + 1)*sizeof(int));
+    affirm(g->cstart != NULL, "out of memory while allocating vertex grid");
+    g->vi = (int *)malloc((nv + 1)*sizeof(int));
+    affirm(g->vi != NULL, "out of memory while allocating vertex grid");
+    int *cell = (int *)malloc((nv + 1)*sizeof(int)); /* {cell[vi]} is the cell of vertex {vi}. */
+    affirm(cell != NULL, "out of memory while allocating vertex grid");
+    int k, vi;
+    for (k = 0; k <= nc; k++) { g->cstart[k] = 0; }
+    for (vi = 0; vi < nv; vi++)
+      { int ix, iy;
+        st_grid_get_cell(g, m->vd[vi]->p, &ix, &iy);
+        cell[vi] = ix + nx*iy;
+        g->cstart[cell[vi] + 1]++;
+      }
+    for (k = 0; k < nc; k++) { g->cstart[k+1] += g->cstart[k]; }
+
+    /* Distribute the vertices, in increasing ID order: */
+    int *next = (int *)malloc(nc*sizeof(int));
+    affirm(next != NULL, "out of memory while allocating vertex grid");
+    for (k = 0; k < nc; k++) { next[k] = g->cstart[k]; }
+    for (vi = 0; vi < nv; vi++) { g->vi[next[cell[vi]]] = vi; next[cell[vi]]++; }
+    free(next);
+    free(cell);
+    return g;
+  }
+
+void st_grid_get_cell(st_VertexGrid *g, Point p, int *ixP, int *iyP)
+  { double fx = floor((p.c[0] - g->xlo)/g->step);
+    double fy = floor((p.c[1] - g->ylo)/g->step);
+    (*ixP) = (fx < 0 ? 0 : (fx >= g->nx ? g->nx - 1 : (int)fx));
+    (*iyP) = (fy < 0 ? 0 : (fy >= g->ny ? g->ny - 1 : (int)fy));
+  }
+
+int st_grid_nearest_vertex(st_VertexGrid *g, Map *m, Point p)
+  { affirm(g->nv == m->nv, "grid does not match the map");
+    if (g->nv == 0) { return -1; }
+    int nx = g->nx, ny = g->ny;
+    double step = g->step;
+    int cx, cy;
+    st_grid_get_cell(g, p, &cx, &cy);
+
+    int imin = -1;
+    double d2min = +INF;
+    int r = 0; /* Ring number. */
+    while (TRUE)
+      { if (r > 0)
+          { /* Compute a lower bound {b} for the distance from {p} to ring {r}: */
+            double x0 = g->xlo + (cx - r + 1)*step, x1 = g->xlo + (cx + r)*step;
+            double y0 = g->ylo + (cy - r + 1)*step, y1 = g->ylo + (cy + r)*step;
+            double px = p.c[0], py = p.c[1];
+            double b = 0;
+            if ((px >= x0) && (px <= x1) && (py >= y0) && (py <= y1))
+              { b = fmin(fmin(px - x0, x1 - px), fmin(py - y0, y1 - py));
+                /* Allow for roundoff in the cell assignment: */
+                b = fmax(0, b - 1.0e-9*step);
+              }
+            if ((imin >= 0) && (b*b > d2min)) { break; }
+          }
+        /* Scan the cells of ring {r} that are inside the grid: */
+        int iy;
+        for (iy = cy - r; iy <= cy + r; iy++)
+          { if ((iy < 0) || (iy >= ny)) { continue; }
+            bool_t full_row = ((iy == cy - r) || (iy == cy + r));
+            int dx = (full_row ? 1 : 2*r);
+            if (dx == 0) { dx = 1; }
+            int ix;
+            for (ix = cx - r; ix <= cx + r; ix += dx)
+              { if ((ix < 0) || (ix >= nx)) { continue; }
+                int k = ix + nx*iy;
+                int j;
+                for (j = g->cstart[k]; j < g->cstart[k+1]; j++)
+                  { int vi = g->vi[j];
+                    VertexData *vd = m->vd[vi];
+                    double dxv = (p.c[0] - vd->p.c[0]);
+                    double dyv = (p.c[1] - vd->p.c[1]);
+                    double d2 = dxv*dxv + dyv*dyv;
+                    if ((d2 < d2min) || ((d2 == d2min) && (vi < imin))) { imin = vi; d2min = d2; }
+                  }
+              }
+          }
+        /* Stop if ring {r} reached all borders of the grid: */
+        if ((cx - r <= 0) && (cx + r >= nx - 1) && (cy - r <= 0) && (cy + r >= ny - 1)) { break; }
+        r++;
+      }
+    return imin;
+  }
+
+void st_grid_discard(st_VertexGrid *g)
+  { if (g != NULL)
+      { free(g->cstart);
+        free(g->vi);
+        free(g);
+      }
+  }
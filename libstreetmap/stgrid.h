@@ -0,0 +1,47 @@
+/* stgrid.h -- Uniform grid index of street map vertices */
+/* Last edited on 2026-10-19 11:26:34 by jstolfi */
+
+#ifndef stgrid_H
+#define stgrid_H
+
+#include <stmap.h>
+
+typedef struct st_VertexGrid /* A bucket grid of vertex IDs */
+  { double xlo;    /* Low X coordinate of the grid (m). */
+    double ylo;    /* Low Y coordinate of the grid (m). */
+    double step;   /* Side of each cell (m). */
+    int nx;        /* Number of cells in the X direction. */
+    int ny;        /* Number of cells in the Y direction. */
+    int nv;        /* Number of vertices in the grid. */
+    int *cstart;   /* The vertices in cell {k} are {vi[cstart[k]..cstart[k+1]-1]}. */
+    int *vi;       /* The vertex IDs, grouped by cell. */
+  } st_VertexGrid;
+  /* A uniform grid of square cells that covers the bounding box of
+    a map's vertices.  Cell {[ix,iy]} is the square
+    {[xlo + ix*step _ xlo + (ix+1)*step] x [ylo + iy*step _ ylo + (iy+1)*step]};
+    its index is {k = ix + nx*iy}.  Each vertex is stored in the cell
+    that contains it.  Within each cell, the IDs are in increasing order. */
+
+st_VertexGrid *st_grid_new(Map *m, double step);
+  /* Builds a grid index for the vertices of {m}, with cells of side
+    {step} meters. If {step} is zero or negative, chooses it so that
+    there are about two vertices per cell on average. Uses {O(m->nv)}
+    time and space. */
+
+int st_grid_nearest_vertex(st_VertexGrid *g, Map *m, Point p);
+  /* Returns the ID of the vertex of {m} nearest to {p}, using the
+    index {g}, which must have been built for {m}.  The result is the
+    same as that of a linear scan of all vertices: among vertices at
+    the same distance from {p}, returns the one with the smallest ID.
+    Returns -1 if the map has no vertices.
+
+    The search examines the cells in rings of increasing size around
+    the cell nearest to {p}, and stops as soon as the nearest vertex
+    found is closer than any cell not yet examined.  For maps whose
+    vertices are not too unevenly distributed, the expected cost is
+    {O(1)} per query. */
+
+void st_grid_discard(st_VertexGrid *g);
+  /* Frees the storage allocated for {g}. */
+
+#endif
@@ -1,5 +1,5 @@
 /* See stmap.h */
-/* Last edited on 2017-01-02 21:44:21 by jstolfi */
+/* Last edited on 2026-10-19 11:26:34 by jstolfi */
 
 #define _GNU_SOURCE
 #include <stdio.h>
@@ -10,6 +10,7 @@
 
 #include <stmap.h>
 #include <stheap.h>
+#include <stgrid.h>
 
 #include <pswr.h>
 #include <affirm.h>
@@ -20,6 +21,7 @@
 #include <jsmath.h>
 #include <sign.h>
 #include <sign_get.h>
+#include <jsthread.h>
 
 /* INTERNAL PROTOTYPES */
 
@@ -30,6 +32,43 @@ int  st_map_ccw(Point p, Point q, Point r);
 bool_t st_map_vertex_is_visible(Point p, Interval xr, Interval yr);
 bool_t st_map_edge_is_visible(Point p, Point q, Interval xr, Interval yr);
 
+void st_map_compute_costs_with_heap
+  ( Map *m, 
+    int u, 
+    float dMax,
+    int *r,
+    int *nr, 
+    float *d, 
+    quad_arc_t *e,
+    float *c,
+    st_Heap *h
+  );
+  /* Same as {st_map_compute_costs}, but uses the given heap {h} 
+    (which must be empty) as a work area. */
+
+typedef struct st_CoverageWork
+  { float *d;          /* Vertex costs. */
+    float *c;          /* Arc costs. */
+    quad_arc_t *e;     /* Last arcs of optimum paths. */
+    int *r;            /* Reached vertices. */
+    st_Heap *h;        /* Arc heap. */
+    int *vcover;       /* Partial vertex coverage counts. */
+    int *ecover;       /* Partial edge coverage counts. */
+  } st_CoverageWork;
+  /* Work areas of one thread of {st_compute_coverage}. */
+
+typedef struct st_CoverageJob
+  { Map *m;                /* The map. */
+    int *u;                /* The sites. */
+    float *dMax;           /* Their cost bounds. */
+    st_CoverageWork *wk;   /* Work areas, one per thread. */
+  } st_CoverageJob;
+  /* Arguments of {st_compute_coverage_range}. */
+
+void st_compute_coverage_range(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Adds to {job->wk[ith].vcover,job->wk[ith].ecover} the coverage of
+    sites {job->u[ini..fin]}, where {job} is {(st_CoverageJob *)arg}. */
+
 /* IMPLEMENTATIONS */
 
 Map *st_map_read(FILE *f)
@@ -48,6 +87,7 @@ Map *st_map_read(FILE *f)
     m->along = (quad_arc_t *)malloc(2 * m->ne * sizeof(quad_arc_t));
     m->vd = (VertexData **)malloc(m->nv * sizeof(VertexData *));
     m->ed = (EdgeData **)malloc(m->ne * sizeof(EdgeData *));
+    m->grid = NULL;
     
     for (vi = 0; vi < m->nv; vi++) { m->vd[vi] = NULL; m->out[vi] = quad_arc_NULL; }
     for (ei = 0; ei < m->ne; ei++) { m->ed[ei] = NULL; }
@@ -116,8 +156,24 @@ void st_map_compute_costs
     float *c
   )
   {
-    int vi;
     st_Heap *h = st_heap_new(2*m->ne);
+    st_map_compute_costs_with_heap(m, u, dMax, r, nr, d, e, c, h);
+    st_heap_discard(h);
+  }
+
+void st_map_compute_costs_with_heap
+  ( Map *m, 
+    int u, 
+    float dMax,
+    int *r,
+    int *nr, 
+    float *d, 
+    quad_arc_t *e,
+    float *c,
+    st_Heap *h
+  )
+  {
+    int vi;
     float cprev = 0.0, dprev = 0.0;
 
     /* Let DIRID(a) be the ID number of the *directed* edge {a},
@@ -127,6 +183,7 @@ void st_map_compute_costs
       quad_arc_t {a}; or is {+INF} if that cost is still unknown. */
     
     affirm(dMax >= 0.0, "invalid {dMax}");
+    affirm(h->n == 0, "heap not empty");
 
     (*nr) = 0;
     d[u] = 0.0;
@@ -170,7 +227,6 @@ void st_map_compute_costs
           }
       }
     while (vi >= 0);
-    st_heap_discard(h);
   }
      
 void st_compute_coverage
@@ -178,6 +234,7 @@ void st_compute_coverage
     int *u, 
     float *dMax, 
     int n, 
+    int nth,
     int *vcover,
     int *ecover
   )
@@ -186,25 +243,66 @@ void st_compute_coverage
     for (vi = 0; vi < m->nv; vi++) { vcover[vi] = 0; }
     for (ei = 0; ei < m->ne; ei++) { ecover[ei] = 0; }
     if (n > 0) 
-      { /* Work files for {st_map_compute_costs}: */
-        float d[m->nv];
-        float c[2 * m->ne];
-        quad_arc_t e[m->nv];
-        int r[m->nv];
-        int nr;
+      { nth = jsthread_choose_count(nth, n);
+        /* Work areas for {st_map_compute_costs}, one set per thread: */
+        st_CoverageWork *wk = (st_CoverageWork *)malloc(nth*sizeof(st_CoverageWork));
+        affirm(wk != NULL, "out of memory");
+        int ith;
+        for (ith = 0; ith < nth; ith++)
+          { st_CoverageWork *wki = &(wk[ith]);
+            wki->d = (float *)malloc((m->nv + 1)*sizeof(float));
+            wki->c = (float *)malloc((2*m->ne + 1)*sizeof(float));
+            wki->e = (quad_arc_t *)malloc((m->nv + 1)*sizeof(quad_arc_t));
+            wki->r = (int *)malloc((m->nv + 1)*sizeof(int));
+            affirm((wki->d != NULL) && (wki->c != NULL) && (wki->e != NULL) && (wki->r != NULL), "out of memory");
+            wki->h = st_heap_new(2*m->ne + 1);
+            st_map_init_costs(m, wki->d, wki->e, wki->c);
+            if (ith == 0)
+              { /* Thread 0 tallies directly into the result: */
+                wki->vcover = vcover; wki->ecover = ecover;
+              }
+            else
+              { wki->vcover = (int *)malloc((m->nv + 1)*sizeof(int));
+                wki->ecover = (int *)malloc((m->ne + 1)*sizeof(int));
+                affirm((wki->vcover != NULL) && (wki->ecover != NULL), "out of memory");
+                for (vi = 0; vi < m->nv; vi++) { wki->vcover[vi] = 0; }
+                for (ei = 0; ei < m->ne; ei++) { wki->ecover[ei] = 0; }
+              }
+          }
         /* Count sites that cover each vertex and each edge: */
-        st_map_init_costs(m, d, e, c);
-        int i;
-        for(i = 0; i < n; i++)
-          { int ui = u[i];
-            float dmi = dMax[i];
-            /* Find vertices within cost {dMax} from {ui}: */
-            st_map_compute_costs(m, ui, dmi, r, &nr, d, e, c);
-            /* Tally vertex and edge coverage: */
-            st_increment_coverage(m, dmi, r, nr, d, c, vcover, ecover);
-            /* Reset costs for next {st_map_compute_costs}: */
-            st_map_reset_costs(m, r, nr, d, e, c);
+        st_CoverageJob job = (st_CoverageJob){ .m = m, .u = u, .dMax = dMax, .wk = wk };
+        jsthread_run_ranges(n, 1, nth, &st_compute_coverage_range, &job);
+        /* Merge the partial counts and reclaim the work areas: */
+        for (ith = 0; ith < nth; ith++)
+          { st_CoverageWork *wki = &(wk[ith]);
+            if (ith > 0)
+              { for (vi = 0; vi < m->nv; vi++) { vcover[vi] += wki->vcover[vi]; }
+                for (ei = 0; ei < m->ne; ei++) { ecover[ei] += wki->ecover[ei]; }
+                free(wki->vcover); free(wki->ecover);
+              }
+            free(wki->d); free(wki->c); free(wki->e); free(wki->r);
+            st_heap_discard(wki->h);
           }
+        free(wk);
+      }
+  }
+
+void st_compute_coverage_range(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    st_CoverageJob *job = (st_CoverageJob *)arg;
+    st_CoverageWork *wki = &(job->wk[ith]);
+    Map *m = job->m;
+    int i;
+    for(i = ini; i <= fin; i++)
+      { int ui = job->u[i];
+        float dmi = job->dMax[i];
+        int nr;
+        /* Find vertices within cost {dMax} from {ui}: */
+        st_map_compute_costs_with_heap(m, ui, dmi, wki->r, &nr, wki->d, wki->e, wki->c, wki->h);
+        /* Tally vertex and edge coverage: */
+        st_increment_coverage(m, dmi, wki->r, nr, wki->d, wki->c, wki->vcover, wki->ecover);
+        /* Reset costs for next {st_map_compute_costs}: */
+        st_map_reset_costs(m, wki->r, nr, wki->d, wki->e, wki->c);
       }
   }
   
@@ -324,17 +422,13 @@ void st_map_get_bbox(Map *m, Interval *xr, Interval *yr)
 
 int st_map_nearest_vertex(Map *m, Point p)
   {
-    int vi;
-    int imin = -1;
-    double d2min = +INF;
-    for (vi = 0; vi < m->nv; vi++)
-      { VertexData *vd = m->vd[vi]; 
-        double dx = (p.c[0] - vd->p.c[0]);
-        double dy = (p.c[1] - vd->p.c[1]);
-        double d2 = dx*dx + dy*dy;
-        if (d2 < d2min) { imin = vi; d2min = d2; }
-      }
-    return imin;
+    st_map_build_grid(m);
+    return st_grid_nearest_vertex(m->grid, m, p);
+  }
+
+void st_map_build_grid(Map *m)
+  {
+    if (m->grid == NULL) { m->grid = st_grid_new(m, 0.0); }
   }
 
 /* INTERNAL PROCEDURES */
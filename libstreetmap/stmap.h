@@ -1,5 +1,5 @@
 /* stmap - tools for reading, plotting, and manipulating street maps */
-/* Last edited on 2011-12-21 23:26:41 by stolfi */
+/* Last edited on 2026-10-19 11:26:34 by jstolfi */
 
 #ifndef stmap_H
 #define stmap_H
@@ -41,11 +41,16 @@ typedef struct Map
     EdgeData **ed;      /* Edge data records. */
     quad_arc_t *out;    /* {out[vi]} is some {quad_arc_t} out of vertex number {vi}. */
     quad_arc_t *along;  /* {along[2*ei+s]} is edge {ei} taken in direction {s}. */
+    struct st_VertexGrid *grid; /* Spatial index of the vertices, or NULL. */
   } Map;
   /* A street map is an undirected graph drawn on the plane. The
     quad_arcs {out[vi]} and {along[2*ei+s]} belong to a quad_edge that
     describes the map's topology. For any integer {ai}, we have 
-    {quad_sym_bit(along[ai]) = (ai % 2)}. */
+    {quad_sym_bit(along[ai]) = (ai % 2)}. 
+    
+    The {grid} field is a uniform grid of the vertices (see {stgrid.h})
+    used by {st_map_nearest_vertex}.  It is created on demand, and must 
+    be discarded and reset to NULL if the vertices are moved. */
 
 Map *st_map_read(FILE *f);
   /* Reads a street map from the file {f}. Plot map format:
@@ -128,6 +133,7 @@ void st_compute_coverage
     int *u, 
     float *dMax, 
     int n, 
+    int nth,
     int *vcover,
     int *ecover
   );
@@ -135,7 +141,13 @@ void st_compute_coverage
     respective cost bounds {dMax[0..n-1]}, computes for each vertex {v}
     the number {vcover[v]} of {dMax[i]}-balls centered at {u[i]} that 
     contain {v}; and, for each undirected edge {e}, the count
-    {ecover[e]} of such balls that contain {e}. */
+    {ecover[e]} of such balls that contain {e}. 
+    
+    The sites are processed by {nth} threads in parallel (one per
+    available processor if {nth} is zero).  Each thread has its own
+    work areas for {st_map_compute_costs} and its own partial counts,
+    which are added together at the end; so the result does not depend
+    on {nth}. */
 
 void st_increment_coverage
   ( Map* m,
@@ -179,7 +191,16 @@ void st_map_plot
     in which case suitable defaults are used.  */
 
 int st_map_nearest_vertex(Map *m, Point p);
-  /* Returns the ID of the vertex of {m} nearest to {p}. */
+  /* Returns the ID of the vertex of {m} nearest to {p}.  Among vertices
+    at the same distance, returns the one with the smallest ID.
+    
+    Uses the grid index {m->grid}, building it on the first call if it is
+    NULL.  Therefore, if this procedure is to be called from several 
+    threads, the client should call {st_map_build_grid} beforehand. */
+
+void st_map_build_grid(Map *m);
+  /* Builds the grid index {m->grid} of the vertices of {m}, if it 
+    is NULL. */
 
 void st_map_get_bbox(Map *m, Interval *xr, Interval *yr);
   /* Returns in {*xr} and {*yr} the bounding box of all map vertices. */
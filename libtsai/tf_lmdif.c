@@ -1,5 +1,5 @@
 /* See {tf_lmdif.h} */
-/* Last edited on 2015-10-05 00:15:05 by stolfilocal */
+/* Last edited on 2026-10-19 13:02:18 by stolfilocal */
 
 /* From public domain Fortran version of Argonne National Laboratories MINPACK
   
@@ -11,6 +11,10 @@
 #define _GNU_SOURCE
 #include <float.h>
 #include <math.h>
+#include <stdlib.h>
+
+#include <affirm.h>
+#include <jsthread.h>
 
 #include <tf_lmdif.h>
 
@@ -24,6 +28,42 @@
 
 /* INTERNAL PROTOTYPES */
 
+int lmdif_core
+  ( tf_lmdif_fcn_t *fcn,
+    tf_lmdif_jac_t *jac,
+    int nth,
+    int rblk[],
+    int cblk[],
+    int m,
+    int n,
+    double x[],
+    double fvec[],
+    double ftol,
+    double xtol,
+    double gtol,
+    int maxfev,
+    double epsfcn,
+    double diag[],
+    int mode,
+    double factor,
+    int nprint,
+    int *info,
+    int *nfev,
+    int *njev,
+    double fjac[],
+    int ldfjac,
+    int ipvt[],
+    double qtf[],
+    double wa1[],
+    double wa2[],
+    double wa3[],
+    double wa4[]
+  );
+  /* The Levenberg-Marquardt loop shared by {lmdif}, {lmdif_par}, and {lmder}.
+    If {jac} is not NULL, it is used to compute the Jacobian, and {*njev}
+    counts its calls.  Otherwise the Jacobian is computed by {fdjac2} if
+    {nth} is 1 and {rblk} is NULL, or by {fdjac2_par} otherwise. */
+
 double enorm(int n, double x[]);
   /*  Computes the Euclidean norm of an {n}-vector {x[0..n-1]}.
 
@@ -387,12 +427,143 @@ int fdjac2
     Burton S. Garbow, Kenneth E. Hillstrom, Jorge J. More
   */
 
+int fdjac2_par
+  ( tf_lmdif_fcn_t *fcn,
+    int m,
+    int n,
+    double x[],
+    double fvec[],
+    double fjac[],
+    int ldfjac,
+    int *iflag,
+    double epsfcn,
+    int nth,
+    int rblk[],
+    int cblk[]
+  );
+  /* Same as {fdjac2}, but the calls to {fcn} are
+    distributed among {nth} threads, and the perturbations may be
+    grouped according to the block structure {rblk,cblk}; see
+    {lmdif_par}.  The step {h} for each variable is the same as in
+    {fdjac2}. Returns the number of calls made to {fcn}.  If any call
+    sets its {iflag} to a negative value, sets {*iflag} to the value set by 
+    the call with lowest group index.  Element {i,j} of the 
+    Jacobian is stored in {fjac[i+ldfjac*j]}. */
+
 /* IMPLEMENTATIONS */
 
 #define BUG 0
 
 int lmdif
-  ( void fcn(int m, int n, double x[], double fvec[], int *iflag),
+  ( tf_lmdif_fcn_t *fcn,
+    int m,
+    int n,
+    double x[],
+    double fvec[],
+    double ftol,
+    double xtol,
+    double gtol,
+    int maxfev,
+    double epsfcn,
+    double diag[],
+    int mode,
+    double factor,
+    int nprint,
+    int *info,
+    int *nfev,
+    double fjac[],
+    int ldfjac,
+    int ipvt[],
+    double qtf[],
+    double wa1[],
+    double wa2[],
+    double wa3[],
+    double wa4[]
+  )
+  { int njev;
+    return lmdif_core
+      ( fcn, NULL, 1, NULL, NULL, m, n, x, fvec, ftol, xtol, gtol, maxfev, epsfcn,
+        diag, mode, factor, nprint, info, nfev, &njev, fjac, ldfjac, ipvt, qtf, wa1, wa2, wa3, wa4
+      );
+  }
+
+int lmdif_par
+  ( tf_lmdif_fcn_t *fcn,
+    int m,
+    int n,
+    double x[],
+    double fvec[],
+    double ftol,
+    double xtol,
+    double gtol,
+    int maxfev,
+    double epsfcn,
+    double diag[],
+    int mode,
+    double factor,
+    int nprint,
+    int *info,
+    int *nfev,
+    double fjac[],
+    int ldfjac,
+    int ipvt[],
+    double qtf[],
+    double wa1[],
+    double wa2[],
+    double wa3[],
+    double wa4[],
+    int nth,
+    int rblk[],
+    int cblk[]
+  )
+  { demand((rblk == NULL) == (cblk == NULL), "inconsistent block structure");
+    int njev;
+    return lmdif_core
+      ( fcn, NULL, nth, rblk, cblk, m, n, x, fvec, ftol, xtol, gtol, maxfev, epsfcn,
+        diag, mode, factor, nprint, info, nfev, &njev, fjac, ldfjac, ipvt, qtf, wa1, wa2, wa3, wa4
+      );
+  }
+
+int lmder
+  ( tf_lmdif_fcn_t *fcn,
+    tf_lmdif_jac_t *jac,
+    int m,
+    int n,
+    double x[],
+    double fvec[],
+    double ftol,
+    double xtol,
+    double gtol,
+    int maxfev,
+    double diag[],
+    int mode,
+    double factor,
+    int nprint,
+    int *info,
+    int *nfev,
+    int *njev,
+    double fjac[],
+    int ldfjac,
+    int ipvt[],
+    double qtf[],
+    double wa1[],
+    double wa2[],
+    double wa3[],
+    double wa4[]
+  )
+  { demand(jac != NULL, "Jacobian procedure not given");
+    return lmdif_core
+      ( fcn, jac, 1, NULL, NULL, m, n, x, fvec, ftol, xtol, gtol, maxfev, 0.0,
+        diag, mode, factor, nprint, info, nfev, njev, fjac, ldfjac, ipvt, qtf, wa1, wa2, wa3, wa4
+      );
+  }
+
+int lmdif_core
+  ( tf_lmdif_fcn_t *fcn,
+    tf_lmdif_jac_t *jac,
+    int nth,
+    int rblk[],
+    int cblk[],
     int m,
     int n,
     double x[],
@@ -408,6 +579,7 @@ int lmdif
     int nprint,
     int *info,
     int *nfev,
+    int *njev,
     double fjac[],
     int ldfjac,
     int ipvt[],
@@ -434,6 +606,7 @@ int lmdif
     *info = 0;
     iflag = 0;
     *nfev = 0;
+    *njev = 0;
     /*
     *     check the input parameters for errors.
     */
@@ -478,8 +651,18 @@ int lmdif
     *    calculate the jacobian matrix.
     */
     iflag = 2;
-    fdjac2(fcn,m,n,x,fvec,fjac,ldfjac,&iflag,epsfcn,wa4);
-    *nfev += n;
+    if (jac != NULL)
+            {
+            jac(m,n,x,fvec,fjac,&iflag);
+            *njev += 1;
+            }
+    else if ((nth == 1) && (rblk == NULL))
+            {
+            fdjac2(fcn,m,n,x,fvec,fjac,ldfjac,&iflag,epsfcn,wa4);
+            *nfev += n;
+            }
+    else
+            *nfev += fdjac2_par(fcn,m,n,x,fvec,fjac,ldfjac,&iflag,epsfcn,nth,rblk,cblk);
     if(iflag < 0)
             goto L300;
     /*
@@ -1436,6 +1619,185 @@ int fdjac2
     #endif
     return 0;
   }
+typedef struct fdjac2_job_t
+  { tf_lmdif_fcn_t *fcn;
+    int m, n;
+    double *x, *fvec, *fjac;
+    int ldfjac;  /* Leading dimension of {fjac}. */
+    int iflag;   /* Value of {iflag} to pass to {fcn}. */
+    double *h;   /* {h[j]} is the step for variable {j}. */
+    int nb;      /* Number of blocks, or 0 if dense. */
+    int *rblk;   /* Block of each function, or NULL if dense. */
+    int ngv;     /* Number of groups that are single global variables. */
+    int *gcol;   /* Variables perturbed in each group; see {fdjac2_par}. */
+    double *xw;  /* Perturbed argument vectors, {n} for each thread. */
+    double *fw;  /* Function values, {m} for each thread. */
+    int *gflag;  /* {gflag[g]} is the {iflag} returned by the call for group {g}. */
+  } fdjac2_job_t;
+  /* Arguments of {fdjac2_par_groups}. */
+
+void fdjac2_par_groups(void *arg, int32_t ith, int32_t ini, int32_t fin);
+  /* Computes the Jacobian columns of groups {ini..fin} for {fdjac2_par},
+    using the work areas of thread {ith}. */
+
+int fdjac2_par
+  ( tf_lmdif_fcn_t *fcn,
+    int m,
+    int n,
+    double x[],
+    double fvec[],
+    double fjac[],
+    int ldfjac,
+    int *iflag,
+    double epsfcn,
+    int nth,
+    int rblk[],
+    int cblk[]
+  )
+  {
+    int i,j,b,g;
+    double eps = sqrt(fmax(epsfcn,MACHEP));
+    
+    /* Compute the steps: */
+    double *h = notnull(malloc(n*sizeof(double)), "no mem");
+    for( j=0; j<n; j++ )
+            {
+            h[j] = eps * fabs(x[j]);
+            if(h[j] == 0.0)
+                    h[j] = eps;
+            }
+    
+    /* Define the groups of variables that are perturbed together.
+      Group {g} perturbs the variables {gcol[g*nc+c]} for {c} in {0..nc-1},
+      where {nc} is {max(1,nb)}, ignoring entries that are {-1}.  In the 
+      dense case, group {g} is just variable {g}.  In the block case, there is
+      one group for each global variable (stored in {gcol[g*nc]}), followed 
+      by one group for each {k}, where entry {gcol[g*nc+b]} is the 
+      {k}th variable of block {b}, or {-1} if none. */
+    int nb = 0;
+    if (rblk != NULL)
+            {
+            for( i=0; i<m; i++ )
+                    {
+                    demand(rblk[i] >= 0, "invalid function block");
+                    if (rblk[i] >= nb) nb = rblk[i] + 1;
+                    }
+            for( j=0; j<n; j++ )
+                    {
+                    demand(cblk[j] >= -1, "invalid variable block");
+                    if (cblk[j] >= nb) nb = cblk[j] + 1;
+                    }
+            }
+    int nc = (nb > 0 ? nb : 1);
+    int ng, ngv = 0;
+    int *gcol;
+    if (nb == 0)
+            {
+            ng = n;
+            gcol = notnull(malloc(n*sizeof(int)), "no mem");
+            for( j=0; j<n; j++ ) gcol[j] = j;
+            }
+    else
+            {
+            /* Count global variables {ngv}, and the size of each block: */
+            int kmax = 0;
+            int *bsz = notnull(malloc(nb*sizeof(int)), "no mem");
+            for( b=0; b<nb; b++ ) bsz[b] = 0;
+            for( j=0; j<n; j++ )
+                    {
+                    if (cblk[j] < 0)
+                            ngv++;
+                    else
+                            {
+                            bsz[cblk[j]]++;
+                            if (bsz[cblk[j]] > kmax) kmax = bsz[cblk[j]];
+                            }
+                    }
+            ng = ngv + kmax;
+            gcol = notnull(malloc(ng*nc*sizeof(int)), "no mem");
+            for( i=0; i<ng*nc; i++ ) gcol[i] = -1;
+            for( b=0; b<nb; b++ ) bsz[b] = 0;
+            g = 0;
+            for( j=0; j<n; j++ )
+                    {
+                    if (cblk[j] < 0)
+                            { gcol[g*nc] = j; g++; }
+                    else
+                            {
+                            b = cblk[j];
+                            gcol[(ngv + bsz[b])*nc + b] = j;
+                            bsz[b]++;
+                            /* Only the entries in block {b} will be set: */
+                            for( i=0; i<m; i++ ) fjac[i+ldfjac*j] = 0.0;
+                            }
+                    }
+            free(bsz);
+            }
+    
+    /* Evaluate the groups: */
+    int nt = jsthread_choose_count(nth, ng);
+    fdjac2_job_t job = (fdjac2_job_t)
+      { .fcn = fcn, .m = m, .n = n, .x = x, .fvec = fvec, .fjac = fjac, .ldfjac = ldfjac, .iflag = *iflag, .h = h,
+        .nb = nb, .rblk = rblk, .ngv = ngv, .gcol = gcol,
+        .xw = notnull(malloc(nt*n*sizeof(double)), "no mem"),
+        .fw = notnull(malloc(nt*m*sizeof(double)), "no mem"),
+        .gflag = notnull(malloc(ng*sizeof(int)), "no mem")
+      };
+    jsthread_run_ranges(ng, 1, nt, &fdjac2_par_groups, &job);
+    
+    for( g=0; g<ng; g++ )
+            {
+            if (job.gflag[g] < 0)
+                    { *iflag = job.gflag[g]; break; }
+            }
+    free(job.xw);
+    free(job.fw);
+    free(job.gflag);
+    free(gcol);
+    free(h);
+    return ng;
+  }
+
+void fdjac2_par_groups(void *arg, int32_t ith, int32_t ini, int32_t fin)
+  {
+    fdjac2_job_t *job = (fdjac2_job_t *)arg;
+    int m = job->m, n = job->n, nb = job->nb, ld = job->ldfjac;
+    int nc = (nb > 0 ? nb : 1);
+    double *xt = &(job->xw[ith*n]);
+    double *ft = &(job->fw[ith*m]);
+    int g,i,j,c;
+    for( g=ini; g<=fin; g++ )
+            {
+            /* Perturb the variables of group {g}: */
+            for( j=0; j<n; j++ ) xt[j] = job->x[j];
+            int *gc = &(job->gcol[g*nc]);
+            for( c=0; c<nc; c++ )
+                    {
+                    j = gc[c];
+                    if (j >= 0) xt[j] = job->x[j] + job->h[j];
+                    }
+            int flag = job->iflag;
+            job->fcn(m,n,xt,ft,&flag);
+            job->gflag[g] = flag;
+            if (flag < 0) continue;
+            /* Store the differences: */
+            if ((nb == 0) || (g < job->ngv))
+                    {
+                    j = gc[0];
+                    for( i=0; i<m; i++ )
+                            job->fjac[i+ld*j] = (ft[i] - job->fvec[i])/job->h[j];
+                    }
+            else
+                    {
+                    for( i=0; i<m; i++ )
+                            {
+                            j = gc[job->rblk[i]];
+                            if (j >= 0) job->fjac[i+ld*j] = (ft[i] - job->fvec[i])/job->h[j];
+                            }
+                    }
+            }
+  }
+
 // /************************lmmisc.c*************************/
 // 
 // double fmax(a,b)
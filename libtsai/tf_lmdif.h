@@ -1,4 +1,4 @@
-/* Last edited on 2015-10-05 00:14:35 by stolfilocal */
+/* Last edited on 2026-10-19 11:38:25 by stolfilocal */
 
 #ifndef tf_lmdif_H
 #define tf_lmdif_H
@@ -189,4 +189,109 @@ int lmdif
    Argonne National Laboratory, minpack project. March 1980.
    Burton S. Garbow, Kenneth E. Hillstrom, Jorge J. More. */
 
+typedef void tf_lmdif_jac_t (int m, int n, double x[], double fvec[], double fjac[], int *iflag);
+  /* Type of a user-supplied procedure that computes the Jacobian
+    for {lmder}.  It receives the argument vector {x[0..n-1]} and the
+    function values {fvec[0..m-1]} at {x}, and should store into
+    {fjac[i+m*j]} the derivative of function {i} with respect to
+    variable {j}, for {i} in {0..m-1} and {j} in {0..n-1}.  It must not
+    change {x} or {fvec}. The procedure may set {*iflag} to a negative
+    integer to terminate {lmder}. */
+
+int lmder
+  ( tf_lmdif_fcn_t *fcn,
+    tf_lmdif_jac_t *jac,
+    int m,
+    int n,
+    double x[],
+    double fvec[],
+    double ftol,
+    double xtol,
+    double gtol,
+    int maxfev,
+    double diag[],
+    int mode,
+    double factor,
+    int nprint,
+    int *info,
+    int *nfev,
+    int *njev,
+    double fjac[],
+    int ldfjac,
+    int ipvt[],
+    double qtf[],
+    double wa1[],
+    double wa2[],
+    double wa3[],
+    double wa4[]
+  );
+  /* Same as {lmdif}, except that the Jacobian is computed by the 
+    user procedure {jac} instead of by finite differences.
+    On output, {*nfev} is the number of calls to {fcn}, and {*njev}
+    is the number of calls to {jac}; the limit {maxfev} applies to
+    {*nfev} only. Since each iteration then needs only one or a few calls to
+    {fcn}, instead of {n+1}, this procedure is much faster when {fcn}
+    is expensive and the derivatives can be computed along with the
+    function values. */
+
+int lmdif_par
+  ( tf_lmdif_fcn_t *fcn,
+    int m,
+    int n,
+    double x[],
+    double fvec[],
+    double ftol,
+    double xtol,
+    double gtol,
+    int maxfev,
+    double epsfcn,
+    double diag[],
+    int mode,
+    double factor,
+    int nprint,
+    int *info,
+    int *nfev,
+    double fjac[],
+    int ldfjac,
+    int ipvt[],
+    double qtf[],
+    double wa1[],
+    double wa2[],
+    double wa3[],
+    double wa4[],
+    int nth,
+    int rblk[],
+    int cblk[]
+  );
+  /* Same as {lmdif}, but the forward-difference approximation to
+    the Jacobian is computed with {nth} threads (one per available
+    processor if {nth} is zero), and may exploit a block structure
+    of the Jacobian.
+    
+    Each thread evaluates {fcn} at different perturbed copies of {x},
+    into its own work area. Therefore, if {nth} is not 1, the
+    procedure {fcn} may be called concurrently by several threads,
+    and must not modify any shared data (in particular, it must not
+    store the given {x} into some global model).  The calls 
+    with {*iflag} equal to 0 or 1 are still made by the calling thread
+    only.
+    
+    If {rblk} and {cblk} are not NULL, they describe a sparse block
+    structure of the Jacobian, as in a bundle of several cameras
+    with separate parameters. There are {nb} blocks, numbered
+    {0..nb-1}. Function {i} belongs to block {rblk[i]}, which must be
+    in {0..nb-1}. Variable {j} belongs to block {cblk[j]}; or, if
+    {cblk[j]} is {-1}, it is a global variable that may affect any
+    function. The client guarantees that a non-global variable in
+    block {b} affects only functions in block {b}.  Then the 
+    {k}th non-global variable of every block is perturbed at the 
+    same time, with a single call to {fcn}; so the number of calls per
+    Jacobian is the number of global variables plus the maximum
+    number of variables in any block, instead of {n}.  The derivatives of 
+    functions with respect to variables of other blocks are set to zero.
+    
+    If {nth} is 1 and {rblk} is NULL, the result is exactly the same as
+    that of {lmdif}. Otherwise the results may differ only in
+    the rounding errors, or in the number of calls {*nfev}. */
+
 #endif